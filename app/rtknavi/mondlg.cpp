@@ -1472,10 +1472,7 @@ void __fastcall TMonitorDialog::ShowSbsMsg(void)
 	char str[256],*p;
 	int i,j,k,n,type;
 	
-	rtksvrlock(&rtksvr); // lock
-	n=rtksvr.nsbs;
-	for (i=0;i<n;i++) msg[i]=rtksvr.sbsmsg[i];
-	rtksvrunlock(&rtksvr); // unlock
+	n=rtksvrsbsmsg(&rtksvr,msg,MAXSBSMSG);
 	
 	Tbl->RowCount=n<=0?2:n+1;
 	Label->Caption="";
@@ -717,9 +717,7 @@ void __fastcall TPlot::MenuOptionsClick(TObject *Sender)
     for (i=0;i<3;i++) oopos[i]-=OOPos[i];
     
     if (TLEFile!=tlefile) {
-        free(TLEData.data);
-        TLEData.data=NULL;
-        TLEData.n=TLEData.nmax=0;
+        tle_free(&TLEData);
         tle_read(TLEFile.c_str(),&TLEData);
     }
     if (TLEFile!=tlefile||TLESatFile!=tlesatfile) {
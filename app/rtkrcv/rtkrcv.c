@@ -23,6 +23,14 @@
 *                           change file paths of solution status and debug trace
 *           2015/01/10 1.11 add line editting and command history
 *                           separate codes for virtual console to vt.c
+*           2026/10/18 1.12 add multi-rover options misc-rovfile,misc-nworker
+*                           add command rover
+*           2026/10/18 1.13 add event queue statistics to status
+*           2026/10/18 1.14 add option misc-basewait and base obs time-alignment status
+*           2026/10/18 1.15 add option misc-sbsbuff and command sbas
+*           2026/10/18 1.16 add option -b for binary debug trace
+*           2026/10/18 1.17 add options misc-profile,misc-profcycle and command profile
+*           2026/10/18 1.18 add option misc-ckptcycle to autosave checkpoint
 *-----------------------------------------------------------------------------*/
 #include <signal.h>
 #include "rtklib.h"
@@ -41,6 +49,7 @@ static const char rcsid[]="$Id:$";
 #define NAVIFILE    "rtkrcv.nav"        /* navigation save file */
 #define STATFILE    "rtkrcv_%Y%m%d%h%M.stat"  /* solution status file */
 #define TRACEFILE   "rtkrcv_%Y%m%d%h%M.trace" /* debug trace file */
+#define TRACEBFILE  "rtkrcv_%Y%m%d%h%M.trb" /* debug trace file (binary) */
 #define INTKEEPALIVE 1000               /* keep alive interval (ms) */
 
 #define ESC_CLEAR   "\033[2J"           /* ansi/vt100: erase screen */
@@ -87,6 +96,13 @@ static int modflgs[256] ={0};           /* modified flags of system options */
 static int moniport     =0;             /* monitor port */
 static int keepalive    =0;             /* keep alive flag */
 static int fswapmargin  =30;            /* file swap margin (s) */
+static char rovfile[MAXSTR]="";         /* rover list file (multi-rover) */
+static int nworker      =0;             /* number of worker threads for rovers */
+static int basewait     =0;             /* wait time for time-matched base (ms) */
+static int sbsbuff      =MAXSBSMSG;     /* depth of sbas message buffer */
+static int prfmode      =0;             /* stage timing profile (0:off,1:on) */
+static int prfcycle     =0;             /* profile output cycle to monitor (ms) */
+static int ckptcycle    =0;             /* checkpoint autosave cycle (ms) */
 
 static prcopt_t prcopt;                 /* processing options */
 static solopt_t solopt[2]={{0}};        /* solution options */
@@ -103,6 +119,9 @@ static const char *helptxt[]={
     " observ [-n] [cycle]   : show observation data",
     " navidata [cycle] : show navigation data",
     " stream [cycle]   : show stream status",
+    " rover [cycle]    : show rover status (multi-rover)",
+    " sbas [prn] [cycle]: show sbas messages",
+    " profile [on|off|reset] [cycle]: show stage timing profile",
     " error            : show error/warning messages",
     " option [opt]     : show option(s)",
     " set opt [val]    : set option",
@@ -135,8 +154,9 @@ static const char *pathopts[]={         /* path options help */
 #define OSTOPT  "0:off,1:serial,2:file,3:tcpsvr,4:tcpcli,6:ntripsvr"
 #define FMTOPT  "0:rtcm2,1:rtcm3,2:oem4,3:oem3,4:ubx,5:ss2,6:hemis,7:skytraq,8:gw10,9:javad,10:nvs,11:binex,12:rt17,15:sp3"
 #define NMEOPT  "0:off,1:latlon,2:single"
-#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea"
+#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea,5:bin"
 #define MSGOPT  "0:all,1:rover,2:base,3:corr"
+#define SWTOPT  "0:off,1:on"
 
 static opt_t rcvopts[]={
     {"console-passwd",  2,  (void *)passwd,              ""     },
@@ -177,6 +197,13 @@ static opt_t rcvopts[]={
     {"misc-navmsgsel",  3,  (void *)&navmsgsel,          MSGOPT },
     {"misc-proxyaddr",  2,  (void *)proxyaddr,           ""     },
     {"misc-fswapmargin",0,  (void *)&fswapmargin,        "s"    },
+    {"misc-rovfile",    2,  (void *)rovfile,             ""     },
+    {"misc-nworker",    0,  (void *)&nworker,            ""     },
+    {"misc-basewait",   0,  (void *)&basewait,           "ms"   },
+    {"misc-sbsbuff",    0,  (void *)&sbsbuff,            ""     },
+    {"misc-profile",    3,  (void *)&prfmode,            SWTOPT },
+    {"misc-profcycle",  0,  (void *)&prfcycle,           "ms"   },
+    {"misc-ckptcycle",  0,  (void *)&ckptcycle,          "ms"   },
     
     {"misc-startcmd",   2,  (void *)startcmd,            ""     },
     {"misc-stopcmd",    2,  (void *)stopcmd,             ""     },
@@ -329,6 +356,70 @@ static void readant(vt_t *vt, prcopt_t *opt, nav_t *nav)
     
     free(pcvr.pcv); free(pcvs.pcv);
 }
+/* option value by number or label -----------------------------------------*/
+static int optval(const char *str, const char *opts)
+{
+    const char *p,*q;
+    int n;
+    
+    if (sscanf(str,"%d",&n)==1) return n;
+    
+    for (p=opts;(q=strchr(p,':'));p=q+1) {
+        n=atoi(p);
+        p=q+1;
+        if (!(q=strchr(p,','))) q=p+strlen(p);
+        if ((int)strlen(str)==q-p&&!strncmp(str,p,q-p)) return n;
+        if (!*q) break;
+    }
+    return -1;
+}
+/* read rover list file ------------------------------------------------------*/
+static int readrov(vt_t *vt, const char *file)
+{
+    FILE *fp;
+    solopt_t sopt;
+    char buff[MAXSTR*3],*p,*args[9],*paths[3];
+    int n,strs[3],format,nrov=0;
+    
+    trace(3,"readrov: file=%s\n",file);
+    
+    if (!(fp=fopen(file,"r"))) {
+        vt_printf(vt,"rover file open error: %s\n",file);
+        return 0;
+    }
+    while (fgets(buff,sizeof(buff),fp)) {
+        
+        if ((p=strchr(buff,'#'))) *p='\0';
+        
+        for (n=0,p=strtok(buff," \t\r\n");p&&n<9;p=strtok(NULL," \t\r\n")) {
+            args[n++]=p;
+        }
+        if (n<6) continue;
+        
+        sopt=solopt[0];
+        strs[0]=optval(args[1],ISTOPT);
+        format =optval(args[3],FMTOPT);
+        strs[1]=optval(args[4],OSTOPT);
+        strs[2]=n>=9?optval(args[7],OSTOPT):STR_NONE;
+        if (n>=7) sopt.posf=optval(args[6],SOLOPT);
+        paths[0]=args[2];
+        paths[1]=args[5];
+        paths[2]=n>=9?args[8]:"";
+        
+        if (strs[0]<0||format<0||strs[1]<0||strs[2]<0||sopt.posf<0) {
+            vt_printf(vt,"invalid rover: %s\n",args[0]);
+            continue;
+        }
+        if (!rtksvraddrov(&svr,args[0],strs,paths,format,"",NULL,&prcopt,
+                          &sopt)) {
+            vt_printf(vt,"rover add error: %s\n",args[0]);
+            continue;
+        }
+        nrov++;
+    }
+    fclose(fp);
+    return nrov;
+}
 /* start rtk server ----------------------------------------------------------*/
 static int startsvr(vt_t *vt)
 {
@@ -396,6 +487,17 @@ static int startsvr(vt_t *vt)
     solopt[0].posf=strfmt[3];
     solopt[1].posf=strfmt[4];
     
+    /* add rovers sharing base station and correction streams */
+    rtksvrfreerov(&svr);
+    if (*rovfile) readrov(vt,rovfile);
+    svr.nworker=nworker;
+    svr.basewait=basewait;
+    svr.nsbsmax=sbsbuff;
+    svr.prfcycle=prfcycle;
+    strcpy(svr.ckptfile,filopt.ckpt);
+    svr.ckptcycle=ckptcycle;
+    prfenable(prfmode);
+    
     /* start rtk server */
     if (!rtksvrstart(&svr,svrcycle,buffsize,strtype,paths,strfmt,navmsgsel,
                      cmds,ropts,nmeacycle,nmeareq,npos,&prcopt,solopt,&moni)) {
@@ -551,6 +653,7 @@ static void prstatus(vt_t *vt)
 {
     rtk_t rtk;
     const char *svrstate[]={"stop","run"},*type[]={"rover","base","corr"};
+    const char *qtype[]={"rover","base","corr","output"};
     const char *sol[]={"-","fix","float","SBAS","DGPS","single","PPP",""};
     const char *mode[]={
          "single","DGPS","kinematic","static","moving-base","fixed",
@@ -558,8 +661,10 @@ static void prstatus(vt_t *vt)
     };
     const char *freq[]={"-","L1","L1+L2","L1+L2+L5","","",""};
     rtcm_t rtcm[3];
+    rtkque_t que[4];
     int i,j,n,thread,cycle,state,rtkstat,nsat0,nsat1,prcout;
     int cputime,nb[3]={0},nmsg[3][10]={{0}};
+    unsigned int nalign[3];
     char tstr[64],s[1024],*p;
     double runtime,rt[3]={0},dop[4]={0},rr[3],bl1=0.0,bl2=0.0;
     double azel[MAXSAT*2],pos[3],vel[3],*del;
@@ -586,6 +691,8 @@ static void prstatus(vt_t *vt)
         rt[1]=floor(runtime/60.0); rt[2]=runtime-rt[1]*60.0;
     }
     for (i=0;i<3;i++) rtcm[i]=svr.rtcm[i];
+    for (i=0;i<4;i++) que[i]=svr.que[i];
+    for (i=0;i<3;i++) nalign[i]=svr.nalign[i];
     rtksvrunlock(&svr);
     
     for (i=n=0;i<MAXSAT;i++) {
@@ -607,7 +714,19 @@ static void prstatus(vt_t *vt)
     vt_printf(vt,"%-28s: %02.0f:%02.0f:%04.1f\n","accumulated time to run",rt[0],rt[1],rt[2]);
     vt_printf(vt,"%-28s: %d\n","cpu time for a cycle (ms)",cputime);
     vt_printf(vt,"%-28s: %d\n","missing obs data count",prcout);
+    vt_printf(vt,"%-28s: %d,%d\n","# of rovers,worker threads",svr.nrov,
+              svr.nworker);
     vt_printf(vt,"%-28s: %d,%d\n","bytes in input buffer",nb[0],nb[1]);
+    for (i=0;i<4;i++) {
+        sprintf(s,"event queue %s",qtype[i]);
+        vt_printf(vt,"%-28s: depth(%d/%d),max(%d),over(%d),lat(%.1f/%d ms)\n",
+                  s,(int)(que[i].wp-que[i].rp),que[i].size,que[i].maxn,
+                  que[i].nover,que[i].nlat>0?que[i].lat/que[i].nlat:0.0,
+                  que[i].latmax);
+    }
+    vt_printf(vt,"%-28s: matched(%u),waited(%u),not matched(%u),wait(%d ms)\n",
+              "base obs time-alignment",nalign[0],nalign[1],nalign[2],
+              svr.basewait);
     for (i=0;i<3;i++) {
         sprintf(s,"# of input data %s",type[i]);
         vt_printf(vt,"%-28s: obs(%d),nav(%d),gnav(%d),ion(%d),sbs(%d),pos(%d),dgps(%d),ssr(%d),err(%d)\n",
@@ -870,6 +989,80 @@ static void prstream(vt_t *vt)
             stream[i].inb,stream[i].inr,stream[i].outb,stream[i].outr,stream[i].msg);
     }
 }
+/* print rover status -------------------------------------------------------*/
+static void prrover(vt_t *vt)
+{
+    rtkrov_t *rov;
+    sol_t sol;
+    double rb[3];
+    int i,j;
+    
+    trace(4,"prrover:\n");
+    
+    vt_printf(vt,"\n%s%3s %-12s %-4s %8s %8s %6s %4s %s%s\n",ESC_BOLD,"No",
+              "Name","Stat","Obs","Sol","Err","CPU","Solution",ESC_RESET);
+    
+    for (i=0;i<svr.nrov;i++) {
+        rov=svr.rov[i];
+        lock(&rov->lock);
+        sol=rov->rtk.sol;
+        for (j=0;j<3;j++) rb[j]=rov->rtk.rb[j];
+        unlock(&rov->lock);
+        
+        vt_printf(vt,"%3d %-12s %-4s %8u %8u %6u %4d ",i+1,rov->name,
+                  rov->state?"run":"-",rov->nmsg[0],rov->nsol,rov->nmsg[9],
+                  rov->cputime);
+        if (sol.time.time==0||!sol.stat) vt_printf(vt,"-\n");
+        else prsolution(vt,&sol,rb);
+    }
+}
+/* print sbas messages -------------------------------------------------------*/
+static void prsbas(vt_t *vt, int prn)
+{
+    sbsmsg_t msg[MAXSBSMSG];
+    gtime_t time;
+    char s1[64],s2[64];
+    int i,j,k,n,type;
+    
+    trace(4,"prsbas: prn=%d\n",prn);
+    
+    vt_printf(vt,"\n%s%-19s %3s %4s %s%s\n",ESC_BOLD,"Time","PRN","Type",
+              "Message",ESC_RESET);
+    
+    if (prn) { /* latest message of each type */
+        for (type=n=0;type<64;type++) {
+            if (rtksvrsbslast(&svr,prn,type,msg+n)) n++;
+        }
+    }
+    else n=rtksvrsbsmsg(&svr,msg,MAXSBSMSG);
+    
+    for (i=0;i<n;i++) {
+        time=gpst2time(msg[i].week,msg[i].tow);
+        time2str(time,s1,0);
+        for (j=k=0;j<29;j++) k+=sprintf(s2+k,"%02X",msg[i].msg[j]);
+        vt_printf(vt,"%-19s %3d %4d %s\n",s1,msg[i].prn,
+                  getbitu(msg[i].msg,8,6),s2);
+    }
+}
+/* print stage timing profile -----------------------------------------------*/
+static void prprofile(vt_t *vt, int reset)
+{
+    prfstat_t prf[NPRF];
+    unsigned char buff[MAXPRFMSG+1];
+    char *p;
+    int n;
+    
+    trace(4,"prprofile: reset=%d\n",reset);
+    
+    rtksvrprf(&svr,prf,reset);
+    n=prfouts(buff,prf,0);
+    buff[n]='\0';
+    
+    if ((p=strchr((char *)buff,'\n'))) *p++='\0';
+    vt_printf(vt,"\n%s%s%s\n",ESC_BOLD,(char *)buff,ESC_RESET);
+    if (p) vt_puts(vt,p);
+    if (!prfmode) vt_printf(vt,"(profile off)\n");
+}
 /* start command -------------------------------------------------------------*/
 static void cmd_start(char **args, int narg, vt_t *vt)
 {
@@ -1011,6 +1204,62 @@ static void cmd_stream(char **args, int narg, vt_t *vt)
     }
     vt_printf(vt,"\n");
 }
+/* rover command -------------------------------------------------------------*/
+static void cmd_rover(char **args, int narg, vt_t *vt)
+{
+    int cycle=0;
+    
+    trace(3,"cmd_rover:\n");
+    
+    if (narg>1) cycle=(int)(atof(args[1])*1000.0);
+    
+    while (!vt_chkbrk(vt)) {
+        if (cycle>0) vt_printf(vt,ESC_CLEAR);
+        prrover(vt);
+        if (cycle>0) sleepms(cycle); else return;
+    }
+    vt_printf(vt,"\n");
+}
+/* sbas command --------------------------------------------------------------*/
+static void cmd_sbas(char **args, int narg, vt_t *vt)
+{
+    int i,prn=0,cycle=0;
+    
+    trace(3,"cmd_sbas:\n");
+    
+    for (i=1;i<narg;i++) {
+        if (atoi(args[i])>=MINPRNSBS&&strchr(args[i],'.')==NULL) {
+            prn=atoi(args[i]);
+        }
+        else cycle=(int)(atof(args[i])*1000.0);
+    }
+    while (!vt_chkbrk(vt)) {
+        if (cycle>0) vt_printf(vt,ESC_CLEAR);
+        prsbas(vt,prn);
+        if (cycle>0) sleepms(cycle); else return;
+    }
+    vt_printf(vt,"\n");
+}
+/* profile command -----------------------------------------------------------*/
+static void cmd_profile(char **args, int narg, vt_t *vt)
+{
+    int i,reset=0,cycle=0;
+    
+    trace(3,"cmd_profile:\n");
+    
+    for (i=1;i<narg;i++) {
+        if      (!strcmp(args[i],"on"   )) prfenable(prfmode=1);
+        else if (!strcmp(args[i],"off"  )) prfenable(prfmode=0);
+        else if (!strcmp(args[i],"reset")) reset=1;
+        else cycle=(int)(atof(args[i])*1000.0);
+    }
+    while (!vt_chkbrk(vt)) {
+        if (cycle>0) vt_printf(vt,ESC_CLEAR);
+        prprofile(vt,reset);
+        if (cycle>0) sleepms(cycle); else return;
+    }
+    vt_printf(vt,"\n");
+}
 /* option command ------------------------------------------------------------*/
 static void cmd_option(char **args, int narg, vt_t *vt)
 {
@@ -1199,9 +1448,9 @@ static int cmd_exec(const char *cmd, vt_t *vt)
 static void cmdshell(vt_t *vt)
 {
     const char *cmds[]={
-        "start","stop","restart","solution","status","satellite","observ",
+        "start","stop","rover","restart","solution","status","satellite","observ",
         "navidata","stream","error","option","set","load","save","log","help",
-        "?","exit","shutdown",""
+        "?","sbas","profile","exit","shutdown",""
     };
     int i,j,narg;
     char buff[MAXCMD],*args[MAXARG],*p;
@@ -1233,23 +1482,26 @@ static void cmdshell(vt_t *vt)
         switch (j) {
             case  0: cmd_start    (args,narg,vt); break;
             case  1: cmd_stop     (args,narg,vt); break;
-            case  2: cmd_restart  (args,narg,vt); break;
-            case  3: cmd_solution (args,narg,vt); break;
-            case  4: cmd_status   (args,narg,vt); break;
-            case  5: cmd_satellite(args,narg,vt); break;
-            case  6: cmd_observ   (args,narg,vt); break;
-            case  7: cmd_navidata (args,narg,vt); break;
-            case  8: cmd_stream   (args,narg,vt); break;
-            case  9: cmd_error    (args,narg,vt); break;
-            case 10: cmd_option   (args,narg,vt); break;
-            case 11: cmd_set      (args,narg,vt); break;
-            case 12: cmd_load     (args,narg,vt); break;
-            case 13: cmd_save     (args,narg,vt); break;
-            case 14: cmd_log      (args,narg,vt); break;
-            case 15: cmd_help     (args,narg,vt); break;
+            case  2: cmd_rover    (args,narg,vt); break;
+            case  3: cmd_restart  (args,narg,vt); break;
+            case  4: cmd_solution (args,narg,vt); break;
+            case  5: cmd_status   (args,narg,vt); break;
+            case  6: cmd_satellite(args,narg,vt); break;
+            case  7: cmd_observ   (args,narg,vt); break;
+            case  8: cmd_navidata (args,narg,vt); break;
+            case  9: cmd_stream   (args,narg,vt); break;
+            case 10: cmd_error    (args,narg,vt); break;
+            case 11: cmd_option   (args,narg,vt); break;
+            case 12: cmd_set      (args,narg,vt); break;
+            case 13: cmd_load     (args,narg,vt); break;
+            case 14: cmd_save     (args,narg,vt); break;
+            case 15: cmd_log      (args,narg,vt); break;
             case 16: cmd_help     (args,narg,vt); break;
-            case 17: if (vt->type) return;        break;
-            case 18:              /* shutdown */
+            case 17: cmd_help     (args,narg,vt); break;
+            case 18: cmd_sbas     (args,narg,vt); break;
+            case 19: cmd_profile  (args,narg,vt); break;
+            case 20: if (vt->type) return;        break;
+            case 21:              /* shutdown */
                 vt_printf(vt,"shutdown %s process ? (y/n): ",PRGNAME);
                 if (!vt_gets(vt,buff,sizeof(buff))||vt->brk) continue;
                 if (toupper((int)buff[0])=='Y') intflg=1;
@@ -1285,6 +1537,8 @@ static void cmdshell(vt_t *vt)
 *     -o file    processing options file       
 *     -r level   output solution status file (0:off,1:states,2:residuals)
 *     -t level   debug trace level (0:off,1-5:on)
+*     -b size    binary debug trace with buffer size per thread (KB)
+*                (decode the trace file by tracedec)
 *
 * command
 *     start
@@ -1320,6 +1574,16 @@ static void cmdshell(vt_t *vt)
 *     stream [cycle]
 *       Show stream status. Use option cycle for cyclic display.
 *
+*     rover [cycle]
+*       Show status and solutions of rovers sharing base station and
+*       correction streams (multi-rover). Use option cycle for cyclic display.
+*
+*     profile [on|off|reset] [cycle]
+*       Show stage timing profile (count, mean, median, 99 percentile and max
+*       of processing time) of decoding, positioning stages, solution output
+*       and server cycle. Use option on|off to switch profiling, reset to reset
+*       the profile after display and cycle for cyclic display.
+*
 *     error
 *       Show error/warning messages. To stop messages, send break (ctr-C).
 *
@@ -1362,11 +1626,39 @@ static void cmdshell(vt_t *vt)
 *     Short form of a command is allowed. In case of the short form, the
 *     command is distinguished according to header characters.
 *     
+*     For multi-rover, set option misc-rovfile to a rover list file. The
+*     rovers are positioned against base station stream (inpstr2) with the
+*     navigation data decoded once from base station and correction streams
+*     (inpstr2,inpstr3). Option misc-nworker sets the number of worker threads
+*     for the rovers. A line of the rover list file is as follows. Stream
+*     types and formats are given by numbers or labels of the options
+*     inpstr*-type, inpstr*-format, outstr*-type and outstr*-format.
+*
+*       name inp-type inp-path inp-format out-type out-path [out-format
+*       [log-type log-path]] [# comment]
+*     
+*     Option misc-basewait sets the max wait time (ms) of a rover epoch for the
+*     time-matched base station epoch under delayed or jittery base station
+*     stream. The rover epoch is positioned with the previous base station
+*     epoch after the wait time (extrapolated with misc-timeinterp=on).
+*     
+*     Option misc-sbsbuff sets the depth of the sbas message buffer. The
+*     buffered messages are kept over restart and shown by command sbas.
+*     
+*     Option misc-profile switches the stage timing profile shown by command
+*     profile. With option misc-profcycle (ms), the profile is also output to
+*     the monitor port (-m) as $PRF messages. For the format, see prfouts().
+*     
+*     Option file-ckptfile sets the checkpoint file of the rtk filter state.
+*     The filter state is restored from the file at the start if not older
+*     than 300 s, saved every misc-ckptcycle (ms) (0: no autosave) and saved
+*     at the stop to restart without the convergence time of the filter.
+*     
 *-----------------------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
     vt_t vt={0};
-    int i,start=0,port=0,outstat=0,trace=0;
+    int i,start=0,port=0,outstat=0,trace=0,tracesize=0;
     char *dev="",file[MAXSTR]="";
     
     for (i=1;i<argc;i++) {
@@ -1377,10 +1669,12 @@ int main(int argc, char **argv)
         else if (!strcmp(argv[i],"-o")&&i+1<argc) strcpy(file,argv[++i]);
         else if (!strcmp(argv[i],"-r")&&i+1<argc) outstat=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-t")&&i+1<argc) trace=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-b")&&i+1<argc) tracesize=atoi(argv[++i]);
         else fprintf(stderr,"Unknown option: %s\n",argv[i]);
     }
     if (trace>0) {
-        traceopen(TRACEFILE);
+        tracebuf(tracesize*1024);
+        traceopen(tracesize>0?TRACEBFILE:TRACEFILE);
         tracelevel(trace);
     }
     /* initialize rtk server and monitor port */
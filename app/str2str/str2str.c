@@ -17,6 +17,7 @@
 *           2014/10/14  1.7  use stdin or stdout if option -in or -out omitted
 *           2014/11/08  1.8  add option -a, -i and -o
 *           2015/03/23  1.9  fix bug on parsing of command line options
+*           2026/10/18  1.10 support ntrip caster output (ntripc://) and show caster status
 *-----------------------------------------------------------------------------*/
 #include <signal.h>
 #include <unistd.h>
@@ -41,8 +42,9 @@ static const char *help[]={
 " Input data from a stream and divide and output them to multiple streams",
 " The input stream can be serial, tcp client, tcp server, ntrip client, or",
 " file. The output stream can be serial, tcp client, tcp server, ntrip server,",
-" or file. str2str is a resident type application. To stop it, type ctr-c in",
-" console if run foreground or send signal SIGINT for background process.",
+" ntrip caster, or file. str2str is a resident type application. To stop it,",
+" type ctr-c in console if run foreground or send signal SIGINT for background",
+" process.",
 " if run foreground or send signal SIGINT for background process.",
 " if both of the input stream and the output stream follow #format, the",
 " format of input messages are converted to output. To specify the output",
@@ -59,6 +61,7 @@ static const char *help[]={
 "    tcp client   : tcpcli://addr[:port]",
 "    ntrip client : ntrip://[user[:passwd]@]addr[:port][/mntpnt]",
 "    ntrip server : ntrips://[:passwd@]addr[:port][/mntpnt[:str]] (only out)",
+"    ntrip caster : ntripc://[user:passwd@][:port]/mntpnt[:str] (only out)",
 "    file         : [file://]path[::T][::+start][::xseppd][::S=swap]",
 "",
 "  format",
@@ -151,6 +154,7 @@ static int decodepath(const char *path, int *type, char *strpath, int *fmt)
     else if (!strncmp(path,"tcpsvr",6)) *type=STR_TCPSVR;
     else if (!strncmp(path,"tcpcli",6)) *type=STR_TCPCLI;
     else if (!strncmp(path,"ntrips",6)) *type=STR_NTRIPSVR;
+    else if (!strncmp(path,"ntripc",6)) *type=STR_NTRIPC;
     else if (!strncmp(path,"ntrip", 5)) *type=STR_NTRIPCLI;
     else if (!strncmp(path,"file",  4)) *type=STR_FILE;
     else {
@@ -189,6 +193,7 @@ int main(int argc, char **argv)
     char *paths[MAXSTR],s[MAXSTR][MAXSTRPATH]={{0}},*cmdfile="";
     char *local="",*proxy="",*msg="1004,1019",*opt="",buff[256],*p;
     char strmsg[MAXSTRMSG]="",*antinfo="",*rcvinfo="";
+    strcasstat_t casstat;
     char *ant[]={"","",""},*rcv[]={"","",""};
     int i,j,n=0,dispint=5000,trlevel=0,opts[]={10000,10000,2000,32768,10,0,30};
     int types[MAXSTR]={STR_FILE,STR_FILE},stat[MAXSTR]={0},byte[MAXSTR]={0};
@@ -294,6 +299,14 @@ int main(int argc, char **argv)
         fprintf(stderr,"%s [%s] %10d B %7d bps %s\n",
                 time_str(utc2gpst(timeget()),0),buff,byte[0],bps[0],strmsg);
         
+        /* show ntrip caster status */
+        for (i=0;i<n;i++) {
+            if (types[i+1]!=STR_NTRIPC||
+                !strcasstat(strsvr.stream+i+1,&casstat)) continue;
+            fprintf(stderr,"  caster %-12s %5d clients %6d acc %4d evict "
+                    "%8d bps out %7d B lag\n",casstat.mntpnt,casstat.ncli,
+                    casstat.nacc,casstat.nevict,casstat.outr,casstat.maxlag);
+        }
         sleepms(dispint);
     }
     if (*cmdfile) readcmd(cmdfile,cmd,1);
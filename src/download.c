@@ -6,10 +6,21 @@
 * version : $Revision:$ $Date:$
 * history : 2012/12/28  1.0  new
 *           2013/06/02  1.1  replace S_IREAD by S_IRUSR
+*           2026/10/18  1.2  download files by concurrent threads with in-process
+*                            ftp/http client instead of wget
+*                            keep ftp/http connections alive and resume download
+*                            add api dl_setthread()
 *-----------------------------------------------------------------------------*/
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#endif
 
 #include "rtklib.h"
 
@@ -26,6 +37,26 @@ static const char rcsid[]="$Id:$";
 #define HTTP_NOFILE 1               /* http error no file */
 #define FTP_RETRY   3               /* ftp number of retry */
 
+#define DL_NTHREAD  4               /* default number of download threads */
+#define DL_MAXTHREAD 32             /* max number of download threads */
+#define DL_NCONN    4               /* number of kept connections per thread */
+#define DL_MAXREDIR 5               /* max number of http redirections */
+#define DL_BUFFSIZE 16384           /* receive buffer size (bytes) */
+#define DL_PART     ".part"         /* suffix of partially downloaded file */
+
+#ifdef WIN32
+#define socket_t    SOCKET
+#define DL_SENDFLAG 0
+#else
+#define socket_t    int
+#define closesocket close
+#ifdef MSG_NOSIGNAL
+#define DL_SENDFLAG MSG_NOSIGNAL
+#else
+#define DL_SENDFLAG 0
+#endif
+#endif
+
 /* type definition -----------------------------------------------------------*/
 
 typedef struct {                    /* download path type */
@@ -38,6 +69,40 @@ typedef struct {                    /* download paths type */
     int n,nmax;                     /* number and max number of paths */
 } paths_t;
 
+typedef struct {                    /* download connection type */
+    socket_t sock;                  /* socket (ftp: control connection) */
+    int proto;                      /* protocol (0:ftp,1:http,-1:closed) */
+    char host[256];                 /* host address */
+    int port;                       /* port number */
+    char user[256];                 /* ftp login user */
+    char cwd[1024];                 /* ftp current directory */
+    unsigned int tick;              /* last used tick (ms) */
+    unsigned char buff[DL_BUFFSIZE]; /* receive buffer */
+    int nb,ib;                      /* receive buffer size and index */
+} dlconn_t;
+
+typedef struct {                    /* download engine type */
+    const paths_t *paths;           /* download paths */
+    const char *usr,*pwd,*proxy;    /* login user, password and proxy */
+    int opts;                       /* download options */
+    int next;                       /* index of next download path */
+    int *fin,nfin;                  /* indexes and number of finished paths */
+    char *stat;                     /* status of paths */
+    int n[4];                       /* number of {ok,no_file,skip,error} */
+    int nrun;                       /* number of running threads */
+    int abort;                      /* abort flag */
+    FILE *fp;                       /* log file pointer */
+    lock_t lock;                    /* lock flag */
+} dleng_t;
+
+typedef struct {                    /* download thread type */
+    dleng_t *eng;                   /* download engine */
+    thread_t thread;                /* thread */
+    dlconn_t conn[DL_NCONN];        /* kept connections */
+} dlthread_t;
+
+static int dl_nthread=DL_NTHREAD;   /* number of download threads */
+
 /* execute command with test timeout -----------------------------------------*/
 extern int execcmd_to(const char *cmd)
 {
@@ -319,7 +384,6 @@ static int get_list(const path_t *path, const char *usr, const char *pwd,
 {
     FILE *fp;
     char cmd[4096],env[1024]="",remot[1024],*opt="",*opt2="",*p;
-    int stat;
     
 #ifndef WIN32
     opt2=" -o /dev/null";
@@ -375,39 +439,522 @@ static int test_list(const path_t *path)
     fclose(fp);
     return 0;
 }
-/* execute download ----------------------------------------------------------*/
-static int exec_down(const path_t *path, char *remot_p, const char *usr,
-                     const char *pwd, const char *proxy, int opts, int *n,
-                     FILE *fp)
+/* get file size -------------------------------------------------------------*/
+static long size_file(const char *file)
 {
-    char dir[1024],errfile[1024],tmpfile[1024],cmd[4096],env[1024]="";
-    char opt[1024]="",*opt2="",*p;
-    int ret,proto;
+    FILE *fp;
+    long size;
     
-#ifndef WIN32
-    opt2=" 2> /dev/null";
+    if (!(fp=fopen(file,"rb"))) return 0;
+    fseek(fp,0,SEEK_END);
+    size=ftell(fp);
+    fclose(fp);
+    return size<0?0:size;
+}
+/* compare header field name (case insensitive) ------------------------------*/
+static char *cmp_field(const char *buff, const char *name)
+{
+    for (;*name;buff++,name++) {
+        if (tolower((int)*buff)!=*name) return NULL;
+    }
+    while (*buff==' '||*buff=='\t') buff++;
+    return (char *)buff;
+}
+/* encode base64 -------------------------------------------------------------*/
+static void encbase64(char *str, const unsigned char *byte, int n)
+{
+    const char table[]=
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int i,j,k,b;
+    
+    for (i=j=0;i/8<n;) {
+        for (k=b=0;k<6;k++,i++) {
+            b<<=1; if (i/8<n) b|=(byte[i/8]>>(7-i%8))&0x1;
+        }
+        str[j++]=table[b];
+    }
+    while (j&0x3) str[j++]='=';
+    str[j]='\0';
+}
+/* decode url ----------------------------------------------------------------*/
+static int decode_url(const char *url, char *host, int *port, char *path)
+{
+    char buff[1024],*p,*q;
+    int proto;
+    
+    if      (!strncmp(url,"ftp://" ,6)) proto=0;
+    else if (!strncmp(url,"http://",7)) proto=1;
+    else return -1;
+    
+    strcpy(buff,url+(proto==0?6:7));
+    
+    if ((p=strchr(buff,'/'))) {
+        strcpy(path,p);
+        *p='\0';
+    }
+    else strcpy(path,"/");
+    
+    if ((p=strrchr(buff,'@'))) p++; else p=buff;
+    
+    *port=proto==0?21:80;
+    if ((q=strchr(p,':'))) {
+        *q='\0';
+        *port=atoi(q+1);
+    }
+    strcpy(host,p);
+    return *host?proto:-1;
+}
+/* connect socket ------------------------------------------------------------*/
+static socket_t connect_sock(const char *host, int port, lock_t *lck)
+{
+    struct hostent *hp;
+    struct sockaddr_in addr;
+    socket_t sock;
+#ifdef WIN32
+    int tv=FTP_TIMEOUT*1000;
+#else
+    struct timeval tv={0};
+    
+    tv.tv_sec=FTP_TIMEOUT;
 #endif
-    strcpy(dir,path->local);
-    if ((p=strrchr(dir,FILEPATHSEP))) *p='\0';
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_port=htons((unsigned short)port);
     
-    if      (!strncmp(path->remot,"ftp://" ,6)) proto=0;
-    else if (!strncmp(path->remot,"http://",7)) proto=1;
-    else {
-        trace(2,"exec_down: invalid path %s\n",path->remot);
-        showmsg("STAT=X");
-        if (fp) fprintf(fp,"%s ERROR (INVALID PATH)\n",path->remot);
-        n[1]++;
+    /* gethostbyname() is not thread-safe */
+    lock(lck);
+    if (!(hp=gethostbyname(host))) {
+        unlock(lck);
+        trace(2,"connect_sock: gethostbyname error host=%s\n",host);
+        return (socket_t)-1;
+    }
+    memcpy(&addr.sin_addr,hp->h_addr_list[0],hp->h_length);
+    unlock(lck);
+    
+    if ((sock=socket(AF_INET,SOCK_STREAM,0))==(socket_t)-1) {
+        trace(2,"connect_sock: socket error\n");
+        return sock;
+    }
+    setsockopt(sock,SOL_SOCKET,SO_RCVTIMEO,(const char *)&tv,sizeof(tv));
+    setsockopt(sock,SOL_SOCKET,SO_SNDTIMEO,(const char *)&tv,sizeof(tv));
+    
+    if (connect(sock,(struct sockaddr *)&addr,sizeof(addr))==-1) {
+        trace(2,"connect_sock: connect error host=%s port=%d\n",host,port);
+        closesocket(sock);
+        return (socket_t)-1;
+    }
+    return sock;
+}
+/* close connection ----------------------------------------------------------*/
+static void close_conn(dlconn_t *conn)
+{
+    if (conn->proto<0) return;
+    closesocket(conn->sock);
+    conn->proto=-1;
+    conn->nb=conn->ib=0;
+    *conn->cwd='\0';
+}
+/* send string to connection -------------------------------------------------*/
+static int send_conn(dlconn_t *conn, const char *str)
+{
+    int n,len=(int)strlen(str);
+    
+    for (;len>0;str+=n,len-=n) {
+        if ((n=send(conn->sock,str,len,DL_SENDFLAG))<=0) return 0;
+    }
+    return 1;
+}
+/* fill receive buffer (1:ok,0:closed,-1:error) ------------------------------*/
+static int fill_conn(dlconn_t *conn)
+{
+    int n;
+    
+    if (conn->ib<conn->nb) return 1;
+    
+    conn->nb=conn->ib=0;
+    if ((n=recv(conn->sock,(char *)conn->buff,DL_BUFFSIZE,0))<=0) {
+        return n<0?-1:0;
+    }
+    conn->nb=n;
+    return 1;
+}
+/* receive line from connection ----------------------------------------------*/
+static int gets_conn(dlconn_t *conn, char *buff, int nmax)
+{
+    int c,n=0;
+    
+    for (;;) {
+        if (fill_conn(conn)<=0) return 0;
+        if ((c=conn->buff[conn->ib++])=='\n') break;
+        if (c!='\r'&&n<nmax-1) buff[n++]=(char)c;
+    }
+    buff[n]='\0';
+    return 1;
+}
+/* copy received data to file (n<0: until connection closed) -----------------*/
+static int copy_conn(dlconn_t *conn, FILE *fp, long n)
+{
+    int m,stat;
+    
+    while (n!=0) {
+        if ((stat=fill_conn(conn))<=0) return stat==0&&n<0;
+        m=conn->nb-conn->ib;
+        if (n>0&&m>n) m=(int)n;
+        if (fp&&fwrite(conn->buff+conn->ib,1,m,fp)!=(size_t)m) return 0;
+        conn->ib+=m;
+        if (n>0) n-=m;
+    }
+    return 1;
+}
+/* receive ftp reply ---------------------------------------------------------*/
+static int ftp_reply(dlconn_t *conn, char *reply)
+{
+    char buff[1024],line[1024];
+    
+    if (!gets_conn(conn,buff,sizeof(buff))||strlen(buff)<3) return -1;
+    
+    if (buff[3]=='-') { /* multi-line reply */
+        do {
+            if (!gets_conn(conn,line,sizeof(line))) return -1;
+        } while (strncmp(line,buff,3)||line[3]!=' ');
+    }
+    if (reply) strcpy(reply,buff);
+    return atoi(buff);
+}
+/* send ftp command and receive reply ----------------------------------------*/
+static int ftp_cmd(dlconn_t *conn, const char *cmd, char *reply)
+{
+    char buff[1104];
+    
+    sprintf(buff,"%s\r\n",cmd);
+    if (!send_conn(conn,buff)) return -1;
+    return ftp_reply(conn,reply);
+}
+/* login to ftp server -------------------------------------------------------*/
+static int ftp_login(dlconn_t *conn, const char *usr, const char *pwd)
+{
+    char cmd[1024];
+    int code;
+    
+    if (ftp_reply(conn,NULL)!=220) return 0;
+    
+    sprintf(cmd,"USER %s",*usr?usr:"anonymous");
+    if ((code=ftp_cmd(conn,cmd,NULL))==331) {
+        sprintf(cmd,"PASS %s",pwd);
+        code=ftp_cmd(conn,cmd,NULL);
+    }
+    if (code!=230&&code!=202) {
+        trace(2,"ftp_login: login error host=%s code=%d\n",conn->host,code);
         return 0;
     }
-    /* test local file existence */
-    if (!(opts&DLOPT_FORCE)&&test_file(path->local)) {
-        showmsg("STAT=.");
-        if (fp) fprintf(fp,"%s in %s\n",path->remot,dir);
-        n[2]++;
+    return ftp_cmd(conn,"TYPE I",NULL)==200;
+}
+/* get kept connection or open new connection --------------------------------*/
+static dlconn_t *get_conn(dlconn_t *conn, int proto, const char *host,
+                          int port, const char *usr, const char *pwd,
+                          lock_t *lck)
+{
+    int i,j=0;
+    
+    for (i=0;i<DL_NCONN;i++) {
+        if (conn[i].proto==proto&&conn[i].port==port&&
+            !strcmp(conn[i].host,host)&&!strcmp(conn[i].user,usr)) {
+            conn[i].tick=tickget();
+            return conn+i;
+        }
+        /* closed or least recently used connection */
+        if (conn[j].proto<0) continue;
+        if (conn[i].proto<0||(int)(conn[i].tick-conn[j].tick)<0) j=i;
+    }
+    close_conn(conn+j);
+    
+    if ((conn[j].sock=connect_sock(host,port,lck))==(socket_t)-1) {
+        return NULL;
+    }
+    conn[j].proto=proto;
+    conn[j].port=port;
+    strcpy(conn[j].host,host);
+    strcpy(conn[j].user,usr);
+    *conn[j].cwd='\0';
+    conn[j].nb=conn[j].ib=0;
+    conn[j].tick=tickget();
+    
+    if (proto==0&&!ftp_login(conn+j,usr,pwd)) {
+        close_conn(conn+j);
+        return NULL;
+    }
+    return conn+j;
+}
+/* replace downloaded file by partial file -----------------------------------*/
+static int rename_part(const char *part, const char *file)
+{
+    remove(file);
+    return !rename(part,file);
+}
+/* download by ftp (0:ok,1:no file,2:error) ----------------------------------*/
+static int down_ftp(dlconn_t *conns, lock_t *lck, const char *url,
+                    const char *usr, const char *pwd, const char *file,
+                    int *err)
+{
+    dlconn_t *conn,data;
+    FILE *fp;
+    char host[256],path[1024],dir[1024],part[1024],cmd[1100],reply[1024];
+    char *fname,*p;
+    long size;
+    int i,port,h[6],code,stat;
+    
+    if (decode_url(url,host,&port,path)!=0) {
+        *err=-1;
+        return 2;
+    }
+    strcpy(dir,path);
+    p=strrchr(dir,'/');
+    fname=path+(p-dir)+1;
+    if (p==dir) p++;
+    *p='\0';
+    
+    sprintf(part,"%s%s",file,DL_PART);
+    data.proto=-1;
+    
+    for (i=0;i<FTP_RETRY;i++) {
+        
+        if (!(conn=get_conn(conns,0,host,port,usr,pwd,lck))) {
+            *err=-1;
+            continue;
+        }
+        /* change directory */
+        if (strcmp(conn->cwd,dir)) {
+            sprintf(cmd,"CWD %s",dir);
+            if ((code=ftp_cmd(conn,cmd,NULL))==550) {
+                *err=code;
+                return 1;
+            }
+            if (code!=250) {
+                close_conn(conn);
+                *err=code;
+                continue;
+            }
+            strcpy(conn->cwd,dir);
+        }
+        /* enter passive mode */
+        if ((code=ftp_cmd(conn,"PASV",reply))!=227) {
+            close_conn(conn);
+            *err=code;
+            continue;
+        }
+        for (p=reply+3;*p;p++) {
+            if (isdigit((int)*p)&&sscanf(p,"%d,%d,%d,%d,%d,%d",h,h+1,h+2,h+3,
+                                         h+4,h+5)==6) break;
+        }
+        /* connect data connection to the control connection host */
+        if (!*p||(data.sock=connect_sock(host,h[4]*256+h[5],lck))==
+            (socket_t)-1) {
+            close_conn(conn);
+            *err=-1;
+            continue;
+        }
+        data.proto=0;
+        data.nb=data.ib=0;
+        
+        /* restart partially downloaded file */
+        if ((size=size_file(part))>0) {
+            sprintf(cmd,"REST %ld",size);
+            if (ftp_cmd(conn,cmd,NULL)!=350) size=0;
+        }
+        sprintf(cmd,"RETR %s",fname);
+        
+        if ((code=ftp_cmd(conn,cmd,NULL))==550) {
+            close_conn(&data);
+            *err=code;
+            return 1;
+        }
+        if (code!=150&&code!=125) {
+            close_conn(&data);
+            close_conn(conn);
+            *err=code;
+            continue;
+        }
+        if (!(fp=fopen(part,size>0?"ab":"wb"))) {
+            close_conn(&data);
+            close_conn(conn);
+            *err=-2;
+            return 2;
+        }
+        stat=copy_conn(&data,fp,-1);
+        fclose(fp);
+        close_conn(&data);
+        
+        if (!stat||((code=ftp_reply(conn,NULL))!=226&&code!=250)) {
+            close_conn(conn);
+            *err=-1;
+            continue;
+        }
+        if (!rename_part(part,file)) {
+            *err=-2;
+            return 2;
+        }
         return 0;
     }
-    showmsg("STAT=_");
+    return 2;
+}
+/* receive http message body -------------------------------------------------*/
+static int http_body(dlconn_t *conn, FILE *fp, long clen, int chunked)
+{
+    char buff[256];
+    long n;
     
+    if (!chunked) return copy_conn(conn,fp,clen);
+    
+    while (gets_conn(conn,buff,sizeof(buff))) {
+        if ((n=strtol(buff,NULL,16))<=0) {
+            
+            /* skip trailer */
+            while (gets_conn(conn,buff,sizeof(buff))) {
+                if (!*buff) return 1;
+            }
+            return 0;
+        }
+        if (!copy_conn(conn,fp,n)||!gets_conn(conn,buff,sizeof(buff))) break;
+    }
+    return 0;
+}
+/* generate http url by host, port and path (0:too long) ---------------------*/
+static int http_url(char *url, const char *host, int port, const char *path)
+{
+    if (strlen(host)>255||strlen(path)>749) { /* 7+255+1+11+749<1024 */
+        trace(2,"http url too long: host=%s path=%s\n",host,path);
+        return 0;
+    }
+    sprintf(url,"http://%.255s:%d%.749s",host,port,path);
+    return 1;
+}
+/* download by http (0:ok,1:no file,2:error) ---------------------------------*/
+static int down_http(dlconn_t *conns, lock_t *lck, const char *url,
+                     const char *usr, const char *pwd, const char *file,
+                     int *err)
+{
+    dlconn_t *conn;
+    FILE *fp;
+    char remot[1024],host[256],path[1024],part[1024],buff[1024],auth[1024];
+    char req[4096],*p,*q;
+    long size,clen;
+    int i=0,port,code,nredir=0,chunked,closed,stat;
+    
+    strcpy(remot,url);
+    sprintf(part,"%s%s",file,DL_PART);
+    
+    while (i<FTP_RETRY) {
+        
+        if (decode_url(remot,host,&port,path)!=1) {
+            *err=-1;
+            return 2;
+        }
+        if (!(conn=get_conn(conns,1,host,port,"","",lck))) {
+            *err=-1;
+            i++;
+            continue;
+        }
+        /* generate request with range for partially downloaded file */
+        p=req;
+        p+=sprintf(p,"GET %s HTTP/1.1\r\nHost: %s",path,host);
+        if (port!=80) p+=sprintf(p,":%d",port);
+        p+=sprintf(p,"\r\nUser-Agent: RTKLIB/%s\r\n",VER_RTKLIB);
+        if (*pwd) {
+            sprintf(buff,"%s:%s",usr,pwd);
+            encbase64(auth,(unsigned char *)buff,(int)strlen(buff));
+            p+=sprintf(p,"Authorization: Basic %s\r\n",auth);
+        }
+        if ((size=size_file(part))>0) {
+            p+=sprintf(p,"Range: bytes=%ld-\r\n",size);
+        }
+        sprintf(p,"\r\n");
+        
+        /* send request and receive status line */
+        if (!send_conn(conn,req)||!gets_conn(conn,buff,sizeof(buff))||
+            strncmp(buff,"HTTP/1.",7)||!(q=strchr(buff,' '))) {
+            
+            /* kept connection may be closed by server */
+            close_conn(conn);
+            *err=-1;
+            i++;
+            continue;
+        }
+        code=atoi(q+1);
+        closed=buff[7]=='0';
+        clen=code==204||code==304||code<200?0:-1;
+        chunked=0;
+        *remot='\0';
+        
+        /* receive header fields */
+        while ((stat=gets_conn(conn,buff,sizeof(buff)))&&*buff) {
+            if ((q=cmp_field(buff,"content-length:"))) {
+                clen=atol(q);
+            }
+            else if ((q=cmp_field(buff,"transfer-encoding:"))) {
+                chunked=cmp_field(q,"chunked")!=NULL;
+            }
+            else if ((q=cmp_field(buff,"connection:"))) {
+                closed=cmp_field(q,"close")!=NULL;
+            }
+            else if ((q=cmp_field(buff,"location:"))) {
+                if (*q!='/') strcpy(remot,q);
+                else if (!http_url(remot,host,port,q)) *remot='\0';
+            }
+        }
+        /* receive body to partial file or discard */
+        fp=NULL;
+        if (stat&&(code==200||code==206)&&!(fp=fopen(part,code==206?"ab":"wb"))) {
+            close_conn(conn);
+            *err=-2;
+            return 2;
+        }
+        if (stat) stat=http_body(conn,fp,clen,chunked);
+        if (fp) fclose(fp);
+        
+        if (!stat||closed||(clen<0&&!chunked)) close_conn(conn);
+        
+        if (!stat) { /* resume by range request */
+            if (!http_url(remot,host,port,path)) {
+                *err=-1;
+                return 2;
+            }
+            *err=-1;
+            i++;
+            continue;
+        }
+        if (code==200||code==206) {
+            if (!rename_part(part,file)) {
+                *err=-2;
+                return 2;
+            }
+            return 0;
+        }
+        if (code>=300&&code<400&&*remot&&nredir++<DL_MAXREDIR) continue;
+        
+        if (code==416&&size>0) { /* range not satisfiable */
+            remove(part);
+            if (!http_url(remot,host,port,path)) {
+                *err=-1;
+                return 2;
+            }
+            continue;
+        }
+        *err=code;
+        return code==404||code==410?1:2;
+    }
+    return 2;
+}
+/* download by external command (0:ok,1:no file,2:error) ---------------------*/
+static int down_cmd(const path_t *path, int proto, char *remot_p,
+                    const char *usr, const char *pwd, const char *proxy,
+                    int opts, int *err)
+{
+    char errfile[1024],cmd[4096],env[1024]="",opt[1024]="",*opt2="",*p;
+    int ret;
+    
+#ifndef WIN32
+    opt2=" 2> /dev/null";
+#endif
     /* get remote file list */
     if ((p=strrchr(path->remot,'/'))&&
         strncmp(path->remot,remot_p,p-path->remot)) {
@@ -418,17 +965,8 @@ static int exec_down(const path_t *path, char *remot_p, const char *usr,
     }
     /* test file in listing */
     if (proto==0&&!test_list(path)) {
-        showmsg("STAT=x");
-        if (fp) fprintf(fp,"%s NO_FILE\n",path->remot);
-        n[1]++;
-        return 0;
-    }
-    /* generate local directory recursively */
-    if (!mkdir_r(dir)) {
-        showmsg("STAT=X");
-        if (fp) fprintf(fp,"%s -> %s ERROR (LOCAL DIR)\n",path->remot,dir);
-        n[3]++;
-        return 0;
+        *err=0;
+        return 1;
     }
     /* proxy option */
     if (*proxy) {
@@ -451,49 +989,134 @@ static int exec_down(const path_t *path, char *remot_p, const char *usr,
         sprintf(cmd,"%s%s %s %s-t %d -T %d -O \"%s\" -o \"%s\"%s\n",env,FTP_CMD,
                 path->remot,opt,FTP_RETRY,FTP_TIMEOUT,path->local,errfile,opt2);
     }
-    if (fp) fprintf(fp,"%s -> %s",path->remot,dir);
-    
     /* execute download command */
     if ((ret=execcmd_to(cmd))) {
-        if ((proto==0&&ret==FTP_NOFILE)||
-            (proto==1&&ret==HTTP_NOFILE)) {
-            showmsg("STAT=x");
-            if (fp) fprintf(fp," NO_FILE\n");
-            n[1]++;
-        }
-        else {
-            trace(2,"exec_down: %s error %d\n",proto==0?"ftp":"http",ret);
-            showmsg("STAT=X");
-            if (fp) fprintf(fp," ERROR (%d)\n",ret);
-            n[3]++;
-        }
         remove(path->local);
         if (!(opts&DLOPT_HOLDERR)) {
             remove(errfile);
         }
-        return ret==2;
+        *err=ret;
+        return (proto==0&&ret==FTP_NOFILE)||(proto==1&&ret==HTTP_NOFILE)?1:2;
     }
     remove(errfile);
+    return 0;
+}
+/* execute download ------------------------------------------------------------
+* download a file and return status (0:ok,1:no file,2:skip,3:error) with status
+* character and log message
+*-----------------------------------------------------------------------------*/
+static int exec_down(const path_t *path, char *remot_p, const char *usr,
+                     const char *pwd, const char *proxy, int opts,
+                     dlconn_t *conn, lock_t *lck, char *stat, char *msg,
+                     int *quit)
+{
+    char dir[1024],tmpfile[1024],*p;
+    int ret,proto,err=0;
     
+    strcpy(dir,path->local);
+    if ((p=strrchr(dir,FILEPATHSEP))) *p='\0';
+    
+    if      (!strncmp(path->remot,"ftp://" ,6)) proto=0;
+    else if (!strncmp(path->remot,"http://",7)) proto=1;
+    else {
+        trace(2,"exec_down: invalid path %s\n",path->remot);
+        *stat='X';
+        sprintf(msg,"%s ERROR (INVALID PATH)\n",path->remot);
+        return 3;
+    }
+    /* test local file existence */
+    if (!(opts&DLOPT_FORCE)&&test_file(path->local)) {
+        *stat='.';
+        sprintf(msg,"%s in %s\n",path->remot,dir);
+        return 2;
+    }
+    /* generate local directory recursively */
+    if (!mkdir_r(dir)) {
+        *stat='X';
+        sprintf(msg,"%s -> %s ERROR (LOCAL DIR)\n",path->remot,dir);
+        return 3;
+    }
+    msg+=sprintf(msg,"%s -> %s",path->remot,dir);
+    
+    /* download by external command via proxy or by ftp/http client */
+    if (*proxy) {
+        ret=down_cmd(path,proto,remot_p,usr,pwd,proxy,opts,&err);
+        *quit=ret==2&&err==2;
+    }
+    else if (proto==0) {
+        ret=down_ftp(conn,lck,path->remot,usr,pwd,path->local,&err);
+    }
+    else {
+        ret=down_http(conn,lck,path->remot,usr,pwd,path->local,&err);
+    }
+    if (ret==1) {
+        *stat='x';
+        sprintf(msg," NO_FILE\n");
+        return 1;
+    }
+    if (ret==2) {
+        trace(2,"exec_down: %s error %d\n",proto==0?"ftp":"http",err);
+        *stat='X';
+        sprintf(msg," ERROR (%d)\n",err);
+        return 3;
+    }
     /* uncompress download file */
     if (!(opts&DLOPT_KEEPCMP)&&(p=strrchr(path->local,'.'))&&
         (!strcmp(p,".z")||!strcmp(p,".gz")||!strcmp(p,".zip")||
          !strcmp(p,".Z")||!strcmp(p,".GZ")||!strcmp(p,".ZIP"))) {
         
-        if (uncompress(path->local,tmpfile)) {
+        if (uncompress(path->local,tmpfile)>0) {
             remove(path->local);
         }
         else {
             trace(2,"exec_down: uncompress error\n");
-            showmsg("STAT=C");
-            if (fp) fprintf(fp," ERROR (UNCOMP)\n");
-            n[3]++;
-            return 0;
+            *stat='C';
+            sprintf(msg," ERROR (UNCOMP)\n");
+            return 3;
         }
     }
-    showmsg("STAT=o");
-    if (fp) fprintf(fp," OK\n");
-    n[0]++;
+    *stat='o';
+    sprintf(msg," OK\n");
+    return 0;
+}
+/* download thread -----------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI down_thread(void *arg)
+#else
+static void *down_thread(void *arg)
+#endif
+{
+    dlthread_t *th=(dlthread_t *)arg;
+    dleng_t *eng=th->eng;
+    char remot_p[1024]="",msg[4096],stat;
+    int i,ret,quit;
+    
+    for (i=0;i<DL_NCONN;i++) th->conn[i].proto=-1;
+    
+    for (;;) {
+        lock(&eng->lock);
+        i=eng->abort?eng->paths->n:eng->next++;
+        unlock(&eng->lock);
+        
+        if (i>=eng->paths->n) break;
+        
+        quit=0;
+        ret=exec_down(eng->paths->path+i,remot_p,eng->usr,eng->pwd,eng->proxy,
+                      eng->opts,th->conn,&eng->lock,&stat,msg,&quit);
+        
+        lock(&eng->lock);
+        eng->n[ret]++;
+        eng->stat[i]=stat;
+        eng->fin[eng->nfin++]=i;
+        if (quit) eng->abort=1;
+        if (eng->fp) fputs(msg,eng->fp);
+        unlock(&eng->lock);
+    }
+    for (i=0;i<DL_NCONN;i++) close_conn(th->conn+i);
+    
+    lock(&eng->lock);
+    eng->nrun--;
+    unlock(&eng->lock);
     return 0;
 }
 /* test local file -----------------------------------------------------------*/
@@ -502,7 +1125,7 @@ static int test_local(gtime_t ts, gtime_t te, double ti, const char *path,
                       FILE *fp)
 {
     gtime_t time;
-    char remot[1024],remot_p[1024],dir_t[1024],local[1024],str[1024];
+    char remot[1024],dir_t[1024],local[1024],str[1024];
     int stat,abort=0;
     
     for (time=ts;timediff(time,te)<=1E-3;time=timeadd(time,ti)) {
@@ -701,6 +1324,12 @@ extern int dl_readstas(const char *file, char **stas, int nmax)
 *          FILE   *fp       IO  log file pointer (NULL: no output log)
 * return : status (1:ok,0:error,-1:aborted)
 * notes  : urls should be read by using dl_readurl()
+*          files are downloaded by concurrent threads set by dl_setthread().
+*          ftp/http connections are kept alive in a thread and reused for
+*          the same host. a file is downloaded to <local>.part at first and
+*          renamed after completion. an interrupted download is resumed by
+*          ftp REST or http Range request. if proxy is set, the external
+*          command (wget) is used instead of the ftp/http client.
 *-----------------------------------------------------------------------------*/
 extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
                    const url_t *urls, int nurl, char **stas, int nsta,
@@ -709,9 +1338,14 @@ extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
 {
     paths_t paths={0};
     gtime_t ts_p={0};
-    char str[2048],remot_p[1024]="";
-    int i,n[4]={0};
+    dleng_t eng={0};
+    dlthread_t *th;
+    char str[2048];
+    int i,j,k=0,nthread,nfin,nrun;
     unsigned int tick=tickget();
+#ifdef WIN32
+    WSADATA data;
+#endif
     
     showmsg("STAT=_");
     
@@ -733,27 +1367,100 @@ extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
         sprintf(msg,"no download data");
         return 0;
     }
-    for (i=0;i<paths.n;i++) {
-        
-        sprintf(str,"%s->%s (%d/%d)",paths.path[i].remot,paths.path[i].local,i+1,
-                paths.n);
-        if (showmsg(str)) break;
-        
-        /* execute download */
-        if (exec_down(paths.path+i,remot_p,usr,pwd,proxy,opts,n,fp)) {
+    /* external command via proxy uses the common listing file */
+    nthread=*proxy?1:(dl_nthread<paths.n?dl_nthread:paths.n);
+    
+    eng.paths=&paths;
+    eng.usr=usr; eng.pwd=pwd; eng.proxy=proxy;
+    eng.opts=opts;
+    eng.fp=fp;
+    eng.fin=imat(paths.n,1);
+    eng.stat=(char *)malloc(paths.n);
+    th=(dlthread_t *)malloc(sizeof(dlthread_t)*nthread);
+    
+    if (!eng.fin||!eng.stat||!th) {
+        free(eng.fin); free(eng.stat); free(th);
+        free_path(&paths);
+        sprintf(msg,"memory allocation error");
+        return 0;
+    }
+    initlock(&eng.lock);
+#ifdef WIN32
+    WSAStartup(MAKEWORD(2,0),&data);
+#endif
+    /* start download threads */
+    for (i=0;i<nthread;i++) {
+        th[i].eng=&eng;
+#ifdef WIN32
+        if (!(th[i].thread=CreateThread(NULL,0,down_thread,th+i,0,NULL))) {
+#else
+        if (pthread_create(&th[i].thread,NULL,down_thread,th+i)) {
+#endif
             break;
         }
+        eng.nrun++;
+    }
+    if ((nthread=i)<=0) {
+        free(eng.fin); free(eng.stat); free(th);
+        free_path(&paths);
+        sprintf(msg,"download thread error");
+        return 0;
+    }
+    /* show status of finished downloads until all threads exit */
+    do {
+        lock(&eng.lock);
+        nfin=eng.nfin;
+        nrun=eng.nrun;
+        unlock(&eng.lock);
+        
+        for (;k<nfin;k++) {
+            j=eng.fin[k];
+            sprintf(str,"%s->%s (%d/%d)",paths.path[j].remot,
+                    paths.path[j].local,k+1,paths.n);
+            showmsg(str);
+            sprintf(str,"STAT=%c",eng.stat[j]);
+            showmsg(str);
+        }
+        if (showmsg("")) {
+            lock(&eng.lock);
+            eng.abort=1;
+            unlock(&eng.lock);
+        }
+        if (nrun>0) sleepms(10);
+    } while (nrun>0);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(th[i].thread,INFINITE);
+        CloseHandle(th[i].thread);
+#else
+        pthread_join(th[i].thread,NULL);
+#endif
     }
+#ifdef WIN32
+    WSACleanup();
+#endif
     if (!(opts&DLOPT_HOLDLST)) {
         remove(FTP_LISTING);
     }
-    sprintf(msg,"OK=%d No_File=%d Skip=%d Error=%d (Time=%.1f s)",n[0],n[1],n[2],
-            n[3],(tickget()-tick)*0.001);
+    sprintf(msg,"OK=%d No_File=%d Skip=%d Error=%d (Time=%.1f s)",eng.n[0],
+            eng.n[1],eng.n[2],eng.n[3],(tickget()-tick)*0.001);
     
+    free(eng.fin); free(eng.stat); free(th);
     free_path(&paths);
     
     return 1;
 }
+/* set number of download threads ----------------------------------------------
+* set number of download threads for dl_exec()
+* args   : int    nthread   I   number of download threads (1-32)
+* return : none
+* notes  : downloads are executed by a thread if proxy server address is set
+*-----------------------------------------------------------------------------*/
+extern void dl_setthread(int nthread)
+{
+    dl_nthread=nthread<1?1:(nthread>DL_MAXTHREAD?DL_MAXTHREAD:nthread);
+}
 /* execute local file test -----------------------------------------------------
 * execute local file test
 * args   : gtime_t ts,te    I   time start and end
@@ -773,7 +1480,6 @@ extern void dl_test(gtime_t ts, gtime_t te, double ti, const url_t *urls,
                     int ncol, int datefmt, FILE *fp)
 {
     gtime_t time;
-    double tow;
     char year[32],date[32],date_p[32];
     int i,j,n,m,*nc,*nt,week,flag,abort=0;
     
@@ -3,30 +3,272 @@
 *
 *          Copyright (C) 2007-2009 by T.TAKASU, All rights reserved.
 *
+* options : -DWIN32    use WIN32 API
+*
 * reference :
 *     [1] EGM96 The NASA GSFC and NIMA Joint Geopotential Model
 *     [2] Earth Gravitational Model 2008 (EGM2008)
+*     [3] R.G.Keys, Cubic convolution interpolation for digital image
+*         processing, IEEE Trans. on Acoustics, Speech and Signal Processing,
+*         29(6), 1981
 *
 * version : $Revision: 1.1 $ $Date: 2008/07/17 21:48:06 $
 * history : 2007/01/07 1.0  new
 *           2009/09/04 1.1  replace geoid data by global model
 *           2009/12/05 1.2  added api:
 *                               opengeoid(),closegeoid()
+*           2026/10/18 1.3  geoid model files are memory-mapped instead of
+*                           read by fseek()/fread() for each grid point
+*                           gsi geoid model is loaded to float grid on open
+*                           geoidh() is thread-safe for open geoid model
+*                           add bicubic interpolation
+*                           added api:
+*                               geoidinterp()
 *-----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 199309
 #include "rtklib.h"
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 static const char rcsid[]="$Id: geoid.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $";
 
+#define GSI_NF      28          /* gsi geoid: number of fields per line */
+#define GSI_WF      9           /* gsi geoid: width of field */
+#define GSI_NL      (GSI_NF*GSI_WF+2) /* gsi geoid: length of line (bytes) */
+
+typedef struct {                /* geoid grid type */
+    double lon0,lat0;           /* longitude/latitude of first grid (deg) */
+    double dlon,dlat;           /* longitude/latitude interval (deg) */
+    int nlon,nlat;              /* number of longitude/latitude grids */
+    int wrap;                   /* wrap-around of longitude (0:no,1:yes) */
+} grid_t;
+
 static const double range[4];       /* embedded geoid area range {W,E,S,N} (deg) */
 static const float geoid[361][181]; /* embedded geoid heights (m) (lon x lat) */
-static FILE *fp_geoid=NULL;         /* geoid file pointer */
 static int model_geoid=GEOID_EMBEDDED; /* geoid model */
+static int interp_geoid=0;          /* interpolation (0:bilinear,1:bicubic) */
+static const unsigned char *data_geoid=NULL; /* geoid file image */
+static size_t size_geoid=0;         /* size of geoid file image (bytes) */
+static float *data_gsi=NULL;        /* gsi geoid heights (lon x lat) (m) */
+#ifdef WIN32
+static HANDLE hmap_geoid=NULL;      /* geoid file mapping handle */
+#endif
+
+/* geoid grid definitions ----------------------------------------------------*/
+static const grid_t grid_emb   ={  0.0,-90.0,1.0    , 1.0    ,  361,  181,0};
+static const grid_t grid_egm96 ={  0.0, 90.0,15.0/60,-15.0/60, 1440,  721,1};
+static const grid_t grid_egm25 ={  0.0, 90.0,2.5/60 ,-2.5/60 , 8640, 4321,1};
+static const grid_t grid_egm10 ={  0.0, 90.0,1.0/60 ,-1.0/60 ,21600,10801,1};
+static const grid_t grid_gsi   ={120.0, 20.0,1.5/60 , 1.0/60 , 1201, 1801,0};
 
+/* map geoid file to memory --------------------------------------------------*/
+static int mapfile(const char *file)
+{
+#ifdef WIN32
+    HANDLE hfile;
+    DWORD size;
+    
+    hfile=CreateFile(file,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL,NULL);
+    if (hfile==INVALID_HANDLE_VALUE) return 0;
+    
+    size=GetFileSize(hfile,NULL);
+    
+    if (size==INVALID_FILE_SIZE||size==0||
+        !(hmap_geoid=CreateFileMapping(hfile,NULL,PAGE_READONLY,0,0,NULL))) {
+        CloseHandle(hfile);
+        return 0;
+    }
+    CloseHandle(hfile);
+    
+    if (!(data_geoid=(const unsigned char *)MapViewOfFile(hmap_geoid,
+                                                FILE_MAP_READ,0,0,0))) {
+        CloseHandle(hmap_geoid);
+        hmap_geoid=NULL;
+        return 0;
+    }
+    size_geoid=(size_t)size;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+    
+    if ((fd=open(file,O_RDONLY))<0) return 0;
+    
+    if (fstat(fd,&st)<0||st.st_size<=0) {
+        close(fd);
+        return 0;
+    }
+    p=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+    
+    if (p==MAP_FAILED) return 0;
+    
+    data_geoid=(const unsigned char *)p;
+    size_geoid=(size_t)st.st_size;
+#endif
+    return 1;
+}
+/* unmap geoid file ----------------------------------------------------------*/
+static void unmapfile(void)
+{
+    if (!data_geoid) return;
+#ifdef WIN32
+    UnmapViewOfFile((LPCVOID)data_geoid);
+    CloseHandle(hmap_geoid);
+    hmap_geoid=NULL;
+#else
+    munmap((void *)data_geoid,size_geoid);
+#endif
+    data_geoid=NULL;
+    size_geoid=0;
+}
+/* load gsi geoid data to float grid -----------------------------------------*/
+static int loadgsi(void)
+{
+    const grid_t *g=&grid_gsi;
+    const int nr=(g->nlon-1)/GSI_NF+1;
+    char buff[GSI_WF+1];
+    size_t off;
+    int i,j;
+    
+    if (size_geoid<(size_t)GSI_NL*(1+(size_t)nr*g->nlat)-2) {
+        trace(2,"gsi geoid data size error: size=%lu\n",(unsigned long)size_geoid);
+        return 0;
+    }
+    if (!(data_gsi=(float *)malloc(sizeof(float)*g->nlon*g->nlat))) {
+        return 0;
+    }
+    buff[GSI_WF]='\0';
+    
+    for (j=0;j<g->nlat;j++) for (i=0;i<g->nlon;i++) {
+        off=GSI_NL+((size_t)j*nr+i/GSI_NF)*GSI_NL+i%GSI_NF*GSI_WF;
+        memcpy(buff,data_geoid+off,GSI_WF);
+        data_gsi[i+j*g->nlon]=(float)atof(buff);
+    }
+    return 1;
+}
+/* get grid definition of geoid model ----------------------------------------*/
+static const grid_t *getgrid(int model)
+{
+    switch (model) {
+        case GEOID_EMBEDDED   : return &grid_emb;
+        case GEOID_EGM96_M150 : return &grid_egm96;
+        case GEOID_EGM2008_M25: return &grid_egm25;
+        case GEOID_EGM2008_M10: return &grid_egm10;
+        case GEOID_GSI2000_M15: return &grid_gsi;
+    }
+    return NULL;
+}
+/* geoid height at grid point ------------------------------------------------*/
+static double gridval(int model, const grid_t *g, long i, long j)
+{
+    const unsigned char *p;
+    size_t off;
+    float v;
+    
+    switch (model) {
+        case GEOID_EMBEDDED:
+            return geoid[i][j];
+            
+        case GEOID_EGM96_M150: /* 2 byte signed integer (big-endian) (cm) */
+            off=2*((size_t)i+(size_t)j*g->nlon);
+            if (off+2>size_geoid) break;
+            p=data_geoid+off;
+            return (short)((p[0]<<8)+p[1])*0.01;
+            
+        case GEOID_EGM2008_M25:
+        case GEOID_EGM2008_M10: /* 4 byte float (cpu byte-order) (m) */
+            
+            /* notes: 4byte-zeros are inserted at first and last field of a */
+            /*        record for current geoid data files (2009/12/10) */
+            /* http://earth-info.nga.mil/GandG/wgs84/gravitymod/egm2008/egm08_wgs84.html */
+            /* (1) Und_min1x1_egm2008_isw=82_WGS84_TideFree_SE.gz */
+            /* (2) Und_min2.5x2.5_egm2008_isw=82_WGS84_TideFree_SE.gz */
+            off=4*((size_t)i+(size_t)j*(g->nlon+2)+1);
+            if (off+4>size_geoid) break;
+            memcpy(&v,data_geoid+off,4);
+            return v;
+            
+        case GEOID_GSI2000_M15:
+            return data_gsi[i+j*g->nlon];
+    }
+    trace(2,"geoid data file range error: i=%ld j=%ld\n",i,j);
+    return 0.0;
+}
+/* index of grid point (wrap-around in longitude or clipped) -----------------*/
+static long gridlon(const grid_t *g, long i)
+{
+    if (g->wrap) return (i%g->nlon+g->nlon)%g->nlon;
+    return i<0?0:(i>g->nlon-1?g->nlon-1:i);
+}
+static long gridlat(const grid_t *g, long j)
+{
+    return j<0?0:(j>g->nlat-1?g->nlat-1:j);
+}
 /* bilinear interpolation ----------------------------------------------------*/
 static double interpb(const double *y, double a, double b)
 {
     return y[0]*(1.0-a)*(1.0-b)+y[1]*a*(1.0-b)+y[2]*(1.0-a)*b+y[3]*a*b;
 }
+/* cubic convolution kernel weights (ref [3]) --------------------------------*/
+static void cubicw(double a, double *w)
+{
+    w[0]=((-0.5*a+1.0)*a-0.5)*a;
+    w[1]=(1.5*a-2.5)*a*a+1.0;
+    w[2]=((-1.5*a+2.0)*a+0.5)*a;
+    w[3]=(0.5*a-0.5)*a*a;
+}
+/* interpolate geoid height on grid ------------------------------------------*/
+static double interpgrid(int model, const double *pos)
+{
+    const grid_t *g=getgrid(model);
+    double a,b,y[16],wa[4],wb[4],h=0.0;
+    long i1,j1,ii[4],jj[4];
+    int i,j;
+    
+    a=(pos[1]-g->lon0)/g->dlon;
+    b=(pos[0]-g->lat0)/g->dlat;
+    i1=(long)a; a-=i1;
+    j1=(long)b; b-=j1;
+    
+    if (!interp_geoid) { /* bilinear */
+        ii[0]=i1; ii[1]=gridlon(g,i1+1);
+        jj[0]=j1; jj[1]=gridlat(g,j1+1);
+        y[0]=gridval(model,g,ii[0],jj[0]);
+        y[1]=gridval(model,g,ii[1],jj[0]);
+        y[2]=gridval(model,g,ii[0],jj[1]);
+        y[3]=gridval(model,g,ii[1],jj[1]);
+        if (model==GEOID_GSI2000_M15&&
+            (y[0]==999.0||y[1]==999.0||y[2]==999.0||y[3]==999.0)) {
+            trace(2,"geoidh_gsi: data outage (lat=%.3f lon=%.3f)\n",pos[0],pos[1]);
+            return 0.0;
+        }
+        return interpb(y,a,b);
+    }
+    /* bicubic */
+    for (i=0;i<4;i++) {
+        ii[i]=gridlon(g,i1-1+i);
+        jj[i]=gridlat(g,j1-1+i);
+    }
+    for (i=0;i<16;i++) {
+        y[i]=gridval(model,g,ii[i%4],jj[i/4]);
+        if (model==GEOID_GSI2000_M15&&y[i]==999.0) {
+            trace(2,"geoidh_gsi: data outage (lat=%.3f lon=%.3f)\n",pos[0],pos[1]);
+            return 0.0;
+        }
+    }
+    cubicw(a,wa);
+    cubicw(b,wb);
+    for (j=0;j<4;j++) for (i=0;i<4;i++) {
+        h+=wa[i]*wb[j]*y[i+j*4];
+    }
+    return h;
+}
 /* embedded geoid model ------------------------------------------------------*/
 static double geoidh_emb(const double *pos)
 {
@@ -38,6 +280,8 @@ static double geoidh_emb(const double *pos)
         trace(2,"out of geoid model range: lat=%.3f lon=%.3f\n",pos[0],pos[1]);
         return 0.0;
     }
+    if (interp_geoid) return interpgrid(GEOID_EMBEDDED,pos);
+    
     a=(pos[1]-range[0])/dlon;
     b=(pos[0]-range[2])/dlat;
     i1=(int)a; a-=i1; i2=i1<360?i1+1:i1;
@@ -48,136 +292,30 @@ static double geoidh_emb(const double *pos)
     y[3]=geoid[i2][j2];
     return interpb(y,a,b);
 }
-/* get 2 byte signed integer from file ---------------------------------------*/
-static short fget2b(FILE *fp, long off)
-{
-    unsigned char v[2];
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(v,2,1,fp)<1) {
-        trace(2,"geoid data file range error: off=%ld\n",off);
-    }
-    return ((short)v[0]<<8)+v[1]; /* big-endian */
-}
 /* egm96 15x15" model --------------------------------------------------------*/
 static double geoidh_egm96(const double *pos)
 {
-    const double lon0=0.0,lat0=90.0,dlon=15.0/60.0,dlat=-15.0/60.0;
-    const int nlon=1440,nlat=721;
-    double a,b,y[4];
-    long i1,i2,j1,j2;
-    
-    if (!fp_geoid) return 0.0;
+    if (!data_geoid) return 0.0;
     
-    a=(pos[1]-lon0)/dlon;
-    b=(pos[0]-lat0)/dlat;
-    i1=(long)a; a-=i1; i2=i1<nlon-1?i1+1:0;
-    j1=(long)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fget2b(fp_geoid,2L*(i1+j1*nlon))*0.01;
-    y[1]=fget2b(fp_geoid,2L*(i2+j1*nlon))*0.01;
-    y[2]=fget2b(fp_geoid,2L*(i1+j2*nlon))*0.01;
-    y[3]=fget2b(fp_geoid,2L*(i2+j2*nlon))*0.01;
-    return interpb(y,a,b);
-}
-/* get 4byte float from file -------------------------------------------------*/
-static float fget4f(FILE *fp, long off)
-{
-    float v=0.0;
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(&v,4,1,fp)<1) {
-        trace(2,"geoid data file range error: off=%ld\n",off);
-    }
-    return v; /* small-endian */
+    return interpgrid(GEOID_EGM96_M150,pos);
 }
 /* egm2008 model -------------------------------------------------------------*/
 static double geoidh_egm08(const double *pos, int model)
 {
-    const double lon0=0.0,lat0=90.0;
-    double dlon,dlat;
-    double a,b,y[4];
-    long i1,i2,j1,j2;
-    int nlon,nlat;
-    
-    if (!fp_geoid) return 0.0;
-    
-    if (model==GEOID_EGM2008_M25) { /* 2.5 x 2.5" grid */
-        dlon= 2.5/60.0;
-        dlat=-2.5/60.0;
-        nlon=8640;
-        nlat=4321;
-    }
-    else { /* 1 x 1" grid */
-        dlon= 1.0/60.0;
-        dlat=-1.0/60.0;
-        nlon=21600;
-        nlat=10801;
-    }
-    a=(pos[1]-lon0)/dlon;
-    b=(pos[0]-lat0)/dlat;
-    i1=(long)a; a-=i1; i2=i1<nlon-1?i1+1:0;
-    j1=(long)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    
-    /* notes: 4byte-zeros are inserted at first and last field of a record */
-    /*        for current geid data files */
-    /* http://earth-info.nga.mil/GandG/wgs84/gravitymod/egm2008/egm08_wgs84.html */
-    /* (1) Und_min1x1_egm2008_isw=82_WGS84_TideFree_SE.gz */
-    /* (2) Und_min2.5x2.5_egm2008_isw=82_WGS84_TideFree_SE.gz */
-#if 0
-    /* not zero-inserted */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon)));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon)));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon)));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon)));
-#else
-    /* zero-inserted version (2009/12/10) */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon+2)+1));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon+2)+1));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon+2)+1));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon+2)+1));
-#endif
-    return interpb(y,a,b);
-}
-/* get gsi geoid data --------------------------------------------------------*/
-static double fgetgsi(FILE *fp, int nlon, int nlat, int i, int j)
-{
-    const int nf=28,wf=9,nl=nf*wf+2,nr=(nlon-1)/nf+1;
-    double v;
-    long off=nl+j*nr*nl+i/nf*nl+i%nf*wf;
-    char buff[16]="";
+    if (!data_geoid) return 0.0;
     
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(buff,wf,1,fp)<1) {
-        trace(2,"out of range for gsi geoid: i=%d j=%d\n",i,j);
-        return 0.0;
-    }
-    if (sscanf(buff,"%lf",&v)<1) {
-        trace(2,"gsi geoid data format error: i=%d j=%d buff=%s\n",i,j,buff);
-        return 0.0;
-    }
-    return v;
+    return interpgrid(model,pos);
 }
 /* gsi geoid 2000 1.0x1.5" model ---------------------------------------------*/
 static double geoidh_gsi(const double *pos)
 {
     const double lon0=120.0,lon1=150.0,lat0=20.0,lat1=50.0;
-    const double dlon=1.5/60.0,dlat=1.0/60.0;
-    const int nlon=1201,nlat=1801;
-    double a,b,y[4];
-    int i1,i2,j1,j2;
     
-    if (!fp_geoid||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
+    if (!data_gsi||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
         trace(2,"out of range for gsi geoid: lat=%.3f lon=%.3f\n",pos[0],pos[1]);
         return 0.0;
     }
-    a=(pos[1]-lon0)/dlon;
-    b=(pos[0]-lat0)/dlat;
-    i1=(int)a; a-=i1; i2=i1<nlon-1?i1+1:i1;
-    j1=(int)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fgetgsi(fp_geoid,nlon,nlat,i1,j1);
-    y[1]=fgetgsi(fp_geoid,nlon,nlat,i2,j1);
-    y[2]=fgetgsi(fp_geoid,nlon,nlat,i1,j2);
-    y[3]=fgetgsi(fp_geoid,nlon,nlat,i2,j2);
-    if (y[0]==999.0||y[1]==999.0||y[2]==999.0||y[3]==999.0) {
-        trace(2,"geoidh_gsi: data outage (lat=%.3f lon=%.3f)\n",pos[0],pos[1]);
-        return 0.0;
-    }
-    return interpb(y,a,b);
+    return interpgrid(GEOID_GSI2000_M15,pos);
 }
 /* open geoid model file -------------------------------------------------------
 * open geoid model file
@@ -195,6 +333,8 @@ static double geoidh_gsi(const double *pos)
 *          Und_min1x1_egm2008_isw=82_WGS84_TideFree_SE    : EGM2008 1.0x1.0"
 *          gsigeome_ver4 : GSI geoid 2000 1.0x1.5" (japanese area)
 *          (byte-order of binary files must be compatible to cpu)
+*          binary geoid model files are mapped to memory. gsi geoid model is
+*          loaded to memory.
 *-----------------------------------------------------------------------------*/
 extern int opengeoid(int model, const char *file)
 {
@@ -209,10 +349,18 @@ extern int opengeoid(int model, const char *file)
         trace(2,"invalid geoid model: model=%d file=%s\n",model,file);
         return 0;
     }
-    if (!(fp_geoid=fopen(file,"rb"))) {
+    if (!mapfile(file)) {
         trace(2,"geoid model file open error: model=%d file=%s\n",model,file);
         return 0;
     }
+    if (model==GEOID_GSI2000_M15) {
+        if (!loadgsi()) {
+            trace(2,"gsi geoid model load error: file=%s\n",file);
+            unmapfile();
+            return 0;
+        }
+        unmapfile();
+    }
     model_geoid=model;
     return 1;
 }
@@ -225,10 +373,22 @@ extern void closegeoid(void)
 {
     trace(3,"closegoid:\n");
     
-    if (fp_geoid) fclose(fp_geoid);
-    fp_geoid=NULL;
+    unmapfile();
+    free(data_gsi); data_gsi=NULL;
     model_geoid=GEOID_EMBEDDED;
 }
+/* set geoid interpolation -----------------------------------------------------
+* set interpolation method of geoid height
+* args   : int    opt       I   interpolation (0:bilinear,1:bicubic)
+* return : none
+* notes  : bilinear interpolation is used by default
+*-----------------------------------------------------------------------------*/
+extern void geoidinterp(int opt)
+{
+    trace(3,"geoidinterp: opt=%d\n",opt);
+    
+    interp_geoid=opt;
+}
 /* geoid height ----------------------------------------------------------------
 * get geoid height from geoid model
 * args   : double *pos      I   geodetic position {lat,lon} (rad)
@@ -236,6 +396,7 @@ extern void closegeoid(void)
 * notes  : to use external geoid model, call function opengeoid() to open
 *          geoid model before calling the function. If the external geoid model
 *          is not open, the function uses embedded geoid model.
+*          the function is thread-safe while the geoid model is opened.
 *-----------------------------------------------------------------------------*/
 extern double geoidh(const double *pos)
 {
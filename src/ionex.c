@@ -15,6 +15,10 @@
 *           2013/03/05 1.1 change api readtec()
 *                          fix problem in case of lat>85deg or lat<-85deg
 *           2014/02/22 1.2 fix problem on compiled as C++
+*           2026/10/18 1.3 search tec grid data by binary search in iontec()
+*                          share ionospheric pierce points of bracketing tec grid
+*                          added api:
+*                              iontecs()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -411,49 +415,91 @@ static int iondelay(gtime_t time, const tec_t *tec, const double *pos,
     
     return 1;
 }
-/* ionosphere model by tec grid data -------------------------------------------
-* compute ionospheric delay by tec grid data
-* args   : gtime_t time     I   time (gpst)
-*          nav_t  *nav      I   navigation data
-*          double *pos      I   receiver position {lat,lon,h} (rad,m)
-*          double *azel     I   azimuth/elevation angle {az,el} (rad)
-*          int    opt       I   model option
-*                                bit0: 0:earth-fixed,1:sun-fixed
-*                                bit1: 0:single-layer,1:modified single-layer
-*          double *delay    O   ionospheric delay (L1) (m)
-*          double *var      O   ionospheric dealy (L1) variance (m^2)
-* return : status (1:ok,0:error)
-* notes  : before calling the function, read tec grid data by calling readtec()
-*          return ok with delay=0 and var=VAR_NOTEC if el<MIN_EL or h<MIN_HGT
-*-----------------------------------------------------------------------------*/
-extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
-                  const double *azel, int opt, double *delay, double *var)
+/* ionosphere delay by two tec grid data with same layers --------------------*/
+static void iondelay2(gtime_t time, const tec_t *tec, const double *pos,
+                      const double *azel, int opt, double *delay, double *var,
+                      int *stat)
 {
-    double dels[2],vars[2],a,tt;
-    int i,stat[2];
+    const double fact=40.30E16/FREQ1/FREQ1; /* tecu->L1 iono (m) */
+    double fs,posp[3]={0},posq[3]={0},vtec,rms,hion,rp;
+    int i,j;
     
-    trace(3,"iontec  : time=%s pos=%.1f %.1f azel=%.1f %.1f\n",time_str(time,0),
-          pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
+    if (tec[0].rb!=tec[1].rb||tec[0].ndata[2]!=tec[1].ndata[2]||
+        tec[0].hgts[0]!=tec[1].hgts[0]||tec[0].hgts[2]!=tec[1].hgts[2]) {
+        stat[0]=iondelay(time,tec  ,pos,azel,opt,delay  ,var  );
+        stat[1]=iondelay(time,tec+1,pos,azel,opt,delay+1,var+1);
+        return;
+    }
+    trace(3,"iondelay2: time=%s pos=%.1f %.1f azel=%.1f %.1f\n",
+          time_str(time,0),pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
     
-    if (azel[1]<MIN_EL||pos[2]<MIN_HGT) {
-        *delay=0.0;
-        *var=VAR_NOTEC;
-        return 1;
+    for (j=0;j<2;j++) {
+        delay[j]=var[j]=0.0;
+        stat[j]=1;
     }
-    for (i=0;i<nav->nt;i++) {
-        if (timediff(nav->tec[i].time,time)>0.0) break;
+    for (i=0;i<tec->ndata[2];i++) { /* for a layer */
+        
+        hion=tec->hgts[0]+tec->hgts[2]*i;
+        
+        /* ionospheric pierce point position shared by two tec grid data */
+        fs=ionppp(pos,azel,tec->rb,hion,posp);
+        
+        if (opt&2) {
+            /* modified single layer mapping function (M-SLM) ref [2] */
+            rp=tec->rb/(tec->rb+hion)*sin(0.9782*(PI/2.0-azel[1]));
+            fs=1.0/sqrt(1.0-rp*rp);
+        }
+        for (j=0;j<2;j++) {
+            if (!stat[j]) continue;
+            
+            posq[0]=posp[0];
+            posq[1]=posp[1];
+            if (opt&1) {
+                /* earth rotation correction (sun-fixed coordinate) */
+                posq[1]+=2.0*PI*timediff(time,tec[j].time)/86400.0;
+            }
+            /* interpolate tec grid data */
+            if (!interptec(tec+j,i,posq,&vtec,&rms)) {
+                stat[j]=0;
+                continue;
+            }
+            delay[j]+=fact*fs*vtec;
+            var[j]+=fact*fact*fs*fs*rms*rms;
+        }
+    }
+    for (j=0;j<2;j++) if (!stat[j]) delay[j]=var[j]=0.0;
+}
+/* search tec grid data by time ----------------------------------------------*/
+static int searchtec(gtime_t time, const nav_t *nav)
+{
+    int i=0,j=nav->nt,k;
+    
+    /* binary search of first tec grid data after time */
+    while (i<j) {
+        k=(i+j)/2;
+        if (timediff(nav->tec[k].time,time)>0.0) j=k; else i=k+1;
     }
     if (i==0||i>=nav->nt) {
         trace(2,"%s: tec grid out of period\n",time_str(time,0));
         return 0;
     }
-    if ((tt=timediff(nav->tec[i].time,nav->tec[i-1].time))==0.0) {
+    if (timediff(nav->tec[i].time,nav->tec[i-1].time)==0.0) {
         trace(2,"tec grid time interval error\n");
         return 0;
     }
+    return i;
+}
+/* ionosphere delay by bracketing tec grid data ------------------------------*/
+static int iontec_i(gtime_t time, const nav_t *nav, int i, const double *pos,
+                    const double *azel, int opt, double *delay, double *var)
+{
+    double dels[2],vars[2],a,tt;
+    int stat[2];
+    
+    tt=timediff(nav->tec[i].time,nav->tec[i-1].time);
+    
     /* ionospheric delay by tec grid data */
-    stat[0]=iondelay(time,nav->tec+i-1,pos,azel,opt,dels  ,vars  );
-    stat[1]=iondelay(time,nav->tec+i  ,pos,azel,opt,dels+1,vars+1);
+    iondelay2(time,nav->tec+i-1,pos,azel,opt,dels,vars,stat);
     
     if (!stat[0]&&!stat[1]) {
         trace(2,"%s: tec grid out of area pos=%6.2f %7.2f azel=%6.1f %5.1f\n",
@@ -473,6 +519,90 @@ extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
         *delay=dels[1];
         *var  =vars[1];
     }
+    return 1;
+}
+/* ionosphere model by tec grid data -------------------------------------------
+* compute ionospheric delay by tec grid data
+* args   : gtime_t time     I   time (gpst)
+*          nav_t  *nav      I   navigation data
+*          double *pos      I   receiver position {lat,lon,h} (rad,m)
+*          double *azel     I   azimuth/elevation angle {az,el} (rad)
+*          int    opt       I   model option
+*                                bit0: 0:earth-fixed,1:sun-fixed
+*                                bit1: 0:single-layer,1:modified single-layer
+*          double *delay    O   ionospheric delay (L1) (m)
+*          double *var      O   ionospheric dealy (L1) variance (m^2)
+* return : status (1:ok,0:error)
+* notes  : before calling the function, read tec grid data by calling readtec()
+*          return ok with delay=0 and var=VAR_NOTEC if el<MIN_EL or h<MIN_HGT
+*-----------------------------------------------------------------------------*/
+extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
+                  const double *azel, int opt, double *delay, double *var)
+{
+    int i;
+    
+    trace(3,"iontec  : time=%s pos=%.1f %.1f azel=%.1f %.1f\n",time_str(time,0),
+          pos[0]*R2D,pos[1]*R2D,azel[0]*R2D,azel[1]*R2D);
+    
+    if (azel[1]<MIN_EL||pos[2]<MIN_HGT) {
+        *delay=0.0;
+        *var=VAR_NOTEC;
+        return 1;
+    }
+    if (!(i=searchtec(time,nav))) return 0;
+    
+    if (!iontec_i(time,nav,i,pos,azel,opt,delay,var)) return 0;
+    
     trace(3,"iontec  : delay=%5.2f std=%5.2f\n",*delay,sqrt(*var));
     return 1;
 }
+/* ionosphere model by tec grid data for satellites ----------------------------
+* compute ionospheric delays by tec grid data for all satellites of an epoch
+* args   : gtime_t time     I   time (gpst)
+*          nav_t  *nav      I   navigation data
+*          double *pos      I   receiver position {lat,lon,h} (rad,m)
+*          double *azel     I   azimuth/elevation angles (2 x n) {az,el} (rad)
+*          int    n         I   number of satellites
+*          int    opt       I   model option (see iontec())
+*          double *delay    O   ionospheric delays (L1) (n) (m)
+*          double *var      O   ionospheric dealy (L1) variances (n) (m^2)
+*          int    *stat     O   status (n) (1:ok,0:error)
+* return : number of satellites with status ok
+* notes  : same as iontec() for each satellite. the bracketing tec grid data
+*          are searched once for the epoch and the ionospheric pierce points
+*          are shared by the two grid data if they have the same layers.
+*-----------------------------------------------------------------------------*/
+extern int iontecs(gtime_t time, const nav_t *nav, const double *pos,
+                   const double *azel, int n, int opt, double *delay,
+                   double *var, int *stat)
+{
+    int i,j,ns=0;
+    
+    trace(3,"iontecs : time=%s pos=%.1f %.1f n=%d\n",time_str(time,0),
+          pos[0]*R2D,pos[1]*R2D,n);
+    
+    for (j=0;j<n;j++) {
+        delay[j]=var[j]=0.0;
+        stat[j]=0;
+    }
+    if (pos[2]<MIN_HGT) {
+        for (j=0;j<n;j++) {
+            var[j]=VAR_NOTEC;
+            stat[j]=1;
+        }
+        return n;
+    }
+    i=searchtec(time,nav);
+    
+    for (j=0;j<n;j++) {
+        if (azel[1+j*2]<MIN_EL) {
+            var[j]=VAR_NOTEC;
+            stat[j]=1;
+        }
+        else if (i) {
+            stat[j]=iontec_i(time,nav,i,pos,azel+j*2,opt,delay+j,var+j);
+        }
+        if (stat[j]) ns++;
+    }
+    return ns;
+}
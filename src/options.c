@@ -16,6 +16,9 @@
 *                                misc-rnxopt1,2,pos1-snrmask_r,_b,_L1,_L2,_L5
 *           2014/10/21  1.4  add pos2-bdsarmode
 *           2015/02/20  1.4  add ppp-fixed as pos1-posmode option
+*           2026/10/18  1.5  add option out-outtix
+*           2026/10/18  1.6  add option misc-obsstream
+*           2026/10/18  1.7  add options misc-warmstart,file-ckptfile
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -41,7 +44,7 @@ static char snrmask_[NFREQ][1024];
 #define EPHOPT  "0:brdc,1:precise,2:brdc+sbas,3:brdc+ssrapc,4:brdc+ssrcom"
 #define NAVOPT  "1:gps+2:sbas+4:glo+8:gal+16:qzs+32:comp"
 #define GAROPT  "0:off,1:on,2:autocal"
-#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea"
+#define SOLOPT  "0:llh,1:xyz,2:enu,3:nmea,5:bin"
 #define TSYOPT  "0:gpst,1:utc,2:jst"
 #define TFTOPT  "0:tow,1:hms"
 #define DFTOPT  "0:deg,1:dms"
@@ -108,6 +111,7 @@ opt_t sysopts[]={
     {"out-nmeaintv1",   1,  (void *)&solopt_.nmeaintv[0],"s"    },
     {"out-nmeaintv2",   1,  (void *)&solopt_.nmeaintv[1],"s"    },
     {"out-outstat",     3,  (void *)&solopt_.sstat,      STSOPT },
+    {"out-outtix",      3,  (void *)&solopt_.outtix,     SWTOPT },
     
     {"stats-eratio1",   1,  (void *)&prcopt_.eratio[0],  ""     },
     {"stats-eratio2",   1,  (void *)&prcopt_.eratio[1],  ""     },
@@ -147,6 +151,8 @@ opt_t sysopts[]={
     {"misc-sbasatsel",  0,  (void *)&prcopt_.sbassatsel, "0:all"},
     {"misc-rnxopt1",    2,  (void *)prcopt_.rnxopt[0],   ""     },
     {"misc-rnxopt2",    2,  (void *)prcopt_.rnxopt[1],   ""     },
+    {"misc-obsstream",  3,  (void *)&prcopt_.obsstream,  SWTOPT },
+    {"misc-warmstart",  3,  (void *)&prcopt_.warmstart,  SWTOPT },
     
     {"file-satantfile", 2,  (void *)&filopt_.satantp,    ""     },
     {"file-rcvantfile", 2,  (void *)&filopt_.rcvantp,    ""     },
@@ -160,6 +166,7 @@ opt_t sysopts[]={
     {"file-geexefile",  2,  (void *)&filopt_.geexe,      ""     },
     {"file-solstatfile",2,  (void *)&filopt_.solstat,    ""     },
     {"file-tracefile",  2,  (void *)&filopt_.trace,      ""     },
+    {"file-ckptfile",   2,  (void *)&filopt_.ckpt,       ""     },
     
     {"",0,NULL,""} /* terminator */
 };
@@ -467,6 +474,7 @@ extern void resetsysopts(void)
     filopt_.blq    [0]='\0';
     filopt_.solstat[0]='\0';
     filopt_.trace  [0]='\0';
+    filopt_.ckpt   [0]='\0';
     for (i=0;i<2;i++) antpostype_[i]=0;
     elmask_=15.0;
     elmaskar_=0.0;
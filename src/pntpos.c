@@ -16,6 +16,8 @@
 *           2012/12/25 1.3  add variable snr mask
 *           2014/05/26 1.4  support galileo and beidou
 *           2015/03/19 1.5  fix bug on ionosphere correction for GLO and BDS
+*           2026/10/18 1.6  use batched satellite geometry in rescode()
+*           2026/10/18 1.7  compute ionex tec delays per epoch by iontecs()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -202,8 +204,9 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
                    double *v, double *H, double *var, double *azel, int *vsat,
                    double *resp, int *ns)
 {
-    double r,dion,dtrp,vmeas,vion,vtrp,rr[3],pos[3],dtr,e[3],P,lam_L1;
-    int i,j,nv=0,sys,mask[4]={0};
+    double r[MAXOBS],e[MAXOBS*3],azels[MAXOBS*2],dions[MAXOBS],vions[MAXOBS];
+    double dion,dtrp,vmeas,vion,vtrp,rr[3],pos[3],dtr,P,lam_L1;
+    int i,j,m,nv=0,sys,mask[4]={0},ionoopt,stec[MAXOBS];
     
     trace(3,"resprng : n=%d\n",n);
     
@@ -211,7 +214,17 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
     
     ecef2pos(rr,pos);
     
-    for (i=*ns=0;i<n&&i<MAXOBS;i++) {
+    /* geometric distance/azimuth/elevation angle of all satellites */
+    m=n<MAXOBS?n:MAXOBS;
+    geodists(rs,rr,m,r,e);
+    satazels(pos,e,r,m,azels);
+    
+    /* ionex tec model for all satellites */
+    ionoopt=iter>0?opt->ionoopt:IONOOPT_BRDC;
+    if (ionoopt==IONOOPT_TEC) {
+        iontecs(obs[0].time,nav,pos,azels,m,1,dions,vions,stec);
+    }
+    for (i=*ns=0;i<m;i++) {
         vsat[i]=0; azel[i*2]=azel[1+i*2]=resp[i]=0.0;
         
         if (!(sys=satsys(obs[i].sat,NULL))) continue;
@@ -224,8 +237,9 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
             continue;
         }
         /* geometric distance/azimuth/elevation angle */
-        if ((r=geodist(rs+i*6,rr,e))<=0.0||
-            satazel(pos,e,azel+i*2)<opt->elmin) continue;
+        if (r[i]<=0.0) continue;
+        azel[i*2]=azels[i*2]; azel[1+i*2]=azels[1+i*2];
+        if (azel[1+i*2]<opt->elmin) continue;
         
         /* psudorange with code bias correction */
         if ((P=prange(obs+i,nav,azel+i*2,iter,opt,&vmeas))==0.0) continue;
@@ -234,8 +248,12 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
         if (satexclude(obs[i].sat,svh[i],opt)) continue;
         
         /* ionospheric corrections */
-        if (!ionocorr(obs[i].time,nav,obs[i].sat,pos,azel+i*2,
-                      iter>0?opt->ionoopt:IONOOPT_BRDC,&dion,&vion)) continue;
+        if (ionoopt==IONOOPT_TEC) {
+            if (!stec[i]) continue;
+            dion=dions[i]; vion=vions[i];
+        }
+        else if (!ionocorr(obs[i].time,nav,obs[i].sat,pos,azel+i*2,ionoopt,
+                           &dion,&vion)) continue;
         
         /* GPS-L1 -> L1/B1 */
         if ((lam_L1=nav->lam[obs[i].sat-1][0])>0.0) {
@@ -247,10 +265,10 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
             continue;
         }
         /* pseudorange residual */
-        v[nv]=P-(r+dtr-CLIGHT*dts[i*2]+dion+dtrp);
+        v[nv]=P-(r[i]+dtr-CLIGHT*dts[i*2]+dion+dtrp);
         
         /* design matrix */
-        for (j=0;j<NX;j++) H[j+nv*NX]=j<3?-e[j]:(j==3?1.0:0.0);
+        for (j=0;j<NX;j++) H[j+nv*NX]=j<3?-e[j+i*3]:(j==3?1.0:0.0);
         
         /* time system and receiver bias offset correction */
         if      (sys==SYS_GLO) {v[nv]-=x[4]; H[4+nv*NX]=1.0; mask[1]=1;}
@@ -27,6 +27,13 @@
 *           2014/06/29  1.14 fix problem on overflow of # of satellites
 *           2015/03/23  1.15 fix bug on ant type replacement by rinex header
 *                            fix bug on combined filter for moving-base mode
+*           2026/10/18  1.16 open output file in binary mode for binary solution
+*           2026/10/18  1.17 output time index file by option out-outtix
+*           2026/10/18  1.18 search epochs by observation data epoch index
+*           2026/10/18  1.19 add streaming input of obs data for forward processing
+*                            by option misc-obsstream
+*           2026/10/18  1.20 save/restore rtk filter state by checkpoint file
+*           2026/10/18  1.21 read precise ephemeris/clock files at once
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -38,6 +45,26 @@ static const char rcsid[]="$Id: postpos.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $"
 #define MAXPRCDAYS  100          /* max days of continuous processing */
 #define MAXINFILE   1000         /* max number of input files */
 
+typedef struct {                /* obs data stream file type */
+    char path[1024];            /* file path (uncompressed) */
+    int cstat;                  /* temporary uncompressed file (0:no,1:yes) */
+} strfile_t;
+
+typedef struct {                /* obs data stream type */
+    int rcv;                    /* receiver number (0:not opened) */
+    int n,nmax,i;               /* number of files/allocated/current file */
+    strfile_t *files;           /* obs data files */
+    FILE *fp;                   /* current file pointer */
+    rnxctr_t rnx;               /* rinex control struct */
+    gtime_t ts,te,time;         /* time start/end, last epoch time */
+    double ti;                  /* time interval (s) */
+    unsigned char slips[MAXSAT][NFREQ]; /* cycle-slip flags */
+    obsd_t data[MAXOBS];        /* next epoch obs data */
+    int nd;                     /* number of next epoch obs data (-1:unread) */
+    obsd_t prev[MAXOBS];        /* current reference epoch obs data */
+    int np;                     /* number of current reference epoch obs data */
+} obsstr_t;
+
 /* constants/global variables ------------------------------------------------*/
 
 static pcvs_t pcvss={0};        /* receiver antenna parameters */
@@ -48,8 +75,8 @@ static sbs_t sbss={0};          /* sbas messages */
 static lex_t lexs={0};          /* lex messages */
 static sta_t stas[MAXRCV];      /* station infomation */
 static int nepoch=0;            /* number of observation epochs */
-static int iobsu =0;            /* current rover observation data index */
-static int iobsr =0;            /* current reference observation data index */
+static int iobsu =0;            /* current rover observation epoch index */
+static int iobsr =0;            /* current reference observation epoch index */
 static int isbs  =0;            /* current sbas message index */
 static int ilex  =0;            /* current lex message index */
 static int revs  =0;            /* analysis direction (0:forward,1:backward) */
@@ -66,6 +93,11 @@ static char rtcm_file[1024]=""; /* rtcm data file */
 static char rtcm_path[1024]=""; /* rtcm data path */
 static rtcm_t rtcm;             /* rtcm control struct */
 static FILE *fp_rtcm=NULL;      /* rtcm data file pointer */
+static soltix_t soltix={0};     /* solution time index */
+static obsstr_t strs[2];        /* obs data streams {rover,base} */
+static int obsstr=0;            /* streaming input of obs data (0:off,1:on) */
+static char ckpt_file[1024]=""; /* checkpoint file of rtk filter state */
+static gtime_t ckpt_time={0};   /* start time of session for checkpoint */
 
 /* show message and check break ----------------------------------------------*/
 static int checkbrk(const char *format, ...)
@@ -107,6 +139,147 @@ static void outrpos(FILE *fp, const double *r, const solopt_t *opt)
         fprintf(fp,"%14.4f%s%14.4f%s%14.4f",r[0],sep,r[1],sep,r[2]);
     }
 }
+/* rewind obs data stream ----------------------------------------------------*/
+static void rewindstr(obsstr_t *str)
+{
+    gtime_t time0={0};
+    int i,j;
+    
+    if (str->fp) fclose(str->fp);
+    str->fp=NULL;
+    str->i=str->np=0;
+    str->nd=-1;
+    str->time=time0;
+    for (i=0;i<MAXSAT;i++) for (j=0;j<NFREQ;j++) str->slips[i][j]=0;
+}
+/* open obs data stream ------------------------------------------------------*/
+static int openstr(obsstr_t *str, int rcv, gtime_t ts, gtime_t te, double ti,
+                   const char *opt)
+{
+    trace(3,"openstr : rcv=%d\n",rcv);
+    
+    str->n=str->nmax=0;
+    str->files=NULL;
+    str->fp=NULL;
+    str->ts=ts; str->te=te; str->ti=ti;
+    if (!init_rnxctr(&str->rnx)) return 0;
+    strcpy(str->rnx.opt,opt);
+    str->rcv=rcv;
+    rewindstr(str);
+    return 1;
+}
+/* close obs data stream -----------------------------------------------------*/
+static void closestr(obsstr_t *str)
+{
+    int i;
+    
+    trace(3,"closestr: rcv=%d\n",str->rcv);
+    
+    if (str->rcv<=0) return;
+    if (str->fp) fclose(str->fp);
+    
+    /* delete temporary files */
+    for (i=0;i<str->n;i++) {
+        if (str->files[i].cstat) remove(str->files[i].path);
+    }
+    free(str->files);
+    free_rnxctr(&str->rnx);
+    str->files=NULL; str->fp=NULL;
+    str->n=str->nmax=str->rcv=0;
+}
+/* add file to obs data stream -----------------------------------------------*/
+static int addstrfile(obsstr_t *str, const char *path, int cstat)
+{
+    strfile_t *files;
+    
+    if (str->n>=str->nmax) {
+        str->nmax=str->nmax<=0?16:str->nmax*2;
+        if (!(files=(strfile_t *)realloc(str->files,
+                                         sizeof(strfile_t)*str->nmax))) {
+            return 0;
+        }
+        str->files=files;
+    }
+    strcpy(str->files[str->n].path,path);
+    str->files[str->n++].cstat=cstat;
+    return 1;
+}
+/* read next epoch of obs data stream ----------------------------------------*/
+static int readstr(obsstr_t *str)
+{
+    obsd_t *data=str->rnx.obs.data;
+    gtime_t time;
+    int i,j,k,n,stat;
+    
+    str->nd=0;
+    
+    while (str->fp||str->i<str->n) {
+        
+        /* open next file */
+        if (!str->fp) {
+            if (!(str->fp=fopen(str->files[str->i].path,"r"))) {
+                trace(2,"obs file open error: %s\n",str->files[str->i].path);
+                str->i++;
+                continue;
+            }
+            if (!open_rnxctr(&str->rnx,str->fp)||str->rnx.type!='O') {
+                fclose(str->fp); str->fp=NULL;
+                str->i++;
+                continue;
+            }
+        }
+        if ((stat=input_rnxctr(&str->rnx,str->fp))<-1) { /* end of file */
+            fclose(str->fp); str->fp=NULL;
+            str->i++;
+            continue;
+        }
+        if (stat!=1||(n=str->rnx.obs.n)<=0) continue;
+        
+        for (i=0;i<n;i++) {
+            
+            /* utc -> gpst */
+            if (str->rnx.tsys==TSYS_UTC) data[i].time=utc2gpst(data[i].time);
+            
+            /* save cycle-slip */
+            for (j=0;j<NFREQ;j++) {
+                if (data[i].LLI[j]&1) str->slips[data[i].sat-1][j]|=1;
+            }
+        }
+        time=data[0].time;
+        
+        /* screen data by time and skip epochs not after the last epoch */
+        if (!screent(time,str->ts,str->te,str->ti)) continue;
+        
+        if (str->time.time&&timediff(time,str->time)<=DTTOL) {
+            trace(2,"obs epoch out of order: rcv=%d %s\n",str->rcv,
+                  time_str(time,0));
+            continue;
+        }
+        for (i=0;i<n;i++) {
+            
+            /* restore cycle-slip */
+            for (j=0;j<NFREQ;j++) {
+                if (str->slips[data[i].sat-1][j]&1) data[i].LLI[j]|=1;
+                str->slips[data[i].sat-1][j]=0;
+            }
+            data[i].rcv=(unsigned char)str->rcv;
+            
+            /* sort by satellite */
+            for (k=i;k>0&&str->data[k-1].sat>data[i].sat;k--) {
+                str->data[k]=str->data[k-1];
+            }
+            str->data[k]=data[i];
+        }
+        str->time=time;
+        return str->nd=n;
+    }
+    return 0;
+}
+/* peek next epoch of obs data stream ----------------------------------------*/
+static int peekstr(obsstr_t *str)
+{
+    return str->nd<0?readstr(str):str->nd;
+}
 /* output header -------------------------------------------------------------*/
 static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
                       const solopt_t *sopt)
@@ -131,11 +304,16 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
         for (i=0;i<n;i++) {
             fprintf(fp,"%s inp file  : %s\n",COMMENTH,file[i]);
         }
-        for (i=0;i<obss.n;i++)    if (obss.data[i].rcv==1) break;
-        for (j=obss.n-1;j>=0;j--) if (obss.data[j].rcv==1) break;
+        if (obsstr) { /* end of streaming input not known */
+            i=0; j=peekstr(strs)-1;
+        }
+        else {
+            for (i=0;i<obss.n;i++)    if (obss.data[i].rcv==1) break;
+            for (j=obss.n-1;j>=0;j--) if (obss.data[j].rcv==1) break;
+        }
         if (j<i) {fprintf(fp,"\n%s no rover obs data\n",COMMENTH); return;}
-        ts=obss.data[i].time;
-        te=obss.data[j].time;
+        ts=obsstr?strs[0].data[0].time:obss.data[i].time;
+        te=obsstr?strs[0].data[0].time:obss.data[j].time;
         t1=time2gpst(ts,&w1);
         t2=time2gpst(te,&w2);
         if (sopt->times>=1) ts=gpst2utc(ts);
@@ -145,7 +323,9 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
         time2str(ts,s2,1);
         time2str(te,s3,1);
         fprintf(fp,"%s obs start : %s %s (week%04d %8.1fs)\n",COMMENTH,s2,s1[sopt->times],w1,t1);
-        fprintf(fp,"%s obs end   : %s %s (week%04d %8.1fs)\n",COMMENTH,s3,s1[sopt->times],w2,t2);
+        if (!obsstr) {
+            fprintf(fp,"%s obs end   : %s %s (week%04d %8.1fs)\n",COMMENTH,s3,s1[sopt->times],w2,t2);
+        }
     }
     if (sopt->outopt) {
         outprcopt(fp,popt);
@@ -159,29 +339,54 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
     
     outsolhead(fp,sopt);
 }
-/* search next observation data index ----------------------------------------*/
+/* search next observation data epoch index ----------------------------------*/
 static int nextobsf(const obs_t *obs, int *i, int rcv)
 {
-    double tt;
-    int n;
-    
-    for (;*i<obs->n;(*i)++) if (obs->data[*i].rcv==rcv) break;
-    for (n=0;*i+n<obs->n;n++) {
-        tt=timediff(obs->data[*i+n].time,obs->data[*i].time);
-        if (obs->data[*i+n].rcv!=rcv||tt>DTTOL) break;
-    }
-    return n;
+    for (;*i<obs->ne;(*i)++) if (obs->idx[*i].rcv==rcv) return obs->idx[*i].n;
+    return 0;
 }
 static int nextobsb(const obs_t *obs, int *i, int rcv)
 {
-    double tt;
-    int n;
-    
-    for (;*i>=0;(*i)--) if (obs->data[*i].rcv==rcv) break;
-    for (n=0;*i-n>=0;n++) {
-        tt=timediff(obs->data[*i-n].time,obs->data[*i].time);
-        if (obs->data[*i-n].rcv!=rcv||tt<-DTTOL) break;
+    for (;*i>=0;(*i)--) if (obs->idx[*i].rcv==rcv) return obs->idx[*i].n;
+    return 0;
+}
+/* observation data epoch time -----------------------------------------------*/
+static gtime_t obstime(const obs_t *obs, int i)
+{
+    return obs->data[obs->idx[i].i].time;
+}
+/* input obs data from streams ----------------------------------------------*/
+static int inputstr(obsd_t *obs, const prcopt_t *popt)
+{
+    obsstr_t *str=strs+1;
+    gtime_t time;
+    obsd_t *data;
+    int i,n=0,nu,nr;
+    
+    if ((nu=peekstr(strs))<=0) return -1;
+    time=strs[0].data[0].time;
+    
+    if (popt->intpref) { /* first reference epoch after rover epoch */
+        while ((nr=peekstr(str))>0) {
+            if (timediff(str->data[0].time,time)>-DTTOL) break;
+            str->nd=-1;
+        }
+        data=str->data;
+    }
+    else { /* last reference epoch before rover epoch */
+        while ((nr=peekstr(str))>0) {
+            if (str->np>0&&timediff(str->data[0].time,time)>DTTOL) break;
+            for (i=0;i<nr;i++) str->prev[i]=str->data[i];
+            str->np=nr;
+            str->nd=-1;
+        }
+        nr=str->np;
+        data=str->prev;
     }
+    for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=strs[0].data[i];
+    for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=data[i];
+    strs[0].nd=-1;
+    
     return n;
 }
 /* input obs data, navigation messages and sbas correction -------------------*/
@@ -193,26 +398,31 @@ static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
     
     trace(3,"infunc  : revs=%d iobsu=%d iobsr=%d isbs=%d\n",revs,iobsu,iobsr,isbs);
     
-    if (0<=iobsu&&iobsu<obss.n) {
-        settime((time=obss.data[iobsu].time));
+    if (obsstr?peekstr(strs)>0:0<=iobsu&&iobsu<obss.ne) {
+        settime((time=obsstr?strs[0].data[0].time:obstime(&obss,iobsu)));
         if (checkbrk("processing : %s Q=%d",time_str(time,0),solq)) {
             aborts=1; showmsg("aborted"); return -1;
         }
     }
     if (!revs) { /* input forward data */
-        if ((nu=nextobsf(&obss,&iobsu,1))<=0) return -1;
-        if (popt->intpref) {
-            for (;(nr=nextobsf(&obss,&iobsr,2))>0;iobsr+=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)>-DTTOL) break;
+        if (obsstr) { /* streaming input */
+            if ((n=inputstr(obs,popt))<0) return -1;
         }
         else {
-            for (i=iobsr;(nr=nextobsf(&obss,&i,2))>0;iobsr=i,i+=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)>DTTOL) break;
+            if ((nu=nextobsf(&obss,&iobsu,1))<=0) return -1;
+            if (popt->intpref) {
+                for (;(nr=nextobsf(&obss,&iobsr,2))>0;iobsr++)
+                    if (timediff(obstime(&obss,iobsr),obstime(&obss,iobsu))>-DTTOL) break;
+            }
+            else {
+                for (i=iobsr;(nr=nextobsf(&obss,&i,2))>0;iobsr=i,i++)
+                    if (timediff(obstime(&obss,i),obstime(&obss,iobsu))>DTTOL) break;
+            }
+            nr=nextobsf(&obss,&iobsr,2);
+            for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[obss.idx[iobsu].i+i];
+            for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[obss.idx[iobsr].i+i];
+            iobsu++;
         }
-        nr=nextobsf(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr+i];
-        iobsu+=nu;
         
         /* update sbas corrections */
         while (isbs<sbss.n) {
@@ -259,17 +469,17 @@ static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
     else { /* input backward data */
         if ((nu=nextobsb(&obss,&iobsu,1))<=0) return -1;
         if (popt->intpref) {
-            for (;(nr=nextobsb(&obss,&iobsr,2))>0;iobsr-=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)<DTTOL) break;
+            for (;(nr=nextobsb(&obss,&iobsr,2))>0;iobsr--)
+                if (timediff(obstime(&obss,iobsr),obstime(&obss,iobsu))<DTTOL) break;
         }
         else {
-            for (i=iobsr;(nr=nextobsb(&obss,&i,2))>0;iobsr=i,i-=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)<-DTTOL) break;
+            for (i=iobsr;(nr=nextobsb(&obss,&i,2))>0;iobsr=i,i--)
+                if (timediff(obstime(&obss,i),obstime(&obss,iobsu))<-DTTOL) break;
         }
         nr=nextobsb(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu-nu+1+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr-nr+1+i];
-        iobsu-=nu;
+        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[obss.idx[iobsu].i+i];
+        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[obss.idx[iobsr].i+i];
+        iobsu--;
         
         /* update sbas corrections */
         while (isbs>=0) {
@@ -291,6 +501,13 @@ static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
     }
     return n;
 }
+/* output solution with time index -----------------------------------------*/
+static void outsolt(FILE *fp, const sol_t *sol, const double *rb,
+                    const solopt_t *sopt)
+{
+    outsoltix(&soltix,sol->time,fp);
+    outsol(fp,sol,rb,sopt);
+}
 /* process positioning -------------------------------------------------------*/
 static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
                     int mode)
@@ -310,6 +527,13 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
     rtkinit(&rtk,popt);
     rtcm_path[0]='\0';
     
+    /* warm-start from checkpoint of previous session */
+    if (!revs&&popt->warmstart&&*ckpt_file) {
+        if (rtkload(&rtk,ckpt_file,ckpt_time)) {
+            trace(2,"warm-start from checkpoint: %s\n",ckpt_file);
+        }
+    }
+    
     while ((nobs=inputobs(obs,rtk.sol.stat,popt))>=0) {
         
         /* exclude satellites */
@@ -323,7 +547,7 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
         
         if (mode==0) { /* forward/backward */
             if (!solstatic) {
-                outsol(fp,&rtk.sol,rtk.rb,sopt);
+                outsolt(fp,&rtk.sol,rtk.rb,sopt);
             }
             else if (time.time==0||pri[rtk.sol.stat]<=pri[sol.stat]) {
                 sol=rtk.sol;
@@ -348,7 +572,11 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
     }
     if (mode==0&&solstatic&&time.time!=0.0) {
         sol.time=time;
-        outsol(fp,&sol,rb,sopt);
+        outsolt(fp,&sol,rb,sopt);
+    }
+    /* save checkpoint for next session */
+    if (!revs&&*ckpt_file&&!rtksave(&rtk,ckpt_file)) {
+        showmsg("error : checkpoint save %s",ckpt_file);
     }
     rtkfree(&rtk);
 }
@@ -447,7 +675,7 @@ static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
             sols.qr[5]=(float)Qs[2];
         }
         if (!solstatic) {
-            outsol(fp,&sols,rbs,sopt);
+            outsolt(fp,&sols,rbs,sopt);
         }
         else if (time.time==0||pri[sols.stat]<=pri[sol.stat]) {
             sol=sols;
@@ -459,7 +687,7 @@ static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
     }
     if (solstatic&&time.time!=0.0) {
         sol.time=time;
-        outsol(fp,&sol,rb,sopt);
+        outsolt(fp,&sol,rb,sopt);
     }
 }
 /* read prec ephemeris, sbas data, lex data, tec grid and open rtcm ----------*/
@@ -467,8 +695,8 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
                         nav_t *nav, sbs_t *sbs, lex_t *lex)
 {
     seph_t seph0={0};
-    int i;
-    char *ext;
+    int i,m;
+    char *ext,*efiles[MAXEXFILE];
     
     trace(3,"readpreceph: n=%d\n",n);
     
@@ -477,16 +705,23 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
     sbs->n =sbs->nmax =0;
     lex->n =lex->nmax =0;
     
-    /* read precise ephemeris files */
-    for (i=0;i<n;i++) {
-        if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
-        readsp3(infile[i],nav,0);
+    for (i=0;i<MAXEXFILE;i++) {
+        if (!(efiles[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(efiles[i]);
+            return;
+        }
     }
-    /* read precise clock files */
-    for (i=0;i<n;i++) {
+    /* expand wild-card in input files */
+    for (i=m=0;i<n&&m<MAXEXFILE;i++) {
         if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
-        readrnxc(infile[i],nav);
+        m+=expath(infile[i],efiles+m,MAXEXFILE-m);
     }
+    /* read precise ephemeris and clock files at once */
+    readsp3s(efiles,m,nav,0);
+    readrnxcs(efiles,m,nav);
+    
+    for (i=0;i<MAXEXFILE;i++) free(efiles[i]);
+    
     /* read sbas message files */
     for (i=0;i<n;i++) {
         if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
@@ -553,6 +788,7 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
     trace(3,"readobsnav: ts=%s n=%d\n",time_str(ts,0),n);
     
     obs->data=NULL; obs->n =obs->nmax =0;
+    obs->idx =NULL; obs->ne=obs->nemax=0;
     nav->eph =NULL; nav->n =nav->nmax =0;
     nav->geph=NULL; nav->ng=nav->ngmax=0;
     nav->seph=NULL; nav->ns=nav->nsmax=0;
@@ -583,9 +819,15 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
         trace(1,"no nav data\n");
         return 0;
     }
-    /* sort observation data */
+    /* sort and index observation data */
     nepoch=sortobs(obs);
     
+    if (indexobs(obs)<0) {
+        checkbrk("error : insufficient memory");
+        trace(1,"insufficient memory\n");
+        return 0;
+    }
+    
     /* delete duplicated ephemeris */
     uniqnav(nav);
     
@@ -601,21 +843,143 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
     }
     return 1;
 }
+/* open obs data streams and read nav data -----------------------------------*/
+static int openobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
+                      const int *index, int n, const prcopt_t *prcopt,
+                      nav_t *nav, sta_t *sta)
+{
+    FILE *fp;
+    rnxctr_t rnx;
+    sta_t sta0={""};
+    char *files[MAXEXFILE]={0},tmpfile[1024],*path;
+    const char *p;
+    int i,j,m,stat,cstat,ind=0,nobs=0,nstr=0,rcv=1;
+    
+    trace(3,"openobsnav: ts=%s n=%d\n",time_str(ts,0),n);
+    
+    nav->eph =NULL; nav->n =nav->nmax =0;
+    nav->geph=NULL; nav->ng=nav->ngmax=0;
+    nav->seph=NULL; nav->ns=nav->nsmax=0;
+    
+    for (i=0;i<2;i++) {
+        if (!openstr(strs+i,i+1,ts,te,ti,prcopt->rnxopt[i])) {
+            checkbrk("error : insufficient memory");
+            return 0;
+        }
+    }
+    for (i=0;i<MAXEXFILE;i++) {
+        if (!(files[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(files[i]);
+            checkbrk("error : insufficient memory");
+            return 0;
+        }
+    }
+    if (!init_rnxctr(&rnx)) {
+        for (i=0;i<MAXEXFILE;i++) free(files[i]);
+        checkbrk("error : insufficient memory");
+        return 0;
+    }
+    for (i=0,stat=1;i<n&&stat;i++) {
+        if (checkbrk("")) {stat=0; break;}
+        
+        if (index[i]!=ind) {
+            if (nstr>nobs) rcv++;
+            ind=index[i]; nobs=nstr;
+        }
+        m=expath(infile[i],files,MAXEXFILE);
+        
+        for (j=0;j<m&&stat;j++) {
+            
+            /* uncompress file and read rinex header */
+            if ((cstat=uncompress(files[j],tmpfile))<0) {
+                trace(2,"rinex file uncompact error: %s\n",files[j]);
+                continue;
+            }
+            path=cstat?tmpfile:files[j];
+            if (!(fp=fopen(path,"r"))) {
+                trace(2,"rinex file open error: %s\n",path);
+                continue;
+            }
+            rnx.sta=sta0;
+            rnx.type=' ';
+            open_rnxctr(&rnx,fp);
+            fclose(fp);
+            
+            /* add obs file to stream */
+            if (rnx.type=='O') {
+                nstr++;
+                if (rcv>2) {
+                    if (cstat) remove(tmpfile);
+                    continue;
+                }
+                if (!addstrfile(strs+rcv-1,path,cstat)) {
+                    if (cstat) remove(tmpfile);
+                    checkbrk("error : insufficient memory");
+                    stat=0;
+                    break;
+                }
+                sta[rcv-1]=rnx.sta;
+                if (!(p=strrchr(infile[i],FILEPATHSEP))) p=infile[i]-1;
+                if (!*sta[rcv-1].name) {
+                    strncpy(sta[rcv-1].name,p+1,4); sta[rcv-1].name[4]='\0';
+                }
+                continue;
+            }
+            if (cstat) remove(tmpfile);
+            
+            /* read rinex nav file */
+            if (readrnxt(files[j],rcv,ts,te,ti,prcopt->rnxopt[rcv<=1?0:1],
+                         NULL,nav,NULL)<0) {
+                checkbrk("error : insufficient memory");
+                stat=0;
+            }
+        }
+    }
+    free_rnxctr(&rnx);
+    for (i=0;i<MAXEXFILE;i++) free(files[i]);
+    
+    if (!stat) return 0;
+    
+    trace(3,"openobsnav: nfile=%d %d\n",strs[0].n,strs[1].n);
+    
+    if (peekstr(strs)<=0) {
+        checkbrk("error : no obs data");
+        trace(1,"no obs data\n");
+        return 0;
+    }
+    if (nav->n<=0&&nav->ng<=0&&nav->ns<=0) {
+        checkbrk("error : no nav data");
+        trace(1,"no nav data\n");
+        return 0;
+    }
+    /* delete duplicated ephemeris */
+    uniqnav(nav);
+    
+    /* set time span for progress display */
+    if (ts.time==0) ts=strs[0].data[0].time;
+    if (te.time!=0) settspan(ts,te);
+    
+    return 1;
+}
 /* free obs and nav data -----------------------------------------------------*/
 static void freeobsnav(obs_t *obs, nav_t *nav)
 {
     trace(3,"freeobsnav:\n");
     
     free(obs->data); obs->data=NULL; obs->n =obs->nmax =0;
+    free(obs->idx ); obs->idx =NULL; obs->ne=obs->nemax=0;
     free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;
     free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
+    closestr(strs);
+    closestr(strs+1);
 }
 /* average of single position ------------------------------------------------*/
 static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
                   const prcopt_t *opt)
 {
-    obsd_t data[MAXOBS];
+    obsstr_t *str=obsstr?strs+rcv-1:NULL;
+    obsd_t data[MAXOBS],*p;
     gtime_t ts={0};
     sol_t sol={{0}};
     int i,j,n=0,m,iobs;
@@ -625,10 +989,18 @@ static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
     
     for (i=0;i<3;i++) ra[i]=0.0;
     
-    for (iobs=0;(m=nextobsf(obs,&iobs,rcv))>0;iobs+=m) {
-        
+    for (iobs=0;;iobs++) {
+        if (str) { /* streaming input */
+            if ((m=peekstr(str))<=0) break;
+            p=str->data;
+            str->nd=-1;
+        }
+        else {
+            if ((m=nextobsf(obs,&iobs,rcv))<=0) break;
+            p=obs->data+obs->idx[iobs].i;
+        }
         for (i=j=0;i<m&&i<MAXOBS;i++) {
-            data[j]=obs->data[iobs+i];
+            data[j]=p[i];
             if ((satsys(data[j].sat,NULL)&opt->navsys)&&
                 opt->exsats[data[j].sat-1]!=1) j++;
         }
@@ -639,6 +1011,8 @@ static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
         for (i=0;i<3;i++) ra[i]+=sol.rr[i];
         n++;
     }
+    if (str) rewindstr(str);
+    
     if (n<=0) {
         trace(1,"no average of base station position\n");
         return 0;
@@ -854,7 +1228,7 @@ static int outhead(const char *outfile, char **infile, int n,
     if (*outfile) {
         createdir(outfile);
         
-        if (!(fp=fopen(outfile,"w"))) {
+        if (!(fp=fopen(outfile,sopt->posf==SOLF_BIN?"wb":"w"))) {
             showmsg("error : open output file %s",outfile);
             return 0;
         }
@@ -864,14 +1238,26 @@ static int outhead(const char *outfile, char **infile, int n,
     
     if (*outfile) fclose(fp);
     
+    /* create time index file */
+    if (*outfile&&sopt->outtix&&opensoltix(&soltix,outfile,0)) {
+        closesoltix(&soltix);
+    }
     return 1;
 }
 /* open output file for append -----------------------------------------------*/
-static FILE *openfile(const char *outfile)
+static FILE *openfile(const char *outfile, const solopt_t *sopt)
 {
+    FILE *fp;
+    
     trace(3,"openfile: outfile=%s\n",outfile);
     
-    return !*outfile?stdout:fopen(outfile,"a");
+    if (!*outfile) return stdout;
+    
+    /* open solution file and time index file for append */
+    if ((fp=fopen(outfile,sopt->posf==SOLF_BIN?"ab":"a"))&&sopt->outtix) {
+        opensoltix(&soltix,outfile,1);
+    }
+    return fp;
 }
 /* execute processing session ------------------------------------------------*/
 static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
@@ -879,6 +1265,7 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
                    char **infile, const int *index, int n, char *outfile)
 {
     FILE *fp;
+    gtime_t time,time0={0};
     prcopt_t popt_=*popt;
     char tracefile[1024],statfile[1024];
     
@@ -897,13 +1284,30 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         traceopen(tracefile);
         tracelevel(sopt->trace);
     }
+    /* streaming input of obs data only for forward processing */
+    obsstr=popt_.obsstream&&(popt_.mode==PMODE_SINGLE||popt_.soltype==0);
+    
     /* read obs and nav data */
-    if (!readobsnav(ts,te,ti,infile,index,n,&popt_,&obss,&navs,stas)) return 0;
+    if (obsstr) {
+        if (!openobsnav(ts,te,ti,infile,index,n,&popt_,&navs,stas)) {
+            freeobsnav(&obss,&navs);
+            return 0;
+        }
+        time=strs[0].data[0].time;
+    }
+    else {
+        if (!readobsnav(ts,te,ti,infile,index,n,&popt_,&obss,&navs,stas)) {
+            return 0;
+        }
+        time=obss.n>0?obss.data[0].time:timeget();
+    }
+    /* checkpoint file of rtk filter state */
+    reppath(fopt->ckpt,ckpt_file,time0,proc_rov,proc_base);
+    ckpt_time=time;
     
     /* set antenna paramters */
     if (popt_.mode!=PMODE_SINGLE) {
-        setpcv(obss.n>0?obss.data[0].time:timeget(),&popt_,&navs,&pcvss,&pcvsr,
-               stas);
+        setpcv(time,&popt_,&navs,&pcvss,&pcvsr,stas);
     }
     /* read ocean tide loading parameters */
     if (popt_.mode>PMODE_SINGLE&&fopt->blq) {
@@ -927,7 +1331,7 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         strcpy(statfile,outfile);
         strcat(statfile,".stat");
         rtkclosestat();
-        rtkopenstat(statfile,sopt->sstat);
+        rtkopenstatt(statfile,sopt->sstat,sopt->outtix);
     }
     /* write header to output file */
     if (flag&&!outhead(outfile,infile,n,&popt_,sopt)) {
@@ -937,16 +1341,18 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
     iobsu=iobsr=isbs=ilex=revs=aborts=0;
     
     if (popt_.mode==PMODE_SINGLE||popt_.soltype==0) {
-        if ((fp=openfile(outfile))) {
+        if ((fp=openfile(outfile,sopt))) {
             procpos(fp,&popt_,sopt,0); /* forward */
             fclose(fp);
+            closesoltix(&soltix);
         }
     }
     else if (popt_.soltype==1) {
-        if ((fp=openfile(outfile))) {
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
+        if ((fp=openfile(outfile,sopt))) {
+            revs=1; iobsu=iobsr=obss.ne-1; isbs=sbss.n-1; ilex=lexs.n-1;
             procpos(fp,&popt_,sopt,0); /* backward */
             fclose(fp);
+            closesoltix(&soltix);
         }
     }
     else { /* combined */
@@ -958,13 +1364,14 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         if (solf&&solb) {
             isolf=isolb=0;
             procpos(NULL,&popt_,sopt,1); /* forward */
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
+            revs=1; iobsu=iobsr=obss.ne-1; isbs=sbss.n-1; ilex=lexs.n-1;
             procpos(NULL,&popt_,sopt,1); /* backward */
             
             /* combine forward/backward solutions */
-            if (!aborts&&(fp=openfile(outfile))) {
+            if (!aborts&&(fp=openfile(outfile,sopt))) {
                 combres(fp,&popt_,sopt);
                 fclose(fp);
+                closesoltix(&soltix);
             }
         }
         else showmsg("error : memory allocation");
@@ -1129,6 +1536,12 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
 *          are output to a single output file.
 *
 *          ssr corrections are valid only for forward estimation.
+*
+*          if the checkpoint file (fopt->ckpt) is set, the filter state at the
+*          end of the forward estimation of each session is saved to the file.
+*          with popt->warmstart, the forward estimation is started from the
+*          filter state of the file if it is of the previous session. the file
+*          can include keywords of rover and base station id (%r,%b).
 *-----------------------------------------------------------------------------*/
 extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                    const prcopt_t *popt, const solopt_t *sopt,
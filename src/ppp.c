@@ -36,6 +36,9 @@
 *           2014/05/23 1.5  add output of trop gradient in solution status
 *           2014/10/13 1.6  fix bug on P0(a[3]) computation in tide_oload()
 *                           fix bug on m2 computation in tide_pole()
+*           2026/10/18 1.7  use batched satellite geometry in res_ppp()
+*           2026/10/18 1.8  add stage timing profile in pppos()
+*           2026/10/18 1.9  compute ionex tec delays per epoch by iontecs()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -569,7 +572,7 @@ static int corr_ion(gtime_t time, const nav_t *nav, int sat, const double *pos,
 static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
                     const double *azel, const prcopt_t *opt,
                     const double *dantr, const double *dants, double phw,
-                    double *meas, double *var, int *brk)
+                    const double *dion, double *meas, double *var, int *brk)
 {
     const double *lam=nav->lam[obs->sat-1];
     double ion=0.0,L1,P1,PC,P1_P2,P1_C1,vari,gamma;
@@ -600,8 +603,12 @@ static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
     if (obs->code[0]==CODE_L1C) P1+=P1_C1; /* C1->P1 */
     PC=P1-P1_P2/(1.0-gamma);               /* P1->PC */
     
-    /* slant ionospheric delay L1 (m) */
-    if (!corr_ion(obs->time,nav,obs->sat,pos,azel,opt->ionoopt,&ion,&vari,brk)) {
+    /* slant ionospheric delay L1 (m) (dion: precomputed {delay,var}) */
+    if (dion) {
+        ion=dion[0]; vari=dion[1];
+    }
+    else if (!corr_ion(obs->time,nav,obs->sat,pos,azel,opt->ionoopt,&ion,&vari,
+                       brk)) {
         
         trace(2,"iono correction error: time=%s sat=%2d ionoopt=%d\n",
               time_str(obs->time,2),obs->sat,opt->ionoopt);
@@ -771,7 +778,7 @@ static void udbias_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
         sat=obs[i].sat;
         j=IB(sat,&rtk->opt);
         if (!corrmeas(obs+i,nav,pos,rtk->ssat[sat-1].azel,&rtk->opt,NULL,NULL,
-                      0.0,meas,var,&brk)) continue;
+                      0.0,NULL,meas,var,&brk)) continue;
         
         if (brk) {
             rtk->ssat[sat-1].slip[0]=1;
@@ -847,18 +854,11 @@ static void satantpcv(const double *rs, const double *rr, const pcv_t *pcv,
     antmodel_s(pcv,nadir,dant);
 }
 /* precise tropospheric model ------------------------------------------------*/
-static double prectrop(gtime_t time, const double *pos, const double *azel,
+static double prectrop(double zhd, double m_h, double m_w, const double *azel,
                        const prcopt_t *opt, const double *x, double *dtdx,
                        double *var)
 {
-    const double zazel[]={0.0,PI/2.0};
-    double zhd,m_h,m_w,cotz,grad_n,grad_e;
-    
-    /* zenith hydrostatic delay */
-    zhd=tropmodel(time,pos,zazel,0.0);
-    
-    /* mapping function */
-    m_h=tropmapf(time,pos,azel,&m_w);
+    double cotz,grad_n,grad_e;
     
     if ((opt->tropopt==TROPOPT_ESTG||opt->tropopt==TROPOPT_CORG)&&azel[1]>0.0) {
         
@@ -880,10 +880,14 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
                    const nav_t *nav, const double *x, rtk_t *rtk, double *v,
                    double *H, double *R, double *azel)
 {
+    const double zazel[]={0.0,PI/2.0};
     prcopt_t *opt=&rtk->opt;
-    double r,rr[3],disp[3],pos[3],e[3],meas[2],dtdx[3],dantr[NFREQ]={0};
-    double dants[NFREQ]={0},var[MAXOBS*2],dtrp=0.0,vart=0.0,varm[2]={0};
-    int i,j,k,sat,sys,nv=0,nx=rtk->nx,brk,tideopt;
+    double r[MAXOBS],e[MAXOBS*3],azels[MAXOBS*2]={0},mapfh[MAXOBS];
+    double mapfw[MAXOBS],dantr[NFREQ*MAXOBS],phw[MAXOBS],zhd=0.0;
+    double rr[3],disp[3],pos[3],meas[2],dtdx[3],dants[NFREQ]={0};
+    double var[MAXOBS*2],dtrp=0.0,vart=0.0,varm[2]={0};
+    double dions[MAXOBS],vions[MAXOBS],dion[2];
+    int i,j,k,m,sat,sys,nv=0,nx=rtk->nx,brk,tideopt,stec[MAXOBS];
     
     trace(3,"res_ppp : n=%d nx=%d\n",n,nx);
     
@@ -901,13 +905,37 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     }
     ecef2pos(rr,pos);
     
-    for (i=0;i<n&&i<MAXOBS;i++) {
+    m=n<MAXOBS?n:MAXOBS;
+    
+    /* geometric distance/azimuth/elevation angle of all satellites */
+    geodists(rs,rr,m,r,e);
+    satazels(pos,e,r,m,azels);
+    
+    /* zenith hydrostatic delay and mapping functions */
+    if (opt->tropopt>=TROPOPT_EST) {
+        zhd=tropmodel(obs[0].time,pos,zazel,0.0);
+        tropmapfs(obs[0].time,pos,azels,m,mapfh,mapfw);
+    }
+    /* receiver antenna model */
+    antmodels(opt->pcvr,opt->antdel[0],azels,m,opt->posopt[1],dantr);
+    
+    /* phase windup correction */
+    if (opt->posopt[2]) {
+        for (i=0;i<m;i++) phw[i]=rtk->ssat[obs[i].sat-1].phw;
+        windupcorrs(rtk->sol.time,rs,rr,m,phw);
+    }
+    /* ionex tec model for all satellites */
+    if (opt->ionoopt==IONOOPT_TEC) {
+        iontecs(obs[0].time,nav,pos,azels,m,1,dions,vions,stec);
+    }
+    for (i=0;i<m;i++) {
         sat=obs[i].sat;
         if (!(sys=satsys(sat,NULL))||!rtk->ssat[sat-1].vs) continue;
         
         /* geometric distance/azimuth/elevation angle */
-        if ((r=geodist(rs+i*6,rr,e))<=0.0||
-            satazel(pos,e,azel+i*2)<opt->elmin) continue;
+        if (r[i]<=0.0) continue;
+        azel[i*2]=azels[i*2]; azel[1+i*2]=azels[1+i*2];
+        if (azel[1+i*2]<opt->elmin) continue;
         
         /* excluded satellite? */
         if (satexclude(obs[i].sat,svh[i],opt)) continue;
@@ -921,33 +949,41 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
             dtrp=sbstropcorr(obs[i].time,pos,azel+i*2,&vart);
         }
         else if (opt->tropopt==TROPOPT_EST||opt->tropopt==TROPOPT_ESTG) {
-            dtrp=prectrop(obs[i].time,pos,azel+i*2,opt,x+IT(opt),dtdx,&vart);
+            dtrp=prectrop(zhd,mapfh[i],mapfw[i],azel+i*2,opt,x+IT(opt),dtdx,
+                          &vart);
         }
         else if (opt->tropopt==TROPOPT_COR||opt->tropopt==TROPOPT_CORG) {
-            dtrp=prectrop(obs[i].time,pos,azel+i*2,opt,x,dtdx,&vart);
+            dtrp=prectrop(zhd,mapfh[i],mapfw[i],azel+i*2,opt,x,dtdx,&vart);
         }
         /* satellite antenna model */
         if (opt->posopt[0]) {
             satantpcv(rs+i*6,rr,nav->pcvs+sat-1,dants);
         }
-        /* receiver antenna model */
-        antmodel(opt->pcvr,opt->antdel[0],azel+i*2,opt->posopt[1],dantr);
-        
         /* phase windup correction */
         if (opt->posopt[2]) {
-            windupcorr(rtk->sol.time,rs+i*6,rr,&rtk->ssat[sat-1].phw);
+            rtk->ssat[sat-1].phw=phw[i];
+        }
+        /* ionospheric delay by ionex tec model */
+        if (opt->ionoopt==IONOOPT_TEC) {
+            if (!stec[i]) {
+                trace(2,"iono correction error: time=%s sat=%2d ionoopt=%d\n",
+                      time_str(obs[i].time,2),sat,opt->ionoopt);
+                continue;
+            }
+            dion[0]=dions[i]; dion[1]=vions[i];
         }
         /* ionosphere and antenna phase corrected measurements */
-        if (!corrmeas(obs+i,nav,pos,azel+i*2,&rtk->opt,dantr,dants,
-                      rtk->ssat[sat-1].phw,meas,varm,&brk)) {
+        if (!corrmeas(obs+i,nav,pos,azel+i*2,&rtk->opt,dantr+i*NFREQ,dants,
+                      rtk->ssat[sat-1].phw,opt->ionoopt==IONOOPT_TEC?dion:NULL,
+                      meas,varm,&brk)) {
             continue;
         }
         /* satellite clock and tropospheric delay */
-        r+=-CLIGHT*dts[i*2]+dtrp;
+        r[i]+=-CLIGHT*dts[i*2]+dtrp;
         
         trace(5,"sat=%2d azel=%6.1f %5.1f dtrp=%.3f dantr=%6.3f %6.3f dants=%6.3f %6.3f phw=%6.3f\n",
-              sat,azel[i*2]*R2D,azel[1+i*2]*R2D,dtrp,dantr[0],dantr[1],dants[0],
-              dants[1],rtk->ssat[sat-1].phw);
+              sat,azel[i*2]*R2D,azel[1+i*2]*R2D,dtrp,dantr[i*NFREQ],
+              dantr[1+i*NFREQ],dants[0],dants[1],rtk->ssat[sat-1].phw);
         
         for (j=0;j<2;j++) { /* for phase and code */
             
@@ -955,9 +991,9 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
             
             for (k=0;k<nx;k++) H[k+nx*nv]=0.0;
             
-            v[nv]=meas[j]-r;
+            v[nv]=meas[j]-r[i];
             
-            for (k=0;k<3;k++) H[k+nx*nv]=-e[k];
+            for (k=0;k<3;k++) H[k+nx*nv]=-e[k+i*3];
             
             if (sys!=SYS_GLO) {
                 v[nv]-=x[IC(0,opt)];
@@ -1014,7 +1050,7 @@ extern int pppnx(const prcopt_t *opt)
 extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
 {
     const prcopt_t *opt=&rtk->opt;
-    double *rs,*dts,*var,*v,*H,*R,*azel,*xp,*Pp;
+    double *rs,*dts,*var,*v,*H,*R,*azel,*xp,*Pp,tick;
     int i,nv,info,svh[MAXOBS],stat=SOLQ_SINGLE;
     
     trace(3,"pppos   : nx=%d n=%d\n",rtk->nx,n);
@@ -1029,7 +1065,9 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     trace(4,"x(0)="); tracemat(4,rtk->x,1,NR(opt),13,4);
     
     /* satellite positions and clocks */
+    tick=prftick();
     satposs(obs[0].time,obs,n,nav,rtk->opt.sateph,rs,dts,var,svh);
+    prfadd(rtk->prf+PRF_SATPOS,tick);
     
     /* exclude measurements of eclipsing satellite */
     if (rtk->opt.posopt[3]) {
@@ -1042,12 +1080,19 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     for (i=0;i<rtk->opt.niter;i++) {
         
         /* phase and code residuals */
-        if ((nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel))<=0) break;
+        tick=prftick();
+        nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel);
+        prfadd(rtk->prf+PRF_ZDRES,tick);
+        if (nv<=0) break;
         
         /* measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
         
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        tick=prftick();
+        info=filter(xp,Pp,H,v,R,rtk->nx,nv);
+        prfadd(rtk->prf+PRF_FILTER,tick);
+        
+        if (info) {
             trace(2,"ppp filter error %s info=%d\n",time_str(rtk->sol.time,0),
                   info);
             break;
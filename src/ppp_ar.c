@@ -11,6 +11,7 @@
 *
 * version : $Revision:$ $Date:$
 * history : 2013/03/11 1.0  new
+*           2026/10/18 1.1  add stage timing profile of lambda()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -358,6 +359,7 @@ static int fix_amb_ROUND(rtk_t *rtk, int *sat1, int *sat2, const int *NW, int n)
 static int fix_amb_ILS(rtk_t *rtk, int *sat1, int *sat2, int *NW, int n)
 {
     double C1,C2,*B1,*N1,*NC,*D,*E,*Q,s[2],lam_NL=lam_LC(1,1,0),lam1,lam2;
+    double tick;
     int i,j,k,m=0,info,stat,flgs[MAXSAT]={0},max_flg=0;
     
     lam1=lam_carr[0]; lam2=lam_carr[1];
@@ -398,7 +400,11 @@ static int fix_amb_ILS(rtk_t *rtk, int *sat1, int *sat2, int *NW, int n)
     matmul("NN",m,m,rtk->nx,1.0,E,D,0.0,Q);
     
     /* integer least square */
-    if ((info=lambda(m,2,B1,Q,N1,s))) {
+    tick=prftick();
+    info=lambda(m,2,B1,Q,N1,s);
+    prfadd(rtk->prf+PRF_LAMBDA,tick);
+    
+    if (info) {
         trace(2,"lambda error: info=%d\n",info);
         return 0;
     }
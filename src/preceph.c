@@ -38,6 +38,9 @@
 *                           change api: satantoff()
 *           2014/08/31 1.13 add member cov and vco in peph_t sturct
 *           2014/10/13 1.14 fix bug on clock error variance in peph2pos()
+*           2026/10/18 1.15 add api readsp3s()
+*                           read sp3 files by concurrent threads
+*                           merge appended epochs without re-sorting
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -49,6 +52,21 @@ static const char rcsid[]="$Id:$";
 #define MAXDTE      900.0           /* max time difference to ephem time (s) */
 #define EXTERR_CLK  1E-3            /* extrapolation error for clock (m/s) */
 #define EXTERR_EPH  5E-7            /* extrapolation error for ephem (m/s^2) */
+#define NTHREAD     4               /* number of threads to read sp3 files */
+
+typedef struct {                    /* precise ephemeris sort key type */
+    gtime_t time;                   /* epoch time */
+    int index;                      /* ephemeris set index */
+    int i;                          /* record index (<0: combined) */
+} pkey_t;
+
+typedef struct {                    /* sp3 file read thread type */
+    const char *file;               /* sp3 file */
+    int index,opt;                  /* ephemeris set index, option */
+    nav_t nav;                      /* read precise ephemeris */
+    thread_t thread;                /* thread */
+    int run;                        /* thread running flag */
+} sp3thr_t;
 
 /* satellite code to satellite system ----------------------------------------*/
 static int code2sys(char code)
@@ -103,7 +121,7 @@ static int addpeph(nav_t *nav, peph_t *peph)
     peph_t *nav_peph;
     
     if (nav->ne>=nav->nemax) {
-        nav->nemax+=256;
+        nav->nemax=nav->nemax<=0?256:nav->nemax*2;
         if (!(nav_peph=(peph_t *)realloc(nav->peph,sizeof(peph_t)*nav->nemax))) {
             trace(1,"readsp3b malloc error n=%d\n",nav->nemax);
             free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;
@@ -200,41 +218,234 @@ static void readsp3b(FILE *fp, char type, int *sats, int ns, double *bfact,
         }
     }
 }
-/* compare precise ephemeris -------------------------------------------------*/
-static int cmppeph(const void *p1, const void *p2)
+/* compare precise ephemeris sort key ----------------------------------------*/
+static int cmppkey(const void *p1, const void *p2)
 {
-    peph_t *q1=(peph_t *)p1,*q2=(peph_t *)p2;
+    pkey_t *q1=(pkey_t *)p1,*q2=(pkey_t *)p2;
     double tt=timediff(q1->time,q2->time);
-    return tt<-1E-9?-1:(tt>1E-9?1:q1->index-q2->index);
+    return tt<-1E-9?-1:(tt>1E-9?1:(q1->index!=q2->index?q1->index-q2->index:
+           q1->i-q2->i));
+}
+/* search precise ephemeris epoch by binary search ---------------------------*/
+static int searchpeph(const peph_t *peph, int n, gtime_t time)
+{
+    int i=0,j=n,k;
+    
+    while (i<j) {
+        k=(i+j)/2;
+        if (timediff(peph[k].time,time)<-1E-9) i=k+1; else j=k;
+    }
+    return i<n&&fabs(timediff(peph[i].time,time))<1E-9?i:-1;
+}
+/* combine satellites of precise ephemeris -----------------------------------*/
+static void combsat(peph_t *peph1, const peph_t *peph2)
+{
+    int k,m;
+    
+    for (k=0;k<MAXSAT;k++) {
+        if (norm(peph2->pos[k],4)<=0.0) continue;
+        for (m=0;m<4;m++) peph1->pos[k][m]=peph2->pos[k][m];
+        for (m=0;m<4;m++) peph1->std[k][m]=peph2->std[k][m];
+        for (m=0;m<4;m++) peph1->vel[k][m]=peph2->vel[k][m];
+        for (m=0;m<4;m++) peph1->vst[k][m]=peph2->vst[k][m];
+    }
+}
+/* permute precise ephemeris in place (peph[i]<-peph[perm[i]]) ---------------*/
+static void permpeph(peph_t *peph, int *perm, int n)
+{
+    peph_t tmp;
+    int i,j,k;
+    
+    for (i=0;i<n;i++) {
+        if (perm[i]==i) continue;
+        tmp=peph[i];
+        for (j=i;perm[j]!=i;j=k) {
+            k=perm[j];
+            peph[j]=peph[k];
+            perm[j]=j;
+        }
+        peph[j]=tmp;
+        perm[j]=j;
+    }
 }
 /* combine precise ephemeris -------------------------------------------------*/
-static void combpeph(nav_t *nav, int opt)
+static void combpeph(nav_t *nav, int n0, int opt)
+{
+    pkey_t *key;
+    int i,j,k,m,n,*perm=NULL;
+    
+    trace(3,"combpeph: ne=%d n0=%d\n",nav->ne,n0);
+    
+    /* nav->peph[0:n0-1] are already sorted and combined */
+    if ((n=nav->ne-n0)<=0) return;
+    
+    if (!(key=(pkey_t *)malloc(sizeof(pkey_t)*n))||
+        !(perm=(int *)malloc(sizeof(int)*nav->ne))) {
+        trace(1,"combpeph malloc error ne=%d\n",nav->ne);
+        free(key);
+        return;
+    }
+    /* sort keys of appended epochs instead of records */
+    for (i=0;i<n;i++) {
+        key[i].time =nav->peph[n0+i].time;
+        key[i].index=nav->peph[n0+i].index;
+        key[i].i=n0+i;
+    }
+    for (i=1;i<n;i++) if (cmppkey(key+i-1,key+i)>0) break;
+    if (i<n) qsort(key,n,sizeof(pkey_t),cmppkey);
+    
+    /* combine satellites of same epoch (later set precedes) */
+    for (i=0,k=-1;!(opt&4)&&i<n;i++) {
+        if (i>0&&fabs(timediff(key[i].time,key[i-1].time))<1E-9) {
+            combsat(nav->peph+k,nav->peph+key[i].i);
+            key[i].i=-key[i].i-1;
+        }
+        else if ((k=searchpeph(nav->peph,n0,key[i].time))>=0) {
+            combsat(nav->peph+k,nav->peph+key[i].i);
+            key[i].i=-key[i].i-1;
+        }
+        else k=key[i].i;
+    }
+    /* merge appended epochs into existing ones and drop combined ones */
+    for (i=j=m=0;i<n0||j<n;) {
+        if (j<n&&key[j].i<0) j++;
+        else if (j>=n||(i<n0&&timediff(nav->peph[i].time,key[j].time)<1E-9)) {
+            perm[m++]=i++;
+        }
+        else perm[m++]=key[j++].i;
+    }
+    for (j=0,n=m;j<nav->ne-n0;j++) {
+        if (key[j].i<0) perm[n++]=-key[j].i-1;
+    }
+    permpeph(nav->peph,perm,nav->ne);
+    nav->ne=m;
+    
+    free(key); free(perm);
+    
+    trace(4,"combpeph: ne=%d\n",nav->ne);
+}
+/* read sp3 precise ephemeris file -------------------------------------------*/
+static void readsp3f(const char *file, int index, int opt, nav_t *nav)
+{
+    FILE *fp;
+    gtime_t time={0};
+    double bfact[2]={0};
+    int ns,sats[MAXSAT]={0};
+    char type=' ',tsys[4]="";
+    
+    trace(3,"readsp3f: file=%s index=%d\n",file,index);
+    
+    if (!(fp=fopen(file,"r"))) {
+        trace(2,"sp3 file open error %s\n",file);
+        return;
+    }
+    /* read sp3 header */
+    ns=readsp3h(fp,&time,&type,sats,bfact,tsys);
+    
+    /* read sp3 body */
+    readsp3b(fp,type,sats,ns,bfact,tsys,index,opt,nav);
+    
+    fclose(fp);
+}
+/* sp3 file read thread ------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI sp3thread(void *arg)
+#else
+static void *sp3thread(void *arg)
+#endif
 {
-    int i,j,k,m;
+    sp3thr_t *th=(sp3thr_t *)arg;
     
-    trace(3,"combpeph: ne=%d\n",nav->ne);
+    readsp3f(th->file,th->index,th->opt,&th->nav);
+    return 0;
+}
+/* append precise ephemeris --------------------------------------------------*/
+static int appendpeph(nav_t *nav, const nav_t *src)
+{
+    peph_t *nav_peph;
+    int nmax=nav->nemax;
+    
+    if (nav->ne+src->ne>nmax) {
+        while (nav->ne+src->ne>nmax) nmax=nmax<=0?256:nmax*2;
+        if (!(nav_peph=(peph_t *)realloc(nav->peph,sizeof(peph_t)*nmax))) {
+            trace(1,"appendpeph malloc error n=%d\n",nmax);
+            return 0;
+        }
+        nav->peph=nav_peph;
+        nav->nemax=nmax;
+    }
+    memcpy(nav->peph+nav->ne,src->peph,sizeof(peph_t)*src->ne);
+    nav->ne+=src->ne;
+    return 1;
+}
+/* read sp3 precise ephemeris files --------------------------------------------
+* read sp3 precise ephemeris/clock files and set them to navigation data
+* args   : char   **files     I   sp3-c precise ephemeris files
+*          int    n           I   number of files
+*          nav_t  *nav        IO  navigation data
+*          int    opt         I   options (1: only observed + 2: only predicted +
+*                                 4: not combined)
+* return : none
+* notes  : see ref [1]
+*          the files are parsed by concurrent threads and the ephemerides are
+*          appended in the order of the files. the epochs of the same time are
+*          combined by satellite, where the later file precedes.
+*          the appended epochs are merged into the existing ones of nav->peph
+*          (sorted and combined by previous call) without re-sorting them.
+*          only files with extensions of .sp3, .SP3, .eph* and .EPH* are read
+*-----------------------------------------------------------------------------*/
+extern void readsp3s(char **files, int n, nav_t *nav, int opt)
+{
+    sp3thr_t *th;
+    nav_t nav0={0};
+    int i,j,k,m=0,n0=nav->ne,stat=1;
+    char *ext;
     
-    qsort(nav->peph,nav->ne,sizeof(peph_t),cmppeph);
+    trace(3,"readsp3s: n=%d\n",n);
     
-    if (opt&4) return;
+    if (n<=0||!(th=(sp3thr_t *)malloc(sizeof(sp3thr_t)*NTHREAD))) return;
     
-    for (i=0,j=1;j<nav->ne;j++) {
+    for (i=0;stat&&i<n;i+=k) {
         
-        if (fabs(timediff(nav->peph[i].time,nav->peph[j].time))<1E-9) {
+        /* read sp3 files by threads */
+        for (k=0;k<NTHREAD&&i+k<n;k++) {
+            th[k].file=files[i+k];
+            th[k].opt=opt;
+            th[k].nav=nav0;
+            th[k].run=0;
             
-            for (k=0;k<MAXSAT;k++) {
-                if (norm(nav->peph[j].pos[k],4)<=0.0) continue;
-                for (m=0;m<4;m++) nav->peph[i].pos[k][m]=nav->peph[j].pos[k][m];
-                for (m=0;m<4;m++) nav->peph[i].std[k][m]=nav->peph[j].std[k][m];
-                for (m=0;m<4;m++) nav->peph[i].vel[k][m]=nav->peph[j].vel[k][m];
-                for (m=0;m<4;m++) nav->peph[i].vst[k][m]=nav->peph[j].vst[k][m];
+            if (!(ext=strrchr(files[i+k],'.'))) continue;
+            
+            if (!strstr(ext+1,"sp3")&&!strstr(ext+1,".SP3")&&
+                !strstr(ext+1,"eph")&&!strstr(ext+1,".EPH")) continue;
+            
+            th[k].index=m++;
+#ifdef WIN32
+            if ((th[k].thread=CreateThread(NULL,0,sp3thread,th+k,0,NULL))) {
+#else
+            if (!pthread_create(&th[k].thread,NULL,sp3thread,th+k)) {
+#endif
+                th[k].run=1;
             }
+            else sp3thread(th+k);
         }
-        else if (++i<j) nav->peph[i]=nav->peph[j];
+        for (j=0;j<k;j++) {
+            if (th[j].run) {
+#ifdef WIN32
+                WaitForSingleObject(th[j].thread,INFINITE);
+                CloseHandle(th[j].thread);
+#else
+                pthread_join(th[j].thread,NULL);
+#endif
+            }
+            if (stat&&th[j].nav.ne>0) stat=appendpeph(nav,&th[j].nav);
+            free(th[j].nav.peph);
+        }
+        /* combine appended precise ephemeris */
+        combpeph(nav,n0,opt);
+        n0=nav->ne;
     }
-    nav->ne=i+1;
-    
-    trace(4,"combpeph: ne=%d\n",nav->ne);
+    free(th);
 }
 /* read sp3 precise ephemeris file ---------------------------------------------
 * read sp3 precise ephemeris/clock files and set them to navigation data
@@ -252,11 +463,8 @@ static void combpeph(nav_t *nav, int opt)
 *-----------------------------------------------------------------------------*/
 extern void readsp3(const char *file, nav_t *nav, int opt)
 {
-    FILE *fp;
-    gtime_t time={0};
-    double bfact[2]={0};
-    int i,j,n,ns,sats[MAXSAT]={0};
-    char *efiles[MAXEXFILE],*ext,type=' ',tsys[4]="";
+    char *efiles[MAXEXFILE];
+    int i,n;
     
     trace(3,"readpephs: file=%s\n",file);
     
@@ -269,28 +477,10 @@ extern void readsp3(const char *file, nav_t *nav, int opt)
     /* expand wild card in file path */
     n=expath(file,efiles,MAXEXFILE);
     
-    for (i=j=0;i<n;i++) {
-        if (!(ext=strrchr(efiles[i],'.'))) continue;
-        
-        if (!strstr(ext+1,"sp3")&&!strstr(ext+1,".SP3")&&
-            !strstr(ext+1,"eph")&&!strstr(ext+1,".EPH")) continue;
-        
-        if (!(fp=fopen(efiles[i],"r"))) {
-            trace(2,"sp3 file open error %s\n",efiles[i]);
-            continue;
-        }
-        /* read sp3 header */
-        ns=readsp3h(fp,&time,&type,sats,bfact,tsys);
-        
-        /* read sp3 body */
-        readsp3b(fp,type,sats,ns,bfact,tsys,j++,opt,nav);
-        
-        fclose(fp);
-    }
-    for (i=0;i<MAXEXFILE;i++) free(efiles[i]);
+    /* read sp3 files */
+    readsp3s(efiles,n,nav,opt);
     
-    /* combine precise ephemeris */
-    if (nav->ne>0) combpeph(nav,opt);
+    for (i=0;i<MAXEXFILE;i++) free(efiles[i]);
 }
 /* read satellite antenna parameters -------------------------------------------
 * read satellite antenna parameters
@@ -12,6 +12,7 @@
 *           2013/04/15 1.1 support 0x01-05 beidou-2/compass ephemeris
 *           2013/05/18 1.2 fix bug on decoding obsflags in message 0x7f-05
 *           2014/04/27 1.3 fix bug on decoding iode for message 0x01-02
+*           2026/10/18 1.4 use gpst2time() for gps time reference
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -344,7 +345,6 @@ static int decode_bnx_00_7f(raw_t *raw, unsigned char *buff, int len)
 /* decode binex mesaage 0x00: site/monument/marker/ref point/setup metadata --*/
 static int decode_bnx_00(raw_t *raw, unsigned char *buff, int len)
 {
-    const static double gpst0[]={1980,1,6,0,0,0};
     char *msg;
     unsigned char *p=buff;
     unsigned int min,qsec,src,fid;
@@ -354,7 +354,7 @@ static int decode_bnx_00(raw_t *raw, unsigned char *buff, int len)
     qsec=U1(p); p+=1;
     src =U1(p); p+=1;
     n+=getbnxi(p,&fid);
-    raw->time=timeadd(epoch2time(gpst0),min*60.0+qsec*0.25);
+    raw->time=timeadd(gpst2time(0,0.0),min*60.0+qsec*0.25);
     
     if (raw->outtype) {
         msg=raw->msgtype+strlen(raw->msgtype);
@@ -1096,7 +1096,6 @@ static int decode_bnx_7f_05(raw_t *raw, unsigned char *buff, int len)
 /* decode binex mesaage 0x7f: gnss data prototyping --------------------------*/
 static int decode_bnx_7f(raw_t *raw, unsigned char *buff, int len)
 {
-    const static double gpst0[]={1980,1,6,0,0,0};
     char *msg;
     unsigned char *p=buff;
     unsigned int srec,min,msec;
@@ -1104,7 +1103,7 @@ static int decode_bnx_7f(raw_t *raw, unsigned char *buff, int len)
     srec=U1(p); p+=1; /* subrecord id */
     min =U4(p); p+=4;
     msec=U2(p); p+=2;
-    raw->time=timeadd(epoch2time(gpst0),min*60.0+msec*0.001);
+    raw->time=timeadd(gpst2time(0,0.0),min*60.0+msec*0.001);
     
     if (raw->outtype) {
         msg=raw->msgtype+strlen(raw->msgtype);
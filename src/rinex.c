@@ -81,6 +81,10 @@
 *           2014/08/29 1.22 fix bug on reading gps "C2" in rinex 2.11 or 2.12
 *           2014/10/20 1.23 recognize "C2" in 2.12 as "C2W" instead of "C2D"
 *           2014/12/07 1.24 add read rinex option -SYS=...
+*           2026/10/18 1.25 add api readrnxcs()
+*                           read rinex clock files by concurrent threads
+*                           merge appended clock epochs without re-sorting
+*           2026/10/18 1.26 clear obs types of previous file in open_rnxctr()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -96,6 +100,22 @@ static const char rcsid[]="$Id:$";
 #define MINFREQ_GLO -7                  /* min frequency number glonass */
 #define MAXFREQ_GLO 13                  /* max frequency number glonass */
 #define NINCOBS     262144              /* inclimental number of obs data */
+#define NTHREAD     4                   /* number of threads to read clock */
+
+typedef struct {                        /* precise clock sort key type */
+    gtime_t time;                       /* epoch time */
+    int index;                          /* clock set index */
+    int i;                              /* record index (<0: combined) */
+} pkey_t;
+
+typedef struct {                        /* rinex clock file read thread type */
+    const char *file;                   /* rinex clock file */
+    int index;                          /* clock set index */
+    int stat;                           /* read status */
+    nav_t nav;                          /* read precise clock */
+    thread_t thread;                    /* thread */
+    int run;                            /* thread running flag */
+} clkthr_t;
 
 static const int navsys[]={             /* satellite systems */
     SYS_GPS,SYS_GLO,SYS_GAL,SYS_QZS,SYS_SBS,SYS_CMP,0
@@ -1366,7 +1386,7 @@ static int readrnxclk(FILE *fp, const char *opt, int index, nav_t *nav)
         for (i=0,j=40;i<2;i++,j+=20) data[i]=str2num(buff,j,19);
         
         if (nav->nc>=nav->ncmax) {
-            nav->ncmax+=1024;
+            nav->ncmax=nav->ncmax<=0?1024:nav->ncmax*2;
             if (!(nav_pclk=(pclk_t *)realloc(nav->pclk,sizeof(pclk_t)*(nav->ncmax)))) {
                 trace(1,"readrnxclk malloc error: nmax=%d\n",nav->ncmax);
                 free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;
@@ -1529,36 +1549,108 @@ extern int readrnx(const char *file, int rcv, const char *opt, obs_t *obs,
     
     return readrnxt(file,rcv,t,t,0.0,opt,obs,nav,sta);
 }
-/* compare precise clock -----------------------------------------------------*/
-static int cmppclk(const void *p1, const void *p2)
+/* compare precise clock sort key --------------------------------------------*/
+static int cmppkey(const void *p1, const void *p2)
 {
-    pclk_t *q1=(pclk_t *)p1,*q2=(pclk_t *)p2;
+    pkey_t *q1=(pkey_t *)p1,*q2=(pkey_t *)p2;
     double tt=timediff(q1->time,q2->time);
-    return tt<-1E-9?-1:(tt>1E-9?1:q1->index-q2->index);
+    return tt<-1E-9?-1:(tt>1E-9?1:(q1->index!=q2->index?q1->index-q2->index:
+           q1->i-q2->i));
+}
+/* search precise clock epoch by binary search -------------------------------*/
+static int searchpclk(const pclk_t *pclk, int n, gtime_t time)
+{
+    int i=0,j=n,k;
+    
+    while (i<j) {
+        k=(i+j)/2;
+        if (timediff(pclk[k].time,time)<-1E-9) i=k+1; else j=k;
+    }
+    return i<n&&fabs(timediff(pclk[i].time,time))<1E-9?i:-1;
+}
+/* combine satellites of precise clock ---------------------------------------*/
+static void combsat(pclk_t *pclk1, const pclk_t *pclk2)
+{
+    int k;
+    
+    for (k=0;k<MAXSAT;k++) {
+        if (pclk2->clk[k][0]==0.0) continue;
+        pclk1->clk[k][0]=pclk2->clk[k][0];
+        pclk1->std[k][0]=pclk2->std[k][0];
+    }
+}
+/* permute precise clock in place (pclk[i]<-pclk[perm[i]]) -------------------*/
+static void permpclk(pclk_t *pclk, int *perm, int n)
+{
+    pclk_t tmp;
+    int i,j,k;
+    
+    for (i=0;i<n;i++) {
+        if (perm[i]==i) continue;
+        tmp=pclk[i];
+        for (j=i;perm[j]!=i;j=k) {
+            k=perm[j];
+            pclk[j]=pclk[k];
+            perm[j]=j;
+        }
+        pclk[j]=tmp;
+        perm[j]=j;
+    }
 }
 /* combine precise clock -----------------------------------------------------*/
-static void combpclk(nav_t *nav)
+static void combpclk(nav_t *nav, int n0)
 {
     pclk_t *nav_pclk;
-    int i,j,k;
+    pkey_t *key;
+    int i,j,k,m,n,*perm=NULL;
     
-    trace(3,"combpclk: nc=%d\n",nav->nc);
+    trace(3,"combpclk: nc=%d n0=%d\n",nav->nc,n0);
     
-    if (nav->nc<=0) return;
+    /* nav->pclk[0:n0-1] are already sorted and combined */
+    if ((n=nav->nc-n0)<=0) return;
     
-    qsort(nav->pclk,nav->nc,sizeof(pclk_t),cmppclk);
+    if (!(key=(pkey_t *)malloc(sizeof(pkey_t)*n))||
+        !(perm=(int *)malloc(sizeof(int)*nav->nc))) {
+        trace(1,"combpclk malloc error nc=%d\n",nav->nc);
+        free(key);
+        return;
+    }
+    /* sort keys of appended epochs instead of records */
+    for (i=0;i<n;i++) {
+        key[i].time =nav->pclk[n0+i].time;
+        key[i].index=nav->pclk[n0+i].index;
+        key[i].i=n0+i;
+    }
+    for (i=1;i<n;i++) if (cmppkey(key+i-1,key+i)>0) break;
+    if (i<n) qsort(key,n,sizeof(pkey_t),cmppkey);
     
-    for (i=0,j=1;j<nav->nc;j++) {
-        if (fabs(timediff(nav->pclk[i].time,nav->pclk[j].time))<1E-9) {
-            for (k=0;k<MAXSAT;k++) {
-                if (nav->pclk[j].clk[k][0]==0.0) continue;
-                nav->pclk[i].clk[k][0]=nav->pclk[j].clk[k][0];
-                nav->pclk[i].std[k][0]=nav->pclk[j].std[k][0];
-            }
+    /* combine satellites of same epoch (later set precedes) */
+    for (i=0,k=-1;i<n;i++) {
+        if (i>0&&fabs(timediff(key[i].time,key[i-1].time))<1E-9) {
+            combsat(nav->pclk+k,nav->pclk+key[i].i);
+            key[i].i=-key[i].i-1;
         }
-        else if (++i<j) nav->pclk[i]=nav->pclk[j];
+        else if ((k=searchpclk(nav->pclk,n0,key[i].time))>=0) {
+            combsat(nav->pclk+k,nav->pclk+key[i].i);
+            key[i].i=-key[i].i-1;
+        }
+        else k=key[i].i;
+    }
+    /* merge appended epochs into existing ones and drop combined ones */
+    for (i=j=m=0;i<n0||j<n;) {
+        if (j<n&&key[j].i<0) j++;
+        else if (j>=n||(i<n0&&timediff(nav->pclk[i].time,key[j].time)<1E-9)) {
+            perm[m++]=i++;
+        }
+        else perm[m++]=key[j++].i;
     }
-    nav->nc=i+1;
+    for (j=0,n=m;j<nav->nc-n0;j++) {
+        if (key[j].i<0) perm[n++]=-key[j].i-1;
+    }
+    permpclk(nav->pclk,perm,nav->nc);
+    nav->nc=m;
+    
+    free(key); free(perm);
     
     if (!(nav_pclk=(pclk_t *)realloc(nav->pclk,sizeof(pclk_t)*nav->nc))) {
         free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;
@@ -1570,6 +1662,102 @@ static void combpclk(nav_t *nav)
     
     trace(4,"combpclk: nc=%d\n",nav->nc);
 }
+/* rinex clock file read thread ----------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI clkthread(void *arg)
+#else
+static void *clkthread(void *arg)
+#endif
+{
+    clkthr_t *th=(clkthr_t *)arg;
+    gtime_t t={0};
+    char type;
+    
+    th->stat=readrnxfile(th->file,t,t,0.0,"",1,th->index,&type,NULL,&th->nav,
+                         NULL);
+    return 0;
+}
+/* append precise clock ------------------------------------------------------*/
+static int appendpclk(nav_t *nav, const nav_t *src)
+{
+    pclk_t *nav_pclk;
+    int nmax=nav->ncmax;
+    
+    if (nav->nc+src->nc>nmax) {
+        while (nav->nc+src->nc>nmax) nmax=nmax<=0?1024:nmax*2;
+        if (!(nav_pclk=(pclk_t *)realloc(nav->pclk,sizeof(pclk_t)*nmax))) {
+            trace(1,"appendpclk malloc error n=%d\n",nmax);
+            return 0;
+        }
+        nav->pclk=nav_pclk;
+        nav->ncmax=nmax;
+    }
+    memcpy(nav->pclk+nav->nc,src->pclk,sizeof(pclk_t)*src->nc);
+    nav->nc+=src->nc;
+    return 1;
+}
+/* read rinex clock files ------------------------------------------------------
+* read rinex clock files
+* args   : char **files  I      rinex clock files
+*          int   n       I      number of files
+*          nav_t *nav    IO     navigation data
+* return : number of precise clock
+* notes  : the files are parsed by concurrent threads and the clocks are
+*          appended in the order of the files. files other than rinex clock
+*          are skipped. the epochs of the same time are combined by satellite,
+*          where the later file precedes.
+*          the appended epochs are merged into the existing ones of nav->pclk
+*          (sorted and combined by previous call) without re-sorting them.
+*-----------------------------------------------------------------------------*/
+extern int readrnxcs(char **files, int n, nav_t *nav)
+{
+    clkthr_t *th;
+    nav_t nav0={0};
+    int i,j,k,n0=nav->nc,stat=1;
+    
+    trace(3,"readrnxcs: n=%d\n",n);
+    
+    if (n<=0||!(th=(clkthr_t *)malloc(sizeof(clkthr_t)*NTHREAD))) return 0;
+    
+    for (i=0;stat&&i<n;i+=k) {
+        
+        /* read rinex clock files by threads */
+        for (k=0;k<NTHREAD&&i+k<n;k++) {
+            th[k].file=files[i+k];
+            th[k].index=i+k;
+            th[k].nav=nav0;
+            th[k].run=0;
+#ifdef WIN32
+            if ((th[k].thread=CreateThread(NULL,0,clkthread,th+k,0,NULL))) {
+#else
+            if (!pthread_create(&th[k].thread,NULL,clkthread,th+k)) {
+#endif
+                th[k].run=1;
+            }
+            else clkthread(th+k);
+        }
+        for (j=0;j<k;j++) {
+            if (th[j].run) {
+#ifdef WIN32
+                WaitForSingleObject(th[j].thread,INFINITE);
+                CloseHandle(th[j].thread);
+#else
+                pthread_join(th[j].thread,NULL);
+#endif
+            }
+            if (stat&&th[j].stat&&th[j].nav.nc>0) {
+                stat=appendpclk(nav,&th[j].nav);
+            }
+            free(th[j].nav.pclk);
+        }
+        /* combine appended precise clock */
+        combpclk(nav,n0);
+        n0=nav->nc;
+    }
+    free(th);
+    
+    return nav->nc;
+}
 /* read rinex clock files ------------------------------------------------------
 * read rinex clock files
 * args   : char *file    I      file (wild-card * expanded)
@@ -1578,9 +1766,8 @@ static void combpclk(nav_t *nav)
 *-----------------------------------------------------------------------------*/
 extern int readrnxc(const char *file, nav_t *nav)
 {
-    gtime_t t={0};
-    int i,n,index=0,stat=1;
-    char *files[MAXEXFILE]={0},type;
+    int i,n;
+    char *files[MAXEXFILE]={0};
     
     trace(3,"readrnxc: file=%s\n",file);
     
@@ -1593,21 +1780,11 @@ extern int readrnxc(const char *file, nav_t *nav)
     n=expath(file,files,MAXEXFILE);
     
     /* read rinex clock files */
-    for (i=0;i<n;i++) {
-        if (readrnxfile(files[i],t,t,0.0,"",1,index++,&type,NULL,nav,NULL)) {
-            continue;
-        }
-        stat=0;
-        break;
-    }
-    for (i=0;i<MAXEXFILE;i++) free(files[i]);
+    n=readrnxcs(files,n,nav);
     
-    if (!stat) return 0;
-    
-    /* unique and combine ephemeris and precise clock */
-    combpclk(nav);
+    for (i=0;i<MAXEXFILE;i++) free(files[i]);
     
-    return nav->nc;
+    return n;
 }
 /* initialize rinex control ----------------------------------------------------
 * initialize rinex control struct and reallocate memory for observation and
@@ -1698,7 +1875,7 @@ extern int open_rnxctr(rnxctr_t *rnx, FILE *fp)
     rnx->type=type;
     rnx->sys=sys;
     rnx->tsys=tsys;
-    for (i=0;i<6;i++) for (j=0;j<MAXOBSTYPE&&*tobs[i][j];j++) {
+    for (i=0;i<6;i++) for (j=0;j<MAXOBSTYPE;j++) { /* clear previous types */
         strcpy(rnx->tobs[i][j],tobs[i][j]);
     }
     rnx->ephsat=0;
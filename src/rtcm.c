@@ -42,6 +42,7 @@
 *                           add options to select used codes for msm
 *           2013/04/27 1.7  comply with rtcm 3.2 with amendment 1/2 (ref[15])
 *           2013/12/06 1.8  support SBAS/BeiDou SSR messages (ref[16])
+*           2026/10/18 1.9  initialize msm encoder layouts in init_rtcm()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -96,6 +97,10 @@ extern int init_rtcm(rtcm_t *rtcm)
         rtcm->lock[i][j]=rtcm->loss[i][j]=0;
         rtcm->lltime[i][j]=time0;
     }
+    for (i=0;i<6;i++) {
+        rtcm->msmlay[i].time=time0;
+        rtcm->msmlay[i].n=-1;
+    }
     rtcm->nbyte=rtcm->nbit=rtcm->len=0;
     rtcm->word=0;
     for (i=0;i<100;i++) rtcm->nmsg2[i]=0;
@@ -23,6 +23,7 @@
 *           2014/09/14 1.7  add receiver option -RT_INP
 *           2014/12/06 1.8  support SBAS/BeiDou SSR messages (ref [16])
 *           2015/03/22 1.9  add handling of iodcrc for beidou/sbas ssr messages
+*           2026/10/18 1.10 decode msm masks and fields by batch bit extraction
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -91,10 +92,72 @@ const char *msm_sig_cmp[32]={
     ""  ,"7I","7Q","7X",""  ,""  ,""  ,""  ,""  ,""  ,""  ,""  ,
     ""  ,""  ,""  ,""  ,""  ,""  ,""  ,""
 };
+/* number of leading zeros of 4 bits -----------------------------------------*/
+static const unsigned char nlz4[16]={4,3,2,2,1,1,1,1,0,0,0,0,0,0,0,0};
+
 /* ssr update intervals ------------------------------------------------------*/
 static const double ssrudint[16]={
     1,2,5,10,15,30,60,120,240,300,600,900,1800,3600,7200,10800
 };
+/* extract unsigned/signed bit fields -----------------------------------------
+* extract n bit fields of same length (len<=24) stored contiguously from pos
+* (n<=64 for signed). the bytes are read only once by the shift register.
+*-----------------------------------------------------------------------------*/
+static void getbitua(const unsigned char *buff, int pos, int len, int n,
+                     unsigned int *val)
+{
+    const unsigned char *p=buff+pos/8;
+    unsigned int reg=*p++&(0xFFu>>(pos%8)),mask=(1u<<len)-1;
+    int i,nb=8-pos%8;
+    
+    for (i=0;i<n;i++) {
+        while (nb<len) {
+            reg=(reg<<8)|*p++; nb+=8;
+        }
+        nb-=len;
+        val[i]=(reg>>nb)&mask;
+    }
+}
+static void getbitsa(const unsigned char *buff, int pos, int len, int n,
+                     int *val)
+{
+    unsigned int u[64],sign=1u<<(len-1),ext=~((1u<<len)-1);
+    int i;
+    
+    getbitua(buff,pos,len,n,u);
+    for (i=0;i<n;i++) val[i]=(int)(u[i]&sign?u[i]|ext:u[i]);
+}
+/* extract bit mask ------------------------------------------------------------
+* extract bit mask of len bits (len<=64) and get indexes of set bits
+* args   : unsigned char *buff I byte data
+*          int    pos    I      bit position of mask (bits)
+*          int    len    I      bit length of mask (bits)
+*          unsigned char *ind  O indexes of set bits (1:msb,...) (NULL: no out)
+*          unsigned char *bits O mask bits (0/1) (NULL: no output)
+* return : number of set bits
+*-----------------------------------------------------------------------------*/
+static int getbitmask(const unsigned char *buff, int pos, int len,
+                      unsigned char *ind, unsigned char *bits)
+{
+    unsigned int w[16],m;
+    int i,j,k,n=0,nw=(len+3)/4;
+    
+    getbitua(buff,pos,4,len/4,w);
+    if (len%4) w[nw-1]=getbitu(buff,pos+len/4*4,len%4)<<(4-len%4);
+    
+    for (i=0;i<nw;i++) {
+        if (bits) {
+            for (j=0;j<4&&i*4+j<len;j++) {
+                bits[i*4+j]=(unsigned char)((w[i]>>(3-j))&1);
+            }
+        }
+        for (m=w[i];m;m&=~(8u>>k),n++) {
+            k=nlz4[m];
+            if (ind) ind[n]=(unsigned char)(i*4+k+1);
+        }
+    }
+    return n;
+}
 /* get sign-magnitude bits ---------------------------------------------------*/
 static double getbitg(const unsigned char *buff, int pos, int len)
 {
@@ -1669,7 +1732,7 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
     msm_h_t h0={0};
     double tow,tod;
     char *msg;
-    int i=24,j,dow,mask,staid,type,ncell=0;
+    int i=24,dow,staid,type,ncell=0;
     
     type=getbitu(rtcm->buff,i,12); i+=12;
     
@@ -1698,14 +1761,8 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
         h->clk_ext=getbitu(rtcm->buff,i, 2);       i+= 2;
         h->smooth =getbitu(rtcm->buff,i, 1);       i+= 1;
         h->tint_s =getbitu(rtcm->buff,i, 3);       i+= 3;
-        for (j=1;j<=64;j++) {
-            mask=getbitu(rtcm->buff,i,1); i+=1;
-            if (mask) h->sats[h->nsat++]=j;
-        }
-        for (j=1;j<=32;j++) {
-            mask=getbitu(rtcm->buff,i,1); i+=1;
-            if (mask) h->sigs[h->nsig++]=j;
-        }
+        h->nsat   =getbitmask(rtcm->buff,i,64,h->sats,NULL); i+=64;
+        h->nsig   =getbitmask(rtcm->buff,i,32,h->sigs,NULL); i+=32;
     }
     else {
         trace(2,"rtcm3 %d length error: len=%d\n",type,rtcm->len);
@@ -1724,10 +1781,8 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
               rtcm->len,h->nsat,h->nsig);
         return -1;
     }
-    for (j=0;j<h->nsat*h->nsig;j++) {
-        h->cellmask[j]=getbitu(rtcm->buff,i,1); i+=1;
-        if (h->cellmask[j]) ncell++;
-    }
+    ncell=getbitmask(rtcm->buff,i,h->nsat*h->nsig,NULL,h->cellmask);
+    i+=h->nsat*h->nsig;
     *hsize=i;
     
     trace(4,"decode_head_msm: time=%s sys=%d staid=%d nsat=%d nsig=%d sync=%d iod=%d ncell=%d\n",
@@ -1749,12 +1804,82 @@ static int decode_msm0(rtcm_t *rtcm, int sys)
     rtcm->obsflag=!sync;
     return sync?0:1;
 }
+/* decode msm satellite data -------------------------------------------------*/
+static int decode_msm_sat(rtcm_t *rtcm, int i, int nsat, double *r, double *rr,
+                          int *ex)
+{
+    unsigned int u[64];
+    int j,v[64];
+    
+    for (j=0;j<nsat;j++) {
+        r[j]=0.0; if (rr) rr[j]=0.0; if (ex) ex[j]=15;
+    }
+    getbitua(rtcm->buff,i, 8,nsat,u); i+= 8*nsat; /* range */
+    for (j=0;j<nsat;j++) {
+        if (u[j]!=255) r[j]=u[j]*RANGE_MS;
+    }
+    if (ex) { /* extended info */
+        getbitua(rtcm->buff,i,4,nsat,u); i+=4*nsat;
+        for (j=0;j<nsat;j++) ex[j]=(int)u[j];
+    }
+    getbitua(rtcm->buff,i,10,nsat,u); i+=10*nsat;
+    for (j=0;j<nsat;j++) {
+        if (r[j]!=0.0) r[j]+=u[j]*P2_10*RANGE_MS;
+    }
+    if (rr) { /* phaserangerate */
+        getbitsa(rtcm->buff,i,14,nsat,v); i+=14*nsat;
+        for (j=0;j<nsat;j++) {
+            if (v[j]!=-8192) rr[j]=v[j]*1.0;
+        }
+    }
+    return i;
+}
+/* decode msm signal data ------------------------------------------------------
+* decode signal data fields of msm 4-7 (ext=0:msm 4/5,1:msm 6/7)
+*-----------------------------------------------------------------------------*/
+static int decode_msm_sig(rtcm_t *rtcm, int i, int ncell, int ext, double *pr,
+                          double *cp, double *rrf, double *cnr, int *lock,
+                          int *half)
+{
+    unsigned int u[64];
+    int j,v[64],npr=ext?20:15,ncp=ext?24:22,nlock=ext?10:4,ncnr=ext?10:6;
+    int prinv=ext?-524288:-16384,cpinv=ext?-8388608:-2097152;
+    double prres=ext?P2_29:P2_24,cpres=ext?P2_31:P2_29,cnrres=ext?0.0625:1.0;
+    
+    for (j=0;j<ncell;j++) {
+        pr[j]=cp[j]=-1E16; if (rrf) rrf[j]=-1E16;
+    }
+    getbitsa(rtcm->buff,i,npr,ncell,v); i+=npr*ncell; /* pseudorange */
+    for (j=0;j<ncell;j++) {
+        if (v[j]!=prinv) pr[j]=v[j]*prres*RANGE_MS;
+    }
+    getbitsa(rtcm->buff,i,ncp,ncell,v); i+=ncp*ncell; /* phaserange */
+    for (j=0;j<ncell;j++) {
+        if (v[j]!=cpinv) cp[j]=v[j]*cpres*RANGE_MS;
+    }
+    getbitua(rtcm->buff,i,nlock,ncell,u); i+=nlock*ncell; /* lock time */
+    for (j=0;j<ncell;j++) lock[j]=(int)u[j];
+    
+    getbitua(rtcm->buff,i,1,ncell,u); i+=ncell; /* half-cycle ambiguity */
+    for (j=0;j<ncell;j++) half[j]=(int)u[j];
+    
+    getbitua(rtcm->buff,i,ncnr,ncell,u); i+=ncnr*ncell; /* cnr */
+    for (j=0;j<ncell;j++) cnr[j]=u[j]*cnrres;
+    
+    if (rrf) { /* phaserangerate */
+        getbitsa(rtcm->buff,i,15,ncell,v); i+=15*ncell;
+        for (j=0;j<ncell;j++) {
+            if (v[j]!=-16384) rrf[j]=v[j]*0.0001;
+        }
+    }
+    return i;
+}
 /* decode msm 4: full pseudorange and phaserange plus cnr --------------------*/
 static int decode_msm4(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
     double r[64],pr[64],cp[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,prv,cpv,lock[64],half[64];
+    int i,type,sync,iod,ncell,lock[64],half[64];
     
     type=getbitu(rtcm->buff,24,12);
     
@@ -1766,36 +1891,12 @@ static int decode_msm4(rtcm_t *rtcm, int sys)
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) r[j]=0.0;
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=-1E16;
-    
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
+    i=decode_msm_sat(rtcm,i,h.nsat,r,NULL,NULL);
+    
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,15); i+=15;
-        if (prv!=-16384) pr[j]=prv*P2_24*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,22); i+=22;
-        if (cpv!=-2097152) cp[j]=cpv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,4); i+=4;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,6)*1.0; i+=6;
-    }
+    decode_msm_sig(rtcm,i,ncell,0,pr,cp,NULL,cnr,lock,half);
+    
     /* save obs data in msm message */
     save_msm_obs(rtcm,sys,&h,r,pr,cp,NULL,NULL,cnr,lock,NULL,half);
     
@@ -1807,8 +1908,7 @@ static int decode_msm5(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
     double r[64],rr[64],pr[64],cp[64],rrf[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,rate,prv,cpv,rrv,lock[64];
-    int ex[64],half[64];
+    int i,type,sync,iod,ncell,lock[64],ex[64],half[64];
     
     type=getbitu(rtcm->buff,24,12);
     
@@ -1820,49 +1920,12 @@ static int decode_msm5(rtcm_t *rtcm, int sys)
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) {
-        r[j]=rr[j]=0.0; ex[j]=15;
-    }
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=rrf[j]=-1E16;
-    
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* extended info */
-        ex[j]=getbitu(rtcm->buff,i, 4); i+= 4;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* phaserangerate */
-        rate =getbits(rtcm->buff,i,14); i+=14;
-        if (rate!=-8192) rr[j]=rate*1.0;
-    }
+    i=decode_msm_sat(rtcm,i,h.nsat,r,rr,ex);
+    
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,15); i+=15;
-        if (prv!=-16384) pr[j]=prv*P2_24*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,22); i+=22;
-        if (cpv!=-2097152) cp[j]=cpv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,4); i+=4;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,6)*1.0; i+=6;
-    }
-    for (j=0;j<ncell;j++) { /* phaserangerate */
-        rrv=getbits(rtcm->buff,i,15); i+=15;
-        if (rrv!=-16384) rrf[j]=rrv*0.0001;
-    }
+    decode_msm_sig(rtcm,i,ncell,0,pr,cp,rrf,cnr,lock,half);
+    
     /* save obs data in msm message */
     save_msm_obs(rtcm,sys,&h,r,pr,cp,rr,rrf,cnr,lock,ex,half);
     
@@ -1874,7 +1937,7 @@ static int decode_msm6(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
     double r[64],pr[64],cp[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,prv,cpv,lock[64],half[64];
+    int i,type,sync,iod,ncell,lock[64],half[64];
     
     type=getbitu(rtcm->buff,24,12);
     
@@ -1886,36 +1949,12 @@ static int decode_msm6(rtcm_t *rtcm, int sys)
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) r[j]=0.0;
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=-1E16;
-    
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
+    i=decode_msm_sat(rtcm,i,h.nsat,r,NULL,NULL);
+    
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,20); i+=20;
-        if (prv!=-524288) pr[j]=prv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,24); i+=24;
-        if (cpv!=-8388608) cp[j]=cpv*P2_31*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,10); i+=10;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,10)*0.0625; i+=10;
-    }
+    decode_msm_sig(rtcm,i,ncell,1,pr,cp,NULL,cnr,lock,half);
+    
     /* save obs data in msm message */
     save_msm_obs(rtcm,sys,&h,r,pr,cp,NULL,NULL,cnr,lock,NULL,half);
     
@@ -1927,8 +1966,7 @@ static int decode_msm7(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
     double r[64],rr[64],pr[64],cp[64],rrf[64],cnr[64];
-    int i,j,type,sync,iod,ncell,rng,rng_m,rate,prv,cpv,rrv,lock[64];
-    int ex[64],half[64];
+    int i,type,sync,iod,ncell,lock[64],ex[64],half[64];
     
     type=getbitu(rtcm->buff,24,12);
     
@@ -1940,49 +1978,12 @@ static int decode_msm7(rtcm_t *rtcm, int sys)
               ncell,rtcm->len);
         return -1;
     }
-    for (j=0;j<h.nsat;j++) {
-        r[j]=rr[j]=0.0; ex[j]=15;
-    }
-    for (j=0;j<ncell;j++) pr[j]=cp[j]=rrf[j]=-1E16;
-    
     /* decode satellite data */
-    for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
-        if (rng!=255) r[j]=rng*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* extended info */
-        ex[j]=getbitu(rtcm->buff,i, 4); i+= 4;
-    }
-    for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
-        if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
-    }
-    for (j=0;j<h.nsat;j++) { /* phaserangerate */
-        rate =getbits(rtcm->buff,i,14); i+=14;
-        if (rate!=-8192) rr[j]=rate*1.0;
-    }
+    i=decode_msm_sat(rtcm,i,h.nsat,r,rr,ex);
+    
     /* decode signal data */
-    for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,20); i+=20;
-        if (prv!=-524288) pr[j]=prv*P2_29*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,24); i+=24;
-        if (cpv!=-8388608) cp[j]=cpv*P2_31*RANGE_MS;
-    }
-    for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,10); i+=10;
-    }
-    for (j=0;j<ncell;j++) { /* half-cycle amiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
-    }
-    for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,10)*0.0625; i+=10;
-    }
-    for (j=0;j<ncell;j++) { /* phaserangerate */
-        rrv=getbits(rtcm->buff,i,15); i+=15;
-        if (rrv!=-16384) rrf[j]=rrv*0.0001;
-    }
+    decode_msm_sig(rtcm,i,ncell,1,pr,cp,rrf,cnr,lock,half);
+    
     /* save obs data in msm message */
     save_msm_obs(rtcm,sys,&h,r,pr,cp,rr,rrf,cnr,lock,ex,half);
     
@@ -25,6 +25,9 @@
 *           2014/12/06 1.9  support SBAS/BeiDou SSR messages (ref [16])
 *                           fix bug on invalid staid in qzss ssr messages
 *           2015/03/22 1.9  add handling of iodcrc for beidou/sbas ssr messages
+*           2026/10/18 1.10 fix null pointer access in msm 4/6 encoding
+*           2026/10/18 1.11 reuse msm layout for messages of same epoch
+*                           write msm fields by word-level bit packing
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -70,6 +73,33 @@ static void set38bits(unsigned char *buff, int pos, double value)
     setbits(buff,pos  ,32,word_h);
     setbitu(buff,pos+32,6,word_l);
 }
+/* set unsigned bits of data array -------------------------------------------*/
+static int setbitua(unsigned char *buff, int pos, int len,
+                    const unsigned int *data, int n)
+{
+    unsigned int bits,mask=0xFFFFFFFFu>>(32-len);
+    int i,nb=pos%8;
+    
+    /* accumulate fields in a word and write bytes (len<=24) */
+    if (n<=0) return pos;
+    buff+=pos/8;
+    bits=nb?(unsigned int)buff[0]>>(8-nb):0;
+    
+    for (i=0;i<n;i++) {
+        bits=(bits<<len)|(data[i]&mask);
+        for (nb+=len;nb>=8;nb-=8) *buff++=(unsigned char)(bits>>(nb-8));
+    }
+    if (nb>0) {
+        *buff=(unsigned char)(((bits<<(8-nb))&0xFFu)|(*buff&(0xFFu>>nb)));
+    }
+    return pos+len*n;
+}
+/* signed bits to unsigned data with sign bit --------------------------------*/
+static unsigned int sbits(int data, int len)
+{
+    if (data<0) data|=1<<(len-1); else data&=~(1<<(len-1)); /* set sign bit */
+    return (unsigned int)data;
+}
 /* lock time -----------------------------------------------------------------*/
 static int locktime(gtime_t time, gtime_t *lltime, unsigned char LLI)
 {
@@ -1525,128 +1555,177 @@ static int to_sigid(int sys, unsigned char code, int *freq)
     }
     return 0;
 }
-/* generate msm satellite, signal and cell index -----------------------------*/
-static void gen_msm_index(rtcm_t *rtcm, int sys, int *nsat, int *nsig,
-                          int *ncell, unsigned char *sat_ind,
-                          unsigned char *sig_ind, unsigned char *cell_ind)
+/* msm system index ----------------------------------------------------------*/
+static int msm_sysind(int sys)
+{
+    switch (sys) {
+        case SYS_GPS: return 0;
+        case SYS_GLO: return 1;
+        case SYS_GAL: return 2;
+        case SYS_QZS: return 3;
+        case SYS_SBS: return 4;
+        case SYS_CMP: return 5;
+    }
+    return -1;
+}
+/* signature of observation satellites and codes -----------------------------*/
+static unsigned int obs_key(const obs_t *obs)
+{
+    unsigned int key=2166136261u;
+    int i,j;
+    
+    for (i=0;i<obs->n;i++) {
+        key=(key^obs->data[i].sat)*16777619u;
+        for (j=0;j<NFREQ+NEXOBS;j++) {
+            key=(key^obs->data[i].code[j])*16777619u;
+        }
+    }
+    return key;
+}
+/* generate msm satellite, signal and cell index -------------------------------
+* generate msm layout of satellite, signal and cell index and signal entries
+* of the system. the layout is kept in rtcm->msmlay[] and reused while the
+* epoch and the satellites/codes of the observation data are not changed, so
+* msm messages of any type for the same epoch share the layout
+*-----------------------------------------------------------------------------*/
+static const msmlay_t *gen_msm_index(rtcm_t *rtcm, int sys)
 {
-    int i,j,sat,sig,cell,f;
+    msmlay_t *lay;
+    unsigned char cell_ind[32*64]={0};
+    unsigned int key;
+    int i,j,s,sat,sig,cell,f;
     
-    *nsat=*nsig=*ncell=0;
+    if ((s=msm_sysind(sys))<0) return NULL;
+    lay=rtcm->msmlay+s;
+    key=obs_key(&rtcm->obs);
     
-    /* generate satellite and signal index */
+    if (lay->n==rtcm->obs.n&&lay->key==key&&
+        timediff(lay->time,rtcm->time)==0.0) {
+        return lay;
+    }
+    lay->nsat=lay->nsig=lay->ncell=lay->nent=0;
+    for (i=0;i<64;i++) lay->sat_ind[i]=lay->cell_ind[i]=0;
+    for (i=0;i<32;i++) lay->sig_ind[i]=0;
+    
+    /* generate satellite and signal index and signal entries */
     for (i=0;i<rtcm->obs.n;i++) {
         if (!(sat=to_satid(sys,rtcm->obs.data[i].sat))) continue;
         
-        for (j=0;j<NFREQ+NEXOBS;j++) {
+        for (j=0;j<NFREQ+NEXOBS&&lay->nent<MAXMSMENT;j++) {
             if (!(sig=to_sigid(sys,rtcm->obs.data[i].code[j],&f))) continue;
             
-            sat_ind[sat-1]=sig_ind[sig-1]=1;
+            lay->sat_ind[sat-1]=lay->sig_ind[sig-1]=1;
+            lay->obs [lay->nent]=(unsigned char)i;
+            lay->slot[lay->nent]=(unsigned char)j;
+            lay->freq[lay->nent]=(unsigned char)f;
+            lay->cell[lay->nent++]=(unsigned char)sig;
         }
     }
     for (i=0;i<64;i++) {
-        if (sat_ind[i]) sat_ind[i]=++(*nsat);
+        if (lay->sat_ind[i]) lay->sat_ind[i]=(unsigned char)++lay->nsat;
     }
     for (i=0;i<32;i++) {
-        if (sig_ind[i]) sig_ind[i]=++(*nsig);
+        if (lay->sig_ind[i]) lay->sig_ind[i]=(unsigned char)++lay->nsig;
     }
     /* generate cell index */
-    for (i=0;i<rtcm->obs.n;i++) {
-        if (!(sat=to_satid(sys,rtcm->obs.data[i].sat))) continue;
-        
-        for (j=0;j<NFREQ+NEXOBS;j++) {
-            if (!(sig=to_sigid(sys,rtcm->obs.data[i].code[j],&f))) continue;
-            
-            cell=sig_ind[sig-1]-1+(sat_ind[sat-1]-1)*(*nsig);
-            cell_ind[cell]=1;
-        }
+    for (i=0;i<lay->nent;i++) {
+        sat=to_satid(sys,rtcm->obs.data[lay->obs[i]].sat);
+        cell=lay->sig_ind[lay->cell[i]-1]-1+(lay->sat_ind[sat-1]-1)*lay->nsig;
+        cell_ind[cell]=1;
     }
-    for (i=0;i<*nsat*(*nsig);i++) {
-        if (cell_ind[i]&&*ncell<64) cell_ind[i]=++(*ncell);
+    for (i=0;i<lay->nsat*lay->nsig;i++) {
+        if (cell_ind[i]&&lay->ncell<64) cell_ind[i]=(unsigned char)++lay->ncell;
     }
+    for (i=0;i<lay->nsat*lay->nsig&&i<64;i++) {
+        lay->cell_ind[i]=cell_ind[i]?1:0;
+    }
+    for (i=0;i<lay->nent;i++) {
+        sat=to_satid(sys,rtcm->obs.data[lay->obs[i]].sat);
+        cell=lay->sig_ind[lay->cell[i]-1]-1+(lay->sat_ind[sat-1]-1)*lay->nsig;
+        lay->cell[i]=cell_ind[cell];
+    }
+    lay->time=rtcm->time;
+    lay->key=key;
+    lay->n=rtcm->obs.n;
+    return lay;
 }
 /* generate msm satellite data fields ----------------------------------------*/
-static void gen_msm_sat(rtcm_t *rtcm, int sys, int nsat,
-                        const unsigned char *sat_ind, double *rrng,
-                        double *rrate, unsigned char *info)
+static void gen_msm_sat(rtcm_t *rtcm, int sys, const msmlay_t *lay,
+                        double *rrng, double *rrate, unsigned char *info)
 {
     obsd_t *data;
     double lambda,rrng_s,rrate_s;
-    int i,j,k,sat,sig,f,fcn;
+    int i,j,k,f,fcn;
     
     for (i=0;i<64;i++) rrng[i]=rrate[i]=0.0;
     
-    for (i=0;i<rtcm->obs.n;i++) {
-        data=rtcm->obs.data+i;
-        if (!(sat=to_satid(sys,data->sat))) continue;
-        fcn=fcn_glo(data->sat,rtcm);
+    for (i=0;i<lay->nent;i++) {
+        data=rtcm->obs.data+lay->obs[i];
+        j=lay->slot[i];
+        f=lay->freq[i];
+        k=lay->sat_ind[to_satid(sys,data->sat)-1]-1;
+        lambda=satwavelen(data->sat,f-1,&rtcm->nav);
         
-        for (j=0;j<NFREQ+NEXOBS;j++) {
-            if (!(sig=to_sigid(sys,data->code[j],&f))) continue;
-            k=sat_ind[sat-1]-1;
-            lambda=satwavelen(data->sat,f-1,&rtcm->nav);
-            
-            /* rough range (ms) and rough phase-range-rate (m/s) */
-            rrng_s =ROUND( data->P[j]/RANGE_MS/P2_10)*RANGE_MS*P2_10;
-            rrate_s=ROUND(-data->D[j]*lambda)*1.0;
-            if (rrng [k]==0.0&&data->P[j]!=0.0) rrng [k]=rrng_s;
-            if (rrate[k]==0.0&&data->D[j]!=0.0) rrate[k]=rrate_s;
-            
-            /* extended satellite info */
+        /* rough range (ms) and rough phase-range-rate (m/s) */
+        rrng_s =ROUND( data->P[j]/RANGE_MS/P2_10)*RANGE_MS*P2_10;
+        rrate_s=ROUND(-data->D[j]*lambda)*1.0;
+        if (rrng [k]==0.0&&data->P[j]!=0.0) rrng [k]=rrng_s;
+        if (rrate[k]==0.0&&data->D[j]!=0.0) rrate[k]=rrate_s;
+        
+        /* extended satellite info */
+        if (info) {
+            fcn=fcn_glo(data->sat,rtcm);
             info[k]=sys!=SYS_GLO?0:(fcn<0?15:fcn);
         }
     }
 }
 /* generate msm signal data fields -------------------------------------------*/
-static void gen_msm_sig(rtcm_t *rtcm, int sys, int nsat, int nsig, int ncell,
-                        const unsigned char *sat_ind,
-                        const unsigned char *sig_ind,
-                        const unsigned char *cell_ind, const double *rrng,
-                        const double *rrate, double *psrng, double *phrng,
-                        double *rate, int *lock, unsigned char *half,
-                        float *cnr)
+static void gen_msm_sig(rtcm_t *rtcm, int sys, const msmlay_t *lay,
+                        const double *rrng, const double *rrate, double *psrng,
+                        double *phrng, double *rate, int *lock,
+                        unsigned char *half, float *cnr)
 {
     obsd_t *data;
     double lambda,psrng_s,phrng_s,rate_s;
-    int i,j,k,sat,sig,cell,f,lt,LLI;
+    int i,j,k,cell,f,lt,LLI;
     
-    for (i=0;i<ncell;i++) {
+    for (i=0;i<lay->ncell;i++) {
         if (psrng) psrng[i]=0.0;
         if (phrng) phrng[i]=0.0;
         if (rate ) rate [i]=0.0;
+        if (lock ) lock [i]=0;
+        if (half ) half [i]=0;
+        if (cnr  ) cnr  [i]=0.0f;
     }
-    for (i=0;i<rtcm->obs.n;i++) {
-        data=rtcm->obs.data+i;
+    for (i=0;i<lay->nent;i++) {
+        if ((cell=lay->cell[i])>=64) continue;
         
-        if (!(sat=to_satid(sys,data->sat))) continue;
+        data=rtcm->obs.data+lay->obs[i];
+        j=lay->slot[i];
+        f=lay->freq[i];
+        k=lay->sat_ind[to_satid(sys,data->sat)-1]-1;
         
-        for (j=0;j<NFREQ+NEXOBS;j++) {
-            if (!(sig=to_sigid(sys,data->code[j],&f))) continue;
-            k=sat_ind[sat-1]-1;
-            if ((cell=cell_ind[sig_ind[sig-1]-1+k*nsig])>=64) continue;
-            
-            lambda=satwavelen(data->sat,f-1,&rtcm->nav);
-            psrng_s=data->P[j]==0.0?0.0:data->P[j]-rrng[k];
-            phrng_s=data->L[j]==0.0||lambda<=0.0?0.0: data->L[j]*lambda-rrng [k];
-            rate_s =data->D[j]==0.0||lambda<=0.0?0.0:-data->D[j]*lambda-rrate[k];
-            
-            /* subtract phase - psudorange integer cycle offset */
-            LLI=data->LLI[j];
-            if ((LLI&1)||fabs(phrng_s-rtcm->cp[data->sat-1][j])>1171.0) {
-                rtcm->cp[data->sat-1][j]=ROUND(phrng_s/lambda)*lambda;
-                LLI|=1;
-            }
-            phrng_s-=rtcm->cp[data->sat-1][j];
-            
-            lt=locktime(data->time,rtcm->lltime[data->sat-1]+j,LLI);
-            
-            if (psrng&&psrng_s!=0.0) psrng[cell-1]=psrng_s;
-            if (phrng&&phrng_s!=0.0) phrng[cell-1]=phrng_s;
-            if (rate &&rate_s !=0.0) rate [cell-1]=rate_s;
-            if (lock) lock[cell-1]=lt;
-            if (half) half[cell-1]=(data->LLI[j]&2)?1:0;
-            if (cnr ) cnr [cell-1]=(float)(data->SNR[j]*0.25);
+        lambda=satwavelen(data->sat,f-1,&rtcm->nav);
+        psrng_s=data->P[j]==0.0?0.0:data->P[j]-rrng[k];
+        phrng_s=data->L[j]==0.0||lambda<=0.0?0.0: data->L[j]*lambda-rrng [k];
+        rate_s =data->D[j]==0.0||lambda<=0.0?0.0:-data->D[j]*lambda-rrate[k];
+        
+        /* subtract phase - psudorange integer cycle offset */
+        LLI=data->LLI[j];
+        if ((LLI&1)||fabs(phrng_s-rtcm->cp[data->sat-1][j])>1171.0) {
+            rtcm->cp[data->sat-1][j]=ROUND(phrng_s/lambda)*lambda;
+            LLI|=1;
         }
+        phrng_s-=rtcm->cp[data->sat-1][j];
+        
+        lt=locktime(data->time,rtcm->lltime[data->sat-1]+j,LLI);
+        
+        if (psrng&&psrng_s!=0.0) psrng[cell-1]=psrng_s;
+        if (phrng&&phrng_s!=0.0) phrng[cell-1]=phrng_s;
+        if (rate &&rate_s !=0.0) rate [cell-1]=rate_s;
+        if (lock) lock[cell-1]=lt;
+        if (half) half[cell-1]=(data->LLI[j]&2)?1:0;
+        if (cnr ) cnr [cell-1]=(float)(data->SNR[j]*0.25);
     }
 }
 /* encode msm header ---------------------------------------------------------*/
@@ -1656,10 +1735,10 @@ static int encode_msm_head(int type, rtcm_t *rtcm, int sys, int sync, int *nsat,
                            double *rate, int *lock, unsigned char *half,
                            float *cnr)
 {
+    const msmlay_t *lay;
     double tow;
-    unsigned char sat_ind[64]={0},sig_ind[32]={0},cell_ind[32*64]={0};
-    unsigned int dow,epoch;
-    int i=24,j,tt,nsig=0;
+    unsigned int dow,epoch,mask[64];
+    int i=24,j,tt;
     
     switch (sys) {
         case SYS_GPS: type+=1070; break;
@@ -1671,7 +1750,9 @@ static int encode_msm_head(int type, rtcm_t *rtcm, int sys, int sync, int *nsat,
         default: return 0;
     }
     /* generate msm satellite, signal and cell index */
-    gen_msm_index(rtcm,sys,nsat,&nsig,ncell,sat_ind,sig_ind,cell_ind);
+    if (!(lay=gen_msm_index(rtcm,sys))) return 0;
+    *nsat=lay->nsat;
+    *ncell=lay->ncell;
     
     if (sys==SYS_GLO) {
         /* glonass time (dow + tod-ms) */
@@ -1703,23 +1784,22 @@ static int encode_msm_head(int type, rtcm_t *rtcm, int sys, int sync, int *nsat,
     setbitu(rtcm->buff,i, 3,0          ); i+= 3; /* smoothing interval */
     
     /* satellite mask */
-    for (j=0;j<64;j++) {
-        setbitu(rtcm->buff,i,1,sat_ind[j]?1:0); i+=1;
-    }
+    for (j=0;j<64;j++) mask[j]=lay->sat_ind[j]?1:0;
+    i=setbitua(rtcm->buff,i,1,mask,64);
+    
     /* signal mask */
-    for (j=0;j<32;j++) {
-        setbitu(rtcm->buff,i,1,sig_ind[j]?1:0); i+=1;
-    }
+    for (j=0;j<32;j++) mask[j]=lay->sig_ind[j]?1:0;
+    i=setbitua(rtcm->buff,i,1,mask,32);
+    
     /* cell mask */
-    for (j=0;j<*nsat*nsig&&j<64;j++) {
-        setbitu(rtcm->buff,i,1,cell_ind[j]?1:0); i+=1;
-    }
+    for (j=0;j<lay->nsat*lay->nsig&&j<64;j++) mask[j]=lay->cell_ind[j];
+    i=setbitua(rtcm->buff,i,1,mask,j);
+    
     /* generate msm satellite data fields */
-    gen_msm_sat(rtcm,sys,*nsat,sat_ind,rrng,rrate,info);
+    gen_msm_sat(rtcm,sys,lay,rrng,rrate,info);
     
     /* generate msm signal data fields */
-    gen_msm_sig(rtcm,sys,*nsat,nsig,*ncell,sat_ind,sig_ind,cell_ind,rrng,rrate,
-                psrng,phrng,rate,lock,half,cnr);
+    gen_msm_sig(rtcm,sys,lay,rrng,rrate,psrng,phrng,rate,lock,half,cnr);
     
     return i;
 }
@@ -1727,233 +1807,233 @@ static int encode_msm_head(int type, rtcm_t *rtcm, int sys, int sync, int *nsat,
 static int encode_msm_int_rrng(rtcm_t *rtcm, int i, const double *rrng,
                                int nsat)
 {
-    unsigned int int_ms;
+    unsigned int int_ms[64];
     int j;
     
     for (j=0;j<nsat;j++) {
         if (rrng[j]==0.0) {
-            int_ms=255;
+            int_ms[j]=255;
         }
         else if (rrng[j]<0.0||rrng[j]>RANGE_MS*255.0) {
             trace(2,"msm rough range overflow %s rrng=%.3f\n",
                  time_str(rtcm->time,0),rrng[j]);
-            int_ms=255;
+            int_ms[j]=255;
         }
         else {
-            int_ms=ROUND_U(rrng[j]/RANGE_MS/P2_10)>>10;
+            int_ms[j]=ROUND_U(rrng[j]/RANGE_MS/P2_10)>>10;
         }
-        setbitu(rtcm->buff,i,8,int_ms); i+=8;
     }
-    return i;
+    return setbitua(rtcm->buff,i,8,int_ms,nsat);
 }
 /* encode rough range modulo 1 ms --------------------------------------------*/
 static int encode_msm_mod_rrng(rtcm_t *rtcm, int i, const double *rrng,
                                int nsat)
 {
-    unsigned int mod_ms;
+    unsigned int mod_ms[64];
     int j;
     
     for (j=0;j<nsat;j++) {
         if (rrng[j]<=0.0||rrng[j]>RANGE_MS*255.0) {
-            mod_ms=0;
+            mod_ms[j]=0;
         }
         else {
-            mod_ms=ROUND_U(rrng[j]/RANGE_MS/P2_10)&0x3FFu;
+            mod_ms[j]=ROUND_U(rrng[j]/RANGE_MS/P2_10)&0x3FFu;
         }
-        setbitu(rtcm->buff,i,10,mod_ms); i+=10;
     }
-    return i;
+    return setbitua(rtcm->buff,i,10,mod_ms,nsat);
 }
 /* encode extended satellite info --------------------------------------------*/
 static int encode_msm_info(rtcm_t *rtcm, int i, const unsigned char *info,
                            int nsat)
 {
+    unsigned int info_val[64]={0};
     int j;
     
     for (j=0;j<nsat;j++) {
-        setbitu(rtcm->buff,i,4,info[j]); i+=4;
+        info_val[j]=info[j];
     }
-    return i;
+    return setbitua(rtcm->buff,i,4,info_val,nsat);
 }
 /* encode rough phase-range-rate ---------------------------------------------*/
 static int encode_msm_rrate(rtcm_t *rtcm, int i, const double *rrate, int nsat)
 {
-    int j,rrate_val;
+    unsigned int rrate_val[64]={0};
+    int j;
     
     for (j=0;j<nsat;j++) {
         if (fabs(rrate[j])>8191.0) {
             trace(2,"msm rough phase-range-rate overflow %s rrate=%.4f\n",
                  time_str(rtcm->time,0),rrate[j]);
-            rrate_val=-8192;
+            rrate_val[j]=sbits(-8192,14);
         }
         else {
-            rrate_val=ROUND(rrate[j]/1.0);
+            rrate_val[j]=sbits(ROUND(rrate[j]/1.0),14);
         }
-        setbits(rtcm->buff,i,14,rrate_val); i+=14;
     }
-    return i;
+    return setbitua(rtcm->buff,i,14,rrate_val,nsat);
 }
 /* encode fine pseudorange ---------------------------------------------------*/
 static int encode_msm_psrng(rtcm_t *rtcm, int i, const double *psrng, int ncell)
 {
-    int j,psrng_val;
+    unsigned int psrng_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
         if (psrng[j]==0.0) {
-            psrng_val=-16384;
+            psrng_val[j]=sbits(-16384,15);
         }
         else if (fabs(psrng[j])>292.7) {
             trace(2,"msm fine pseudorange overflow %s psrng=%.3f\n",
                  time_str(rtcm->time,0),psrng[j]);
-            psrng_val=-16384;
+            psrng_val[j]=sbits(-16384,15);
         }
         else {
-            psrng_val=ROUND(psrng[j]/RANGE_MS/P2_24);
+            psrng_val[j]=sbits(ROUND(psrng[j]/RANGE_MS/P2_24),15);
         }
-        setbits(rtcm->buff,i,15,psrng_val); i+=15;
     }
-    return i;
+    return setbitua(rtcm->buff,i,15,psrng_val,ncell);
 }
 /* encode fine pseudorange with extended resolution --------------------------*/
 static int encode_msm_psrng_ex(rtcm_t *rtcm, int i, const double *psrng,
                                int ncell)
 {
-    int j,psrng_val;
+    unsigned int psrng_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
         if (psrng[j]==0.0) {
-            psrng_val=-524288;
+            psrng_val[j]=sbits(-524288,20);
         }
         else if (fabs(psrng[j])>292.7) {
             trace(2,"msm fine pseudorange ext overflow %s psrng=%.3f\n",
                  time_str(rtcm->time,0),psrng[j]);
-            psrng_val=-524288;
+            psrng_val[j]=sbits(-524288,20);
         }
         else {
-            psrng_val=ROUND(psrng[j]/RANGE_MS/P2_29);
+            psrng_val[j]=sbits(ROUND(psrng[j]/RANGE_MS/P2_29),20);
         }
-        setbits(rtcm->buff,i,20,psrng_val); i+=20;
     }
-    return i;
+    return setbitua(rtcm->buff,i,20,psrng_val,ncell);
 }
 /* encode fine phase-range ---------------------------------------------------*/
 static int encode_msm_phrng(rtcm_t *rtcm, int i, const double *phrng, int ncell)
 {
-    int j,phrng_val;
+    unsigned int phrng_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
         if (phrng[j]==0.0) {
-            phrng_val=-2097152;
+            phrng_val[j]=sbits(-2097152,22);
         }
         else if (fabs(phrng[j])>1171.0) {
             trace(2,"msm fine phase-range overflow %s phrng=%.3f\n",
                  time_str(rtcm->time,0),phrng[j]);
-            phrng_val=-2097152;
+            phrng_val[j]=sbits(-2097152,22);
         }
         else {
-            phrng_val=ROUND(phrng[j]/RANGE_MS/P2_29);
+            phrng_val[j]=sbits(ROUND(phrng[j]/RANGE_MS/P2_29),22);
         }
-        setbits(rtcm->buff,i,22,phrng_val); i+=22;
     }
-    return i;
+    return setbitua(rtcm->buff,i,22,phrng_val,ncell);
 }
 /* encode fine phase-range with extended resolution --------------------------*/
 static int encode_msm_phrng_ex(rtcm_t *rtcm, int i, const double *phrng,
                                int ncell)
 {
-    int j,phrng_val;
+    unsigned int phrng_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
         if (phrng[j]==0.0) {
-            phrng_val=-8388608;
+            phrng_val[j]=sbits(-8388608,24);
         }
         else if (fabs(phrng[j])>1171.0) {
             trace(2,"msm fine phase-range ext overflow %s phrng=%.3f\n",
                  time_str(rtcm->time,0),phrng[j]);
-            phrng_val=-8388608;
+            phrng_val[j]=sbits(-8388608,24);
         }
         else {
-            phrng_val=ROUND(phrng[j]/RANGE_MS/P2_31);
+            phrng_val[j]=sbits(ROUND(phrng[j]/RANGE_MS/P2_31),24);
         }
-        setbits(rtcm->buff,i,24,phrng_val); i+=24;
     }
-    return i;
+    return setbitua(rtcm->buff,i,24,phrng_val,ncell);
 }
 /* encode lock-time indicator ------------------------------------------------*/
 static int encode_msm_lock(rtcm_t *rtcm, int i, const int *lock, int ncell)
 {
-    int j,lock_val;
+    unsigned int lock_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
-        lock_val=to_msm_lock(lock[j]);
-        setbitu(rtcm->buff,i,4,lock_val); i+=4;
+        lock_val[j]=(unsigned int)to_msm_lock(lock[j]);
     }
-    return i;
+    return setbitua(rtcm->buff,i,4,lock_val,ncell);
 }
 /* encode lock-time indicator with extended range and resolution -------------*/
 static int encode_msm_lock_ex(rtcm_t *rtcm, int i, const int *lock, int ncell)
 {
-    int j,lock_val;
+    unsigned int lock_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
-        lock_val=to_msm_lock_ex(lock[j]);
-        setbitu(rtcm->buff,i,10,lock_val); i+=10;
+        lock_val[j]=(unsigned int)to_msm_lock_ex(lock[j]);
     }
-    return i;
+    return setbitua(rtcm->buff,i,10,lock_val,ncell);
 }
 /* encode half-cycle-ambiguity indicator -------------------------------------*/
 static int encode_msm_half_amb(rtcm_t *rtcm, int i, const unsigned char *half,
                                int ncell)
 {
+    unsigned int half_val[64]={0};
     int j;
     
     for (j=0;j<ncell;j++) {
-        setbitu(rtcm->buff,i,1,half[j]); i+=1;
+        half_val[j]=half[j];
     }
-    return i;
+    return setbitua(rtcm->buff,i,1,half_val,ncell);
 }
 /* encode signal cnr ---------------------------------------------------------*/
 static int encode_msm_cnr(rtcm_t *rtcm, int i, const float *cnr, int ncell)
 {
-    int j,cnr_val;
+    unsigned int cnr_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
-        cnr_val=ROUND(cnr[j]/1.0);
-        setbitu(rtcm->buff,i,6,cnr_val); i+=6;
+        cnr_val[j]=(unsigned int)ROUND(cnr[j]/1.0);
     }
-    return i;
+    return setbitua(rtcm->buff,i,6,cnr_val,ncell);
 }
 /* encode signal cnr with extended resolution --------------------------------*/
 static int encode_msm_cnr_ex(rtcm_t *rtcm, int i, const float *cnr, int ncell)
 {
-    int j,cnr_val;
+    unsigned int cnr_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
-        cnr_val=ROUND(cnr[j]/0.0625);
-        setbitu(rtcm->buff,i,10,cnr_val); i+=10;
+        cnr_val[j]=(unsigned int)ROUND(cnr[j]/0.0625);
     }
-    return i;
+    return setbitua(rtcm->buff,i,10,cnr_val,ncell);
 }
 /* encode fine phase-range-rate ----------------------------------------------*/
 static int encode_msm_rate(rtcm_t *rtcm, int i, const double *rate, int ncell)
 {
-    int j,rate_val;
+    unsigned int rate_val[64]={0};
+    int j;
     
     for (j=0;j<ncell;j++) {
         if (rate[j]==0.0) {
-            rate_val=-16384;
+            rate_val[j]=(unsigned int)-16384;
         }
         else if (fabs(rate[j])>1.6384) {
             trace(2,"msm fine phase-range-rate overflow %s rate=%.3f\n",
                  time_str(rtcm->time,0),rate[j]);
-            rate_val=-16384;
+            rate_val[j]=(unsigned int)-16384;
         }
         else {
-            rate_val=ROUND(rate[j]/0.0001);
+            rate_val[j]=(unsigned int)ROUND(rate[j]/0.0001);
         }
-        setbitu(rtcm->buff,i,15,rate_val); i+=15;
     }
-    return i;
+    return setbitua(rtcm->buff,i,15,rate_val,ncell);
 }
 /* encode msm 1: compact pseudorange -----------------------------------------*/
 static int encode_msm1(rtcm_t *rtcm, int sys, int sync)
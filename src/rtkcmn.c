@@ -105,6 +105,28 @@
 *           2015/03/19 1.30 fix bug on interpolation of erp values in geterp()
 *                           add leap second insertion before 2015/07/01 00:00
 *                           add api read_leaps()
+*           2026/10/18 1.31 add api geodists(),satazels(),tropmapfs(),
+*                           antmodels(),windupcorrs()
+*           2026/10/18 1.32 add outtix to default solution options
+*           2026/10/18 1.33 write byte spans instead of single bits in setbitu()
+*           2026/10/18 1.34 add binary trace with ring buffers and writer thread
+*                           add api tracebuf(),tracedec()
+*           2026/10/18 1.35 add stage timing profile by cycle counter
+*                           add api prfenable(),prftick(),prfadd(),prfsum(),
+*                           prfpct(),prfouts()
+*           2026/10/18 1.36 uncompress compress/gzip format files in-process in
+*                           uncompress()
+*           2026/10/18 1.37 use precomputed gps/gst/bdt reference times and
+*                           leap second times in time conversions
+*                           add api time2timens(),timens2time(),timeaddns(),
+*                           timediffns(),gpst2timens(),timens2gpst()
+*           2026/10/18 1.38 sortobs() merges time-ordered runs by record index
+*           2026/10/18 1.39 add api indexobs(),seekobs()
+*           2026/10/18 1.40 unique ephemerides by hash table in uniqnav()
+*           2026/10/18 1.41 lock cache of eci2ecef() shared by rtk server threads
+*           2026/10/18 1.42 build leap second time cache under lock
+*           2026/10/18 1.43 screen time interval by integer nanoseconds in
+*                           screent()
 *-----------------------------------------------------------------------------*/
 #define _POSIX_C_SOURCE 199309
 #include <stdarg.h>
@@ -125,9 +147,10 @@ static const char rcsid[]="$Id: rtkcmn.c,v 1.1 2008/07/17 21:48:06 ttaka Exp tta
 #define POLYCRC32   0xEDB88320u /* CRC32 polynomial */
 #define POLYCRC24Q  0x1864CFBu  /* CRC24Q polynomial */
 
-const static double gpst0[]={1980,1, 6,0,0,0}; /* gps time reference */
-const static double gst0 []={1999,8,22,0,0,0}; /* galileo system time reference */
-const static double bdt0 []={2006,1, 1,0,0,0}; /* beidou time reference */
+#define GPST0_TIME  315964800   /* gps time reference by time_t */
+#define GST0_TIME   935280000   /* galileo system time reference by time_t */
+#define BDT0_TIME   1136073600  /* beidou time reference by time_t */
+#define SECWEEK     604800      /* seconds in a week */
 
 static double leaps[MAXLEAPS+1][7]={ /* leap seconds (y,m,d,h,m,s,utc-gpst) */
     {2015,7,1,0,0,0,-17},
@@ -149,6 +172,8 @@ static double leaps[MAXLEAPS+1][7]={ /* leap seconds (y,m,d,h,m,s,utc-gpst) */
     {1981,7,1,0,0,0, -1},
     {0}
 };
+static time_t leapt[MAXLEAPS+1];       /* leap second times by time_t (utc) */
+static int nleapt=-1;                  /* number of leap second times */
 const double chisqr[100]={      /* chi-sqr(n) (alpha=0.001) */
     10.8,13.8,16.3,18.5,20.5,22.5,24.3,26.1,27.9,29.6,
     31.3,32.9,34.5,36.1,37.7,39.3,40.8,42.3,43.8,45.3,
@@ -189,7 +214,8 @@ const solopt_t solopt_default={ /* defaults solution output options */
     0,1,0,0,0,0,                /* degf,outhead,outopt,datum,height,geoid */
     0,0,0,                      /* solstatic,sstat,trace */
     {0.0,0.0},                  /* nmeaintv */
-    " ",""                      /* separator/program name */
+    " ","",                     /* separator/program name */
+    0                           /* outtix */
 };
 const char *formatstrs[]={      /* stream format strings */
     "RTCM 2",                   /*  0 */
@@ -338,6 +364,32 @@ static void fatalerr(const char *format, ...)
     va_start(ap,format); vfprintf(stderr,format,ap); va_end(ap);
     exit(-9);
 }
+/* lock/unlock shared caches (initialized at first use) ----------------------*/
+#ifdef WIN32
+static CRITICAL_SECTION lock_cache;
+static volatile LONG stat_cache=0;     /* 0:not init,1:initializing,2:ready */
+
+static void lockcache(void)
+{
+    if (InterlockedCompareExchange(&stat_cache,1,0)==0) {
+        InitializeCriticalSection(&lock_cache);
+        InterlockedExchange(&stat_cache,2);
+    }
+    while (InterlockedCompareExchange(&stat_cache,2,2)!=2) Sleep(0);
+    EnterCriticalSection(&lock_cache);
+}
+#else
+static pthread_mutex_t lock_cache=PTHREAD_MUTEX_INITIALIZER;
+
+static void lockcache(void)
+{
+    pthread_mutex_lock(&lock_cache);
+}
+#endif
+static void unlockcache(void)
+{
+    unlock(&lock_cache);
+}
 /* satellite system+prn/slot number to satellite number ------------------------
 * convert satellite system+prn/slot number to satellite number
 * args   : int    sys       I   satellite system (SYS_GPS,SYS_GLO,...)
@@ -625,11 +677,17 @@ extern int getbits(const unsigned char *buff, int pos, int len)
 *-----------------------------------------------------------------------------*/
 extern void setbitu(unsigned char *buff, int pos, int len, unsigned int data)
 {
-    unsigned int mask=1u<<(len-1);
-    int i;
+    unsigned int mask;
+    int n,sft;
     if (len<=0||32<len) return;
-    for (i=pos;i<pos+len;i++,mask>>=1) {
-        if (data&mask) buff[i/8]|=1u<<(7-i%8); else buff[i/8]&=~(1u<<(7-i%8));
+    
+    /* write bits byte by byte with the neighbouring bits kept */
+    for (;len>0;pos+=n,len-=n) {
+        n=8-pos%8<len?8-pos%8:len;
+        sft=8-pos%8-n;
+        mask=((1u<<n)-1u)<<sft;
+        buff[pos/8]=(unsigned char)((buff[pos/8]&~mask)|
+                                    (((data>>(len-n))<<sft)&mask));
     }
 }
 extern void setbits(unsigned char *buff, int pos, int len, int data)
@@ -1240,10 +1298,10 @@ extern void time2epoch(gtime_t t, double *ep)
 *-----------------------------------------------------------------------------*/
 extern gtime_t gpst2time(int week, double sec)
 {
-    gtime_t t=epoch2time(gpst0);
+    gtime_t t;
     
     if (sec<-1E9||1E9<sec) sec=0.0;
-    t.time+=86400*7*week+(int)sec;
+    t.time=(time_t)GPST0_TIME+(time_t)SECWEEK*week+(int)sec;
     t.sec=sec-(int)sec;
     return t;
 }
@@ -1255,12 +1313,11 @@ extern gtime_t gpst2time(int week, double sec)
 *-----------------------------------------------------------------------------*/
 extern double time2gpst(gtime_t t, int *week)
 {
-    gtime_t t0=epoch2time(gpst0);
-    time_t sec=t.time-t0.time;
-    int w=(int)(sec/(86400*7));
+    time_t sec=t.time-GPST0_TIME;
+    int w=(int)(sec/SECWEEK);
     
     if (week) *week=w;
-    return (double)(sec-w*86400*7)+t.sec;
+    return (double)(sec-(time_t)w*SECWEEK)+t.sec;
 }
 /* galileo system time to time -------------------------------------------------
 * convert week and tow in galileo system time (gst) to gtime_t struct
@@ -1270,10 +1327,10 @@ extern double time2gpst(gtime_t t, int *week)
 *-----------------------------------------------------------------------------*/
 extern gtime_t gst2time(int week, double sec)
 {
-    gtime_t t=epoch2time(gst0);
+    gtime_t t;
     
     if (sec<-1E9||1E9<sec) sec=0.0;
-    t.time+=86400*7*week+(int)sec;
+    t.time=(time_t)GST0_TIME+(time_t)SECWEEK*week+(int)sec;
     t.sec=sec-(int)sec;
     return t;
 }
@@ -1285,12 +1342,11 @@ extern gtime_t gst2time(int week, double sec)
 *-----------------------------------------------------------------------------*/
 extern double time2gst(gtime_t t, int *week)
 {
-    gtime_t t0=epoch2time(gst0);
-    time_t sec=t.time-t0.time;
-    int w=(int)(sec/(86400*7));
+    time_t sec=t.time-GST0_TIME;
+    int w=(int)(sec/SECWEEK);
     
     if (week) *week=w;
-    return (double)(sec-w*86400*7)+t.sec;
+    return (double)(sec-(time_t)w*SECWEEK)+t.sec;
 }
 /* beidou time (bdt) to time ---------------------------------------------------
 * convert week and tow in beidou time (bdt) to gtime_t struct
@@ -1300,10 +1356,10 @@ extern double time2gst(gtime_t t, int *week)
 *-----------------------------------------------------------------------------*/
 extern gtime_t bdt2time(int week, double sec)
 {
-    gtime_t t=epoch2time(bdt0);
+    gtime_t t;
     
     if (sec<-1E9||1E9<sec) sec=0.0;
-    t.time+=86400*7*week+(int)sec;
+    t.time=(time_t)BDT0_TIME+(time_t)SECWEEK*week+(int)sec;
     t.sec=sec-(int)sec;
     return t;
 }
@@ -1315,12 +1371,11 @@ extern gtime_t bdt2time(int week, double sec)
 *-----------------------------------------------------------------------------*/
 extern double time2bdt(gtime_t t, int *week)
 {
-    gtime_t t0=epoch2time(bdt0);
-    time_t sec=t.time-t0.time;
-    int w=(int)(sec/(86400*7));
+    time_t sec=t.time-BDT0_TIME;
+    int w=(int)(sec/SECWEEK);
     
     if (week) *week=w;
-    return (double)(sec-w*86400*7)+t.sec;
+    return (double)(sec-(time_t)w*SECWEEK)+t.sec;
 }
 /* add time --------------------------------------------------------------------
 * add time to gtime_t struct
@@ -1332,7 +1387,7 @@ extern gtime_t timeadd(gtime_t t, double sec)
 {
     double tt;
     
-    t.sec+=sec; tt=floor(t.sec); t.time+=(int)tt; t.sec-=tt;
+    t.sec+=sec; tt=floor(t.sec); t.time+=(time_t)tt; t.sec-=tt;
     return t;
 }
 /* time difference -------------------------------------------------------------
@@ -1342,7 +1397,90 @@ extern gtime_t timeadd(gtime_t t, double sec)
 *-----------------------------------------------------------------------------*/
 extern double timediff(gtime_t t1, gtime_t t2)
 {
-    return difftime(t1.time,t2.time)+t1.sec-t2.sec;
+    return (double)(t1.time-t2.time)+t1.sec-t2.sec;
+}
+/* time to time by integer nanoseconds -----------------------------------------
+* convert gtime_t struct to gtimens_t struct
+* args   : gtime_t t        I   gtime_t struct
+* return : gtimens_t struct (fraction of second rounded to 1 ns)
+*-----------------------------------------------------------------------------*/
+extern gtimens_t time2timens(gtime_t t)
+{
+    gtimens_t tn;
+    double ns=floor(t.sec*1E9+0.5);
+    
+    tn.time=t.time+(time_t)floor(ns/1E9);
+    tn.nsec=(long)(ns-floor(ns/1E9)*1E9);
+    return tn;
+}
+/* time by integer nanoseconds to time -----------------------------------------
+* convert gtimens_t struct to gtime_t struct
+* args   : gtimens_t t      I   gtimens_t struct
+* return : gtime_t struct
+*-----------------------------------------------------------------------------*/
+extern gtime_t timens2time(gtimens_t t)
+{
+    gtime_t tt;
+    
+    tt.time=t.time;
+    tt.sec=t.nsec*1E-9;
+    return tt;
+}
+/* add time by integer nanoseconds ---------------------------------------------
+* add time to gtimens_t struct
+* args   : gtimens_t t      I   gtimens_t struct
+*          double sec       I   time to add (s) (rounded to 1 ns)
+* return : gtimens_t struct (t+sec)
+* notes  : the time is stepped by integer seconds and nanoseconds, so repeated
+*          additions of a fixed interval (ex. 0.1 s) do not accumulate
+*          rounding errors as timeadd() does
+*-----------------------------------------------------------------------------*/
+extern gtimens_t timeaddns(gtimens_t t, double sec)
+{
+    double s=floor(sec);
+    long ns=(long)floor((sec-s)*1E9+0.5);
+    
+    t.time+=(time_t)s;
+    t.nsec+=ns;
+    while (t.nsec>=1000000000L) {t.time++; t.nsec-=1000000000L;}
+    return t;
+}
+/* time difference by integer nanoseconds --------------------------------------
+* difference between gtimens_t structs
+* args   : gtimens_t t1,t2  I   gtimens_t structs
+* return : time difference (t1-t2) (s)
+*-----------------------------------------------------------------------------*/
+extern double timediffns(gtimens_t t1, gtimens_t t2)
+{
+    return (double)(t1.time-t2.time)+(t1.nsec-t2.nsec)*1E-9;
+}
+/* gps time to time by integer nanoseconds -------------------------------------
+* convert week and tow in gps time to gtimens_t struct
+* args   : int    week      I   week number in gps time
+*          double sec       I   time of week in gps time (s)
+* return : gtimens_t struct
+*-----------------------------------------------------------------------------*/
+extern gtimens_t gpst2timens(int week, double sec)
+{
+    gtimens_t t={0};
+    
+    if (sec<-1E9||1E9<sec) sec=0.0;
+    t.time=(time_t)GPST0_TIME+(time_t)SECWEEK*week;
+    return timeaddns(t,sec);
+}
+/* time by integer nanoseconds to gps time -------------------------------------
+* convert gtimens_t struct to week and tow in gps time
+* args   : gtimens_t t      I   gtimens_t struct
+*          int    *week     IO  week number in gps time (NULL: no output)
+* return : time of week in gps time (s)
+*-----------------------------------------------------------------------------*/
+extern double timens2gpst(gtimens_t t, int *week)
+{
+    time_t sec=t.time-GPST0_TIME;
+    int w=(int)(sec/SECWEEK);
+    
+    if (week) *week=w;
+    return (double)(sec-(time_t)w*SECWEEK)+t.nsec*1E-9;
 }
 /* get current time in utc -----------------------------------------------------
 * get current time in utc
@@ -1400,6 +1538,7 @@ extern int read_leaps(const char *file)
     
     if (!(fp=fopen(file,"r"))) return 0;
     
+    lockcache();
     while (fgets(buff,sizeof(buff),fp)&&n<MAXLEAPS) {
         if ((p=strchr(buff,'#'))) *p='\0';
         if (sscanf(buff,"%d %d %d %d %d %d %d",ep,ep+1,ep+2,ep+3,ep+4,ep+5,
@@ -1408,9 +1547,27 @@ extern int read_leaps(const char *file)
         leaps[n++][6]=ls;
     }
     for (i=0;i<7;i++) leaps[n][i]=0.0;
+    nleapt=-1;
+    unlockcache();
     fclose(fp);
     return 1;
 }
+/* number of leap second times (convert them to time_t at first use) ---------*/
+static int getleapt(void)
+{
+    int i,n;
+    
+    lockcache();
+    if (nleapt<0) {
+        for (i=0;leaps[i][0]>0;i++) {
+            leapt[i]=epoch2time(leaps[i]).time;
+        }
+        nleapt=i;
+    }
+    n=nleapt;
+    unlockcache();
+    return n;
+}
 /* gpstime to utc --------------------------------------------------------------
 * convert gpstime to utc considering leap seconds
 * args   : gtime_t t        I   time expressed in gpstime
@@ -1419,12 +1576,13 @@ extern int read_leaps(const char *file)
 *-----------------------------------------------------------------------------*/
 extern gtime_t gpst2utc(gtime_t t)
 {
-    gtime_t tu;
-    int i;
+    gtime_t tu,tl={0};
+    int i,n=getleapt();
     
-    for (i=0;leaps[i][0]>0;i++) {
+    for (i=0;i<n;i++) {
         tu=timeadd(t,leaps[i][6]);
-        if (timediff(tu,epoch2time(leaps[i]))>=0.0) return tu;
+        tl.time=leapt[i];
+        if (timediff(tu,tl)>=0.0) return tu;
     }
     return t;
 }
@@ -1436,10 +1594,12 @@ extern gtime_t gpst2utc(gtime_t t)
 *-----------------------------------------------------------------------------*/
 extern gtime_t utc2gpst(gtime_t t)
 {
-    int i;
+    gtime_t tl={0};
+    int i,n=getleapt();
     
-    for (i=0;leaps[i][0]>0;i++) {
-        if (timediff(t,epoch2time(leaps[i]))>=0.0) return timeadd(t,-leaps[i][6]);
+    for (i=0;i<n;i++) {
+        tl.time=leapt[i];
+        if (timediff(t,tl)>=0.0) return timeadd(t,-leaps[i][6]);
     }
     return t;
 }
@@ -1596,6 +1756,188 @@ extern void sleepms(int ms)
     nanosleep(&ts,NULL);
 #endif
 }
+/* stage timing profile --------------------------------------------------------
+* stage timing profiles are sampled by the cycle counter (x86 time stamp
+* counter, or monotonic clock/performance counter on other platforms) and
+* aggregated to count, sum, max and histogram of log2 time (us)
+*-----------------------------------------------------------------------------*/
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))&&!defined(WIN32)
+#define PRF_TSC                         /* use time stamp counter */
+#endif
+static const char *prfname[]={          /* profile stage names */
+    "rtkpos","pntpos","relpos","pppos","satposs","zdres","ddres","filter",
+    "lambda","decode-rov","decode-base","decode-corr","update","output","cycle"
+};
+static int prf_ena=0;                   /* profile enable flag */
+static double prf_period=1E-9;          /* period of profile counter (s) */
+
+/* read profile counter ------------------------------------------------------*/
+static double prfcount(void)
+{
+#ifdef WIN32
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart;
+#elif defined(PRF_TSC)
+    unsigned int lo,hi;
+    __asm__ __volatile__("rdtsc":"=a"(lo),"=d"(hi));
+    return 4294967296.0*hi+lo;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec tp={0};
+    clock_gettime(CLOCK_MONOTONIC,&tp);
+    return tp.tv_sec*1E9+tp.tv_nsec;
+#else
+    struct timeval tv={0};
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec*1E9+tv.tv_usec*1E3;
+#endif
+}
+/* calibrate period of profile counter ---------------------------------------*/
+static double prfcalib(void)
+{
+#ifdef WIN32
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    return 1.0/(double)f.QuadPart;
+#elif defined(PRF_TSC)
+    struct timeval t0,t1;
+    double c0,c1,dt;
+    
+    /* time stamp counter against system clock for 20 ms */
+    gettimeofday(&t0,NULL); c0=prfcount();
+    do {
+        gettimeofday(&t1,NULL); c1=prfcount();
+        dt=(t1.tv_sec-t0.tv_sec)+(t1.tv_usec-t0.tv_usec)*1E-6;
+    } while (dt<0.02&&dt>=0.0);
+    return dt>0.0&&c1>c0?dt/(c1-c0):1E-9;
+#else
+    return 1E-9;
+#endif
+}
+/* enable/disable stage timing profile -----------------------------------------
+* enable or disable sampling of stage timing profiles
+* args   : int    ena       I   enable flag (0:disable,1:enable)
+* return : none
+* notes  : the period of the cycle counter is calibrated at first enable
+*-----------------------------------------------------------------------------*/
+extern void prfenable(int ena)
+{
+    static int calib=0;
+    
+    if (ena&&!calib) {
+        prf_period=prfcalib();
+        calib=1;
+    }
+    prf_ena=ena;
+}
+/* start tick of stage timing profile ------------------------------------------
+* get start tick of a stage for prfadd()
+* args   : none
+* return : start tick (0.0: profile disabled)
+*-----------------------------------------------------------------------------*/
+extern double prftick(void)
+{
+    return prf_ena?prfcount():0.0;
+}
+/* add sample to stage timing profile ------------------------------------------
+* add time from start tick to stage timing profile
+* args   : prfstat_t *prf   IO  stage timing profile
+*          double tick      I   start tick by prftick() (0.0: no sample)
+* return : none
+* notes  : a profile should be updated by one thread at a time
+*-----------------------------------------------------------------------------*/
+extern void prfadd(prfstat_t *prf, double tick)
+{
+    double t;
+    int i;
+    
+    if (tick<=0.0) return;
+    
+    if ((t=(prfcount()-tick)*prf_period)<0.0) t=0.0;
+    prf->n++;
+    prf->sum+=t;
+    if (t>prf->max) prf->max=t;
+    
+    /* histogram bin i: 2^(i-1)<=t<2^i (us) */
+    frexp(t*1E6,&i);
+    prf->hist[i<0?0:(i<NPRFBIN?i:NPRFBIN-1)]++;
+}
+/* sum stage timing profiles ---------------------------------------------------
+* add stage timing profiles to other profiles
+* args   : prfstat_t *prf   IO  stage timing profiles
+*          prfstat_t *src   I   stage timing profiles to be added
+*          int    n         I   number of profiles
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void prfsum(prfstat_t *prf, const prfstat_t *src, int n)
+{
+    int i,j;
+    
+    for (i=0;i<n;i++) {
+        prf[i].n+=src[i].n;
+        prf[i].sum+=src[i].sum;
+        if (src[i].max>prf[i].max) prf[i].max=src[i].max;
+        for (j=0;j<NPRFBIN;j++) prf[i].hist[j]+=src[i].hist[j];
+    }
+}
+/* percentile of stage timing profile ------------------------------------------
+* estimate percentile of time by histogram of stage timing profile
+* args   : prfstat_t *prf   I   stage timing profile
+*          double p         I   percentile (0-1)
+* return : percentile of time (s) (upper bound of histogram bin)
+*-----------------------------------------------------------------------------*/
+extern double prfpct(const prfstat_t *prf, double p)
+{
+    unsigned int k=0,m;
+    double t;
+    int i;
+    
+    if (prf->n<=0) return 0.0;
+    
+    if ((m=(unsigned int)ceil(p*prf->n))<1) m=1;
+    for (i=0;i<NPRFBIN-1;i++) {
+        if ((k+=prf->hist[i])>=m) break;
+    }
+    t=ldexp(1.0,i)*1E-6;
+    return t<prf->max?t:prf->max;
+}
+/* output stage timing profiles ------------------------------------------------
+* output stage timing profiles to buffer
+* args   : unsigned char *buff IO output buffer (MAXPRFMSG bytes)
+*          prfstat_t *prf   I   stage timing profiles (NPRF)
+*          int    opt       I   output option (0:table,1:$PRF messages)
+* return : number of output bytes
+* notes  : stages without samples are not output. the format of $PRF message
+*          is as follows. h0,h1,... are histogram counts of bin i: 2^(i-1)<=
+*          time<2^i (us) up to the last non-empty bin.
+*
+*          $PRF,stage,count,mean(us),p50(us),p99(us),max(us),h0,h1,...
+*-----------------------------------------------------------------------------*/
+extern int prfouts(unsigned char *buff, const prfstat_t *prf, int opt)
+{
+    char *p=(char *)buff;
+    int i,j,n;
+    
+    if (!opt) {
+        p+=sprintf(p,"%-12s %10s %10s %10s %10s %10s\n","stage","count",
+                   "mean(us)","p50(us)","p99(us)","max(us)");
+    }
+    for (i=0;i<NPRF;i++) {
+        if (prf[i].n<=0) continue;
+        
+        p+=sprintf(p,opt?"$PRF,%s,%u,%.1f,%.1f,%.1f,%.1f":
+                   "%-12s %10u %10.1f %10.1f %10.1f %10.1f",prfname[i],
+                   prf[i].n,prf[i].sum/prf[i].n*1E6,prfpct(prf+i,0.5)*1E6,
+                   prfpct(prf+i,0.99)*1E6,prf[i].max*1E6);
+        if (opt) {
+            for (n=NPRFBIN;n>0&&!prf[i].hist[n-1];n--) ;
+            for (j=0;j<n;j++) p+=sprintf(p,",%u",prf[i].hist[j]);
+            p+=sprintf(p,"\r");
+        }
+        p+=sprintf(p,"\n");
+    }
+    return (int)(p-(char *)buff);
+}
 /* convert degree to deg-min-sec -----------------------------------------------
 * convert degree to degree-minute-second
 * args   : double deg       I   degree
@@ -1899,7 +2241,7 @@ static void nut_iau1980(double t, const double *f, double *dpsi, double *deps)
 *                               (NULL: no output)
 * return : none
 * note   : see ref [3] chap 5
-*          not thread-safe
+*          the cache of the last result is shared by threads under lock
 *-----------------------------------------------------------------------------*/
 extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
 {
@@ -1907,21 +2249,23 @@ extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
     static gtime_t tutc_;
     static double U_[9],gmst_;
     gtime_t tgps;
-    double eps,ze,th,z,t,t2,t3,dpsi,deps,gast,f[5];
+    double eps,ze,th,z,t,t2,t3,dpsi,deps,gast,gmst0,f[5];
     double R1[9],R2[9],R3[9],R[9],W[9],N[9],P[9],NP[9];
     int i;
     
     trace(3,"eci2ecef: tutc=%s\n",time_str(tutc,3));
     
+    lockcache();
     if (fabs(timediff(tutc,tutc_))<0.01) { /* read cache */
         for (i=0;i<9;i++) U[i]=U_[i];
-        if (gmst) *gmst=gmst_; 
+        if (gmst) *gmst=gmst_;
+        unlockcache();
         return;
     }
-    tutc_=tutc;
+    unlockcache();
     
     /* terrestrial time */
-    tgps=utc2gpst(tutc_);
+    tgps=utc2gpst(tutc);
     t=(timediff(tgps,epoch2time(ep2000))+19.0+32.184)/86400.0/36525.0;
     t2=t*t; t3=t2*t;
     
@@ -1944,8 +2288,8 @@ extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
     matmul("NN",3,3,3,1.0,R ,R3,0.0,N); /* N=Rx(-eps)*Rz(-dspi)*Rx(eps) */
     
     /* greenwich aparent sidereal time (rad) */
-    gmst_=utc2gmst(tutc_,erpv[2]);
-    gast=gmst_+dpsi*cos(eps);
+    gmst0=utc2gmst(tutc,erpv[2]);
+    gast=gmst0+dpsi*cos(eps);
     gast+=(0.00264*sin(f[4])+0.000063*sin(2.0*f[4]))*AS2R;
     
     /* eci to ecef transformation matrix */
@@ -1953,12 +2297,15 @@ extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
     matmul("NN",3,3,3,1.0,R1,R2,0.0,W );
     matmul("NN",3,3,3,1.0,W ,R3,0.0,R ); /* W=Ry(-xp)*Rx(-yp) */
     matmul("NN",3,3,3,1.0,N ,P ,0.0,NP);
-    matmul("NN",3,3,3,1.0,R ,NP,0.0,U_); /* U=W*Rz(gast)*N*P */
+    matmul("NN",3,3,3,1.0,R ,NP,0.0,U ); /* U=W*Rz(gast)*N*P */
+    if (gmst) *gmst=gmst0;
     
-    for (i=0;i<9;i++) U[i]=U_[i];
-    if (gmst) *gmst=gmst_; 
+    lockcache(); /* write cache */
+    for (i=0;i<9;i++) U_[i]=U[i];
+    gmst_=gmst0; tutc_=tutc;
+    unlockcache();
     
-    trace(5,"gmst=%.12f gast=%.12f\n",gmst_,gast);
+    trace(5,"gmst=%.12f gast=%.12f\n",gmst0,gast);
     trace(5,"P=\n"); tracemat(5,P,3,3,15,12);
     trace(5,"N=\n"); tracemat(5,N,3,3,15,12);
     trace(5,"W=\n"); tracemat(5,W,3,3,15,12);
@@ -2376,118 +2723,179 @@ extern int geterp(const erp_t *erp, gtime_t time, double *erpv)
     erpv[3]=(1.0-a)*erp->data[j].lod    +a*erp->data[j+1].lod;
     return 1;
 }
-/* compare ephemeris ---------------------------------------------------------*/
-static int cmpeph(const void *p1, const void *p2)
+typedef struct {                /* ephemeris sort and unique key */
+    time_t t1,t2;               /* transmission time, toe (t0 for sbas) */
+    int sat,id;                 /* satellite, iode (svh for glonass) */
+    int i;                      /* ephemeris index (-1: duplicated) */
+} navkey_t;
+
+/* compare ephemeris sort key ------------------------------------------------*/
+static int cmpnavkey(const void *p1, const void *p2)
+{
+    navkey_t *q1=(navkey_t *)p1,*q2=(navkey_t *)p2;
+    return q1->t1!=q2->t1?(q1->t1<q2->t1?-1:1):
+           (q1->t2!=q2->t2?(q1->t2<q2->t2?-1:1):
+           (q1->sat!=q2->sat?q1->sat-q2->sat:q1->i-q2->i));
+}
+/* hash of ephemeris unique key ----------------------------------------------*/
+static unsigned int hashnavkey(const navkey_t *key)
 {
-    eph_t *q1=(eph_t *)p1,*q2=(eph_t *)p2;
-    return q1->ttr.time!=q2->ttr.time?(int)(q1->ttr.time-q2->ttr.time):
-           (q1->toe.time!=q2->toe.time?(int)(q1->toe.time-q2->toe.time):
-            q1->sat-q2->sat);
+    unsigned int h=(unsigned int)key->sat*0x9E3779B1u;
+    
+    h^=(unsigned int)key->t2*0x85EBCA6Bu+(h<<6)+(h>>2);
+    h^=(unsigned int)key->id*0xC2B2AE35u+(h<<6)+(h>>2);
+    return h^(h>>16);
+}
+/* sort and unique ephemeris keys --------------------------------------------*/
+static int uniqnavkey(navkey_t *key, int n)
+{
+    int i,j,k,m,*tbl;
+    
+    for (m=16;m<n*2;m<<=1) ;
+    
+    /* unique (sat,t2,id) by hash table keeping first one in sort order */
+    if ((tbl=(int *)malloc(sizeof(int)*m))) {
+        for (i=0;i<m;i++) tbl[i]=-1;
+        
+        for (i=0;i<n;i++) {
+            for (k=hashnavkey(key+i)&(m-1);(j=tbl[k])>=0;k=(k+1)&(m-1)) {
+                if (key[j].sat==key[i].sat&&key[j].t2==key[i].t2&&
+                    key[j].id==key[i].id) break;
+            }
+            if (j<0) {
+                tbl[k]=i;
+            }
+            else if (cmpnavkey(key+i,key+j)<0) { /* duplicated */
+                key[j].i=-1;
+                tbl[k]=i;
+            }
+            else key[i].i=-1;
+        }
+        free(tbl);
+        
+        for (i=j=0;i<n;i++) {
+            if (key[i].i>=0) key[j++]=key[i];
+        }
+        n=j;
+    }
+    else {
+        trace(1,"uniqnavkey malloc error n=%d\n",n);
+    }
+    for (i=1;i<n;i++) if (cmpnavkey(key+i-1,key+i)>0) break;
+    if (i<n) qsort(key,n,sizeof(navkey_t),cmpnavkey);
+    return n;
 }
 /* sort and unique ephemeris -------------------------------------------------*/
 static void uniqeph(nav_t *nav)
 {
     eph_t *nav_eph;
-    int i,j;
+    navkey_t *key;
+    int i,n;
     
     trace(3,"uniqeph: n=%d\n",nav->n);
     
     if (nav->n<=0) return;
     
-    qsort(nav->eph,nav->n,sizeof(eph_t),cmpeph);
-    
-    for (i=1,j=0;i<nav->n;i++) {
-        if (nav->eph[i].sat!=nav->eph[j].sat||
-            nav->eph[i].iode!=nav->eph[j].iode) {
-            nav->eph[++j]=nav->eph[i];
-        }
+    if (!(key=(navkey_t *)malloc(sizeof(navkey_t)*nav->n))) {
+        trace(1,"uniqeph malloc error n=%d\n",nav->n);
+        return;
+    }
+    for (i=0;i<nav->n;i++) {
+        key[i].t1=nav->eph[i].ttr.time;
+        key[i].t2=nav->eph[i].toe.time;
+        key[i].sat=nav->eph[i].sat;
+        key[i].id=nav->eph[i].iode;
+        key[i].i=i;
     }
-    nav->n=j+1;
+    n=uniqnavkey(key,nav->n);
     
-    if (!(nav_eph=(eph_t *)realloc(nav->eph,sizeof(eph_t)*nav->n))) {
-        trace(1,"uniqeph malloc error n=%d\n",nav->n);
+    if (!(nav_eph=(eph_t *)malloc(sizeof(eph_t)*n))) {
+        trace(1,"uniqeph malloc error n=%d\n",n);
         free(nav->eph); nav->eph=NULL; nav->n=nav->nmax=0;
+        free(key);
         return;
     }
+    for (i=0;i<n;i++) nav_eph[i]=nav->eph[key[i].i];
+    free(nav->eph);
+    free(key);
     nav->eph=nav_eph;
-    nav->nmax=nav->n;
+    nav->n=nav->nmax=n;
     
     trace(4,"uniqeph: n=%d\n",nav->n);
 }
-/* compare glonass ephemeris -------------------------------------------------*/
-static int cmpgeph(const void *p1, const void *p2)
-{
-    geph_t *q1=(geph_t *)p1,*q2=(geph_t *)p2;
-    return q1->tof.time!=q2->tof.time?(int)(q1->tof.time-q2->tof.time):
-           (q1->toe.time!=q2->toe.time?(int)(q1->toe.time-q2->toe.time):
-            q1->sat-q2->sat);
-}
 /* sort and unique glonass ephemeris -----------------------------------------*/
 static void uniqgeph(nav_t *nav)
 {
     geph_t *nav_geph;
-    int i,j;
+    navkey_t *key;
+    int i,n;
     
     trace(3,"uniqgeph: ng=%d\n",nav->ng);
     
     if (nav->ng<=0) return;
     
-    qsort(nav->geph,nav->ng,sizeof(geph_t),cmpgeph);
-    
-    for (i=j=0;i<nav->ng;i++) {
-        if (nav->geph[i].sat!=nav->geph[j].sat||
-            nav->geph[i].toe.time!=nav->geph[j].toe.time||
-            nav->geph[i].svh!=nav->geph[j].svh) {
-            nav->geph[++j]=nav->geph[i];
-        }
+    if (!(key=(navkey_t *)malloc(sizeof(navkey_t)*nav->ng))) {
+        trace(1,"uniqgeph malloc error ng=%d\n",nav->ng);
+        return;
+    }
+    for (i=0;i<nav->ng;i++) {
+        key[i].t1=nav->geph[i].tof.time;
+        key[i].t2=nav->geph[i].toe.time;
+        key[i].sat=nav->geph[i].sat;
+        key[i].id=nav->geph[i].svh;
+        key[i].i=i;
     }
-    nav->ng=j+1;
+    n=uniqnavkey(key,nav->ng);
     
-    if (!(nav_geph=(geph_t *)realloc(nav->geph,sizeof(geph_t)*nav->ng))) {
-        trace(1,"uniqgeph malloc error ng=%d\n",nav->ng);
+    if (!(nav_geph=(geph_t *)malloc(sizeof(geph_t)*n))) {
+        trace(1,"uniqgeph malloc error ng=%d\n",n);
         free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
+        free(key);
         return;
     }
+    for (i=0;i<n;i++) nav_geph[i]=nav->geph[key[i].i];
+    free(nav->geph);
+    free(key);
     nav->geph=nav_geph;
-    nav->ngmax=nav->ng;
+    nav->ng=nav->ngmax=n;
     
     trace(4,"uniqgeph: ng=%d\n",nav->ng);
 }
-/* compare sbas ephemeris ----------------------------------------------------*/
-static int cmpseph(const void *p1, const void *p2)
-{
-    seph_t *q1=(seph_t *)p1,*q2=(seph_t *)p2;
-    return q1->tof.time!=q2->tof.time?(int)(q1->tof.time-q2->tof.time):
-           (q1->t0.time!=q2->t0.time?(int)(q1->t0.time-q2->t0.time):
-            q1->sat-q2->sat);
-}
 /* sort and unique sbas ephemeris --------------------------------------------*/
 static void uniqseph(nav_t *nav)
 {
     seph_t *nav_seph;
-    int i,j;
+    navkey_t *key;
+    int i,n;
     
     trace(3,"uniqseph: ns=%d\n",nav->ns);
     
     if (nav->ns<=0) return;
     
-    qsort(nav->seph,nav->ns,sizeof(seph_t),cmpseph);
-    
-    for (i=j=0;i<nav->ns;i++) {
-        if (nav->seph[i].sat!=nav->seph[j].sat||
-            nav->seph[i].t0.time!=nav->seph[j].t0.time) {
-            nav->seph[++j]=nav->seph[i];
-        }
+    if (!(key=(navkey_t *)malloc(sizeof(navkey_t)*nav->ns))) {
+        trace(1,"uniqseph malloc error ns=%d\n",nav->ns);
+        return;
     }
-    nav->ns=j+1;
+    for (i=0;i<nav->ns;i++) {
+        key[i].t1=nav->seph[i].tof.time;
+        key[i].t2=nav->seph[i].t0.time;
+        key[i].sat=nav->seph[i].sat;
+        key[i].id=0;
+        key[i].i=i;
+    }
+    n=uniqnavkey(key,nav->ns);
     
-    if (!(nav_seph=(seph_t *)realloc(nav->seph,sizeof(seph_t)*nav->ns))) {
-        trace(1,"uniqseph malloc error ns=%d\n",nav->ns);
+    if (!(nav_seph=(seph_t *)malloc(sizeof(seph_t)*n))) {
+        trace(1,"uniqseph malloc error ns=%d\n",n);
         free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
+        free(key);
         return;
     }
+    for (i=0;i<n;i++) nav_seph[i]=nav->seph[key[i].i];
+    free(nav->seph);
+    free(key);
     nav->seph=nav_seph;
-    nav->nsmax=nav->ns;
+    nav->ns=nav->nsmax=n;
     
     trace(4,"uniqseph: ns=%d\n",nav->ns);
 }
@@ -2521,27 +2929,120 @@ static int cmpobs(const void *p1, const void *p2)
     if (q1->rcv!=q2->rcv) return (int)q1->rcv-(int)q2->rcv;
     return (int)q1->sat-(int)q2->sat;
 }
+/* sift down heap of observation data runs ----------------------------------*/
+static void siftobs(const obsd_t *data, const int *idx, const int *ps, int *heap,
+                    int n, int i)
+{
+    int j,r=heap[i],c;
+    
+    for (;(j=i*2+1)<n;i=j) {
+        if (j+1<n) {
+            c=cmpobs(data+idx[ps[heap[j+1]]],data+idx[ps[heap[j]]]);
+            if (c<0||(c==0&&heap[j+1]<heap[j])) j++;
+        }
+        c=cmpobs(data+idx[ps[heap[j]]],data+idx[ps[r]]);
+        if (c>0||(c==0&&heap[j]>r)) break;
+        heap[i]=heap[j];
+    }
+    heap[i]=r;
+}
+/* merge sort index of observation data --------------------------------------*/
+static int mergeobs(const obsd_t *data, int n, int *idx)
+{
+    int i,j,k,r,nrun=0,*ps,*pe,*heap,*out;
+    
+    /* split data into runs by backward time jumps */
+    for (i=0;i<n;i++) {
+        if (i==0||timediff(data[i].time,data[i-1].time)<-DTTOL) nrun++;
+    }
+    if (!(ps=(int *)malloc(sizeof(int)*nrun*3))) return 0;
+    pe=ps+nrun; heap=pe+nrun;
+    
+    /* sort each epoch in runs by rcv and sat with insertion sort */
+    for (i=k=0;i<n;i++) {
+        if (i==0||timediff(data[i].time,data[i-1].time)<-DTTOL) {
+            if (k>0) pe[k-1]=i;
+            ps[k++]=i;
+            idx[i]=i;
+            continue;
+        }
+        for (j=i;j>ps[k-1]&&cmpobs(data+idx[j-1],data+i)>0;j--) {
+            idx[j]=idx[j-1];
+        }
+        idx[j]=i;
+    }
+    pe[k-1]=n;
+    
+    trace(4,"mergeobs: n=%d nrun=%d\n",n,nrun);
+    
+    if (nrun<=1) {
+        free(ps);
+        return 1;
+    }
+    if (!(out=(int *)malloc(sizeof(int)*n))) {
+        free(ps);
+        return 0;
+    }
+    /* k-way merge of runs with binary heap */
+    for (r=0;r<nrun;r++) heap[r]=r;
+    for (i=nrun/2-1;i>=0;i--) siftobs(data,idx,ps,heap,nrun,i);
+    
+    for (i=0;i<n;i++) {
+        r=heap[0];
+        out[i]=idx[ps[r]++];
+        if (ps[r]>=pe[r]) heap[0]=heap[--k];
+        if (k>0) siftobs(data,idx,ps,heap,k,0);
+    }
+    memcpy(idx,out,sizeof(int)*n);
+    free(out);
+    free(ps);
+    return 1;
+}
 /* sort and unique observation data --------------------------------------------
 * sort and unique observation data by time, rcv, sat
 * args   : obs_t *obs    IO     observation data
 * return : number of epochs
+* notes  : the data are split into runs of time-ordered epochs (ex. rinex obs
+*          files appended to obs) and the runs are merged by the record index.
+*          out-of-order epochs just start new runs. each record is moved only
+*          once to the sorted position. qsort() is used if memory allocation
+*          for the index fails.
 *-----------------------------------------------------------------------------*/
 extern int sortobs(obs_t *obs)
 {
-    int i,j,n;
+    obsd_t data;
+    int i,j,k,n,*idx;
     
     trace(3,"sortobs: nobs=%d\n",obs->n);
     
     if (obs->n<=0) return 0;
     
-    qsort(obs->data,obs->n,sizeof(obsd_t),cmpobs);
+    if ((idx=(int *)malloc(sizeof(int)*obs->n))&&
+        mergeobs(obs->data,obs->n,idx)) {
+        
+        /* move records along cycles of permutation */
+        for (i=0;i<obs->n;i++) {
+            if (idx[i]==i) continue;
+            data=obs->data[i];
+            for (j=i;(k=idx[j])!=i;j=k) {
+                obs->data[j]=obs->data[k];
+                idx[j]=j;
+            }
+            obs->data[j]=data;
+            idx[j]=j;
+        }
+    }
+    else {
+        qsort(obs->data,obs->n,sizeof(obsd_t),cmpobs);
+    }
+    free(idx);
     
     /* delete duplicated data */
     for (i=j=0;i<obs->n;i++) {
         if (obs->data[i].sat!=obs->data[j].sat||
             obs->data[i].rcv!=obs->data[j].rcv||
             timediff(obs->data[i].time,obs->data[j].time)!=0.0) {
-            obs->data[++j]=obs->data[i];
+            if (++j<i) obs->data[j]=obs->data[i];
         }
     }
     obs->n=j+1;
@@ -2553,6 +3054,64 @@ extern int sortobs(obs_t *obs)
     }
     return n;
 }
+/* index observation data by epoch ---------------------------------------------
+* generate epoch index of observation data by epoch and receiver
+* args   : obs_t *obs    IO     observation data (sorted by sortobs())
+* return : number of epoch index (-1: memory allocation error)
+* notes  : obs->idx[k] points to the records obs->data[idx[k].i...
+*          idx[k].i+idx[k].n-1] of an epoch of receiver idx[k].rcv. the index
+*          is ordered by time and receiver.
+*          the index should be regenerated if the data are modified.
+*-----------------------------------------------------------------------------*/
+extern int indexobs(obs_t *obs)
+{
+    obsidx_t *obs_idx;
+    int i,n;
+    
+    trace(3,"indexobs: nobs=%d\n",obs->n);
+    
+    obs->ne=0;
+    
+    for (i=0;i<obs->n;i+=n) {
+        for (n=1;i+n<obs->n;n++) {
+            if (obs->data[i+n].rcv!=obs->data[i].rcv||
+                timediff(obs->data[i+n].time,obs->data[i].time)>DTTOL) break;
+        }
+        if (obs->ne>=obs->nemax) {
+            obs->nemax=obs->nemax<=0?1024:obs->nemax*2;
+            if (!(obs_idx=(obsidx_t *)realloc(obs->idx,
+                                              sizeof(obsidx_t)*obs->nemax))) {
+                trace(1,"indexobs malloc error: n=%d\n",obs->nemax);
+                free(obs->idx); obs->idx=NULL; obs->ne=obs->nemax=0;
+                return -1;
+            }
+            obs->idx=obs_idx;
+        }
+        obs->idx[obs->ne].rcv=obs->data[i].rcv;
+        obs->idx[obs->ne].i=i;
+        obs->idx[obs->ne++].n=n;
+    }
+    return obs->ne;
+}
+/* seek observation data epoch index by time -----------------------------------
+* search the first epoch index of receiver at or after the time
+* args   : obs_t   *obs  I      observation data (indexed by indexobs())
+*          gtime_t time  I      time
+*          int     rcv   I      receiver number
+* return : epoch index (obs->ne: not found)
+*-----------------------------------------------------------------------------*/
+extern int seekobs(const obs_t *obs, gtime_t time, int rcv)
+{
+    int i=0,j=obs->ne,k;
+    
+    while (i<j) { /* binary search */
+        k=(i+j)/2;
+        if (timediff(obs->data[obs->idx[k].i].time,time)<-DTTOL) i=k+1;
+        else j=k;
+    }
+    for (;i<obs->ne;i++) if (obs->idx[i].rcv==rcv) break;
+    return i;
+}
 /* screen by time --------------------------------------------------------------
 * screening by time start, time end, and time interval
 * args   : gtime_t time  I      time
@@ -2560,11 +3119,20 @@ extern int sortobs(obs_t *obs)
 *          gtime_t te    I      time end   (te.time==0:no screening by te)
 *          double  tint  I      time interval (s) (0.0:no screen by tint)
 * return : 1:on condition, 0:not on condition
+* notes  : the time interval is screened by integer nanoseconds of time of week
 *-----------------------------------------------------------------------------*/
 extern int screent(gtime_t time, gtime_t ts, gtime_t te, double tint)
 {
-    return (tint<=0.0||fmod(time2gpst(time,NULL)+DTTOL,tint)<=DTTOL*2.0)&&
-           (ts.time==0||timediff(time,ts)>=-DTTOL)&&
+    gtimens_t tn;
+    double tow,ti,tol=DTTOL*1E9;
+    
+    if (tint>0.0) {
+        tn=time2timens(time);
+        tow=(double)((tn.time-GPST0_TIME)%SECWEEK)*1E9+tn.nsec; /* (ns) */
+        ti=floor(tint*1E9+0.5);
+        if (fmod(tow+tol,ti)>tol*2.0) return 0;
+    }
+    return (ts.time==0||timediff(time,ts)>=-DTTOL)&&
            (te.time==0||timediff(time,te)<  DTTOL);
 }
 /* read/save navigation data ---------------------------------------------------
@@ -2661,6 +3229,7 @@ extern int savenav(const char *file, const nav_t *nav)
 extern void freeobs(obs_t *obs)
 {
     free(obs->data); obs->data=NULL; obs->n=obs->nmax=0;
+    free(obs->idx ); obs->idx =NULL; obs->ne=obs->nemax=0;
 }
 /* free navigation data ---------------------------------------------------------
 * free memory for navigation data
@@ -2683,15 +3252,75 @@ extern void freenav(nav_t *nav, int opt)
     if (opt&0x40) {free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;}
 }
 /* debug trace functions -----------------------------------------------------*/
+#define TRB_FMT     1                   /* binary trace: format string */
+#define TRB_TRACE   2                   /* binary trace: trace() */
+#define TRB_TRACET  3                   /* binary trace: tracet() */
+#define TRB_LINE    4                   /* binary trace: line of tracexxx() */
+#define TRB_MAT     5                   /* binary trace: tracemat() row (cont) */
+#define TRB_MATE    6                   /* binary trace: tracemat() row (end) */
+#define TRB_BYTES   7                   /* binary trace: traceb() (cont) */
+#define TRB_BYTESE  8                   /* binary trace: traceb() (end) */
+#define TRB_DROP    9                   /* binary trace: dropped records */
+
+#define TRB_MAGIC   "RTKLIB_TRB 1.1\n"  /* binary trace file magic */
+#define TRB_FHLEN   32                  /* binary trace file header length */
+#define TRB_HLEN    16                  /* binary trace record header length */
+#define TRB_MAXREC  4096                /* max length of binary trace record */
+#define TRB_MAXTHR  64                  /* max number of traced threads */
+#define TRB_CYCLE   20                  /* binary trace writer cycle (ms) */
+
 #ifdef TRACE
 
+#ifdef WIN32
+#define MEMBAR()    MemoryBarrier()
+#else
+#define MEMBAR()    __sync_synchronize()
+#endif
+
+typedef struct {                /* binary trace record header in buffer */
+    unsigned short len;         /* record length incl. header (bytes) */
+    unsigned char type,level;   /* record type and trace level */
+    unsigned int tick;          /* tick time (ms) */
+    const char *fmt;            /* format string (NULL: none) */
+} trbhdr_t;
+
+typedef struct {                /* binary trace buffer (one per thread) */
+    unsigned char *buff;        /* ring buffer */
+    unsigned int size;          /* buffer size (bytes, power of 2) */
+    volatile unsigned int wp;   /* write pointer (producer) */
+    volatile unsigned int rp;   /* read pointer (writer thread) */
+    volatile unsigned int ndrop; /* number of dropped records */
+    unsigned int nrep;          /* number of reported dropped records */
+    volatile int state;         /* state (0:free,1:used,2:released) */
+} trbuf_t;
+
 static FILE *fp_trace=NULL;     /* file pointer of trace */
 static char file_trace[1024];   /* trace file */
 static int level_trace=0;       /* level of trace */
 static unsigned int tick_trace=0; /* tick time at traceopen (ms) */
+static unsigned int tick_swap=0; /* tick time at last swap check (ms) */
 static gtime_t time_trace={0};  /* time at traceopen */
 static lock_t lock_trace;       /* lock for trace */
 
+static int size_trb=0;          /* binary trace buffer size (0:text trace) */
+static int bin_trace=0;         /* binary trace flag */
+static FILE *fp_trb=NULL;       /* file pointer of binary trace writer */
+static trbuf_t buf_trb[TRB_MAXTHR]; /* binary trace buffers */
+static volatile int nbuf_trb=0; /* number of used binary trace buffers */
+static volatile unsigned int nlost_trb=0; /* records lost by no buffer */
+static unsigned int nlrep_trb=0; /* reported records lost by no buffer */
+static volatile int state_trb=0; /* binary trace writer state */
+static thread_t thread_trb;     /* binary trace writer thread */
+static int key_trb_init=0;      /* thread specific key initialized flag */
+#ifdef WIN32
+static DWORD key_trb;           /* thread specific key of trace buffer */
+#else
+static pthread_key_t key_trb;   /* thread specific key of trace buffer */
+#endif
+static const char **fmt_trb=NULL; /* format table of writer (hash) */
+static unsigned int *id_trb=NULL; /* format ids of writer */
+static int nfmt_trb=0,nmax_trb=0; /* number of formats and table size */
+
 static void traceswap(void)
 {
     gtime_t time=utc2gpst(timeget());
@@ -2717,38 +3346,441 @@ static void traceswap(void)
     }
     unlock(&lock_trace);
 }
-extern void traceopen(const char *file)
+/* check swap of trace file once per second ----------------------------------*/
+static void traceswapt(void)
 {
-    gtime_t time=utc2gpst(timeget());
-    char path[1024];
+    unsigned int tick=tickget();
     
-    reppath(file,path,time,"","");
-    if (!*path||!(fp_trace=fopen(path,"w"))) fp_trace=stderr;
-    strcpy(file_trace,file);
-    tick_trace=tickget();
-    time_trace=time;
-    initlock(&lock_trace);
+    if ((int)(tick-tick_swap)<1000) return;
+    tick_swap=tick;
+    traceswap();
 }
-extern void traceclose(void)
+/* release binary trace buffer at thread exit --------------------------------*/
+static void trb_release(void *arg)
 {
-    if (fp_trace&&fp_trace!=stderr) fclose(fp_trace);
-    fp_trace=NULL;
-    file_trace[0]='\0';
+    ((trbuf_t *)arg)->state=2;
 }
-extern void tracelevel(int level)
+/* get binary trace buffer of calling thread ---------------------------------*/
+static trbuf_t *trb_buf(void)
 {
-    level_trace=level;
+    trbuf_t *buf=NULL;
+    int i;
+    
+#ifdef WIN32
+    if ((buf=(trbuf_t *)TlsGetValue(key_trb))) return buf;
+#else
+    if ((buf=(trbuf_t *)pthread_getspecific(key_trb))) return buf;
+#endif
+    lock(&lock_trace);
+    
+    /* released buffers are reused after drained by the writer */
+    for (i=0;i<TRB_MAXTHR;i++) {
+        buf=buf_trb+i;
+        if (buf->state==0||(buf->state==2&&buf->rp==buf->wp)) break;
+    }
+    if (i>=TRB_MAXTHR||
+        (!buf->buff&&!(buf->buff=(unsigned char *)malloc(size_trb)))) {
+        unlock(&lock_trace);
+        nlost_trb++;
+        return NULL;
+    }
+    if (buf->state==0) buf->size=(unsigned int)size_trb;
+    buf->state=1;
+    MEMBAR();
+    if (i>=nbuf_trb) nbuf_trb=i+1;
+    
+    unlock(&lock_trace);
+    
+#ifdef WIN32
+    TlsSetValue(key_trb,buf);
+#else
+    pthread_setspecific(key_trb,buf);
+#endif
+    return buf;
 }
-extern void trace(int level, const char *format, ...)
+/* copy data into/out of ring buffer -----------------------------------------*/
+static void trb_copyin(trbuf_t *buf, unsigned int pos, const void *data,
+                       unsigned int n)
 {
-    va_list ap;
+    unsigned int i=pos&(buf->size-1),k=buf->size-i;
+    
+    if (n<=k) {
+        memcpy(buf->buff+i,data,n);
+    }
+    else {
+        memcpy(buf->buff+i,data,k);
+        memcpy(buf->buff,(const unsigned char *)data+k,n-k);
+    }
+}
+static void trb_copyout(const trbuf_t *buf, unsigned int pos, void *data,
+                        unsigned int n)
+{
+    unsigned int i=pos&(buf->size-1),k=buf->size-i;
+    
+    if (n<=k) {
+        memcpy(data,buf->buff+i,n);
+    }
+    else {
+        memcpy(data,buf->buff+i,k);
+        memcpy((unsigned char *)data+k,buf->buff,n-k);
+    }
+}
+/* push binary trace record to buffer of calling thread ----------------------*/
+static void trb_push(int type, int level, const char *fmt,
+                     const unsigned char *data, int n)
+{
+    trbuf_t *buf;
+    trbhdr_t hdr;
+    unsigned int len=(unsigned int)(sizeof(hdr)+n);
+    
+    if (!(buf=trb_buf())) return;
+    
+    /* drop record if buffer full (never blocks the caller) */
+    if (buf->size-(buf->wp-buf->rp)<len) {
+        buf->ndrop++;
+        return;
+    }
+    hdr.len=(unsigned short)len;
+    hdr.type=(unsigned char)type;
+    hdr.level=(unsigned char)level;
+    hdr.tick=tickget();
+    hdr.fmt=fmt;
+    trb_copyin(buf,buf->wp,&hdr,sizeof(hdr));
+    if (n>0) trb_copyin(buf,buf->wp+sizeof(hdr),data,n);
+    MEMBAR();
+    buf->wp+=len;
+}
+/* encode trace arguments by format ------------------------------------------*/
+static int trb_args(unsigned char *p, const char *format, va_list ap)
+{
+    const int nmax=TRB_MAXREC-(int)sizeof(trbhdr_t);
+    const char *q,*s;
+    unsigned long u;
+    unsigned short len;
+    double d;
+    long l;
+    int n=0,k,lmod;
+    
+    for (q=format;*q;q++) {
+        if (*q!='%') continue;
+        for (q++;*q&&strchr("-+ #0",*q);q++) ;
+        if (n+(int)sizeof(long)*3>nmax) break;
+        if (*q=='*') {
+            l=va_arg(ap,int); memcpy(p+n,&l,sizeof(l)); n+=sizeof(l); q++;
+        }
+        else while (isdigit((int)*q)) q++;
+        if (*q=='.') {
+            if (*++q=='*') {
+                l=va_arg(ap,int); memcpy(p+n,&l,sizeof(l)); n+=sizeof(l); q++;
+            }
+            else while (isdigit((int)*q)) q++;
+        }
+        for (lmod=0;*q=='h'||*q=='l'||*q=='L';q++) {
+            if (*q=='l') lmod=1; else if (*q=='L') lmod=2;
+        }
+        switch (*q) {
+            case 'd': case 'i': case 'c':
+                l=lmod==1?va_arg(ap,long):va_arg(ap,int);
+                memcpy(p+n,&l,sizeof(l)); n+=sizeof(l);
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                u=lmod==1?va_arg(ap,unsigned long):va_arg(ap,unsigned int);
+                memcpy(p+n,&u,sizeof(u)); n+=sizeof(u);
+                break;
+            case 'e': case 'E': case 'f': case 'g': case 'G':
+                d=lmod==2?(double)va_arg(ap,long double):va_arg(ap,double);
+                memcpy(p+n,&d,sizeof(d)); n+=sizeof(d);
+                break;
+            case 's':
+                if (!(s=va_arg(ap,const char *))) s="(null)";
+                for (k=0;n+(int)sizeof(len)+k<nmax&&s[k];k++) ;
+                len=(unsigned short)k;
+                memcpy(p+n,&len,sizeof(len)); n+=sizeof(len);
+                memcpy(p+n,s,k); n+=k;
+                break;
+            case 'p':
+                u=(unsigned long)va_arg(ap,void *);
+                memcpy(p+n,&u,sizeof(u)); n+=sizeof(u);
+                break;
+            case 'n':
+                (void)va_arg(ap,int *);
+                break;
+            case '\0':
+                return n;
+        }
+    }
+    return n;
+}
+/* output binary trace record by format --------------------------------------*/
+static void trb_printf(int type, int level, const char *format, va_list ap)
+{
+    unsigned char data[TRB_MAXREC];
+    
+    trb_push(type,level,format,data,trb_args(data,format,ap));
+}
+/* output trace line ---------------------------------------------------------*/
+static void tracel(int level, const char *format, ...)
+{
+    va_list ap;
+    
+    va_start(ap,format);
+    if (bin_trace) trb_printf(TRB_LINE,level,format,ap);
+    else vfprintf(fp_trace,format,ap);
+    va_end(ap);
+}
+/* format id of binary trace writer ------------------------------------------*/
+static unsigned int trb_fmtid(const char *fmt, int *isnew)
+{
+    const char **fmts;
+    unsigned int *ids,i,j;
+    int n;
+    
+    *isnew=0;
+    if (nfmt_trb*2>=nmax_trb) {
+        n=nmax_trb<=0?256:nmax_trb*2;
+        fmts=(const char **)calloc(n,sizeof(char *));
+        ids=(unsigned int *)calloc(n,sizeof(unsigned int));
+        if (!fmts||!ids) {
+            free(fmts); free(ids);
+            return 0;
+        }
+        for (i=0;i<(unsigned int)nmax_trb;i++) {
+            if (!fmt_trb[i]) continue;
+            j=(unsigned int)(((unsigned long)fmt_trb[i]>>3)*2654435761u)&(n-1);
+            while (fmts[j]) j=(j+1)&(n-1);
+            fmts[j]=fmt_trb[i]; ids[j]=id_trb[i];
+        }
+        free(fmt_trb); free(id_trb);
+        fmt_trb=fmts; id_trb=ids; nmax_trb=n;
+    }
+    i=(unsigned int)(((unsigned long)fmt>>3)*2654435761u)&(nmax_trb-1);
+    for (;fmt_trb[i];i=(i+1)&(nmax_trb-1)) {
+        if (fmt_trb[i]==fmt) return id_trb[i];
+    }
+    fmt_trb[i]=fmt;
+    id_trb[i]=(unsigned int)nfmt_trb++;
+    *isnew=1;
+    return id_trb[i];
+}
+/* write binary trace record to file -----------------------------------------*/
+static void trb_write(FILE *fp, int type, int level, unsigned int tick,
+                      int thr, unsigned int id, const void *data, int n)
+{
+    unsigned char hdr[TRB_HLEN]={0};
+    unsigned short len=(unsigned short)(TRB_HLEN+n),no=(unsigned short)thr;
+    
+    memcpy(hdr,&len,2);
+    hdr[2]=(unsigned char)type;
+    hdr[3]=(unsigned char)level;
+    memcpy(hdr+ 4,&tick,4);
+    memcpy(hdr+ 8,&no  ,2);
+    memcpy(hdr+12,&id  ,4);
+    fwrite(hdr,1,TRB_HLEN,fp);
+    if (n>0) fwrite(data,1,n,fp);
+}
+/* write binary trace file header --------------------------------------------*/
+static void trb_head(FILE *fp)
+{
+    unsigned char buff[TRB_FHLEN]={0};
+    unsigned int order=0x01020304,nlong=(unsigned int)sizeof(long);
+    
+    memcpy(buff,TRB_MAGIC,strlen(TRB_MAGIC));
+    memcpy(buff+16,&order,4);
+    memcpy(buff+20,&tick_trace,4);
+    memcpy(buff+24,&nlong,4);
+    fwrite(buff,1,TRB_FHLEN,fp);
+    
+    /* format ids are local to each file */
+    if (fmt_trb) memset(fmt_trb,0,sizeof(char *)*nmax_trb);
+    nfmt_trb=0;
+}
+/* swap binary trace file by writer ------------------------------------------*/
+static void trb_swap(void)
+{
+    gtime_t time=utc2gpst(timeget());
+    FILE *fp;
+    char path[1024];
+    
+    if ((int)(time2gpst(time      ,NULL)/INT_SWAP_TRAC)==
+        (int)(time2gpst(time_trace,NULL)/INT_SWAP_TRAC)) return;
+    time_trace=time;
+    
+    if (!reppath(file_trace,path,time,"","")||!(fp=fopen(path,"wb"))) return;
+    fclose(fp_trb);
+    fp_trb=fp;
+    trb_head(fp_trb);
+}
+/* drain binary trace buffers to file ----------------------------------------*/
+static void trb_drain(void)
+{
+    trbhdr_t hdr;
+    unsigned char data[TRB_MAXREC];
+    unsigned int wp[TRB_MAXTHR],tick=0,id,ndrop;
+    int i,j,n=nbuf_trb,isnew;
+    
+    if (INT_SWAP_TRAC>0.0) trb_swap();
+    
+    /* snapshot of write pointers */
+    for (i=0;i<n;i++) wp[i]=buf_trb[i].wp;
+    MEMBAR();
+    
+    /* merge records of all threads in order of tick time */
+    for (;;) {
+        for (i=0,j=-1;i<n;i++) {
+            if (buf_trb[i].rp==wp[i]) continue;
+            trb_copyout(buf_trb+i,buf_trb[i].rp,&hdr,sizeof(hdr));
+            if (j<0||(int)(hdr.tick-tick)<0) {
+                j=i; tick=hdr.tick;
+            }
+        }
+        if (j<0) break;
+        trb_copyout(buf_trb+j,buf_trb[j].rp,&hdr,sizeof(hdr));
+        trb_copyout(buf_trb+j,buf_trb[j].rp+sizeof(hdr),data,
+                    hdr.len-sizeof(hdr));
+        MEMBAR();
+        buf_trb[j].rp+=hdr.len;
+        
+        id=0;
+        if (hdr.fmt) {
+            id=trb_fmtid(hdr.fmt,&isnew);
+            if (isnew) {
+                trb_write(fp_trb,TRB_FMT,0,hdr.tick,j,id,hdr.fmt,
+                          (int)strlen(hdr.fmt)+1);
+            }
+        }
+        trb_write(fp_trb,hdr.type,hdr.level,hdr.tick,j,id,data,
+                  hdr.len-(int)sizeof(hdr));
+    }
+    /* report dropped records */
+    for (i=0;i<n;i++) {
+        if (buf_trb[i].ndrop==buf_trb[i].nrep) continue;
+        ndrop=buf_trb[i].ndrop-buf_trb[i].nrep;
+        buf_trb[i].nrep+=ndrop;
+        trb_write(fp_trb,TRB_DROP,0,tickget(),i,0,&ndrop,4);
+    }
+    if (nlost_trb!=nlrep_trb) {
+        ndrop=nlost_trb-nlrep_trb;
+        nlrep_trb+=ndrop;
+        trb_write(fp_trb,TRB_DROP,0,tickget(),0xFFFF,0,&ndrop,4);
+    }
+    fflush(fp_trb);
+}
+/* binary trace writer thread ------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI trb_thread(void *arg)
+#else
+static void *trb_thread(void *arg)
+#endif
+{
+    (void)arg;
+    
+    while (state_trb) {
+        sleepms(TRB_CYCLE);
+        trb_drain();
+    }
+    trb_drain();
+    return 0;
+}
+/* set binary trace buffer size ------------------------------------------------
+* set buffer size of binary trace. with the size>0, trace records are written
+* into lock-free ring buffers of the calling threads in binary and output to
+* the trace file by a background writer thread
+* args   : int    size      I   buffer size per thread (bytes) (0:text trace)
+* return : none
+* notes  : call before traceopen(). the size is rounded up to power of 2.
+*          records are dropped if the buffer is full and the number of dropped
+*          records is recorded in the trace file.
+*          the binary trace file is converted to text trace by tracedec().
+*          arguments of a record exceeding 4096 bytes in total are truncated.
+*-----------------------------------------------------------------------------*/
+extern void tracebuf(int size)
+{
+    int n;
+    
+    if (size<=0) {
+        size_trb=0;
+        return;
+    }
+    for (n=TRB_MAXREC*4;n<size&&n<0x40000000;n<<=1) ;
+    size_trb=n;
+}
+extern void traceopen(const char *file)
+{
+    gtime_t time=utc2gpst(timeget());
+    char path[1024];
+    
+    reppath(file,path,time,"","");
+    bin_trace=0;
+    if (size_trb>0&&*path&&(fp_trace=fopen(path,"wb"))) bin_trace=1;
+    else if (!*path||!(fp_trace=fopen(path,"w"))) fp_trace=stderr;
+    strcpy(file_trace,file);
+    tick_trace=tick_swap=tickget();
+    time_trace=time;
+    initlock(&lock_trace);
+    
+    if (!bin_trace) return;
+    
+    /* start binary trace writer */
+    if (!key_trb_init) {
+#ifdef WIN32
+        key_trb=TlsAlloc();
+#else
+        pthread_key_create(&key_trb,trb_release);
+#endif
+        key_trb_init=1;
+    }
+    fp_trb=fp_trace;
+    trb_head(fp_trb);
+    state_trb=1;
+#ifdef WIN32
+    if (!(thread_trb=CreateThread(NULL,0,trb_thread,NULL,0,NULL))) {
+#else
+    if (pthread_create(&thread_trb,NULL,trb_thread,NULL)) {
+#endif
+        state_trb=bin_trace=0;
+        fclose(fp_trb);
+        fp_trace=fp_trb=stderr;
+    }
+}
+extern void traceclose(void)
+{
+    if (bin_trace) {
+        fp_trace=NULL;
+        
+        /* stop binary trace writer and drain buffers */
+        state_trb=0;
+#ifdef WIN32
+        WaitForSingleObject(thread_trb,10000);
+        CloseHandle(thread_trb);
+#else
+        pthread_join(thread_trb,NULL);
+#endif
+        fclose(fp_trb);
+        fp_trb=NULL;
+        bin_trace=0;
+    }
+    if (fp_trace&&fp_trace!=stderr) fclose(fp_trace);
+    fp_trace=NULL;
+    file_trace[0]='\0';
+}
+extern void tracelevel(int level)
+{
+    level_trace=level;
+}
+extern void trace(int level, const char *format, ...)
+{
+    va_list ap;
     
     /* print error message to stderr */
     if (level<=1) {
         va_start(ap,format); vfprintf(stderr,format,ap); va_end(ap);
     }
     if (!fp_trace||level>level_trace) return;
-    traceswap();
+    if (bin_trace) {
+        va_start(ap,format); trb_printf(TRB_TRACE,level,format,ap); va_end(ap);
+        return;
+    }
+    traceswapt();
     fprintf(fp_trace,"%d ",level);
     va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
     fflush(fp_trace);
@@ -2758,15 +3790,36 @@ extern void tracet(int level, const char *format, ...)
     va_list ap;
     
     if (!fp_trace||level>level_trace) return;
-    traceswap();
+    if (bin_trace) {
+        va_start(ap,format); trb_printf(TRB_TRACET,level,format,ap); va_end(ap);
+        return;
+    }
+    traceswapt();
     fprintf(fp_trace,"%d %9.3f: ",level,(tickget()-tick_trace)/1000.0);
     va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
     fflush(fp_trace);
 }
 extern void tracemat(int level, const double *A, int n, int m, int p, int q)
 {
+    unsigned char data[TRB_MAXREC];
+    int i,j,k,nmax=(TRB_MAXREC-(int)sizeof(trbhdr_t)-2)/(int)sizeof(double);
+    
     if (!fp_trace||level>level_trace) return;
-    matfprint(A,n,m,p,q,fp_trace); fflush(fp_trace);
+    if (!bin_trace) {
+        matfprint(A,n,m,p,q,fp_trace); fflush(fp_trace);
+        return;
+    }
+    data[0]=(unsigned char)p;
+    data[1]=(unsigned char)q;
+    for (i=0;i<n;i++) {
+        for (j=0;j==0||j<m;j+=nmax) {
+            for (k=0;k<nmax&&j+k<m;k++) {
+                memcpy(data+2+k*sizeof(double),A+i+(j+k)*n,sizeof(double));
+            }
+            trb_push(j+k<m?TRB_MAT:TRB_MATE,level,NULL,data,
+                     2+k*(int)sizeof(double));
+        }
+    }
 }
 extern void traceobs(int level, const obsd_t *obs, int n)
 {
@@ -2777,12 +3830,12 @@ extern void traceobs(int level, const obsd_t *obs, int n)
     for (i=0;i<n;i++) {
         time2str(obs[i].time,str,3);
         satno2id(obs[i].sat,id);
-        fprintf(fp_trace," (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
+        tracel(level," (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
               i+1,str,id,obs[i].rcv,obs[i].L[0],obs[i].L[1],obs[i].P[0],
               obs[i].P[1],obs[i].LLI[0],obs[i].LLI[1],obs[i].code[0],
               obs[i].code[1],obs[i].SNR[0]*0.25,obs[i].SNR[1]*0.25);
     }
-    fflush(fp_trace);
+    if (!bin_trace) fflush(fp_trace);
 }
 extern void tracenav(int level, const nav_t *nav)
 {
@@ -2794,14 +3847,14 @@ extern void tracenav(int level, const nav_t *nav)
         time2str(nav->eph[i].toe,s1,0);
         time2str(nav->eph[i].ttr,s2,0);
         satno2id(nav->eph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
+        tracel(level,"(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
                 id,s1,s2,nav->eph[i].iode,nav->eph[i].iodc,nav->eph[i].svh);
     }
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
+    tracel(level,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
             nav->ion_gps[1],nav->ion_gps[2],nav->ion_gps[3]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
+    tracel(level,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
             nav->ion_gps[5],nav->ion_gps[6],nav->ion_gps[7]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
+    tracel(level,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
             nav->ion_gal[1],nav->ion_gal[2],nav->ion_gal[3]);
 }
 extern void tracegnav(int level, const nav_t *nav)
@@ -2814,7 +3867,7 @@ extern void tracegnav(int level, const nav_t *nav)
         time2str(nav->geph[i].toe,s1,0);
         time2str(nav->geph[i].tof,s2,0);
         satno2id(nav->geph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
+        tracel(level,"(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
                 id,s1,s2,nav->geph[i].frq,nav->geph[i].svh,nav->geph[i].taun*1E6);
     }
 }
@@ -2828,7 +3881,7 @@ extern void tracehnav(int level, const nav_t *nav)
         time2str(nav->seph[i].t0,s1,0);
         time2str(nav->seph[i].tof,s2,0);
         satno2id(nav->seph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d\n",i+1,
+        tracel(level,"(%3d) %-3s : %s %s %2d %2d\n",i+1,
                 id,s1,s2,nav->seph[i].svh,nav->seph[i].sva);
     }
 }
@@ -2843,7 +3896,7 @@ extern void tracepeph(int level, const nav_t *nav)
         time2str(nav->peph[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
+            tracel(level,"%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
                     s,nav->peph[i].index,id,
                     nav->peph[i].pos[j][0],nav->peph[i].pos[j][1],
                     nav->peph[i].pos[j][2],nav->peph[i].pos[j][3]*1E9,
@@ -2863,7 +3916,7 @@ extern void tracepclk(int level, const nav_t *nav)
         time2str(nav->pclk[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %6.3f\n",
+            tracel(level,"%-3s %d %-3s %13.3f %6.3f\n",
                     s,nav->pclk[i].index,id,
                     nav->pclk[i].clk[j][0]*1E9,nav->pclk[i].std[j][0]*1E9);
         }
@@ -2871,12 +3924,20 @@ extern void tracepclk(int level, const nav_t *nav)
 }
 extern void traceb(int level, const unsigned char *p, int n)
 {
-    int i;
+    int i,k,nmax=(TRB_MAXREC-(int)sizeof(trbhdr_t))&~7;
     if (!fp_trace||level>level_trace) return;
+    if (bin_trace) {
+        for (i=0;i==0||i<n;i+=nmax) {
+            k=n-i<nmax?n-i:nmax;
+            trb_push(i+k<n?TRB_BYTES:TRB_BYTESE,level,NULL,p+i,k);
+        }
+        return;
+    }
     for (i=0;i<n;i++) fprintf(fp_trace,"%02X%s",*p++,i%8==7?" ":"");
     fprintf(fp_trace,"\n");
 }
 #else
+extern void tracebuf(int size) {}
 extern void traceopen(const char *file) {}
 extern void traceclose(void) {}
 extern void tracelevel(int level) {}
@@ -2893,6 +3954,205 @@ extern void traceb  (int level, const unsigned char *p, int n) {}
 
 #endif /* TRACE */
 
+/* read binary trace data ----------------------------------------------------*/
+static int trb_get(const unsigned char **p, const unsigned char *end, void *v,
+                   int n)
+{
+    if (end-*p<n) return 0;
+    memcpy(v,*p,n);
+    *p+=n;
+    return 1;
+}
+/* output binary trace record arguments by format ----------------------------*/
+static void trb_print(FILE *fp, const char *format, const unsigned char *p,
+                      const unsigned char *end)
+{
+    const char *q;
+    char spec[64],str[TRB_MAXREC+1];
+    unsigned long u;
+    unsigned short len;
+    double d;
+    long l;
+    int k,lmod;
+    
+    for (q=format;*q;q++) {
+        if (*q!='%') {
+            fputc(*q,fp);
+            continue;
+        }
+        /* rebuild conversion specification with arguments of widths */
+        k=0; spec[k++]='%';
+        for (q++;*q&&strchr("-+ #0",*q)&&k<8;q++) spec[k++]=*q;
+        if (*q=='*') {
+            if (!trb_get(&p,end,&l,sizeof(l))) return;
+            k+=sprintf(spec+k,"%ld",l); q++;
+        }
+        else for (;isdigit((int)*q)&&k<20;q++) spec[k++]=*q;
+        if (*q=='.') {
+            spec[k++]=*q++;
+            if (*q=='*') {
+                if (!trb_get(&p,end,&l,sizeof(l))) return;
+                k+=sprintf(spec+k,"%ld",l); q++;
+            }
+            else for (;isdigit((int)*q)&&k<40;q++) spec[k++]=*q;
+        }
+        for (lmod=0;*q=='h'||*q=='l'||*q=='L';q++) {
+            if (*q=='l') lmod=1;
+        }
+        if (!*q) break;
+        if (lmod) spec[k++]='l';
+        spec[k++]=*q; spec[k]='\0';
+        
+        switch (*q) {
+            case 'd': case 'i': case 'c':
+                if (!trb_get(&p,end,&l,sizeof(l))) return;
+                if (lmod) fprintf(fp,spec,l); else fprintf(fp,spec,(int)l);
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                if (!trb_get(&p,end,&u,sizeof(u))) return;
+                if (lmod) fprintf(fp,spec,u);
+                else fprintf(fp,spec,(unsigned int)u);
+                break;
+            case 'e': case 'E': case 'f': case 'g': case 'G':
+                if (!trb_get(&p,end,&d,sizeof(d))) return;
+                fprintf(fp,spec,d);
+                break;
+            case 's':
+                if (!trb_get(&p,end,&len,sizeof(len))||
+                    !trb_get(&p,end,str,len)) return;
+                str[len]='\0';
+                fprintf(fp,spec,str);
+                break;
+            case 'p':
+                if (!trb_get(&p,end,&u,sizeof(u))) return;
+                fprintf(fp,"0x%lx",u);
+                break;
+            case '%':
+                fputc('%',fp);
+                break;
+            case 'n':
+                break;
+            default:
+                fputs(spec,fp);
+                break;
+        }
+    }
+}
+/* decode binary trace file ----------------------------------------------------
+* decode binary trace file and output text trace
+* args   : char   *file     I   binary trace file
+*          FILE   *fp       I   output file pointer
+*          int    level     I   max trace level of output (0:all levels)
+* return : number of output records (-1:error)
+* notes  : the output is identical with the text trace except for the lines of
+*          dropped records. the file has to be generated on the same platform
+*          (byte order and size of long)
+*-----------------------------------------------------------------------------*/
+extern int tracedec(const char *file, FILE *fp, int level)
+{
+    FILE *fpi;
+    unsigned char head[TRB_FHLEN],hdr[TRB_HLEN],*data,*p;
+    unsigned int order,tick0,nlong,tick,id,ndrop;
+    unsigned short len,thr;
+    double d;
+    char **fmts=NULL,**fmts_p;
+    int i,type,lvl,n,nfmt=0,nrec=0;
+    
+    trace(3,"tracedec: file=%s level=%d\n",file,level);
+    
+    if (!(fpi=fopen(file,"rb"))) {
+        trace(2,"binary trace file open error: %s\n",file);
+        return -1;
+    }
+    if (fread(head,TRB_FHLEN,1,fpi)<1||
+        strncmp((char *)head,TRB_MAGIC,strlen(TRB_MAGIC))) {
+        trace(2,"binary trace file format error: %s\n",file);
+        fclose(fpi);
+        return -1;
+    }
+    memcpy(&order,head+16,4);
+    memcpy(&tick0,head+20,4);
+    memcpy(&nlong,head+24,4);
+    if (order!=0x01020304||nlong!=sizeof(long)) {
+        trace(2,"binary trace file platform error: %s\n",file);
+        fclose(fpi);
+        return -1;
+    }
+    if (!(data=(unsigned char *)malloc(65536))) {
+        fclose(fpi);
+        return -1;
+    }
+    while (fread(hdr,TRB_HLEN,1,fpi)==1) {
+        memcpy(&len ,hdr   ,2);
+        memcpy(&tick,hdr+ 4,4);
+        memcpy(&thr ,hdr+ 8,2);
+        memcpy(&id  ,hdr+12,4);
+        type=hdr[2]; lvl=hdr[3];
+        if (len<TRB_HLEN) break;
+        n=len-TRB_HLEN;
+        if (n>0&&fread(data,n,1,fpi)<1) break;
+        
+        if (type==TRB_FMT) {
+            if (n<=0||(int)id>=nfmt+65536) continue;
+            if ((int)id>=nfmt) {
+                if (!(fmts_p=(char **)realloc(fmts,sizeof(char *)*(id+256)))) {
+                    break;
+                }
+                fmts=fmts_p;
+                for (i=nfmt;i<(int)id+256;i++) fmts[i]=NULL;
+                nfmt=id+256;
+            }
+            free(fmts[id]);
+            if ((fmts[id]=(char *)malloc(n+1))) {
+                memcpy(fmts[id],data,n); fmts[id][n]='\0';
+            }
+            continue;
+        }
+        if (level>0&&lvl>level) continue;
+        
+        switch (type) {
+            case TRB_TRACE:
+            case TRB_TRACET:
+            case TRB_LINE:
+                if ((int)id>=nfmt||!fmts[id]) continue;
+                if (type==TRB_TRACE) fprintf(fp,"%d ",lvl);
+                else if (type==TRB_TRACET) {
+                    fprintf(fp,"%d %9.3f: ",lvl,(tick-tick0)/1000.0);
+                }
+                trb_print(fp,fmts[id],data,data+n);
+                break;
+            case TRB_MAT:
+            case TRB_MATE:
+                if (n<2) continue;
+                for (p=data+2;p+sizeof(double)<=data+n;p+=sizeof(double)) {
+                    memcpy(&d,p,sizeof(d));
+                    fprintf(fp," %*.*f",data[0],data[1],d);
+                }
+                if (type==TRB_MATE) fprintf(fp,"\n");
+                break;
+            case TRB_BYTES:
+            case TRB_BYTESE:
+                for (i=0;i<n;i++) fprintf(fp,"%02X%s",data[i],i%8==7?" ":"");
+                if (type==TRB_BYTESE) fprintf(fp,"\n");
+                break;
+            case TRB_DROP:
+                if (n<4) continue;
+                memcpy(&ndrop,data,4);
+                fprintf(fp,"*** %u trace records dropped (thread=%d)\n",ndrop,
+                        thr==0xFFFF?-1:thr);
+                break;
+            default:
+                continue;
+        }
+        nrec++;
+    }
+    for (i=0;i<nfmt;i++) free(fmts[i]);
+    free(fmts);
+    free(data);
+    fclose(fpi);
+    return nrec;
+}
+
 /* execute command -------------------------------------------------------------
 * execute command line by operating system shell
 * args   : char   *cmd      I   command line
@@ -3223,6 +4483,77 @@ extern double satazel(const double *pos, const double *e, double *azel)
     if (azel) {azel[0]=az; azel[1]=el;}
     return el;
 }
+/* geometric distances ---------------------------------------------------------
+* compute geometric distances and receiver-to-satellite unit vectors for all
+* satellites of an epoch
+* args   : double *rs       I   satellite positions/velocities (6 x n) (m,m/s)
+*          double *rr       I   receiver position (ecef at reception) (m)
+*          int    n         I   number of satellites
+*          double *r        O   geometric distances (n) (m)
+*                               (0>:error/no satellite position)
+*          double *e        O   line-of-sight vectors (3 x n) (ecef)
+* return : none
+* notes  : same as geodist() for each satellite. line-of-sight vector is not
+*          changed for the satellite without position.
+*-----------------------------------------------------------------------------*/
+extern void geodists(const double *rs, const double *rr, int n, double *r,
+                     double *e)
+{
+    double d[3];
+    int i;
+    
+    for (i=0;i<n;i++) {
+        r[i]=dot(rs+i*6,rs+i*6,3);
+    }
+    for (i=0;i<n;i++) {
+        if (r[i]<RE_WGS84*RE_WGS84) {r[i]=-1.0; continue;}
+        d[0]=rs[i*6  ]-rr[0];
+        d[1]=rs[i*6+1]-rr[1];
+        d[2]=rs[i*6+2]-rr[2];
+        r[i]=sqrt(d[2]*d[2]+d[1]*d[1]+d[0]*d[0]);
+        e[i*3  ]=d[0]/r[i];
+        e[i*3+1]=d[1]/r[i];
+        e[i*3+2]=d[2]/r[i];
+        r[i]+=OMGE*(rs[i*6]*rr[1]-rs[i*6+1]*rr[0])/CLIGHT;
+    }
+}
+/* satellite azimuth/elevation angles ------------------------------------------
+* compute satellite azimuth/elevation angles for all satellites of an epoch
+* args   : double *pos      I   geodetic position {lat,lon,h} (rad,m)
+*          double *e        I   receiver-to-satellilte unit vevtors (3 x n)
+*          double *r        I   geometric distances (n) (m) (NULL: all valid)
+*          int    n         I   number of satellites
+*          double *azel     O   azimuth/elevation angles (2 x n) {az,el} (rad)
+* return : none
+* notes  : same as satazel() for each satellite. the ecef to local coordinate
+*          transformation is computed once for the epoch. azimuth/elevation
+*          angles are not changed for the satellite with r[i]<=0.
+*-----------------------------------------------------------------------------*/
+extern void satazels(const double *pos, const double *e, const double *r,
+                     int n, double *azel)
+{
+    double E[9],enu[3];
+    int i;
+    
+    if (pos[2]<=-RE_WGS84) {
+        for (i=0;i<n;i++) {
+            if (r&&r[i]<=0.0) continue;
+            azel[i*2]=0.0; azel[1+i*2]=PI/2.0;
+        }
+        return;
+    }
+    xyz2enu(pos,E);
+    
+    for (i=0;i<n;i++) {
+        if (r&&r[i]<=0.0) continue;
+        enu[0]=E[0]*e[i*3]+E[3]*e[i*3+1]+E[6]*e[i*3+2];
+        enu[1]=E[1]*e[i*3]+E[4]*e[i*3+1]+E[7]*e[i*3+2];
+        enu[2]=E[2]*e[i*3]+E[5]*e[i*3+1]+E[8]*e[i*3+2];
+        azel[i*2]=dot(enu,enu,2)<1E-12?0.0:atan2(enu[0],enu[1]);
+        if (azel[i*2]<0.0) azel[i*2]+=2*PI;
+        azel[1+i*2]=asin(enu[2]);
+    }
+}
 /* compute dops ----------------------------------------------------------------
 * compute DOP (dilution of precision)
 * args   : int    ns        I   number of satellites
@@ -3391,8 +4722,7 @@ static double mapf(double el, double a, double b, double c)
     double sinel=sin(el);
     return (1.0+a/(1.0+b/(1.0+c)))/(sinel+(a/(sinel+b/(sinel+c))));
 }
-static double nmf(gtime_t time, const double pos[], const double azel[],
-                  double *mapfw)
+static void nmf_coef(gtime_t time, const double pos[], double *ah, double *aw)
 {
     /* ref [5] table 3 */
     /* hydro-ave-a,b,c, hydro-amp-a,b,c, wet-a,b,c at latitude 15,30,45,60,75 */
@@ -3409,15 +4739,9 @@ static double nmf(gtime_t time, const double pos[], const double azel[],
         { 1.4275268E-3, 1.5138625E-3, 1.4572752E-3, 1.5007428E-3, 1.7599082E-3},
         { 4.3472961E-2, 4.6729510E-2, 4.3908931E-2, 4.4626982E-2, 5.4736038E-2}
     };
-    const double aht[]={ 2.53E-5, 5.49E-3, 1.14E-3}; /* height correction */
-    
-    double y,cosy,ah[3],aw[3],dm,el=azel[1],lat=pos[0]*R2D,hgt=pos[2];
+    double y,cosy,lat=pos[0]*R2D;
     int i;
     
-    if (el<=0.0) {
-        if (mapfw) *mapfw=0.0;
-        return 0.0;
-    }
     /* year from doy 28, added half a year for southern latitudes */
     y=(time2doy(time)-28.0)/365.25+(lat<0.0?0.5:0.0);
     
@@ -3428,6 +4752,17 @@ static double nmf(gtime_t time, const double pos[], const double azel[],
         ah[i]=interpc(coef[i  ],lat)-interpc(coef[i+3],lat)*cosy;
         aw[i]=interpc(coef[i+6],lat);
     }
+}
+static double nmf_el(const double *ah, const double *aw, double hgt, double el,
+                     double *mapfw)
+{
+    const double aht[]={ 2.53E-5, 5.49E-3, 1.14E-3}; /* height correction */
+    double dm;
+    
+    if (el<=0.0) {
+        if (mapfw) *mapfw=0.0;
+        return 0.0;
+    }
     /* ellipsoidal height is used instead of height above sea level */
     dm=(1.0/sin(el)-mapf(el,aht[0],aht[1],aht[2]))*hgt/1E3;
     
@@ -3435,6 +4770,19 @@ static double nmf(gtime_t time, const double pos[], const double azel[],
     
     return mapf(el,ah[0],ah[1],ah[2])+dm;
 }
+static double nmf(gtime_t time, const double pos[], const double azel[],
+                  double *mapfw)
+{
+    double ah[3],aw[3];
+    
+    if (azel[1]<=0.0) {
+        if (mapfw) *mapfw=0.0;
+        return 0.0;
+    }
+    nmf_coef(time,pos,ah,aw);
+    
+    return nmf_el(ah,aw,pos[2],azel[1],mapfw);
+}
 
 /* troposphere mapping function ------------------------------------------------
 * compute tropospheric mapping function by NMF
@@ -3478,6 +4826,62 @@ extern double tropmapf(gtime_t time, const double pos[], const double azel[],
     return nmf(time,pos,azel,mapfw); /* NMF */
 #endif
 }
+/* troposphere mapping functions -----------------------------------------------
+* compute tropospheric mapping functions for all satellites of an epoch
+* args   : gtime_t t        I   time
+*          double *pos      I   receiver position {lat,lon,h} (rad,m)
+*          double *azel     I   azimuth/elevation angles (2 x n) {az,el} (rad)
+*          int    n         I   number of satellites
+*          double *mapfh    O   dry mapping functions (n)
+*          double *mapfw    O   wet mapping functions (n) (NULL: not output)
+* return : none
+* notes  : same as tropmapf() for each satellite. the time and position
+*          dependent coefficients are computed once for the epoch.
+*-----------------------------------------------------------------------------*/
+extern void tropmapfs(gtime_t time, const double pos[], const double *azel,
+                      int n, double *mapfh, double *mapfw)
+{
+#ifdef IERS_MODEL
+    const double ep[]={2000,1,1,12,0,0};
+    double mjd,lat,lon,hgt,zd,gmfh,gmfw;
+#else
+    double ah[3],aw[3];
+#endif
+    int i;
+    
+    trace(4,"tropmapfs: pos=%10.6f %11.6f %6.1f n=%d\n",pos[0]*R2D,pos[1]*R2D,
+          pos[2],n);
+    
+    if (pos[2]<-1000.0||pos[2]>20000.0) {
+        for (i=0;i<n;i++) {
+            mapfh[i]=0.0;
+            if (mapfw) mapfw[i]=0.0;
+        }
+        return;
+    }
+#ifdef IERS_MODEL
+    mjd=51544.5+(timediff(time,epoch2time(ep)))/86400.0;
+    lat=pos[0];
+    lon=pos[1];
+    hgt=pos[2]-geoidh(pos); /* height in m (mean sea level) */
+    
+    for (i=0;i<n;i++) {
+        zd=PI/2.0-azel[1+i*2];
+        
+        /* call GMF */
+        gmf_(&mjd,&lat,&lon,&hgt,&zd,&gmfh,&gmfw);
+        
+        mapfh[i]=gmfh;
+        if (mapfw) mapfw[i]=gmfw;
+    }
+#else
+    nmf_coef(time,pos,ah,aw);
+    
+    for (i=0;i<n;i++) {
+        mapfh[i]=nmf_el(ah,aw,pos[2],azel[1+i*2],mapfw?mapfw+i:NULL);
+    }
+#endif
+}
 /* interpolate antenna phase center variation --------------------------------*/
 static double interpvar(double ang, const double *var)
 {
@@ -3514,6 +4918,44 @@ extern void antmodel(const pcv_t *pcv, const double *del, const double *azel,
     }
     trace(5,"antmodel: dant=%6.3f %6.3f\n",dant[0],dant[1]);
 }
+/* receiver antenna models -----------------------------------------------------
+* compute antenna offsets for all satellites of an epoch
+* args   : pcv_t *pcv       I   antenna phase center parameters
+*          double *del      I   antenna delta {e,n,u} (m)
+*          double *azel     I   azimuth/elevation angles (2 x n) {az,el} (rad)
+*          int    n         I   number of satellites
+*          int    opt       I   option (0:only offset,1:offset+pcv)
+*          double *dant     O   range offsets (NFREQ x n) (m)
+* return : none
+* notes  : same as antmodel() for each satellite
+*-----------------------------------------------------------------------------*/
+extern void antmodels(const pcv_t *pcv, const double *del, const double *azel,
+                      int n, int opt, double *dant)
+{
+    double off[NFREQ][3],e[3],cosel;
+    int i,j,k;
+    
+    trace(4,"antmodels: n=%d opt=%d\n",n,opt);
+    
+    for (i=0;i<NFREQ;i++) for (j=0;j<3;j++) {
+        off[i][j]=pcv->off[i][j]+del[j];
+    }
+    for (k=0;k<n;k++) {
+        cosel=cos(azel[1+k*2]);
+        e[0]=sin(azel[k*2])*cosel;
+        e[1]=cos(azel[k*2])*cosel;
+        e[2]=sin(azel[1+k*2]);
+        
+        for (i=0;i<NFREQ;i++) {
+            dant[i+k*NFREQ]=-dot(off[i],e,3);
+        }
+        if (!opt) continue;
+        
+        for (i=0;i<NFREQ;i++) {
+            dant[i+k*NFREQ]+=interpvar(90.0-azel[1+k*2]*R2D,pcv->var[i]);
+        }
+    }
+}
 /* satellite antenna model ------------------------------------------------------
 * compute satellite antenna phase center parameters
 * args   : pcv_t *pcv       I   antenna phase center parameters
@@ -3621,50 +5063,69 @@ extern void sunmoonpos(gtime_t tutc, const double *erpv, double *rsun,
 *-----------------------------------------------------------------------------*/
 extern void windupcorr(gtime_t time, const double *rs, const double *rr,
                        double *phw)
+{
+    windupcorrs(time,rs,rr,1,phw);
+}
+/* phase windup corrections ----------------------------------------------------
+* phase windup corrections for all satellites of an epoch
+* args   : gtime_t time     I   time (GPST)
+*          double  *rs      I   satellite positions/velocities (6 x n) (m,m/s)
+*          double  *rr      I   receiver  position (ecef) {x,y,z} (m)
+*          int     n        I   number of satellites
+*          double  *phw     IO  phase windup corrections (n) (cycle)
+* return : none
+* notes  : same as windupcorr() for each satellite. the sun position and the
+*          receiver antenna unit vectors are computed once for the epoch.
+*-----------------------------------------------------------------------------*/
+extern void windupcorrs(gtime_t time, const double *rs, const double *rr,
+                        int n, double *phw)
 {
     double ek[3],exs[3],eys[3],ezs[3],ess[3],exr[3],eyr[3],eks[3],ekr[3],E[9];
     double dr[3],ds[3],drs[3],r[3],pos[3],rsun[3],cosp,ph,erpv[5]={0};
-    int i;
+    int i,j;
     
-    trace(4,"windupcorr: time=%s\n",time_str(time,0));
+    trace(4,"windupcorrs: time=%s n=%d\n",time_str(time,0),n);
     
     /* sun position in ecef */
     sunmoonpos(gpst2utc(time),erpv,rsun,NULL,NULL);
     
-    /* unit vector satellite to receiver */
-    for (i=0;i<3;i++) r[i]=rr[i]-rs[i];
-    if (!normv3(r,ek)) return;
-    
-    /* unit vectors of satellite antenna */
-    for (i=0;i<3;i++) r[i]=-rs[i];
-    if (!normv3(r,ezs)) return;
-    for (i=0;i<3;i++) r[i]=rsun[i]-rs[i];
-    if (!normv3(r,ess)) return;
-    cross3(ezs,ess,r);
-    if (!normv3(r,eys)) return;
-    cross3(eys,ezs,exs);
-    
     /* unit vectors of receiver antenna */
     ecef2pos(rr,pos);
     xyz2enu(pos,E);
     exr[0]= E[1]; exr[1]= E[4]; exr[2]= E[7]; /* x = north */
     eyr[0]=-E[0]; eyr[1]=-E[3]; eyr[2]=-E[6]; /* y = west  */
     
-    /* phase windup effect */
-    cross3(ek,eys,eks);
-    cross3(ek,eyr,ekr);
-    for (i=0;i<3;i++) {
-        ds[i]=exs[i]-ek[i]*dot(ek,exs,3)-eks[i];
-        dr[i]=exr[i]-ek[i]*dot(ek,exr,3)+ekr[i];
+    for (j=0;j<n;j++,rs+=6) {
+        
+        /* unit vector satellite to receiver */
+        for (i=0;i<3;i++) r[i]=rr[i]-rs[i];
+        if (!normv3(r,ek)) continue;
+        
+        /* unit vectors of satellite antenna */
+        for (i=0;i<3;i++) r[i]=-rs[i];
+        if (!normv3(r,ezs)) continue;
+        for (i=0;i<3;i++) r[i]=rsun[i]-rs[i];
+        if (!normv3(r,ess)) continue;
+        cross3(ezs,ess,r);
+        if (!normv3(r,eys)) continue;
+        cross3(eys,ezs,exs);
+        
+        /* phase windup effect */
+        cross3(ek,eys,eks);
+        cross3(ek,eyr,ekr);
+        for (i=0;i<3;i++) {
+            ds[i]=exs[i]-ek[i]*dot(ek,exs,3)-eks[i];
+            dr[i]=exr[i]-ek[i]*dot(ek,exr,3)+ekr[i];
+        }
+        cosp=dot(ds,dr,3)/norm(ds,3)/norm(dr,3);
+        if      (cosp<-1.0) cosp=-1.0;
+        else if (cosp> 1.0) cosp= 1.0;
+        ph=acos(cosp)/2.0/PI;
+        cross3(ds,dr,drs);
+        if (dot(ek,drs,3)<0.0) ph=-ph;
+        
+        phw[j]=ph+floor(phw[j]-ph+0.5); /* in cycle */
     }
-    cosp=dot(ds,dr,3)/norm(ds,3)/norm(dr,3);
-    if      (cosp<-1.0) cosp=-1.0;
-    else if (cosp> 1.0) cosp= 1.0;
-    ph=acos(cosp)/2.0/PI;
-    cross3(ds,dr,drs);
-    if (dot(ek,drs,3)<0.0) ph=-ph;
-    
-    *phw=ph+floor(*phw-ph+0.5); /* in cycle */
 }
 /* carrier smoothing -----------------------------------------------------------
 * carrier smoothing by Hatch filter
@@ -3696,17 +5157,390 @@ extern void csmooth(obs_t *obs, int ns)
         }
     }
 }
+/* bit stream input for uncompress (lsb first) -------------------------------*/
+typedef struct {
+    FILE *fp;               /* input file pointer */
+    unsigned long buff;     /* bit buffer */
+    int nbit;               /* number of bits in bit buffer */
+} ucbits_t;
+
+static int ucgetbits(ucbits_t *in, int n, unsigned int *val)
+{
+    int c;
+    
+    while (in->nbit<n) {
+        if ((c=fgetc(in->fp))==EOF) return 0;
+        in->buff|=(unsigned long)c<<in->nbit;
+        in->nbit+=8;
+    }
+    *val=(unsigned int)(in->buff&((1UL<<n)-1));
+    in->buff>>=n;
+    in->nbit-=n;
+    return 1;
+}
+/* uncompress lzw (unix compress) stream -------------------------------------*/
+static int uncomp_lzw(ucbits_t *in, FILE *ofp)
+{
+    unsigned short *prefix;
+    unsigned char *suffix,*stack,*sp;
+    unsigned int flag,code,incode,maxbits,maxmax,maxcode,fent,ncode=0,nskip;
+    unsigned int oldcode=0xFFFFFFFF,finchar=0,dummy;
+    int i,nbits=9,block,stat=1;
+    
+    if (!ucgetbits(in,8,&flag)) return -1;
+    maxbits=flag&0x1F; block=(flag&0x80)!=0;
+    if (maxbits<9||maxbits>16) return -1;
+    maxmax=1U<<maxbits;
+    maxcode=(1U<<nbits)-1;
+    fent=block?257:256;
+    
+    prefix=(unsigned short *)malloc(sizeof(unsigned short)*65536);
+    suffix=(unsigned char *)malloc(65536);
+    stack =(unsigned char *)malloc(65536);
+    if (!prefix||!suffix||!stack) {
+        free(prefix); free(suffix); free(stack);
+        return -1;
+    }
+    for (i=0;i<256;i++) {
+        prefix[i]=0; suffix[i]=(unsigned char)i;
+    }
+    while (stat>0) {
+        
+        /* increase code width (codes are packed in groups of 8 codes) */
+        if (fent>maxcode&&nbits<(int)maxbits) {
+            nskip=(8-ncode%8)%8*nbits;
+            for (;nskip>0;nskip-=nskip<16?nskip:16) {
+                if (!ucgetbits(in,nskip<16?nskip:16,&dummy)) break;
+            }
+            if (nskip>0) break;
+            maxcode=++nbits==(int)maxbits?maxmax:(1U<<nbits)-1;
+            ncode=0;
+        }
+        if (!ucgetbits(in,nbits,&code)) break;
+        ncode++;
+        
+        if (oldcode==0xFFFFFFFF) {
+            if (code>=256) {stat=-1; break;}
+            fputc(finchar=oldcode=code,ofp);
+            continue;
+        }
+        if (code==256&&block) { /* clear table */
+            nskip=(8-ncode%8)%8*nbits;
+            for (;nskip>0;nskip-=nskip<16?nskip:16) {
+                if (!ucgetbits(in,nskip<16?nskip:16,&dummy)) break;
+            }
+            if (nskip>0) break;
+            fent=256;
+            maxcode=(1U<<(nbits=9))-1;
+            ncode=0;
+            continue;
+        }
+        incode=code;
+        sp=stack+65536;
+        if (code>=fent) { /* kwkwk case */
+            if (code>fent) {stat=-1; break;}
+            *--sp=(unsigned char)finchar;
+            code=oldcode;
+        }
+        while (code>=256) {
+            *--sp=suffix[code];
+            code=prefix[code];
+        }
+        *--sp=(unsigned char)(finchar=suffix[code]);
+        fwrite(sp,1,stack+65536-sp,ofp);
+        
+        if (fent<maxmax) {
+            prefix[fent]=(unsigned short)oldcode;
+            suffix[fent++]=(unsigned char)finchar;
+        }
+        oldcode=incode;
+    }
+    free(prefix); free(suffix); free(stack);
+    return stat;
+}
+/* inflate output window -----------------------------------------------------*/
+typedef struct {
+    FILE *fp;               /* output file pointer */
+    unsigned char win[32768]; /* sliding window */
+    unsigned int pos;       /* window position */
+    unsigned long size;     /* output size (bytes) */
+    unsigned long crc;      /* crc-32 of output */
+    unsigned long crctbl[256]; /* crc-32 table */
+} ucwin_t;
+
+static void ucflush(ucwin_t *out)
+{
+    unsigned int i;
+    
+    for (i=0;i<out->pos;i++) {
+        out->crc=out->crctbl[(out->crc^out->win[i])&0xFF]^(out->crc>>8);
+    }
+    fwrite(out->win,1,out->pos,out->fp);
+    out->size+=out->pos;
+    out->pos=0;
+}
+static void ucputc(ucwin_t *out, unsigned char c)
+{
+    out->win[out->pos++]=c;
+    if (out->pos>=sizeof(out->win)) ucflush(out);
+}
+/* huffman code table for inflate --------------------------------------------*/
+typedef struct {
+    short count[16];        /* number of codes of each length */
+    short symbol[288];      /* symbols ordered by code */
+} uchuff_t;
+
+static int uchuff_make(uchuff_t *h, const short *len, int n)
+{
+    short offs[16];
+    int i,left=1;
+    
+    for (i=0;i<16;i++) h->count[i]=0;
+    for (i=0;i<n;i++) h->count[len[i]]++;
+    if (h->count[0]==n) return 0;
+    
+    for (i=1;i<16;i++) {
+        left<<=1;
+        if ((left-=h->count[i])<0) return -1; /* over-subscribed */
+    }
+    for (offs[1]=0,i=1;i<15;i++) offs[i+1]=offs[i]+h->count[i];
+    for (i=0;i<n;i++) {
+        if (len[i]) h->symbol[offs[len[i]]++]=(short)i;
+    }
+    return left;
+}
+static int uchuff_decode(ucbits_t *in, const uchuff_t *h)
+{
+    unsigned int bit;
+    int len,code=0,first=0,index=0,count;
+    
+    for (len=1;len<16;len++) {
+        if (!ucgetbits(in,1,&bit)) return -1;
+        code|=bit;
+        count=h->count[len];
+        if (code-count<first) return h->symbol[index+code-first];
+        index+=count;
+        first=(first+count)<<1;
+        code<<=1;
+    }
+    return -1;
+}
+/* inflate huffman coded block -----------------------------------------------*/
+static int uncomp_codes(ucbits_t *in, ucwin_t *out, const uchuff_t *lcode,
+                        const uchuff_t *dcode)
+{
+    static const short lbase[]={
+        3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,
+        131,163,195,227,258
+    };
+    static const short lext[]={
+        0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0
+    };
+    static const short dbase[]={
+        1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,
+        2049,3073,4097,6145,8193,12289,16385,24577
+    };
+    static const short dext[]={
+        0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13
+    };
+    unsigned int val,len,dist;
+    int sym;
+    
+    while ((sym=uchuff_decode(in,lcode))!=256) {
+        if (sym<0) return 0;
+        if (sym<256) {
+            ucputc(out,(unsigned char)sym);
+            continue;
+        }
+        if ((sym-=257)>=29||!ucgetbits(in,lext[sym],&val)) return 0;
+        len=lbase[sym]+val;
+        if ((sym=uchuff_decode(in,dcode))<0||sym>=30||
+            !ucgetbits(in,dext[sym],&val)) return 0;
+        dist=dbase[sym]+val;
+        if (dist>out->size+out->pos) return 0;
+        
+        for (;len>0;len--) {
+            ucputc(out,out->win[(out->pos-dist)&(sizeof(out->win)-1)]);
+        }
+    }
+    return 1;
+}
+/* inflate deflate stream ----------------------------------------------------*/
+static int uncomp_inflate(ucbits_t *in, ucwin_t *out)
+{
+    static const short order[19]={
+        16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15
+    };
+    uchuff_t lcode,dcode;
+    short len[320];
+    unsigned int last,type,nlen,ndist,ncode,val,nval,rep;
+    int i,sym;
+    
+    do {
+        if (!ucgetbits(in,1,&last)||!ucgetbits(in,2,&type)) return 0;
+        
+        if (type==0) { /* stored block */
+            in->buff>>=in->nbit%8;
+            in->nbit-=in->nbit%8;
+            if (!ucgetbits(in,16,&val)||!ucgetbits(in,16,&nval)||
+                val!=(~nval&0xFFFF)) return 0;
+            for (;val>0;val--) {
+                if (!ucgetbits(in,8,&nval)) return 0;
+                ucputc(out,(unsigned char)nval);
+            }
+            continue;
+        }
+        if (type==1) { /* fixed huffman codes */
+            for (i=0;i<144;i++) len[i]=8;
+            for (;i<256;i++) len[i]=9;
+            for (;i<280;i++) len[i]=7;
+            for (;i<288;i++) len[i]=8;
+            uchuff_make(&lcode,len,288);
+            for (i=0;i<30;i++) len[i]=5;
+            uchuff_make(&dcode,len,30);
+        }
+        else if (type==2) { /* dynamic huffman codes */
+            if (!ucgetbits(in,5,&nlen)||!ucgetbits(in,5,&ndist)||
+                !ucgetbits(in,4,&ncode)) return 0;
+            nlen+=257; ndist+=1; ncode+=4;
+            if (nlen>286||ndist>30) return 0;
+            
+            for (i=0;i<19;i++) {
+                if (i<(int)ncode&&!ucgetbits(in,3,&val)) return 0;
+                len[order[i]]=i<(int)ncode?(short)val:0;
+            }
+            if (uchuff_make(&lcode,len,19)!=0) return 0;
+            
+            for (i=0;i<(int)(nlen+ndist);) {
+                if ((sym=uchuff_decode(in,&lcode))<0) return 0;
+                if (sym<16) {
+                    len[i++]=(short)sym;
+                    continue;
+                }
+                if (sym==16) {
+                    if (i==0||!ucgetbits(in,2,&rep)) return 0;
+                    val=len[i-1]; rep+=3;
+                }
+                else if (sym==17) {
+                    if (!ucgetbits(in,3,&rep)) return 0;
+                    val=0; rep+=3;
+                }
+                else {
+                    if (!ucgetbits(in,7,&rep)) return 0;
+                    val=0; rep+=11;
+                }
+                if (i+rep>nlen+ndist) return 0;
+                for (;rep>0;rep--) len[i++]=(short)val;
+            }
+            if (len[256]==0) return 0;
+            if (uchuff_make(&lcode,len,nlen)<0||
+                uchuff_make(&dcode,len+nlen,ndist)<0) return 0;
+        }
+        else return 0;
+        
+        if (!uncomp_codes(in,out,&lcode,&dcode)) return 0;
+        
+    } while (!last);
+    
+    return 1;
+}
+/* uncompress gzip stream ----------------------------------------------------*/
+static int uncomp_gzip(ucbits_t *in, FILE *ofp)
+{
+    ucwin_t *out;
+    unsigned int i,j,cm,flag,val,crc[4],size[4];
+    int stat=1;
+    
+    if (!(out=(ucwin_t *)malloc(sizeof(ucwin_t)))) return -1;
+    
+    for (i=0;i<256;i++) {
+        for (val=i,j=0;j<8;j++) val=val&1?0xEDB88320^(val>>1):val>>1;
+        out->crctbl[i]=val;
+    }
+    out->fp=ofp;
+    
+    do { /* gzip members */
+        if (!ucgetbits(in,8,&cm)||cm!=8||!ucgetbits(in,8,&flag)) {
+            stat=-1;
+            break;
+        }
+        for (i=0;i<6;i++) ucgetbits(in,8,&val); /* mtime,xfl,os */
+        
+        if (flag&0x04) { /* extra field */
+            ucgetbits(in,16,&j);
+            for (i=0;i<j;i++) ucgetbits(in,8,&val);
+        }
+        if (flag&0x08) { /* file name */
+            while (ucgetbits(in,8,&val)&&val) ;
+        }
+        if (flag&0x10) { /* comment */
+            while (ucgetbits(in,8,&val)&&val) ;
+        }
+        if (flag&0x02) ucgetbits(in,16,&val); /* header crc */
+        
+        out->pos=0; out->size=0; out->crc=0xFFFFFFFF;
+        
+        if (!uncomp_inflate(in,out)) {
+            stat=-1;
+            break;
+        }
+        ucflush(out);
+        in->buff>>=in->nbit%8;
+        in->nbit-=in->nbit%8;
+        
+        for (i=0;i<4;i++) ucgetbits(in,8,crc+i);
+        for (i=0;i<4;i++) if (!ucgetbits(in,8,size+i)) stat=-1;
+        
+        if (stat<0||
+            (out->crc^0xFFFFFFFF)!=(crc[0]|(crc[1]<<8)|(crc[2]<<16)|
+                                   ((unsigned long)crc[3]<<24))||
+            (out->size&0xFFFFFFFF)!=(size[0]|(size[1]<<8)|(size[2]<<16)|
+                                     ((unsigned long)size[3]<<24))) {
+            stat=-1;
+            break;
+        }
+    } while (ucgetbits(in,16,&val)&&val==0x8B1F);
+    
+    free(out);
+    return stat;
+}
+/* uncompress compress/gzip format file in-process ---------------------------*/
+static int uncomp_file(const char *file, const char *uncfile)
+{
+    ucbits_t in={0};
+    FILE *ofp;
+    unsigned int magic;
+    int stat;
+    
+    if (!(in.fp=fopen(file,"rb"))) return -1;
+    
+    if (!ucgetbits(&in,16,&magic)||(magic!=0x9D1F&&magic!=0x8B1F)) {
+        fclose(in.fp);
+        return 0; /* other formats */
+    }
+    if (!(ofp=fopen(uncfile,"wb"))) {
+        fclose(in.fp);
+        return -1;
+    }
+    stat=magic==0x9D1F?uncomp_lzw(&in,ofp):uncomp_gzip(&in,ofp);
+    
+    fclose(in.fp);
+    if (fclose(ofp)) stat=-1;
+    return stat;
+}
 /* uncompress file -------------------------------------------------------------
 * uncompress (uncompress/unzip/uncompact hatanaka-compression/tar) file
 * args   : char   *file     I   input file
 *          char   *uncfile  O   uncompressed file
 * return : status (-1:error,0:not compressed file,1:uncompress completed)
 * note   : creates uncompressed file in tempolary directory
-*          gzip and crx2rnx commands have to be installed in commands path
+*          compress (.Z) and gzip (.gz) format files are uncompressed in-process
+*          gzip and crx2rnx commands have to be installed in commands path for
+*          other formats
 *-----------------------------------------------------------------------------*/
 extern int uncompress(const char *file, char *uncfile)
 {
-    int stat=0;
+    int stat=0,ret;
     char *p,cmd[2048]="",tmpfile[1024]="",buff[1024],*fname,*dir="";
     
     trace(3,"uncompress: file=%s\n",file);
@@ -3714,15 +5548,18 @@ extern int uncompress(const char *file, char *uncfile)
     strcpy(tmpfile,file);
     if (!(p=strrchr(tmpfile,'.'))) return 0;
     
-    /* uncompress by gzip */
+    /* uncompress in-process or by gzip */
     if (!strcmp(p,".z"  )||!strcmp(p,".Z"  )||
         !strcmp(p,".gz" )||!strcmp(p,".GZ" )||
         !strcmp(p,".zip")||!strcmp(p,".ZIP")) {
         
         strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
-        sprintf(cmd,"gzip -f -d -c \"%s\" > \"%s\"",tmpfile,uncfile);
         
-        if (execcmd(cmd)) {
+        if (!(ret=uncomp_file(tmpfile,uncfile))) {
+            sprintf(cmd,"gzip -f -d -c \"%s\" > \"%s\"",tmpfile,uncfile);
+            ret=execcmd(cmd)?-1:1;
+        }
+        if (ret<0) {
             remove(uncfile);
             return -1;
         }
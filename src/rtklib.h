@@ -219,13 +219,16 @@ extern "C" {
 #define MAXSTRPATH  1024                /* max length of stream path */
 #define MAXSTRMSG   1024                /* max length of stream message */
 #define MAXSTRRTK   8                   /* max number of stream in RTK server */
-#define MAXSBSMSG   32                  /* max number of SBAS msg in RTK server */
+#define MAXSBSMSG   32                  /* default depth of SBAS msg buffer in RTK server */
 #define MAXSOLMSG   4096                /* max length of solution message */
+#define MAXPRFMSG   (NPRF*512)          /* max length of profile message */
 #define MAXRAWLEN   4096                /* max length of receiver raw message */
+#define MAXMSMENT   (64*(NFREQ+NEXOBS)) /* max number of signal entries in MSM layout */
 #define MAXERRMSG   4096                /* max length of error/warning message */
 #define MAXANT      64                  /* max length of station name/antenna type */
 #define MAXSOLBUF   256                 /* max number of solution buffer */
 #define MAXOBSBUF   128                 /* max number of observation data buffer */
+#define MAXOBSALN   32                  /* max number of obs buffer for time-alignment */
 #define MAXNRPOS    16                  /* max number of reference positions */
 #define MAXLEAPS    64                  /* max number of leap seconds table */
 
@@ -312,6 +315,7 @@ extern "C" {
 #define SOLF_ENU    2                   /* solution format: e/n/u-baseline */
 #define SOLF_NMEA   3                   /* solution format: NMEA-183 */
 #define SOLF_GSIF   4                   /* solution format: GSI-F1/2/3 */
+#define SOLF_BIN    5                   /* solution format: binary record */
 
 #define SOLQ_NONE   0                   /* solution status: no solution */
 #define SOLQ_FIX    1                   /* solution status: fix */
@@ -376,6 +380,7 @@ extern "C" {
 #define STR_NTRIPCLI 7                  /* stream type: NTRIP client */
 #define STR_FTP      8                  /* stream type: ftp */
 #define STR_HTTP     9                  /* stream type: http */
+#define STR_NTRIPC   10                 /* stream type: NTRIP caster */
 
 #define STRFMT_RTCM2 0                  /* stream format: RTCM 2 */
 #define STRFMT_RTCM3 1                  /* stream format: RTCM 3 */
@@ -422,6 +427,22 @@ extern "C" {
 #define DLOPT_HOLDERR 0x04              /* download option: hold on error file */
 #define DLOPT_HOLDLST 0x08              /* download option: hold on listing file */
 
+#define PRF_RTKPOS  0                   /* profile stage: rtkpos() */
+#define PRF_PNTPOS  1                   /* profile stage: pntpos() */
+#define PRF_RELPOS  2                   /* profile stage: relative positioning */
+#define PRF_PPPOS   3                   /* profile stage: pppos() */
+#define PRF_SATPOS  4                   /* profile stage: satposs() */
+#define PRF_ZDRES   5                   /* profile stage: undifferenced residuals */
+#define PRF_DDRES   6                   /* profile stage: double-differenced residuals */
+#define PRF_FILTER  7                   /* profile stage: kalman filter update */
+#define PRF_LAMBDA  8                   /* profile stage: lambda() */
+#define PRF_DECODE  9                   /* profile stage: decode input (+0:rov,+1:base,+2:corr) */
+#define PRF_UPDATE  12                  /* profile stage: update rtk server by input */
+#define PRF_OUTPUT  13                  /* profile stage: format solution output */
+#define PRF_CYCLE   14                  /* profile stage: rtk server cycle */
+#define NPRF        15                  /* number of profile stages */
+#define NPRFBIN     32                  /* number of profile histogram bins */
+
 #define P2_5        0.03125             /* 2^-5 */
 #define P2_6        0.015625            /* 2^-6 */
 #define P2_11       4.882812500000000E-04 /* 2^-11 */
@@ -453,6 +474,10 @@ extern "C" {
 #define initlock(f) InitializeCriticalSection(f)
 #define lock(f)     EnterCriticalSection(f)
 #define unlock(f)   LeaveCriticalSection(f)
+#define cond_t      CONDITION_VARIABLE
+#define initcond(f) InitializeConditionVariable(f)
+#define condwait(f,l) SleepConditionVariableCS(f,l,INFINITE)
+#define condbroadcast(f) WakeAllConditionVariable(f)
 #define FILEPATHSEP '\\'
 #else
 #define thread_t    pthread_t
@@ -460,6 +485,10 @@ extern "C" {
 #define initlock(f) pthread_mutex_init(f,NULL)
 #define lock(f)     pthread_mutex_lock(f)
 #define unlock(f)   pthread_mutex_unlock(f)
+#define cond_t      pthread_cond_t
+#define initcond(f) pthread_cond_init(f,NULL)
+#define condwait(f,l) pthread_cond_wait(f,l)
+#define condbroadcast(f) pthread_cond_broadcast(f)
 #define FILEPATHSEP '/'
 #endif
 
@@ -470,6 +499,11 @@ typedef struct {        /* time struct */
     double sec;         /* fraction of second under 1 s */
 } gtime_t;
 
+typedef struct {        /* time struct by integer nanoseconds */
+    time_t time;        /* time (s) expressed by standard time_t */
+    long nsec;          /* fraction of second (ns) (0-999999999) */
+} gtimens_t;
+
 typedef struct {        /* observation data record */
     gtime_t time;       /* receiver sampling time (GPST) */
     unsigned char sat,rcv; /* satellite/receiver number */
@@ -481,9 +515,16 @@ typedef struct {        /* observation data record */
     float  D[NFREQ+NEXOBS]; /* observation data doppler frequency (Hz) */
 } obsd_t;
 
+typedef struct {        /* observation data epoch index type */
+    int rcv;            /* receiver number */
+    int i,n;            /* index/number of observation data records */
+} obsidx_t;
+
 typedef struct {        /* observation data */
     int n,nmax;         /* number of obervation data/allocated */
     obsd_t *data;       /* observation data records */
+    int ne,nemax;       /* number of epoch index/allocated */
+    obsidx_t *idx;      /* epoch index by epoch and receiver */
 } obs_t;
 
 typedef struct {        /* earth rotation parameter data type */
@@ -616,6 +657,8 @@ typedef struct {        /* norad two line element data type */
 typedef struct {        /* norad two line element type */
     int n,nmax;         /* number/max number of two line element data */
     tled_t *data;       /* norad two line element data */
+    int nhash;          /* size of catalog index hash table */
+    int *hash;          /* catalog index hash table (satno,desig) */
 } tle_t;
 
 typedef struct {        /* TEC grid type */
@@ -885,6 +928,26 @@ typedef struct {        /* solution status buffer type */
     solstat_t *data;    /* solution status data */
 } solstatbuf_t;
 
+typedef struct {        /* solution time index type */
+    FILE *fp;           /* time index file pointer */
+    gtime_t time;       /* time of last index record */
+} soltix_t;
+
+typedef struct {        /* RTCM 3 MSM encoder layout type */
+    gtime_t time;       /* epoch time of layout */
+    unsigned int key;   /* signature of observation satellites and codes */
+    int n;              /* number of observation data */
+    int nsat,nsig,ncell; /* number of satellites, signals and cells */
+    int nent;           /* number of signal entries */
+    unsigned char sat_ind[64]; /* satellite index (0:no satellite) */
+    unsigned char sig_ind[32]; /* signal index (0:no signal) */
+    unsigned char cell_ind[64]; /* cell mask */
+    unsigned char obs[MAXMSMENT]; /* observation data index of signal entry */
+    unsigned char slot[MAXMSMENT]; /* frequency slot of signal entry */
+    unsigned char freq[MAXMSMENT]; /* frequency index (1:L1,2:L2,...) */
+    unsigned char cell[MAXMSMENT]; /* cell index of signal entry */
+} msmlay_t;
+
 typedef struct {        /* RTCM control struct type */
     int staid;          /* station id */
     int stah;           /* station health */
@@ -906,6 +969,7 @@ typedef struct {        /* RTCM control struct type */
     unsigned char lock[MAXSAT][NFREQ+NEXOBS]; /* lock time */
     unsigned char loss[MAXSAT][NFREQ+NEXOBS]; /* loss of lock count */
     gtime_t lltime[MAXSAT][NFREQ+NEXOBS]; /* last lock time */
+    msmlay_t msmlay[6]; /* msm encoder layouts (gps,glo,gal,qzs,sbs,cmp) */
     int nbyte;          /* number of bytes in message buffer */ 
     int nbit;           /* number of bits in word buffer */ 
     int len;            /* message length (bytes) */
@@ -977,7 +1041,7 @@ typedef struct {        /* processing options type */
     int tidecorr;       /* earth tide correction (0:off,1:solid,2:solid+otl+pole) */
     int niter;          /* number of filter iteration */
     int codesmooth;     /* code smoothing window size (0:none) */
-    int intpref;        /* interpolate reference obs (for post mission) */
+    int intpref;        /* interpolate reference obs */
     int sbascorr;       /* SBAS correction options */
     int sbassatsel;     /* SBAS satellite selection (0:all) */
     int rovpos;         /* rover position for fixed mode */
@@ -1009,6 +1073,8 @@ typedef struct {        /* processing options type */
     char rnxopt[2][256]; /* rinex options {rover,base} */
     int  posopt[6];     /* positioning options */
     int  syncsol;       /* solution sync mode (0:off,1:on) */
+    int  obsstream;     /* streaming input of obs data (0:off,1:on) */
+    int  warmstart;     /* warm-start from checkpoint (0:off,1:on) */
     double odisp[2][6*11]; /* ocean tide loading parameters {rov,base} */
     exterr_t exterr;    /* extended receiver error model */
 } prcopt_t;
@@ -1029,8 +1095,10 @@ typedef struct {        /* solution options type */
     int trace;          /* debug trace level (0:off,1-5:debug) */
     double nmeaintv[2]; /* nmea output interval (s) (<0:no,0:all) */
                         /* nmeaintv[0]:gprmc,gpgga,nmeaintv[1]:gpgsv */
+                        /* (binary: nmeaintv[1]:satellite block) */
     char sep[64];       /* field separator */
     char prog[64];      /* program name */
+    int outtix;         /* output time index file (0:no,1:yes) */
 } solopt_t;
 
 typedef struct {        /* file options type */
@@ -1046,6 +1114,7 @@ typedef struct {        /* file options type */
     char geexe  [MAXSTRPATH]; /* google earth exec file */
     char solstat[MAXSTRPATH]; /* solution statistics file */
     char trace  [MAXSTRPATH]; /* debug trace file */
+    char ckpt   [MAXSTRPATH]; /* checkpoint file of rtk filter state */
 } filopt_t;
 
 typedef struct {        /* RINEX options type */
@@ -1113,6 +1182,13 @@ typedef struct {        /* ambiguity control type */
     double LCv[4];      /* linear combination variance */
 } ambc_t;
 
+typedef struct {        /* stage timing profile type */
+    unsigned int n;     /* number of samples */
+    double sum;         /* sum of time (s) */
+    double max;         /* max of time (s) */
+    unsigned int hist[NPRFBIN]; /* histogram (bin i:time<2^i us) */
+} prfstat_t;
+
 typedef struct {        /* RTK control/result type */
     sol_t  sol;         /* RTK solution */
     double rb[6];       /* base position/velocity (ecef) (m|m/s) */
@@ -1126,6 +1202,10 @@ typedef struct {        /* RTK control/result type */
     int neb;            /* bytes in error message buffer */
     char errbuf[MAXERRMSG]; /* error message buffer */
     prcopt_t opt;       /* processing options */
+    int nobsb[2];       /* number of base obs data {previous,current} */
+    obsd_t *obsb;       /* base obs data {previous,current} (time-interpolation) */
+    prfstat_t prf[NPRF]; /* stage timing profile (PRF_???) */
+    int rov;            /* rover number of rtk server (0:main rover) */
 } rtk_t;
 
 typedef struct {        /* receiver raw data control type */
@@ -1177,6 +1257,27 @@ typedef struct {        /* stream type */
     char msg [MAXSTRMSG];  /* stream message */
 } stream_t;
 
+typedef struct {        /* stream event type */
+    int n,nmax;         /* number/max number of streams */
+    stream_t **stream;  /* streams */
+    int *ready;         /* ready flags of streams (0:no,1:ready to read) */
+    int *nfd;           /* number of descriptors of streams */
+    int *fd;            /* descriptors of streams */
+    unsigned int *gen;  /* generations of descriptors */
+    int efd;            /* epoll descriptor (-1:not used) */
+} strevt_t;
+
+typedef struct {        /* ntrip caster mountpoint status type */
+    char mntpnt[256];   /* mountpoint */
+    int ncli;           /* number of connected clients */
+    int nacc;           /* number of accepted clients */
+    int nevict;         /* number of evicted slow clients */
+    int nbuff;          /* number of shared data chunks */
+    int maxlag;         /* max send lag of clients (bytes) */
+    double inb,outb;    /* input/output bytes */
+    int inr,outr;       /* input/output rate (bps) */
+} strcasstat_t;
+
 typedef struct {        /* stream converter type */
     int itype,otype;    /* input and output stream type */
     int nmsg;           /* number of output messages */
@@ -1188,6 +1289,9 @@ typedef struct {        /* stream converter type */
     rtcm_t rtcm;        /* rtcm input data buffer */
     raw_t raw;          /* raw  input data buffer */
     rtcm_t out;         /* rtcm output data buffer */
+    int nref;           /* number of converters sharing output messages */
+    int nfbuf,fbufsize; /* length and size of shared message buffer (bytes) */
+    unsigned char *fbuf; /* shared message buffer */
 } strconv_t;
 
 typedef struct {        /* stream server type */
@@ -1203,10 +1307,48 @@ typedef struct {        /* stream server type */
     unsigned int tick;  /* start tick */
     stream_t stream[16]; /* input/output streams */
     strconv_t *conv[16]; /* stream converter */
+    int share[16];      /* converter index sharing output messages (-1:no) */
     thread_t thread;    /* server thread */
     lock_t lock;        /* lock flag */
 } strsvr_t;
 
+typedef struct {        /* single-producer single-consumer queue type */
+    int size;           /* number of queue slots (power of 2) */
+    int elem;           /* size of queue element (bytes) */
+    volatile unsigned int wp; /* write count (updated by producer) */
+    volatile unsigned int rp; /* read count (updated by consumer) */
+    unsigned char *buff; /* queue element buffer */
+    unsigned int nover; /* number of queue overflows */
+    unsigned int maxn;  /* max queue depth */
+    unsigned int nlat;  /* number of latency samples */
+    double lat;         /* sum of latency (ms) */
+    int latmax;         /* max latency (ms) */
+} rtkque_t;
+
+typedef struct {        /* rover of RTK server type */
+    int state;          /* rover state (0:off,1:running) */
+    char name[32];      /* rover name */
+    int format;         /* input format (STRFMT_???) */
+    int strs[3];        /* stream types {input,solution,log} */
+    char paths[3][MAXSTRPATH]; /* stream paths {input,solution,log} */
+    char *cmd;          /* input stream start command (NULL: no command) */
+    char rcvopt[256];   /* receiver option */
+    prcopt_t prcopt;    /* processing options */
+    solopt_t solopt;    /* solution options */
+    rtk_t rtk;          /* RTK control/result struct */
+    int nb;             /* bytes in input buffer */
+    unsigned char *buff; /* input buffer */
+    raw_t  raw;         /* receiver raw control */
+    rtcm_t rtcm;        /* RTCM control */
+    obs_t obs[MAXOBSBUF]; /* observation data */
+    stream_t stream[3]; /* streams {input,solution,log} */
+    unsigned int nmsg[10]; /* input message counts */
+    unsigned int nsol;  /* number of solutions */
+    int cputime;        /* CPU time (ms) for a processing cycle */
+    int prcout;         /* missing observation data count */
+    lock_t lock;        /* lock flag */
+} rtkrov_t;
+
 typedef struct {        /* RTK server type */
     int state;          /* server state (0:stop,1:running) */
     int cycle;          /* processing cycle (ms) */
@@ -1217,7 +1359,7 @@ typedef struct {        /* RTK server type */
     int format[3];      /* input format {rov,base,corr} */
     solopt_t solopt[2]; /* output solution options {sol1,sol2} */
     int navsel;         /* ephemeris select (0:all,1:rover,2:base,3:corr) */
-    int nsbs;           /* number of sbas message */
+    int nsbs;           /* number of sbas messages in buffer */
     int nsol;           /* number of solution buffer */
     rtk_t rtk;          /* RTK control/result struct */
     int nb [3];         /* bytes in input buffers {rov,base} */
@@ -1234,7 +1376,7 @@ typedef struct {        /* RTK server type */
     char files[3][MAXSTRPATH]; /* download paths {rov,base,corr} */
     obs_t obs[3][MAXOBSBUF]; /* observation data {rov,base,corr} */
     nav_t nav;          /* navigation data */
-    sbsmsg_t sbsmsg[MAXSBSMSG]; /* SBAS message buffer */
+    sbsmsg_t *sbsmsg;   /* SBAS message ring buffer */
     stream_t stream[8]; /* streams {rov,base,corr,sol1,sol2,logr,logb,logc} */
     stream_t *moni;     /* monitor stream */
     unsigned int tick;  /* start tick */
@@ -1242,6 +1384,39 @@ typedef struct {        /* RTK server type */
     int cputime;        /* CPU time (ms) for a processing cycle */
     int prcout;         /* missing observation data count */
     lock_t lock;        /* lock flag */
+    int nrov,nrovmax;   /* number/max number of rovers (multi-rover) */
+    int nworker;        /* number of worker threads for rovers */
+    rtkrov_t **rov;     /* rovers sharing base/correction (multi-rover) */
+    thread_t *worker;   /* worker threads for rovers */
+    int wstate;         /* worker state (0:stop,1:running) */
+    int wgen;           /* worker job generation */
+    int wnext;          /* next rover index for workers */
+    int wdone;          /* number of processed rovers */
+    lock_t wlock;       /* worker lock flag */
+    cond_t wcond;       /* worker condition of job start/end */
+    thread_t dthread[3]; /* decoder threads {rov,base,corr} */
+    thread_t othread;   /* output thread */
+    rtkque_t que[4];    /* event queues {rov,base,corr,output} */
+    lock_t qlock;       /* queue lock flag */
+    cond_t qcond[2];    /* queue condition {positioning,output} */
+    int basewait;       /* wait time for time-matched base obs (ms) (0:no wait) */
+    int nbobs,ibobs;    /* number/next index of base obs buffer */
+    int nrobs,irobs;    /* number/first index of rover obs waiting base obs */
+    obs_t bobs[MAXOBSALN]; /* base obs buffer for time-alignment */
+    obs_t robs[MAXOBSALN]; /* rover obs waiting base obs */
+    unsigned int rtick[MAXOBSALN]; /* ticks of rover obs waiting base obs */
+    unsigned char rwait[MAXOBSALN]; /* flags of rover obs waited base obs */
+    unsigned int nalign[3]; /* rover epochs {time-matched,waited,not matched} */
+    unsigned int fcnver; /* version of glonass fcn table (nav.glo_fcn) */
+    unsigned int fcnvers[3]; /* fcn table versions applied by decoders */
+    int nsbsmax;        /* depth of SBAS message buffer (0:MAXSBSMSG) */
+    int sbssize;        /* allocated depth of SBAS message buffer */
+    unsigned int sbsw;  /* number of SBAS messages written to buffer */
+    unsigned int sbsidx[NSATSBS][64]; /* latest SBAS message {prn,type} (no+1) */
+    prfstat_t prf[NPRF]; /* stage timing profile of server (PRF_???) */
+    int prfcycle;       /* profile output cycle to monitor (ms) (0:no output) */
+    char ckptfile[MAXSTRPATH]; /* checkpoint file of rtk filter state */
+    int ckptcycle;      /* checkpoint autosave cycle (ms) (0:no autosave) */
 } rtksvr_t;
 
 /* global variables ----------------------------------------------------------*/
@@ -1307,6 +1482,12 @@ extern char    *time_str(gtime_t t, int n);
 
 extern gtime_t timeadd  (gtime_t t, double sec);
 extern double  timediff (gtime_t t1, gtime_t t2);
+extern gtimens_t time2timens(gtime_t t);
+extern gtime_t timens2time(gtimens_t t);
+extern gtimens_t timeaddns(gtimens_t t, double sec);
+extern double  timediffns(gtimens_t t1, gtimens_t t2);
+extern gtimens_t gpst2timens(int week, double sec);
+extern double  timens2gpst(gtimens_t t, int *week);
 extern gtime_t gpst2utc (gtime_t t);
 extern gtime_t utc2gpst (gtime_t t);
 extern gtime_t gpst2bdt (gtime_t t);
@@ -1321,6 +1502,13 @@ extern int adjgpsweek(int week);
 extern unsigned int tickget(void);
 extern void sleepms(int ms);
 
+extern void   prfenable(int ena);
+extern double prftick  (void);
+extern void   prfadd   (prfstat_t *prf, double tick);
+extern void   prfsum   (prfstat_t *prf, const prfstat_t *src, int n);
+extern double prfpct   (const prfstat_t *prf, double p);
+extern int    prfouts  (unsigned char *buff, const prfstat_t *prf, int opt);
+
 extern int reppath(const char *path, char *rpath, gtime_t time, const char *rov,
                    const char *base);
 extern int reppaths(const char *path, char *rpaths[], int nmax, gtime_t ts,
@@ -1341,6 +1529,8 @@ extern double dms2deg(const double *dms);
 /* input and output functions ------------------------------------------------*/
 extern void readpos(const char *file, const char *rcv, double *pos);
 extern int  sortobs(obs_t *obs);
+extern int  indexobs(obs_t *obs);
+extern int  seekobs(const obs_t *obs, gtime_t time, int rcv);
 extern void uniqnav(nav_t *nav);
 extern int  screent(gtime_t time, gtime_t ts, gtime_t te, double tint);
 extern int  readnav(const char *file, nav_t *nav);
@@ -1365,6 +1555,8 @@ extern void tracehnav(int level, const nav_t *nav);
 extern void tracepeph(int level, const nav_t *nav);
 extern void tracepclk(int level, const nav_t *nav);
 extern void traceb   (int level, const unsigned char *p, int n);
+extern void tracebuf (int size);
+extern int  tracedec (const char *file, FILE *fp, int level);
 
 /* platform dependent functions ----------------------------------------------*/
 extern int execcmd(const char *cmd);
@@ -1375,6 +1567,10 @@ extern void createdir(const char *path);
 extern double satwavelen(int sat, int frq, const nav_t *nav);
 extern double satazel(const double *pos, const double *e, double *azel);
 extern double geodist(const double *rs, const double *rr, double *e);
+extern void geodists(const double *rs, const double *rr, int n, double *r,
+                     double *e);
+extern void satazels(const double *pos, const double *e, const double *r,
+                     int n, double *azel);
 extern void dops(int ns, const double *azel, double elmin, double *dop);
 extern void csmooth(obs_t *obs, int ns);
 
@@ -1388,8 +1584,13 @@ extern double tropmodel(gtime_t time, const double *pos, const double *azel,
                         double humi);
 extern double tropmapf(gtime_t time, const double *pos, const double *azel,
                        double *mapfw);
+extern void tropmapfs(gtime_t time, const double *pos, const double *azel,
+                      int n, double *mapfh, double *mapfw);
 extern int iontec(gtime_t time, const nav_t *nav, const double *pos,
                   const double *azel, int opt, double *delay, double *var);
+extern int iontecs(gtime_t time, const nav_t *nav, const double *pos,
+                   const double *azel, int n, int opt, double *delay,
+                   double *var, int *stat);
 extern void readtec(const char *file, nav_t *nav, int opt);
 extern int ionocorr(gtime_t time, const nav_t *nav, int sat, const double *pos,
                     const double *azel, int ionoopt, double *ion, double *var);
@@ -1411,6 +1612,8 @@ extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs);
 extern void antmodel(const pcv_t *pcv, const double *del, const double *azel,
                      int opt, double *dant);
+extern void antmodels(const pcv_t *pcv, const double *del, const double *azel,
+                      int n, int opt, double *dant);
 extern void antmodel_s(const pcv_t *pcv, double nadir, double *dant);
 
 /* earth tide models ---------------------------------------------------------*/
@@ -1422,6 +1625,7 @@ extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
 /* geiod models --------------------------------------------------------------*/
 extern int opengeoid(int model, const char *file);
 extern void closegeoid(void);
+extern void geoidinterp(int opt);
 extern double geoidh(const double *pos);
 
 /* datum transformation ------------------------------------------------------*/
@@ -1436,6 +1640,7 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
                     double tint, const char *opt, obs_t *obs, nav_t *nav,
                     sta_t *sta);
 extern int readrnxc(const char *file, nav_t *nav);
+extern int readrnxcs(char **files, int n, nav_t *nav);
 extern int outrnxobsh(FILE *fp, const rnxopt_t *opt, const nav_t *nav);
 extern int outrnxobsb(FILE *fp, const rnxopt_t *opt, const obsd_t *obs, int n,
                       int epflag);
@@ -1475,15 +1680,22 @@ extern int  satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
 extern void satposs(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                     int sateph, double *rs, double *dts, double *var, int *svh);
 extern void readsp3(const char *file, nav_t *nav, int opt);
+extern void readsp3s(char **files, int n, nav_t *nav, int opt);
 extern int  readsap(const char *file, gtime_t time, nav_t *nav);
 extern int  readdcb(const char *file, nav_t *nav);
 extern void alm2pos(gtime_t time, const alm_t *alm, double *rs, double *dts);
 
 extern int tle_read(const char *file, tle_t *tle);
 extern int tle_name_read(const char *file, tle_t *tle);
+extern void tle_free(tle_t *tle);
+extern int tle_search(const char *name, const char *satno, const char *desig,
+                      const tle_t *tle);
 extern int tle_pos(gtime_t time, const char *name, const char *satno,
                    const char *desig, const tle_t *tle, const erp_t *erp,
                    double *rs);
+extern int tle_poss(const gtime_t *time, int nt, const int *index, int n,
+                    const tle_t *tle, const erp_t *erp, int nthread,
+                    double *rs);
 
 /* receiver raw data functions -----------------------------------------------*/
 extern unsigned int getbitu(const unsigned char *buff, int pos, int len);
@@ -1567,12 +1779,18 @@ extern int outsols  (unsigned char *buff, const sol_t *sol, const double *rb,
                      const solopt_t *opt);
 extern int outsolexs(unsigned char *buff, const sol_t *sol, const ssat_t *ssat,
                      const solopt_t *opt);
+extern int outsolbins(unsigned char *buff, const sol_t *sol, const double *rb);
+extern int outsolbinexs(unsigned char *buff, const sol_t *sol,
+                        const ssat_t *ssat);
 extern void outprcopt(FILE *fp, const prcopt_t *opt);
 extern void outsolhead(FILE *fp, const solopt_t *opt);
 extern void outsol  (FILE *fp, const sol_t *sol, const double *rb,
                      const solopt_t *opt);
 extern void outsolex(FILE *fp, const sol_t *sol, const ssat_t *ssat,
                      const solopt_t *opt);
+extern int  opensoltix (soltix_t *tix, const char *file, int append);
+extern void closesoltix(soltix_t *tix);
+extern void outsoltix  (soltix_t *tix, gtime_t time, FILE *fp);
 extern int outnmea_rmc(unsigned char *buff, const sol_t *sol);
 extern int outnmea_gga(unsigned char *buff, const sol_t *sol);
 extern int outnmea_gsa(unsigned char *buff, const sol_t *sol,
@@ -1627,6 +1845,11 @@ extern int  strstat  (stream_t *stream, char *msg);
 extern void strsum   (stream_t *stream, int *inb, int *inr, int *outb, int *outr);
 extern void strsetopt(const int *opt);
 extern gtime_t strgettime(stream_t *stream);
+extern int  strevtinit(strevt_t *evt, int nmax);
+extern void strevtfree(strevt_t *evt);
+extern int  strevtadd (strevt_t *evt, stream_t *stream);
+extern int  strevtwait(strevt_t *evt, int msec);
+extern int  strcasstat(stream_t *stream, strcasstat_t *stat);
 extern void strsendnmea(stream_t *stream, const double *pos);
 extern void strsendcmd(stream_t *stream, const char *cmd);
 extern void strsettimeout(stream_t *stream, int toinact, int tirecon);
@@ -1647,7 +1870,10 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt);
 extern void rtkfree(rtk_t *rtk);
 extern int  rtkpos (rtk_t *rtk, const obsd_t *obs, int nobs, const nav_t *nav);
 extern int  rtkopenstat(const char *file, int level);
+extern int  rtkopenstatt(const char *file, int level, int tix);
 extern void rtkclosestat(void);
+extern int  rtksave(const rtk_t *rtk, const char *file);
+extern int  rtkload(rtk_t *rtk, const char *file, gtime_t time);
 
 /* precise point positioning -------------------------------------------------*/
 extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav);
@@ -1657,6 +1883,8 @@ extern int pppnx(const prcopt_t *opt);
 extern void pppoutsolstat(rtk_t *rtk, int level, FILE *fp);
 extern void windupcorr(gtime_t time, const double *rs, const double *rr,
                        double *phw);
+extern void windupcorrs(gtime_t time, const double *rs, const double *rr,
+                        int n, double *phw);
 
 /* post-processing positioning -----------------------------------------------*/
 extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
@@ -1692,6 +1920,14 @@ extern void rtksvrunlock(rtksvr_t *svr);
 extern int  rtksvrostat (rtksvr_t *svr, int type, gtime_t *time, int *sat,
                          double *az, double *el, int **snr, int *vsat);
 extern void rtksvrsstat (rtksvr_t *svr, int *sstat, char *msg);
+extern int  rtksvrsbsmsg(rtksvr_t *svr, sbsmsg_t *msgs, int nmax);
+extern int  rtksvrsbslast(rtksvr_t *svr, int prn, int type, sbsmsg_t *msg);
+extern void rtksvrprf   (rtksvr_t *svr, prfstat_t *prf, int reset);
+extern int  rtksvraddrov(rtksvr_t *svr, const char *name, const int *strs,
+                         char **paths, int format, const char *rcvopt,
+                         const char *cmd, const prcopt_t *prcopt,
+                         const solopt_t *solopt);
+extern void rtksvrfreerov(rtksvr_t *svr);
 
 /* downloader functions ------------------------------------------------------*/
 extern int dl_readurls(const char *file, char **types, int ntype, url_t *urls,
@@ -1701,6 +1937,7 @@ extern int dl_exec(gtime_t ts, gtime_t te, double ti, int seqnos, int seqnoe,
                    const url_t *urls, int nurl, char **stas, int nsta,
                    const char *dir, const char *usr, const char *pwd,
                    const char *proxy, int opts, char *msg, FILE *fp);
+extern void dl_setthread(int nthread);
 extern void dl_test(gtime_t ts, gtime_t te, double ti, const url_t *urls,
                     int nurl, char **stas, int nsta, const char *dir,
                     int ncol, int datefmt, FILE *fp);
@@ -34,6 +34,15 @@
 *           2014/10/21 1.16 fix bug on beidou amb-res with pos2-bdsarmode=0
 *           2014/11/08 1.17 fix bug on ar-degradation by unhealthy satellites
 *           2015/03/23 1.18 residuals referenced to reference satellite
+*           2026/10/18 1.19 use batched satellite geometry in zdres()
+*           2026/10/18 1.20 lock solution status output shared by rtk server rovers
+*           2026/10/18 1.21 keep base epochs for time-interpolation in rtk_t by intpres()
+*                           interpolate by previous distinct base epoch for real-time
+*           2026/10/18 1.22 add api rtkopenstatt() to output time index of status
+*           2026/10/18 1.23 add stage timing profile in rtk_t
+*           2026/10/18 1.24 add api rtksave(),rtkload() for checkpoint of filter state
+*           2026/10/18 1.25 add rover number in rtk_t and $ROV status record
+*                           initialize status file lock once
 *-----------------------------------------------------------------------------*/
 #include <stdarg.h>
 #include "rtklib.h"
@@ -63,6 +72,10 @@ static const char rcsid[]="$Id:$";
 #define TTOL_MOVEB  (1.0+2*DTTOL)
                              /* time sync tolerance for moving-baseline (s) */
 
+#define CKPT_ID     "RTKCKPT" /* checkpoint id */
+#define CKPT_VER    1        /* checkpoint format version */
+#define MAXCKPTAGE  300.0    /* max age of checkpoint to restore (s) */
+
 /* number of parameters (pos,ionos,tropos,hw-bias,phase-bias,real,estimated) */
 #define NF(opt)     ((opt)->ionoopt==IONOOPT_IFLC?1:(opt)->nf)
 #define NP(opt)     ((opt)->dynamics==0?3:9)
@@ -102,16 +115,29 @@ static int statlevel=0;          /* rtk status output level (0:off) */
 static FILE *fp_stat=NULL;       /* rtk status file pointer */
 static char file_stat[1024]="";  /* rtk status file original path */
 static gtime_t time_stat={0};    /* rtk status file time */
+static lock_t lock_stat;         /* rtk status file lock */
+static int initstat=0;           /* rtk status file lock initialized */
+static int stattix=0;            /* rtk status time index (0:off,1:on) */
+static soltix_t tix_stat={0};    /* rtk status time index */
 
 /* open solution status file ---------------------------------------------------
 * open solution status file and set output level
 * args   : char     *file   I   rtk status file
 *          int      level   I   rtk status level (0: off)
+*          int      tix     I   output time index file (0:off,1:on)
 * return : status (1:ok,0:error)
 * notes  : file can constain time keywords (%Y,%y,%m...) defined in reppath().
 *          The time to replace keywords is based on UTC of CPU time.
+*          rtkopenstatt() with tix=1 also outputs time index file (<file>.tix)
+*          of $POS records (see opensoltix()).
+*          the status file is shared by the rovers of rtk server. the records
+*          of rover with rtk->rov>0 are preceded by $ROV record.
 * output : solution status file record format
 *
+*   $ROV,week,tow,rov
+*          week/tow : gps week no/time of week (s)
+*          rov      : rover number of rtk server (1,2,...)
+*
 *   $POS,week,tow,stat,posx,posy,posz,posxf,posyf,poszf
 *          week/tow : gps week no/time of week (s)
 *          stat     : solution status
@@ -172,12 +198,12 @@ static gtime_t time_stat={0};    /* rtk status file time */
 *          rejc     : data reject (outlier) count
 *
 *-----------------------------------------------------------------------------*/
-extern int rtkopenstat(const char *file, int level)
+extern int rtkopenstatt(const char *file, int level, int tix)
 {
     gtime_t time=utc2gpst(timeget());
     char path[1024];
     
-    trace(3,"rtkopenstat: file=%s level=%d\n",file,level);
+    trace(3,"rtkopenstatt: file=%s level=%d tix=%d\n",file,level,tix);
     
     if (level<=0) return 0;
     
@@ -187,11 +213,21 @@ extern int rtkopenstat(const char *file, int level)
         trace(1,"rtkopenstat: file open error path=%s\n",path);
         return 0;
     }
+    if (tix) opensoltix(&tix_stat,path,0);
     strcpy(file_stat,file);
     time_stat=time;
+    if (!initstat) {
+        initlock(&lock_stat);
+        initstat=1;
+    }
     statlevel=level;
+    stattix=tix;
     return 1;
 }
+extern int rtkopenstat(const char *file, int level)
+{
+    return rtkopenstatt(file,level,0);
+}
 /* close solution status file --------------------------------------------------
 * close solution status file
 * args   : none
@@ -203,8 +239,10 @@ extern void rtkclosestat(void)
     
     if (fp_stat) fclose(fp_stat);
     fp_stat=NULL;
+    closesoltix(&tix_stat);
     file_stat[0]='\0';
     statlevel=0;
+    stattix=0;
 }
 /* swap solution status file -------------------------------------------------*/
 static void swapsolstat(void)
@@ -222,28 +260,23 @@ static void swapsolstat(void)
         return;
     }
     if (fp_stat) fclose(fp_stat);
+    closesoltix(&tix_stat);
     
     if (!(fp_stat=fopen(path,"w"))) {
         trace(2,"swapsolstat: file open error path=%s\n",path);
         return;
     }
+    if (stattix) opensoltix(&tix_stat,path,0);
     trace(3,"swapsolstat: path=%s\n",path);
 }
-/* output solution status ----------------------------------------------------*/
-static void outsolstat(rtk_t *rtk)
+/* write solution status ----------------------------------------------------*/
+static void writesolstat(rtk_t *rtk)
 {
     ssat_t *ssat;
     double tow,pos[3],vel[3],acc[3],vela[3]={0},acca[3]={0},xa[3];
     int i,j,week,est,nfreq,nf=NF(&rtk->opt);
     char id[32];
     
-    if (statlevel<=0||!fp_stat) return;
-    
-    trace(3,"outsolstat:\n");
-    
-    /* swap solution status file */
-    swapsolstat();
-    
     est=rtk->opt.mode>=PMODE_DGPS;
     nfreq=est?nf:1;
     tow=time2gpst(rtk->sol.time,&week);
@@ -328,6 +361,37 @@ static void outsolstat(rtk_t *rtk)
         }
     }
 }
+/* output solution status ----------------------------------------------------*/
+static void outsolstat(rtk_t *rtk)
+{
+    double tow;
+    int week;
+    
+    if (statlevel<=0||!fp_stat) return;
+    
+    trace(3,"outsolstat:\n");
+    
+    /* lock status file shared by rtk control structs of rtk server rovers */
+    lock(&lock_stat);
+    
+    /* swap solution status file */
+    swapsolstat();
+    
+    outsoltix(&tix_stat,rtk->sol.time,fp_stat);
+    
+    /* rover number of rtk server */
+    if (rtk->rov>0) {
+        tow=time2gpst(rtk->sol.time,&week);
+        fprintf(fp_stat,"$ROV,%d,%.3f,%d\n",week,tow,rtk->rov);
+    }
+    if (rtk->opt.mode>=PMODE_PPP_KINEMA) {
+        pppoutsolstat(rtk,statlevel,fp_stat);
+    }
+    else {
+        writesolstat(rtk);
+    }
+    unlock(&lock_stat);
+}
 /* save error message --------------------------------------------------------*/
 static void errmsg(rtk_t *rtk, const char *format, ...)
 {
@@ -848,7 +912,7 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
                  const double *rr, const prcopt_t *opt, int index, double *y,
                  double *e, double *azel)
 {
-    double r,rr_[3],pos[3],dant[NFREQ]={0},disp[3];
+    double *r,*mapfh,*dant,rr_[3],pos[3],disp[3];
     double zhd,zazel[]={0.0,90.0*D2R};
     int i,nf=NF(opt);
     
@@ -856,7 +920,7 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
     
     for (i=0;i<n*nf*2;i++) y[i]=0.0;
     
-    if (norm(rr,3)<=0.0) return 0; /* no receiver position */
+    if (n<=0||norm(rr,3)<=0.0) return 0; /* no obs or receiver position */
     
     for (i=0;i<3;i++) rr_[i]=rr[i];
     
@@ -868,28 +932,36 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
     }
     ecef2pos(rr_,pos);
     
+    r=mat(n,1); mapfh=mat(n,1); dant=mat(NFREQ,n);
+    
+    /* geometric-range and azimuth/elevation angle of all satellites */
+    geodists(rs,rr_,n,r,e);
+    satazels(pos,e,r,n,azel);
+    
+    /* zenith hydrostatic delay and mapping functions */
+    zhd=tropmodel(obs[0].time,pos,zazel,0.0);
+    tropmapfs(obs[0].time,pos,azel,n,mapfh,NULL);
+    
+    /* receiver antenna phase center correction */
+    antmodels(opt->pcvr+index,opt->antdel[index],azel,n,opt->posopt[1],dant);
+    
     for (i=0;i<n;i++) {
-        /* compute geometric-range and azimuth/elevation angle */
-        if ((r=geodist(rs+i*6,rr_,e+i*3))<=0.0) continue;
-        if (satazel(pos,e+i*3,azel+i*2)<opt->elmin) continue;
+        if (r[i]<=0.0||azel[1+i*2]<opt->elmin) continue;
         
         /* excluded satellite? */
         if (satexclude(obs[i].sat,svh[i],opt)) continue;
         
         /* satellite clock-bias */
-        r+=-CLIGHT*dts[i*2];
+        r[i]+=-CLIGHT*dts[i*2];
         
         /* troposphere delay model (hydrostatic) */
-        zhd=tropmodel(obs[0].time,pos,zazel,0.0);
-        r+=tropmapf(obs[i].time,pos,azel+i*2,NULL)*zhd;
-        
-        /* receiver antenna phase center correction */
-        antmodel(opt->pcvr+index,opt->antdel[index],azel+i*2,opt->posopt[1],
-                 dant);
+        r[i]+=mapfh[i]*zhd;
         
         /* undifferenced phase/code residual for satellite */
-        zdres_sat(base,r,obs+i,nav,azel+i*2,dant,opt,y+i*nf*2);
+        zdres_sat(base,r[i],obs+i,nav,azel+i*2,dant+i*NFREQ,opt,y+i*nf*2);
     }
+    free(r); free(mapfh); free(dant);
+    
     trace(4,"rr_=%.3f %.3f %.3f\n",rr_[0],rr_[1],rr_[2]);
     trace(4,"pos=%.9f %.9f %.3f\n",pos[0]*R2D,pos[1]*R2D,pos[2]);
     for (i=0;i<n;i++) {
@@ -1026,6 +1098,7 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     prcopt_t *opt=&rtk->opt;
     double bl,dr[3],posu[3],posr[3],didxi=0.0,didxj=0.0,*im;
     double *tropr,*tropu,*dtdxr,*dtdxu,*Ri,*Rj,lami,lamj,fi,fj,df,*Hi=NULL;
+    double tick=prftick();
     int i,j,k,m,f,ff,nv=0,nb[NFREQ*4*2+2]={0},b=0,sysi,sysj,nf=NF(opt);
     
     trace(3,"ddres   : dt=%.1f nx=%d ns=%d\n",dt,rtk->nx,ns);
@@ -1199,42 +1272,53 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     free(Ri); free(Rj); free(im);
     free(tropu); free(tropr); free(dtdxu); free(dtdxr);
     
+    prfadd(rtk->prf+PRF_DDRES,tick);
     return nv;
 }
-/* time-interpolation of residuals (for post-mission) ------------------------*/
+/* time-interpolation of residuals ------------------------------------------*/
 static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                       rtk_t *rtk, double *y)
 {
-    static obsd_t obsb[MAXOBS];
-    static double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2],var[MAXOBS];
-    static double e[MAXOBS*3],azel[MAXOBS*2];
-    static int nb=0,svh[MAXOBS*2];
     prcopt_t *opt=&rtk->opt;
-    double tt=timediff(time,obs[0].time),ttb,*p,*q;
-    int i,j,k,nf=NF(opt);
+    obsd_t *obsb=rtk->obsb;
+    double tt=timediff(time,obs[0].time),ttb,*yb,*rs,*dts,*var,*e,*azel,*p,*q;
+    int i,j,k,nb,nf=NF(opt),svh[MAXOBS];
     
     trace(3,"intpres : n=%d tt=%.1f\n",n,tt);
     
-    if (nb==0||fabs(tt)<DTTOL) {
-        nb=n; for (i=0;i<n;i++) obsb[i]=obs[i];
-        return tt;
+    if (!obsb) return tt;
+    
+    /* update previous and current base epochs */
+    if (rtk->nobsb[1]<=0||timediff(obs[0].time,obsb[MAXOBS].time)!=0.0) {
+        for (i=0;i<rtk->nobsb[1];i++) obsb[i]=obsb[MAXOBS+i];
+        rtk->nobsb[0]=rtk->nobsb[1];
+        for (i=0;i<n&&i<MAXOBS;i++) obsb[MAXOBS+i]=obs[i];
+        rtk->nobsb[1]=i;
     }
+    if ((nb=rtk->nobsb[0])<=0||fabs(tt)<DTTOL) return tt;
+    
     ttb=timediff(time,obsb[0].time);
     if (fabs(ttb)>opt->maxtdiff*2.0||ttb==tt) return tt;
     
+    yb=mat(nf*2,nb); rs=mat(6,nb); dts=mat(2,nb); var=mat(1,nb);
+    e=mat(3,nb); azel=zeros(2,nb);
+    
     satposs(time,obsb,nb,nav,opt->sateph,rs,dts,var,svh);
     
-    if (!zdres(1,obsb,nb,rs,dts,svh,nav,rtk->rb,opt,1,yb,e,azel)) {
-        return tt;
-    }
-    for (i=0;i<n;i++) {
-        for (j=0;j<nb;j++) if (obsb[j].sat==obs[i].sat) break;
-        if (j>=nb) continue;
-        for (k=0,p=y+i*nf*2,q=yb+j*nf*2;k<nf*2;k++,p++,q++) {
-            if (*p==0.0||*q==0.0) *p=0.0; else *p=(ttb*(*p)-tt*(*q))/(ttb-tt);
+    if (zdres(1,obsb,nb,rs,dts,svh,nav,rtk->rb,opt,1,yb,e,azel)) {
+        
+        /* interpolate or extrapolate by previous and current base epochs */
+        for (i=0;i<n;i++) {
+            for (j=0;j<nb;j++) if (obsb[j].sat==obs[i].sat) break;
+            if (j>=nb) continue;
+            for (k=0,p=y+i*nf*2,q=yb+j*nf*2;k<nf*2;k++,p++,q++) {
+                if (*p==0.0||*q==0.0) *p=0.0; else *p=(ttb*(*p)-tt*(*q))/(ttb-tt);
+            }
         }
+        if (fabs(ttb)>fabs(tt)) tt=ttb;
     }
-    return fabs(ttb)>fabs(tt)?ttb:tt;
+    free(yb); free(rs); free(dts); free(var); free(e); free(azel);
+    return tt;
 }
 /* single to double-difference transformation matrix (D') --------------------*/
 static int ddmat(rtk_t *rtk, double *D)
@@ -1360,7 +1444,7 @@ static int resamb_LAMBDA(rtk_t *rtk, double *bias, double *xa)
 {
     prcopt_t *opt=&rtk->opt;
     int i,j,ny,nb,info,nx=rtk->nx,na=rtk->na;
-    double *D,*DP,*y,*Qy,*b,*db,*Qb,*Qab,*QQ,s[2];
+    double *D,*DP,*y,*Qy,*b,*db,*Qb,*Qab,*QQ,s[2],tick;
     
     trace(3,"resamb_LAMBDA : nx=%d\n",nx);
     
@@ -1392,7 +1476,11 @@ static int resamb_LAMBDA(rtk_t *rtk, double *bias, double *xa)
     trace(4,"N(0)="); tracemat(4,y+na,1,nb,10,3);
     
     /* lambda/mlambda integer least-square estimation */
-    if (!(info=lambda(nb,2,y+na,Qb,b,s))) {
+    tick=prftick();
+    info=lambda(nb,2,y+na,Qb,b,s);
+    prfadd(rtk->prf+PRF_LAMBDA,tick);
+    
+    if (!info) {
         
         trace(4,"N(1)="); tracemat(4,b   ,1,nb,10,3);
         trace(4,"N(2)="); tracemat(4,b+nb,1,nb,10,3);
@@ -1492,9 +1580,9 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
 {
     prcopt_t *opt=&rtk->opt;
     gtime_t time=obs[0].time;
-    double *rs,*dts,*var,*y,*e,*azel,*v,*H,*R,*xp,*Pp,*xa,*bias,dt;
+    double *rs,*dts,*var,*y,*e,*azel,*v,*H,*R,*xp,*Pp,*xa,*bias,dt,tick;
     int i,j,f,n=nu+nr,ns,ny,nv,sat[MAXSAT],iu[MAXSAT],ir[MAXSAT],niter;
-    int info,vflg[MAXOBS*NFREQ*2+1],svh[MAXOBS*2];
+    int info,zstat,vflg[MAXOBS*NFREQ*2+1],svh[MAXOBS*2];
     int stat=rtk->opt.mode<=PMODE_DGPS?SOLQ_DGPS:SOLQ_FLOAT;
     int nf=opt->ionoopt==IONOOPT_IFLC?1:opt->nf;
     
@@ -1510,17 +1598,23 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         for (j=0;j<NFREQ;j++) rtk->ssat[i].vsat[j]=rtk->ssat[i].snr[j]=0;
     }
     /* satellite positions/clocks */
+    tick=prftick();
     satposs(time,obs,n,nav,opt->sateph,rs,dts,var,svh);
+    prfadd(rtk->prf+PRF_SATPOS,tick);
     
     /* undifferenced residuals for base station */
-    if (!zdres(1,obs+nu,nr,rs+nu*6,dts+nu*2,svh+nu,nav,rtk->rb,opt,1,
-               y+nu*nf*2,e+nu*3,azel+nu*2)) {
+    tick=prftick();
+    zstat=zdres(1,obs+nu,nr,rs+nu*6,dts+nu*2,svh+nu,nav,rtk->rb,opt,1,
+                y+nu*nf*2,e+nu*3,azel+nu*2);
+    prfadd(rtk->prf+PRF_ZDRES,tick);
+    
+    if (!zstat) {
         errmsg(rtk,"initial base station position error\n");
         
         free(rs); free(dts); free(var); free(y); free(e); free(azel);
         return 0;
     }
-    /* time-interpolation of residuals (for post-processing) */
+    /* time-interpolation of residuals */
     if (opt->intpref) {
         dt=intpres(time,obs+nu,nr,nav,rtk,y+nu*nf*2);
     }
@@ -1547,7 +1641,11 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
     
     for (i=0;i<niter;i++) {
         /* undifferenced residuals for rover */
-        if (!zdres(0,obs,nu,rs,dts,svh,nav,xp,opt,0,y,e,azel)) {
+        tick=prftick();
+        zstat=zdres(0,obs,nu,rs,dts,svh,nav,xp,opt,0,y,e,azel);
+        prfadd(rtk->prf+PRF_ZDRES,tick);
+        
+        if (!zstat) {
             errmsg(rtk,"rover initial position error\n");
             stat=SOLQ_NONE;
             break;
@@ -1560,7 +1658,11 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         }
         /* kalman filter measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        tick=prftick();
+        info=filter(xp,Pp,H,v,R,rtk->nx,nv);
+        prfadd(rtk->prf+PRF_FILTER,tick);
+        
+        if (info) {
             errmsg(rtk,"filter error (info=%d)\n",info);
             stat=SOLQ_NONE;
             break;
@@ -1678,6 +1780,7 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     sol_t sol0={{0}};
     ambc_t ambc0={{{0}}};
     ssat_t ssat0={0};
+    prfstat_t prf0={0};
     int i;
     
     trace(3,"rtkinit :\n");
@@ -1698,6 +1801,10 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     }
     for (i=0;i<MAXERRMSG;i++) rtk->errbuf[i]=0;
     rtk->opt=*opt;
+    rtk->nobsb[0]=rtk->nobsb[1]=0;
+    rtk->obsb=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS*2);
+    for (i=0;i<NPRF;i++) rtk->prf[i]=prf0;
+    rtk->rov=0;
 }
 /* free rtk control ------------------------------------------------------------
 * free memory for rtk control struct
@@ -1713,6 +1820,287 @@ extern void rtkfree(rtk_t *rtk)
     free(rtk->P ); rtk->P =NULL;
     free(rtk->xa); rtk->xa=NULL;
     free(rtk->Pa); rtk->Pa=NULL;
+    free(rtk->obsb); rtk->obsb=NULL;
+    rtk->nobsb[0]=rtk->nobsb[1]=0;
+}
+/* put/get bytes of checkpoint -----------------------------------------------*/
+static unsigned char *putckpt(unsigned char *p, const void *data, int n)
+{
+    memcpy(p,data,n);
+    return p+n;
+}
+static const unsigned char *getckpt(const unsigned char *p,
+                                    const unsigned char *q, void *data, int n)
+{
+    if (!p||p+n>q) return NULL;
+    memcpy(data,p,n);
+    return p+n;
+}
+/* number of active states ---------------------------------------------------*/
+static int nactive(const double *x, const double *P, int n)
+{
+    int i,m=0;
+    
+    for (i=0;i<n;i++) {
+        if (x[i]!=0.0||P[i+i*n]!=0.0) m++;
+    }
+    return m;
+}
+/* encode states and covariance of active states -----------------------------*/
+static unsigned char *encstate(unsigned char *p, const double *x,
+                               const double *P, int n)
+{
+    int i,j,m=nactive(x,P,n),*ix;
+    
+    p=putckpt(p,&m,4);
+    if (m<=0) return p;
+    if (!(ix=imat(m,1))) return NULL;
+    
+    for (i=m=0;i<n;i++) {
+        if (x[i]!=0.0||P[i+i*n]!=0.0) ix[m++]=i;
+    }
+    for (i=0;i<m;i++) p=putckpt(p,ix+i,4);
+    for (i=0;i<m;i++) p=putckpt(p,x+ix[i],8);
+    for (i=0;i<m;i++) for (j=i;j<m;j++) {
+        p=putckpt(p,P+ix[i]+ix[j]*n,8);
+    }
+    free(ix);
+    return p;
+}
+/* decode states and covariance of active states -----------------------------*/
+static const unsigned char *decstate(const unsigned char *p,
+                                     const unsigned char *q, double *x,
+                                     double *P, int n)
+{
+    int i,j,m=0,*ix;
+    
+    if (!(p=getckpt(p,q,&m,4))||m<0||m>n) return NULL;
+    if (m==0) return p;
+    if (!(ix=imat(m,1))) return NULL;
+    
+    for (i=0;i<m&&p;i++) {
+        if ((p=getckpt(p,q,ix+i,4))&&(ix[i]<0||ix[i]>=n)) p=NULL;
+    }
+    for (i=0;i<m&&p;i++) {
+        p=getckpt(p,q,x+ix[i],8);
+    }
+    for (i=0;i<m&&p;i++) for (j=i;j<m&&p;j++) {
+        p=getckpt(p,q,P+ix[i]+ix[j]*n,8);
+        P[ix[j]+ix[i]*n]=P[ix[i]+ix[j]*n];
+    }
+    free(ix);
+    return p;
+}
+/* satellite with status to be saved -----------------------------------------*/
+static int ckptsat(const ssat_t *ssat, const ambc_t *ambc)
+{
+    int i;
+    
+    if (ssat->vs||ssat->gf!=0.0||ssat->gf2!=0.0||ssat->phw!=0.0) return 1;
+    if (ambc->fixcnt||ambc->epoch[0].time) return 1;
+    
+    for (i=0;i<NFREQ;i++) {
+        if (ssat->lock[i]||ssat->outc[i]||ssat->slipc[i]||ssat->rejc[i]||
+            ssat->pt[0][i].time||ssat->pt[1][i].time) return 1;
+    }
+    return 0;
+}
+/* save rtk filter state to checkpoint -----------------------------------------
+* save the filter state of rtk control struct to checkpoint file
+* args   : rtk_t    *rtk    I   rtk control/result struct
+*          char     *file   I   checkpoint file
+* return : status (1:ok,0:error)
+* notes  : the checkpoint includes the solution, the base position, the float
+*          and fixed states with their covariances, the ambiguity control and
+*          the satellite status.
+*          only active states (x[i]!=0 or P[i,i]!=0) are saved with the state
+*          indices (active-state map) and the upper triangle of the covariance
+*          among them. since a state with zero variance has zero covariances
+*          with others, the covariance is restored without loss. the status
+*          of satellites never tracked is not saved.
+*          values are saved in native byte order and struct layout with a crc
+*          at the end. the checkpoint is written to file.tmp and renamed to
+*          file to keep the previous checkpoint on a failure.
+*-----------------------------------------------------------------------------*/
+extern int rtksave(const rtk_t *rtk, const char *file)
+{
+    FILE *fp;
+    unsigned char *buff,*p;
+    unsigned int crc;
+    char id[8]=CKPT_ID,tmp[1024];
+    int i,m1,m2,ns=0,len,head[8];
+    
+    trace(3,"rtksave : file=%s\n",file);
+    
+    m1=nactive(rtk->x ,rtk->P ,rtk->nx);
+    m2=nactive(rtk->xa,rtk->Pa,rtk->na);
+    for (i=0;i<MAXSAT;i++) {
+        if (ckptsat(rtk->ssat+i,rtk->ambc+i)) ns++;
+    }
+    len=8+32+(int)sizeof(sol_t)+56+4+(4+m1*12+m1*(m1+1)*4)+
+        (4+m2*12+m2*(m2+1)*4)+4+ns*(4+(int)sizeof(ssat_t)+
+        (int)sizeof(ambc_t))+4;
+    
+    if (!(buff=(unsigned char *)malloc(len))) {
+        trace(1,"rtksave: malloc error len=%d\n",len);
+        return 0;
+    }
+    head[0]=CKPT_VER;
+    head[1]=rtk->opt.mode;
+    head[2]=rtk->opt.nf;
+    head[3]=rtk->nx;
+    head[4]=rtk->na;
+    head[5]=(int)sizeof(sol_t);
+    head[6]=(int)sizeof(ssat_t);
+    head[7]=(int)sizeof(ambc_t);
+    
+    p=putckpt(buff,id,8);
+    p=putckpt(p,head,32);
+    p=putckpt(p,&rtk->sol,sizeof(sol_t));
+    p=putckpt(p,rtk->rb,48);
+    p=putckpt(p,&rtk->tt,8);
+    p=putckpt(p,&rtk->nfix,4);
+    if (!(p=encstate(p,rtk->x,rtk->P,rtk->nx))||
+        !(p=encstate(p,rtk->xa,rtk->Pa,rtk->na))) {
+        free(buff);
+        return 0;
+    }
+    p=putckpt(p,&ns,4);
+    for (i=0;i<MAXSAT;i++) {
+        if (!ckptsat(rtk->ssat+i,rtk->ambc+i)) continue;
+        p=putckpt(p,&i,4);
+        p=putckpt(p,rtk->ssat+i,sizeof(ssat_t));
+        p=putckpt(p,rtk->ambc+i,sizeof(ambc_t));
+    }
+    crc=crc32(buff,(int)(p-buff));
+    p=putckpt(p,&crc,4);
+    
+    sprintf(tmp,"%.1019s.tmp",file);
+    
+    if (!(fp=fopen(tmp,"wb"))) {
+        trace(2,"rtksave: file open error %s\n",tmp);
+        free(buff);
+        return 0;
+    }
+    len=(int)(p-buff);
+    i=(int)fwrite(buff,1,len,fp)==len;
+    free(buff);
+    if (fclose(fp)||!i) {
+        trace(2,"rtksave: file write error %s\n",tmp);
+        remove(tmp);
+        return 0;
+    }
+    remove(file);
+    if (rename(tmp,file)) {
+        trace(2,"rtksave: file rename error %s\n",file);
+        return 0;
+    }
+    trace(4,"rtksave: len=%d nx=%d/%d na=%d/%d ns=%d\n",len,m1,rtk->nx,m2,
+          rtk->na,ns);
+    return 1;
+}
+/* decode checkpoint ---------------------------------------------------------*/
+static int decode_ckpt(rtk_t *rtk, const unsigned char *buff, int len,
+                       gtime_t time)
+{
+    const unsigned char *p=buff+40,*q=buff+len-4;
+    sol_t sol;
+    double age;
+    char id[8]=CKPT_ID;
+    int i,ns=0,sat,head[8];
+    
+    memcpy(head,buff+8,32);
+    
+    if (memcmp(buff,id,8)||head[0]!=CKPT_VER) {
+        trace(2,"checkpoint format error: ver=%d\n",head[0]);
+        return 0;
+    }
+    if (head[5]!=(int)sizeof(sol_t)||head[6]!=(int)sizeof(ssat_t)||
+        head[7]!=(int)sizeof(ambc_t)) {
+        trace(2,"checkpoint struct size mismatch\n");
+        return 0;
+    }
+    if (head[1]!=rtk->opt.mode||head[2]!=rtk->opt.nf||head[3]!=rtk->nx||
+        head[4]!=rtk->na) {
+        trace(2,"checkpoint option mismatch: mode=%d nf=%d nx=%d na=%d\n",
+              head[1],head[2],head[3],head[4]);
+        return 0;
+    }
+    if (!(p=getckpt(p,q,&sol,sizeof(sol_t)))) return 0;
+    
+    if (time.time) {
+        age=timediff(time,sol.time);
+        if (age<0.0||age>MAXCKPTAGE) {
+            trace(2,"checkpoint out of time: age=%.0fs\n",age);
+            return 0;
+        }
+    }
+    rtk->sol=sol;
+    if (!(p=getckpt(p,q,rtk->rb,48))||!(p=getckpt(p,q,&rtk->tt,8))||
+        !(p=getckpt(p,q,&rtk->nfix,4))) return 0;
+    
+    if (!(p=decstate(p,q,rtk->x,rtk->P,rtk->nx))||
+        !(p=decstate(p,q,rtk->xa,rtk->Pa,rtk->na))) return 0;
+    
+    if (!(p=getckpt(p,q,&ns,4))||ns<0||ns>MAXSAT) return 0;
+    
+    for (i=0;i<ns;i++) {
+        if (!(p=getckpt(p,q,&sat,4))||sat<0||sat>=MAXSAT) return 0;
+        if (!(p=getckpt(p,q,rtk->ssat+sat,sizeof(ssat_t)))||
+            !(p=getckpt(p,q,rtk->ambc+sat,sizeof(ambc_t)))) return 0;
+    }
+    return p==q;
+}
+/* load rtk filter state from checkpoint ---------------------------------------
+* restore the filter state of rtk control struct from checkpoint file
+* args   : rtk_t    *rtk    IO  rtk control/result struct
+*          char     *file   I   checkpoint file
+*          gtime_t  time    I   time of restart (gpst) (time.time==0: no check)
+* return : status (1:ok,0:error)
+* notes  : rtk should be initialized by rtkinit() with the same positioning
+*          mode and the same number of states as the checkpoint.
+*          the checkpoint is not restored if the solution time of it is after
+*          the time or older than MAXCKPTAGE from the time.
+*          if the checkpoint is not restored, rtk is reinitialized.
+*-----------------------------------------------------------------------------*/
+extern int rtkload(rtk_t *rtk, const char *file, gtime_t time)
+{
+    FILE *fp;
+    prcopt_t opt=rtk->opt;
+    unsigned char *buff=NULL;
+    unsigned int crc=0;
+    long len=0;
+    int stat=0;
+    
+    trace(3,"rtkload : file=%s time=%s\n",file,time_str(time,0));
+    
+    if (!(fp=fopen(file,"rb"))) {
+        trace(2,"rtkload: file open error %s\n",file);
+        return 0;
+    }
+    if (!fseek(fp,0,SEEK_END)&&(len=ftell(fp))>=44&&!fseek(fp,0,SEEK_SET)&&
+        (buff=(unsigned char *)malloc(len))) {
+        stat=(long)fread(buff,1,len,fp)==len;
+    }
+    fclose(fp);
+    
+    if (stat) {
+        memcpy(&crc,buff+len-4,4);
+        if (crc!=crc32(buff,(int)len-4)) {
+            trace(2,"rtkload: checkpoint crc error %s\n",file);
+            stat=0;
+        }
+    }
+    rtkfree(rtk);
+    rtkinit(rtk,&opt);
+    
+    if (stat&&!(stat=decode_ckpt(rtk,buff,(int)len,time))) {
+        rtkfree(rtk);
+        rtkinit(rtk,&opt);
+    }
+    free(buff);
+    trace(3,"rtkload: stat=%d nx=%d na=%d\n",stat,rtk->nx,rtk->na);
+    return stat;
 }
 /* precise positioning ---------------------------------------------------------
 * input observation data and navigation message, compute rover position by 
@@ -1777,7 +2165,8 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     prcopt_t *opt=&rtk->opt;
     sol_t solb={{0}};
     gtime_t time;
-    int i,nu,nr;
+    double tick;
+    int i,nu,nr,stat;
     char msg[128]="";
     
     trace(3,"rtkpos  : time=%s n=%d\n",time_str(obs[0].time,3),n);
@@ -1795,7 +2184,11 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     time=rtk->sol.time; /* previous epoch */
     
     /* rover position by single point positioning */
-    if (!pntpos(obs,nu,nav,&rtk->opt,&rtk->sol,NULL,rtk->ssat,msg)) {
+    tick=prftick();
+    stat=pntpos(obs,nu,nav,&rtk->opt,&rtk->sol,NULL,rtk->ssat,msg);
+    prfadd(rtk->prf+PRF_PNTPOS,tick);
+    
+    if (!stat) {
         errmsg(rtk,"point pos error (%s)\n",msg);
         
         if (!rtk->opt.dynamics) {
@@ -1812,8 +2205,10 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     }
     /* precise point positioning */
     if (opt->mode>=PMODE_PPP_KINEMA) {
+        tick=prftick();
         pppos(rtk,obs,nu,nav);
-        pppoutsolstat(rtk,statlevel,fp_stat);
+        prfadd(rtk->prf+PRF_PPPOS,tick);
+        outsolstat(rtk);
         return 1;
     }
     /* check number of data of base station and age of differential */
@@ -1850,7 +2245,9 @@ extern int rtkpos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
         }
     }
     /* relative potitioning */
+    tick=prftick();
     relpos(rtk,obs,nu,nr,nav);
+    prfadd(rtk->prf+PRF_RELPOS,tick);
     outsolstat(rtk);
     
     return 1;
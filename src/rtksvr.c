@@ -25,11 +25,188 @@
 *                            fix problem on ephemeris with inverted toe
 *                            add api rtksvrfree()
 *           2014/06/28  1.9  fix probram on ephemeris update of beidou
+*           2026/10/18  1.10 support multi-rover sharing base/correction streams
+*                            with worker threads
+*                            added api:
+*                                rtksvraddrov(),rtksvrfreerov()
+*           2026/10/18  1.11 pipelined rtk server with decoder threads per input
+*                            stream, event queues and output thread
+*                            added queue depth/latency statistics
+*           2026/10/18  1.12 wait input data by stream event in decoder threads
+*           2026/10/18  1.13 pair rover obs with time-matched base obs by base obs buffer
+*                            wait for base obs within svr->basewait and count alignment
+*           2026/10/18  1.14 batch queued solutions into one write per output stream
+*           2026/10/18  1.15 update wavelength per satellite by ephemeris
+*                            apply glonass fcn table to decoders only if updated
+*           2026/10/18  1.16 sbas message ring buffer with index by prn/type
+*                            update sbas corrections without server lock
+*                            added api:
+*                                rtksvrsbsmsg(),rtksvrsbslast()
+*           2026/10/18  1.17 add stage timing profile of decoders/server cycle
+*                            output stage timing profile to monitor port
+*                            added api:
+*                                rtksvrprf()
+*           2026/10/18  1.18 restore/autosave rtk filter state by checkpoint file
+*           2026/10/18  1.19 set rover number of rtk control for solution status
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
+#ifndef WIN32
+#include <sys/time.h>
+#endif
 
 static const char rcsid[]="$Id:$";
 
+#define MAXQUEIN    128                 /* size of input event queues */
+#define MAXQUEOUT   256                 /* size of output queue */
+#define MAXOUTMSG   2048                /* max length of output message */
+#define MAXOUTBATCH 32768               /* max length of batched output */
+
+#define EV_SP3      20                  /* event: sp3 precise ephemeris */
+#define EV_RNXCLK   21                  /* event: rinex clock */
+
+#ifdef WIN32
+#define MEMBAR()    MemoryBarrier()
+#else
+#define MEMBAR()    __sync_synchronize()
+#endif
+
+typedef struct {        /* rtk server input event type */
+    int type;           /* event type (input_raw() return, EV_???) */
+    int sat;            /* satellite number */
+    unsigned int tick;  /* tick of decoding (ms) */
+    union {
+        struct {        /* observation data */
+            int n;
+            obsd_t data[MAXOBS];
+        } obs;
+        eph_t eph;      /* gps/gal/qzs/bds ephemeris */
+        geph_t geph;    /* glonass ephemeris */
+        sbsmsg_t sbsmsg; /* sbas message */
+        sta_t sta;      /* station parameters */
+        dgps_t dgps;    /* dgps correction */
+        ssr_t ssr;      /* ssr correction */
+        lexmsg_t lexmsg; /* lex message */
+        struct {        /* ion/utc parameters */
+            double ion_gps[8],utc_gps[4],ion_gal[4],utc_gal[4];
+            double ion_qzs[8],utc_qzs[4];
+            int leaps;
+        } ion;
+        struct {        /* precise ephemeris/clock products */
+            peph_t *peph;
+            pclk_t *pclk;
+            int n;
+            char file[MAXSTRPATH];
+        } prod;
+    } u;
+} rtksvrev_t;
+
+typedef struct {        /* rtk server output type */
+    unsigned int tick;  /* tick of input observation data (ms) */
+    sol_t sol;          /* solution */
+    int n[3];           /* length of messages {sol1,sol2,monitor} */
+    unsigned char buff[3][MAXOUTMSG]; /* messages {sol1,sol2,monitor} */
+} rtksvrout_t;
+
+typedef struct {        /* decoder thread argument type */
+    rtksvr_t *svr;      /* rtk server */
+    int index;          /* input stream index */
+} rtksvrdec_t;
+
+/* initialize/free queue -----------------------------------------------------*/
+static int queinit(rtkque_t *q, int size, int elem)
+{
+    q->size=size;
+    q->elem=elem;
+    q->wp=q->rp=0;
+    q->nover=q->maxn=q->nlat=0;
+    q->lat=0.0;
+    q->latmax=0;
+    if (!(q->buff=(unsigned char *)malloc((size_t)size*elem))) {
+        q->size=0;
+        return 0;
+    }
+    return 1;
+}
+static void quefree(rtkque_t *q)
+{
+    free(q->buff); q->buff=NULL;
+    q->size=0;
+}
+/* get queue slot for write (producer) (NULL: queue full) --------------------*/
+static void *quewptr(rtkque_t *q)
+{
+    if (q->wp-q->rp>=(unsigned int)q->size) return NULL;
+    return q->buff+(size_t)(q->wp&(q->size-1))*q->elem;
+}
+/* push queue element written to slot (producer) -----------------------------*/
+static void quepush(rtkque_t *q)
+{
+    unsigned int n;
+    
+    MEMBAR();
+    q->wp++;
+    if ((n=q->wp-q->rp)>q->maxn) q->maxn=n;
+}
+/* get head element of queue (consumer) (NULL: queue empty) ------------------*/
+static void *queptr(rtkque_t *q)
+{
+    if (q->rp==q->wp) return NULL;
+    MEMBAR();
+    return q->buff+(size_t)(q->rp&(q->size-1))*q->elem;
+}
+/* pop head element of queue and update latency (consumer) -------------------*/
+static void quepop(rtkque_t *q, unsigned int tick)
+{
+    int lat=(int)(tickget()-tick);
+    
+    q->lat+=lat;
+    q->nlat++;
+    if (lat>q->latmax) q->latmax=lat;
+    MEMBAR();
+    q->rp++;
+}
+/* notify queue update -------------------------------------------------------*/
+static void quesignal(rtksvr_t *svr, int i)
+{
+    lock(&svr->qlock);
+    condbroadcast(svr->qcond+i);
+    unlock(&svr->qlock);
+}
+/* wait for queue update with timeout ----------------------------------------*/
+static void quewait(rtksvr_t *svr, int i, int ms)
+{
+#ifndef WIN32
+    struct timeval tv;
+    struct timespec ts;
+#endif
+    int empty;
+    
+    if (ms<=0) return;
+    
+    lock(&svr->qlock);
+    
+    if (i==0) {
+        empty=svr->que[0].rp==svr->que[0].wp&&svr->que[1].rp==svr->que[1].wp&&
+              svr->que[2].rp==svr->que[2].wp;
+    }
+    else empty=svr->que[3].rp==svr->que[3].wp;
+    
+    if (empty&&svr->state) {
+#ifdef WIN32
+        SleepConditionVariableCS(svr->qcond+i,&svr->qlock,ms);
+#else
+        gettimeofday(&tv,NULL);
+        ts.tv_sec =tv.tv_sec+ms/1000;
+        ts.tv_nsec=(tv.tv_usec+ms%1000*1000)*1000;
+        if (ts.tv_nsec>=1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec-=1000000000;
+        }
+        pthread_cond_timedwait(svr->qcond+i,&svr->qlock,&ts);
+#endif
+    }
+    unlock(&svr->qlock);
+}
 /* write solution header to output stream ------------------------------------*/
 static void writesolhead(stream_t *stream, const solopt_t *solopt)
 {
@@ -50,41 +227,76 @@ static void saveoutbuf(rtksvr_t *svr, unsigned char *buff, int n, int index)
     
     rtksvrunlock(svr);
 }
-/* write solution to output stream -------------------------------------------*/
-static void writesol(rtksvr_t *svr, int index)
+/* write solution to output queue --------------------------------------------*/
+static void writesol(rtksvr_t *svr, unsigned int tick)
 {
+    rtksvrout_t *out;
     solopt_t solopt=solopt_default;
-    unsigned char buff[1024];
+    double tickprf=prftick();
     int i,n;
     
-    tracet(4,"writesol: index=%d\n",index);
+    tracet(4,"writesol:\n");
+    
+    if (!(out=(rtksvrout_t *)quewptr(svr->que+3))) {
+        svr->que[3].nover++;
+        return;
+    }
+    out->tick=tick;
+    out->sol=svr->rtk.sol;
     
     for (i=0;i<2;i++) {
-        /* output solution */
-        n=outsols(buff,&svr->rtk.sol,svr->rtk.rb,svr->solopt+i);
-        strwrite(svr->stream+i+3,buff,n);
-        
-        /* save output buffer */
-        saveoutbuf(svr,buff,n,i);
-        
-        /* output extended solution */
-        n=outsolexs(buff,&svr->rtk.sol,svr->rtk.ssat,svr->solopt+i);
-        strwrite(svr->stream+i+3,buff,n);
-        
-        /* save output buffer */
-        saveoutbuf(svr,buff,n,i);
+        /* output solution and extended solution */
+        n=outsols(out->buff[i],&svr->rtk.sol,svr->rtk.rb,svr->solopt+i);
+        n+=outsolexs(out->buff[i]+n,&svr->rtk.sol,svr->rtk.ssat,svr->solopt+i);
+        out->n[i]=n;
     }
     /* output solution to monitor port */
-    if (svr->moni) {
-        n=outsols(buff,&svr->rtk.sol,svr->rtk.rb,&solopt);
-        strwrite(svr->moni,buff,n);
+    out->n[2]=!svr->moni?0:
+              outsols(out->buff[2],&svr->rtk.sol,svr->rtk.rb,&solopt);
+    prfadd(svr->prf+PRF_OUTPUT,tickprf);
+    
+    quepush(svr->que+3);
+    quesignal(svr,1);
+}
+/* add solution to output batch ---------------------------------------------*/
+static int addoutbatch(rtksvr_t *svr, const rtksvrout_t *out,
+                       unsigned char (*buff)[MAXOUTBATCH], int *n)
+{
+    int i;
+    
+    for (i=0;i<3;i++) {
+        if (n[i]+out->n[i]>MAXOUTBATCH) return 0;
+    }
+    for (i=0;i<3;i++) {
+        memcpy(buff[i]+n[i],out->buff[i],out->n[i]);
+        n[i]+=out->n[i];
     }
     /* save solution buffer */
     if (svr->nsol<MAXSOLBUF) {
         rtksvrlock(svr);
-        svr->solbuf[svr->nsol++]=svr->rtk.sol;
+        svr->solbuf[svr->nsol++]=out->sol;
         rtksvrunlock(svr);
     }
+    return 1;
+}
+/* output solution batch to output/monitor streams ---------------------------*/
+static void outputsol(rtksvr_t *svr, unsigned char (*buff)[MAXOUTBATCH],
+                      int *n)
+{
+    int i;
+    
+    tracet(4,"outputsol: n=%d %d %d\n",n[0],n[1],n[2]);
+    
+    for (i=0;i<2;i++) {
+        if (n[i]<=0) continue;
+        strwrite(svr->stream+i+3,buff[i],n[i]);
+        
+        /* save output buffer */
+        saveoutbuf(svr,buff[i],n[i],i);
+    }
+    if (svr->moni&&n[2]>0) {
+        strwrite(svr->moni,buff[2],n[2]);
+    }
 }
 /* update navigation data ----------------------------------------------------*/
 static void updatenav(nav_t *nav)
@@ -94,56 +306,125 @@ static void updatenav(nav_t *nav)
         nav->lam[i][j]=satwavelen(i+1,j,nav);
     }
 }
+/* update navigation data of a satellite -------------------------------------*/
+static void updatenavsat(nav_t *nav, int sat)
+{
+    int j;
+    for (j=0;j<NFREQ;j++) {
+        nav->lam[sat-1][j]=satwavelen(sat,j,nav);
+    }
+}
+/* update glonass frequency channel number table -----------------------------*/
+static void setfcn(rtksvr_t *svr, int prn, int frq)
+{
+    if (prn<1||prn>MAXPRNGLO||frq<-7||frq>6) return;
+    if (svr->nav.glo_fcn[prn-1]==frq+8) return;
+    svr->nav.glo_fcn[prn-1]=(char)(frq+8);
+    svr->fcnver++;
+}
 /* update glonass frequency channel number in raw data struct ----------------*/
-static void updatefcn(rtksvr_t *svr)
+static void updatefcn(rtksvr_t *svr, int index)
 {
-    int i,j,sat,frq;
+    int i,sat;
+    
+    /* apply fcn table only if updated (fcnver is updated under lock) */
+    if (svr->fcnvers[index]==svr->fcnver) return;
+    
+    rtksvrlock(svr);
     
     for (i=0;i<MAXPRNGLO;i++) {
+        if (svr->nav.glo_fcn[i]<=0) continue;
         sat=satno(SYS_GLO,i+1);
         
-        for (j=0,frq=-999;j<3;j++) {
-            if (svr->raw[j].nav.geph[i].sat!=sat) continue;
-            frq=svr->raw[j].nav.geph[i].frq;
-        }
-        if (frq<-7||frq>6) continue;
-        
-        for (j=0;j<3;j++) {
-            if (svr->raw[j].nav.geph[i].sat==sat) continue;
-            svr->raw[j].nav.geph[i].sat=sat;
-            svr->raw[j].nav.geph[i].frq=frq;
-        }
+        if (svr->raw[index].nav.geph[i].sat==sat) continue;
+        svr->raw[index].nav.geph[i].sat=sat;
+        svr->raw[index].nav.geph[i].frq=svr->nav.glo_fcn[i]-8;
     }
+    svr->fcnvers[index]=svr->fcnver;
+    
+    rtksvrunlock(svr);
+}
+/* add sbas message to ring buffer (server thread) ----------------------------
+* the message is written to the slot before the number of written messages is
+* updated, so readers can detect slots overwritten during copy without lock
+*-----------------------------------------------------------------------------*/
+static void addsbsmsg(rtksvr_t *svr, const sbsmsg_t *msg)
+{
+    unsigned int no=svr->sbsw;
+    int prn=msg->prn,type=getbitu(msg->msg,8,6);
+    
+    if (svr->sbssize<=0) return;
+    
+    svr->sbsmsg[no%svr->sbssize]=*msg;
+    MEMBAR();
+    svr->sbsw=no+1;
+    if (svr->nsbs<svr->sbssize) svr->nsbs++;
+    if (MINPRNSBS<=prn&&prn<=MAXPRNSBS) svr->sbsidx[prn-MINPRNSBS][type]=no+1;
 }
-/* update rtk server struct --------------------------------------------------*/
-static void updatesvr(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
-                      sbsmsg_t *sbsmsg, int index, int iobs)
+/* update sbas corrections by sbas message (server thread) -------------------*/
+static void applysbsmsg(rtksvr_t *svr, const sbsmsg_t *msg)
 {
-    eph_t *eph1,*eph2,*eph3;
-    geph_t *geph1,*geph2,*geph3;
+    int sbssat=svr->rtk.opt.sbassatsel;
+    
+    if (sbssat==msg->prn||sbssat==0) sbsupdatecorr(msg,&svr->nav);
+}
+/* allocate sbas message buffer and replay buffered messages -----------------*/
+static int initsbsbuf(rtksvr_t *svr)
+{
+    int i,n=svr->nsbsmax>0?svr->nsbsmax:MAXSBSMSG;
+    
+    if (n!=svr->sbssize) { /* buffered messages discarded by depth change */
+        free(svr->sbsmsg);
+        svr->sbssize=svr->nsbs=0;
+        svr->sbsw=0;
+        memset(svr->sbsidx,0,sizeof(svr->sbsidx));
+        if (!(svr->sbsmsg=(sbsmsg_t *)malloc(sizeof(sbsmsg_t)*n))) return 0;
+        svr->sbssize=n;
+    }
+    for (i=svr->nsbs;i>0;i--) {
+        applysbsmsg(svr,svr->sbsmsg+(svr->sbsw-i)%svr->sbssize);
+    }
+    return 1;
+}
+/* select observation data by processing options -----------------------------*/
+static void selobs(const prcopt_t *opt, const obs_t *obs, int rcv, obs_t *out)
+{
+    int i,n=0;
+    
+    for (i=0;i<obs->n;i++) {
+        if (opt->exsats[obs->data[i].sat-1]==1||
+            !(satsys(obs->data[i].sat,NULL)&opt->navsys)) continue;
+        out->data[n]=obs->data[i];
+        out->data[n++].rcv=rcv;
+    }
+    out->n=n;
+    sortobs(out);
+}
+/* update rtk server struct by input event -----------------------------------*/
+static void updatesvr(rtksvr_t *svr, const rtksvrev_t *ev, int index)
+{
+    eph_t *eph2,*eph3;
+    geph_t *geph2,*geph3;
+    const eph_t *eph1;
+    const geph_t *geph1;
+    const ssr_t *ssr;
+    lexmsg_t lexmsg;
     gtime_t tof;
+    obs_t obs;
     double pos[3],del[3]={0},dr[3];
-    int i,n=0,prn,sbssat=svr->rtk.opt.sbassatsel,sys,iode;
+    int i,prn,sat=ev->sat,sys,iode;
     
-    tracet(4,"updatesvr: ret=%d sat=%2d index=%d\n",ret,sat,index);
+    tracet(4,"updatesvr: type=%d sat=%2d index=%d\n",ev->type,sat,index);
     
-    if (ret==1) { /* observation data */
-        if (iobs<MAXOBSBUF) {
-            for (i=0;i<obs->n;i++) {
-                if (svr->rtk.opt.exsats[obs->data[i].sat-1]==1||
-                    !(satsys(obs->data[i].sat,NULL)&svr->rtk.opt.navsys)) continue;
-                svr->obs[index][iobs].data[n]=obs->data[i];
-                svr->obs[index][iobs].data[n++].rcv=index+1;
-            }
-            svr->obs[index][iobs].n=n;
-            sortobs(&svr->obs[index][iobs]);
-        }
-        svr->nmsg[index][0]++;
+    if (ev->type==1) { /* observation data */
+        obs.n=ev->u.obs.n;
+        obs.data=(obsd_t *)ev->u.obs.data;
+        selobs(&svr->rtk.opt,&obs,index+1,&svr->obs[index][0]);
     }
-    else if (ret==2) { /* ephemeris */
+    else if (ev->type==2) { /* ephemeris */
         if (satsys(sat,&prn)!=SYS_GLO) {
             if (!svr->navsel||svr->navsel==index+1) {
-                eph1=nav->eph+sat-1;
+                eph1=&ev->u.eph;
                 eph2=svr->nav.eph+sat-1;
                 eph3=svr->nav.eph+sat-1+MAXSAT;
                 if (eph2->ttr.time==0||
@@ -152,105 +433,220 @@ static void updatesvr(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
                      timediff(eph1->toe,eph2->toe)!=0.0)) {
                     *eph3=*eph2;
                     *eph2=*eph1;
-                    updatenav(&svr->nav);
                 }
             }
-            svr->nmsg[index][1]++;
         }
         else {
            if (!svr->navsel||svr->navsel==index+1) {
-               geph1=nav->geph+prn-1;
+               geph1=&ev->u.geph;
                geph2=svr->nav.geph+prn-1;
                geph3=svr->nav.geph+prn-1+MAXPRNGLO;
                if (geph2->tof.time==0||
                    (geph1->iode!=geph3->iode&&geph1->iode!=geph2->iode)) {
                    *geph3=*geph2;
                    *geph2=*geph1;
-                   updatenav(&svr->nav);
-                   updatefcn(svr);
+                   
+                   /* update wavelengths and fcn table only by fcn change */
+                   if (geph3->tof.time==0||geph3->frq!=geph2->frq) {
+                       updatenavsat(&svr->nav,sat);
+                   }
+                   setfcn(svr,prn,geph2->frq);
                }
            }
-           svr->nmsg[index][6]++;
         }
     }
-    else if (ret==3) { /* sbas message */
-        if (sbsmsg&&(sbssat==sbsmsg->prn||sbssat==0)) {
-            if (svr->nsbs<MAXSBSMSG) {
-                svr->sbsmsg[svr->nsbs++]=*sbsmsg;
-            }
-            else {
-                for (i=0;i<MAXSBSMSG-1;i++) svr->sbsmsg[i]=svr->sbsmsg[i+1];
-                svr->sbsmsg[i]=*sbsmsg;
-            }
-            sbsupdatecorr(sbsmsg,&svr->nav);
-        }
-        svr->nmsg[index][3]++;
+    else if (ev->type==3) { /* sbas message */
+        addsbsmsg(svr,&ev->u.sbsmsg);
     }
-    else if (ret==9) { /* ion/utc parameters */
+    else if (ev->type==9) { /* ion/utc parameters */
         if (svr->navsel==index||svr->navsel>=3) {
-            for (i=0;i<8;i++) svr->nav.ion_gps[i]=nav->ion_gps[i];
-            for (i=0;i<4;i++) svr->nav.utc_gps[i]=nav->utc_gps[i];
-            for (i=0;i<4;i++) svr->nav.ion_gal[i]=nav->ion_gal[i];
-            for (i=0;i<4;i++) svr->nav.utc_gal[i]=nav->utc_gal[i];
-            for (i=0;i<8;i++) svr->nav.ion_qzs[i]=nav->ion_qzs[i];
-            for (i=0;i<4;i++) svr->nav.utc_qzs[i]=nav->utc_qzs[i];
-            svr->nav.leaps=nav->leaps;
+            for (i=0;i<8;i++) svr->nav.ion_gps[i]=ev->u.ion.ion_gps[i];
+            for (i=0;i<4;i++) svr->nav.utc_gps[i]=ev->u.ion.utc_gps[i];
+            for (i=0;i<4;i++) svr->nav.ion_gal[i]=ev->u.ion.ion_gal[i];
+            for (i=0;i<4;i++) svr->nav.utc_gal[i]=ev->u.ion.utc_gal[i];
+            for (i=0;i<8;i++) svr->nav.ion_qzs[i]=ev->u.ion.ion_qzs[i];
+            for (i=0;i<4;i++) svr->nav.utc_qzs[i]=ev->u.ion.utc_qzs[i];
+            svr->nav.leaps=ev->u.ion.leaps;
         }
-        svr->nmsg[index][2]++;
     }
-    else if (ret==5) { /* antenna postion parameters */
+    else if (ev->type==5) { /* antenna postion parameters */
         if (svr->rtk.opt.refpos==4&&index==1) {
             for (i=0;i<3;i++) {
-                svr->rtk.rb[i]=svr->rtcm[1].sta.pos[i];
+                svr->rtk.rb[i]=ev->u.sta.pos[i];
             }
             /* antenna delta */
             ecef2pos(svr->rtk.rb,pos);
-            if (svr->rtcm[1].sta.deltype) { /* xyz */
-                del[2]=svr->rtcm[1].sta.hgt;
+            if (ev->u.sta.deltype) { /* xyz */
+                del[2]=ev->u.sta.hgt;
                 enu2ecef(pos,del,dr);
                 for (i=0;i<3;i++) {
-                    svr->rtk.rb[i]+=svr->rtcm[1].sta.del[i]+dr[i];
+                    svr->rtk.rb[i]+=ev->u.sta.del[i]+dr[i];
                 }
             }
             else { /* enu */
-                enu2ecef(pos,svr->rtcm[1].sta.del,dr);
+                enu2ecef(pos,ev->u.sta.del,dr);
                 for (i=0;i<3;i++) {
                     svr->rtk.rb[i]+=dr[i];
                 }
             }
         }
+    }
+    else if (ev->type==7) { /* dgps correction */
+        svr->nav.dgps[sat-1]=ev->u.dgps;
+    }
+    else if (ev->type==10) { /* ssr message */
+        ssr=&ev->u.ssr;
+        iode=ssr->iode;
+        sys=satsys(sat,&prn);
+        
+        /* check corresponding ephemeris exists */
+        if (sys==SYS_GPS||sys==SYS_GAL||sys==SYS_QZS) {
+            if (svr->nav.eph[sat-1       ].iode!=iode&&
+                svr->nav.eph[sat-1+MAXSAT].iode!=iode) {
+                return;
+            }
+        }
+        else if (sys==SYS_GLO) {
+            if (svr->nav.geph[prn-1          ].iode!=iode&&
+                svr->nav.geph[prn-1+MAXPRNGLO].iode!=iode) {
+                return;
+            }
+        }
+        svr->nav.ssr[sat-1]=*ssr;
+    }
+    else if (ev->type==31) { /* lex message */
+        lexmsg=ev->u.lexmsg;
+        lexupdatecorr(&lexmsg,&svr->nav,&tof);
+    }
+    else if (ev->type==EV_SP3) { /* precise ephemeris */
+        if (svr->nav.peph) free(svr->nav.peph);
+        svr->nav.ne=svr->nav.nemax=ev->u.prod.n;
+        svr->nav.peph=ev->u.prod.peph;
+        svr->ftime[index]=utc2gpst(timeget());
+        strcpy(svr->files[index],ev->u.prod.file);
+    }
+    else if (ev->type==EV_RNXCLK) { /* precise clock */
+        if (svr->nav.pclk) free(svr->nav.pclk);
+        svr->nav.nc=svr->nav.ncmax=ev->u.prod.n;
+        svr->nav.pclk=ev->u.prod.pclk;
+        svr->ftime[index]=utc2gpst(timeget());
+        strcpy(svr->files[index],ev->u.prod.file);
+    }
+}
+/* get new input event (NULL: observation data overflow or server stopped) ---*/
+static rtksvrev_t *newevent(rtksvr_t *svr, int index, int type, int sat)
+{
+    rtksvrev_t *ev;
+    
+    if (!(ev=(rtksvrev_t *)quewptr(svr->que+index))) {
+        svr->que[index].nover++;
+        
+        /* drop observation data not to delay positioning */
+        if (type==1) {
+            svr->prcout++;
+            return NULL;
+        }
+        /* wait for navigation data to be consumed */
+        do {
+            quesignal(svr,0);
+            sleepms(1);
+        } while (!(ev=(rtksvrev_t *)quewptr(svr->que+index))&&svr->state);
+        
+        if (!ev) return NULL;
+    }
+    ev->type=type;
+    ev->sat=sat;
+    ev->tick=tickget();
+    return ev;
+}
+/* post decoded data as input events -----------------------------------------*/
+static void postevent(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
+                      sbsmsg_t *sbsmsg, int index)
+{
+    rtksvrev_t *ev;
+    rtcm_t *rtcm=svr->rtcm+index;
+    int i,prn;
+    
+    tracet(4,"postevent: ret=%d sat=%2d index=%d\n",ret,sat,index);
+    
+    if (ret==1) { /* observation data */
+        if ((ev=newevent(svr,index,ret,0))) {
+            ev->u.obs.n=obs->n<MAXOBS?obs->n:MAXOBS;
+            for (i=0;i<ev->u.obs.n;i++) ev->u.obs.data[i]=obs->data[i];
+            quepush(svr->que+index);
+        }
+        svr->nmsg[index][0]++;
+    }
+    else if (ret==2) { /* ephemeris */
+        if (satsys(sat,&prn)!=SYS_GLO) {
+            if ((ev=newevent(svr,index,ret,sat))) {
+                ev->u.eph=nav->eph[sat-1];
+                quepush(svr->que+index);
+            }
+            svr->nmsg[index][1]++;
+        }
+        else {
+            if ((ev=newevent(svr,index,ret,sat))) {
+                ev->u.geph=nav->geph[prn-1];
+                quepush(svr->que+index);
+            }
+            svr->nmsg[index][6]++;
+        }
+    }
+    else if (ret==3) { /* sbas message */
+        if (sbsmsg&&(ev=newevent(svr,index,ret,0))) {
+            ev->u.sbsmsg=*sbsmsg;
+            quepush(svr->que+index);
+        }
+        svr->nmsg[index][3]++;
+    }
+    else if (ret==9) { /* ion/utc parameters */
+        if ((ev=newevent(svr,index,ret,0))) {
+            for (i=0;i<8;i++) ev->u.ion.ion_gps[i]=nav->ion_gps[i];
+            for (i=0;i<4;i++) ev->u.ion.utc_gps[i]=nav->utc_gps[i];
+            for (i=0;i<4;i++) ev->u.ion.ion_gal[i]=nav->ion_gal[i];
+            for (i=0;i<4;i++) ev->u.ion.utc_gal[i]=nav->utc_gal[i];
+            for (i=0;i<8;i++) ev->u.ion.ion_qzs[i]=nav->ion_qzs[i];
+            for (i=0;i<4;i++) ev->u.ion.utc_qzs[i]=nav->utc_qzs[i];
+            ev->u.ion.leaps=nav->leaps;
+            quepush(svr->que+index);
+        }
+        svr->nmsg[index][2]++;
+    }
+    else if (ret==5) { /* antenna postion parameters */
+        if ((ev=newevent(svr,index,ret,0))) {
+            ev->u.sta=rtcm->sta;
+            quepush(svr->que+index);
+        }
         svr->nmsg[index][4]++;
     }
     else if (ret==7) { /* dgps correction */
+        for (i=0;i<MAXSAT;i++) {
+            if (timediff(rtcm->nav.dgps[i].t0,rtcm->time)!=0.0) continue;
+            if ((ev=newevent(svr,index,ret,i+1))) {
+                ev->u.dgps=rtcm->nav.dgps[i];
+                quepush(svr->que+index);
+            }
+        }
         svr->nmsg[index][5]++;
     }
     else if (ret==10) { /* ssr message */
         for (i=0;i<MAXSAT;i++) {
-            if (!svr->rtcm[index].ssr[i].update) continue;
-            svr->rtcm[index].ssr[i].update=0;
-            
-            iode=svr->rtcm[index].ssr[i].iode;
-            sys=satsys(i+1,&prn);
+            if (!rtcm->ssr[i].update) continue;
+            rtcm->ssr[i].update=0;
             
-            /* check corresponding ephemeris exists */
-            if (sys==SYS_GPS||sys==SYS_GAL||sys==SYS_QZS) {
-                if (svr->nav.eph[i       ].iode!=iode&&
-                    svr->nav.eph[i+MAXSAT].iode!=iode) {
-                    continue;
-                }
+            if ((ev=newevent(svr,index,ret,i+1))) {
+                ev->u.ssr=rtcm->ssr[i];
+                quepush(svr->que+index);
             }
-            else if (sys==SYS_GLO) {
-                if (svr->nav.geph[prn-1          ].iode!=iode&&
-                    svr->nav.geph[prn-1+MAXPRNGLO].iode!=iode) {
-                    continue;
-                }
-            }
-            svr->nav.ssr[i]=svr->rtcm[index].ssr[i];
         }
         svr->nmsg[index][7]++;
     }
     else if (ret==31) { /* lex message */
-        lexupdatecorr(&svr->raw[index].lexmsg,&svr->nav,&tof);
+        if ((ev=newevent(svr,index,ret,0))) {
+            ev->u.lexmsg=svr->raw[index].lexmsg;
+            quepush(svr->que+index);
+        }
         svr->nmsg[index][8]++;
     }
     else if (ret==-1) { /* error */
@@ -258,118 +654,757 @@ static void updatesvr(rtksvr_t *svr, int ret, obs_t *obs, nav_t *nav, int sat,
     }
 }
 /* decode receiver raw/rtcm data ---------------------------------------------*/
-static int decoderaw(rtksvr_t *svr, int index)
+static void decoderaw(rtksvr_t *svr, int index)
 {
     obs_t *obs;
     nav_t *nav;
     sbsmsg_t *sbsmsg=NULL;
-    int i,ret,sat,fobs=0;
+    int i,ret,sat;
+    
+    tracet(4,"decoderaw: index=%d\n",index);
+    
+    for (i=0;i<svr->nb[index];i++) {
+        
+        /* input rtcm/receiver raw data from stream */
+        if (svr->format[index]==STRFMT_RTCM2) {
+            ret=input_rtcm2(svr->rtcm+index,svr->buff[index][i]);
+            obs=&svr->rtcm[index].obs;
+            nav=&svr->rtcm[index].nav;
+            sat=svr->rtcm[index].ephsat;
+        }
+        else if (svr->format[index]==STRFMT_RTCM3) {
+            ret=input_rtcm3(svr->rtcm+index,svr->buff[index][i]);
+            obs=&svr->rtcm[index].obs;
+            nav=&svr->rtcm[index].nav;
+            sat=svr->rtcm[index].ephsat;
+        }
+        else {
+            ret=input_raw(svr->raw+index,svr->format[index],svr->buff[index][i]);
+            obs=&svr->raw[index].obs;
+            nav=&svr->raw[index].nav;
+            sat=svr->raw[index].ephsat;
+            sbsmsg=&svr->raw[index].sbsmsg;
+        }
+#if 0 /* record for receiving tick */
+        if (ret==1) {
+            trace(0,"%d %10d T=%s NS=%2d\n",index,tickget(),
+                  time_str(obs->data[0].time,0),obs->n);
+        }
+#endif
+        /* post input events to rtk server */
+        if (ret>0||ret==-1) postevent(svr,ret,obs,nav,sat,sbsmsg,index);
+    }
+    svr->nb[index]=0;
+}
+/* decode download file ------------------------------------------------------*/
+static void decodefile(rtksvr_t *svr, int index)
+{
+    rtksvrev_t *ev;
+    nav_t nav={0};
+    char file[1024];
+    int nb;
+    
+    tracet(4,"decodefile: index=%d\n",index);
+    
+    /* check file path completed */
+    if ((nb=svr->nb[index])<=2||
+        svr->buff[index][nb-2]!='\r'||svr->buff[index][nb-1]!='\n') {
+        return;
+    }
+    nb=nb-2<(int)sizeof(file)-1?nb-2:(int)sizeof(file)-1;
+    strncpy(file,(char *)svr->buff[index],nb); file[nb]='\0';
+    svr->nb[index]=0;
+    
+    if (svr->format[index]==STRFMT_SP3) { /* precise ephemeris */
+        
+        /* read sp3 precise ephemeris */
+        readsp3(file,&nav,0);
+        if (nav.ne<=0) {
+            tracet(1,"sp3 file read error: %s\n",file);
+            return;
+        }
+        /* post precise ephemeris update */
+        if (!(ev=newevent(svr,index,EV_SP3,0))) {
+            free(nav.peph);
+            return;
+        }
+        ev->u.prod.peph=nav.peph;
+        ev->u.prod.n=nav.ne;
+    }
+    else if (svr->format[index]==STRFMT_RNXCLK) { /* precise clock */
+        
+        /* read rinex clock */
+        if (readrnxc(file,&nav)<=0) {
+            tracet(1,"rinex clock file read error: %s\n",file);
+            return;
+        }
+        /* post precise clock update */
+        if (!(ev=newevent(svr,index,EV_RNXCLK,0))) {
+            free(nav.pclk);
+            return;
+        }
+        ev->u.prod.pclk=nav.pclk;
+        ev->u.prod.n=nav.nc;
+    }
+    else return;
+    
+    strcpy(ev->u.prod.file,file);
+    quepush(svr->que+index);
+}
+/* add base observation data to time-alignment buffer ------------------------*/
+static void addbase(rtksvr_t *svr)
+{
+    obs_t *obs=svr->bobs+svr->ibobs;
+    int i;
+    
+    if (svr->obs[1][0].n<=0) return;
+    
+    for (i=0;i<svr->obs[1][0].n;i++) obs->data[i]=svr->obs[1][0].data[i];
+    obs->n=svr->obs[1][0].n;
+    svr->ibobs=(svr->ibobs+1)%MAXOBSALN;
+    if (svr->nbobs<MAXOBSALN) svr->nbobs++;
+}
+/* base observation data in time-alignment buffer (0:latest) -----------------*/
+static const obs_t *bobs(const rtksvr_t *svr, int i)
+{
+    return svr->bobs+(svr->ibobs-1-i+MAXOBSALN*2)%MAXOBSALN;
+}
+/* select base observation data for rover time -------------------------------*/
+static const obs_t *selbase(const rtksvr_t *svr, gtime_t time, int *match)
+{
+    const obs_t *obs,*prev=NULL,*next=NULL;
+    double tt;
+    int i;
+    
+    *match=0;
+    
+    if (svr->nbobs<=0) return svr->obs[1];
+    
+    for (i=0;i<svr->nbobs;i++) {
+        obs=bobs(svr,i);
+        tt=timediff(time,obs->data[0].time);
+        if (fabs(tt)<DTTOL) { /* time-matched */
+            *match=1;
+            return obs;
+        }
+        if (tt>0.0) {
+            if (!prev||timediff(obs->data[0].time,prev->data[0].time)>0.0) prev=obs;
+        }
+        else if (!next||timediff(obs->data[0].time,next->data[0].time)<0.0) {
+            next=obs;
+        }
+    }
+    /* next base for interpolation or previous base for extrapolation */
+    if (svr->rtk.opt.intpref&&next&&prev) return next;
+    return prev?prev:bobs(svr,0);
+}
+/* test time-matched base observation data expected --------------------------*/
+static int expbase(const rtksvr_t *svr, gtime_t time)
+{
+    double ti,tt;
+    
+    if (svr->rtk.opt.mode<PMODE_DGPS||svr->rtk.opt.mode>PMODE_FIXED) {
+        return 0; /* no base */
+    }
+    if (svr->nbobs<2) return 1;
+    
+    /* base interval estimated by latest epochs */
+    tt=timediff(time,bobs(svr,0)->data[0].time);
+    ti=timediff(bobs(svr,0)->data[0].time,bobs(svr,1)->data[0].time);
+    
+    if (tt<-DTTOL) return 0; /* base already ahead of rover */
+    if (ti<=DTTOL) return 1;
+    return fabs(tt-floor(tt/ti+0.5)*ti)<DTTOL;
+}
+/* write solution of rover to output stream ----------------------------------*/
+static void writesolrov(rtkrov_t *rov)
+{
+    unsigned char buff[MAXSOLMSG*2];
+    double tick=prftick();
+    int n;
+    
+    tracet(4,"writesolrov: name=%s\n",rov->name);
+    
+    /* output solution */
+    n=outsols(buff,&rov->rtk.sol,rov->rtk.rb,&rov->solopt);
+    n+=outsolexs(buff+n,&rov->rtk.sol,rov->rtk.ssat,&rov->solopt);
+    prfadd(rov->rtk.prf+PRF_OUTPUT,tick);
+    
+    /* output solution and extended solution */
+    strwrite(rov->stream+1,buff,n);
+    
+    rov->nsol++;
+}
+/* decode receiver raw/rtcm data of rover ------------------------------------*/
+static int decoderov(rtkrov_t *rov)
+{
+    obs_t *obs;
+    int i,ret,fobs=0;
+    
+    tracet(4,"decoderov: name=%s\n",rov->name);
+    
+    for (i=0;i<rov->nb;i++) {
+        
+        /* input rtcm/receiver raw data from stream */
+        if (rov->format==STRFMT_RTCM2) {
+            ret=input_rtcm2(&rov->rtcm,rov->buff[i]);
+            obs=&rov->rtcm.obs;
+        }
+        else if (rov->format==STRFMT_RTCM3) {
+            ret=input_rtcm3(&rov->rtcm,rov->buff[i]);
+            obs=&rov->rtcm.obs;
+        }
+        else {
+            ret=input_raw(&rov->raw,rov->format,rov->buff[i]);
+            obs=&rov->raw.obs;
+        }
+        /* navigation data of rover are not used (shared by rtk server) */
+        if (ret==1) { /* observation data */
+            if (fobs<MAXOBSBUF) {
+                selobs(&rov->rtk.opt,obs,1,rov->obs+fobs++);
+            }
+            else rov->prcout++;
+            rov->nmsg[0]++;
+        }
+        else if (ret==-1) { /* error */
+            rov->nmsg[9]++;
+        }
+    }
+    rov->nb=0;
+    
+    return fobs;
+}
+/* process rover -------------------------------------------------------------*/
+static void processrov(rtksvr_t *svr, rtkrov_t *rov)
+{
+    obs_t obs;
+    const obs_t *base;
+    obsd_t data[MAXOBS*2];
+    unsigned int tick=tickget();
+    double tickprf;
+    int i,j,n,fobs,match;
+    
+    tracet(4,"processrov: name=%s\n",rov->name);
+    
+    if (!rov->state) return;
+    
+    /* read receiver raw/rtcm data from input stream */
+    if ((n=strread(rov->stream,rov->buff,svr->buffsize))>0) {
+        
+        /* write receiver raw/rtcm data to log stream */
+        strwrite(rov->stream+2,rov->buff,n);
+        rov->nb=n;
+    }
+    /* decode receiver raw/rtcm data */
+    tickprf=prftick();
+    fobs=decoderov(rov);
+    prfadd(rov->rtk.prf+PRF_DECODE,tickprf);
+    
+    obs.data=data;
+    
+    for (i=0;i<fobs;i++) { /* for each rover observation data */
+        obs.n=0;
+        for (j=0;j<rov->obs[i].n&&obs.n<MAXOBS*2;j++) {
+            obs.data[obs.n++]=rov->obs[i].data[j];
+        }
+        /* base observation data time-matched to rover if buffered */
+        base=obs.n>0?selbase(svr,obs.data[0].time,&match):svr->obs[1];
+        
+        for (j=0;j<base->n&&obs.n<MAXOBS*2;j++) {
+            obs.data[obs.n++]=base->data[j];
+        }
+        /* rtk positioning with shared navigation data */
+        lock(&rov->lock);
+        if (rov->prcopt.refpos==4) { /* rtcm */
+            for (j=0;j<6;j++) rov->rtk.rb[j]=svr->rtk.rb[j];
+        }
+        tickprf=prftick();
+        rtkpos(&rov->rtk,obs.data,obs.n,&svr->nav);
+        prfadd(rov->rtk.prf+PRF_RTKPOS,tickprf);
+        unlock(&rov->lock);
+        
+        /* write solution */
+        if (rov->rtk.sol.stat!=SOLQ_NONE) writesolrov(rov);
+    }
+    rov->cputime=(int)(tickget()-tick);
+}
+/* process rovers by worker ---------------------------------------------------*/
+static void processrovs(rtksvr_t *svr)
+{
+    int i;
+    
+    while (svr->wnext<svr->nrov) {
+        i=svr->wnext++;
+        unlock(&svr->wlock);
+        
+        processrov(svr,svr->rov[i]);
+        
+        lock(&svr->wlock);
+        svr->wdone++;
+    }
+}
+/* worker thread for rovers --------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI rtksvrworker(void *arg)
+#else
+static void *rtksvrworker(void *arg)
+#endif
+{
+    rtksvr_t *svr=(rtksvr_t *)arg;
+    int gen=0;
+    
+    tracet(3,"rtksvrworker:\n");
+    
+    lock(&svr->wlock);
+    
+    while (svr->wstate) {
+        
+        /* wait for start of job */
+        if (gen==svr->wgen) {
+            condwait(&svr->wcond,&svr->wlock);
+            continue;
+        }
+        gen=svr->wgen;
+        
+        processrovs(svr);
+        
+        /* notify end of job */
+        if (svr->wdone>=svr->nrov) condbroadcast(&svr->wcond);
+    }
+    unlock(&svr->wlock);
+    return 0;
+}
+/* run rovers ----------------------------------------------------------------*/
+static void runrovs(rtksvr_t *svr)
+{
+    tracet(4,"runrovs: nrov=%d\n",svr->nrov);
+    
+    lock(&svr->wlock);
+    
+    /* start job of workers and process rovers also by server thread */
+    svr->wnext=svr->wdone=0;
+    svr->wgen++;
+    condbroadcast(&svr->wcond);
+    
+    processrovs(svr);
+    
+    /* wait for end of job */
+    while (svr->wdone<svr->nrov) {
+        condwait(&svr->wcond,&svr->wlock);
+    }
+    unlock(&svr->wlock);
+}
+/* start rovers --------------------------------------------------------------*/
+static void startrovs(rtksvr_t *svr)
+{
+    rtkrov_t *rov;
+    gtime_t time;
+    int i,j,rw;
+    
+    tracet(3,"startrovs: nrov=%d\n",svr->nrov);
+    
+    for (i=0;i<svr->nrov;i++) {
+        rov=svr->rov[i];
+        rov->state=rov->nb=rov->nsol=rov->cputime=rov->prcout=0;
+        for (j=0;j<10;j++) rov->nmsg[j]=0;
+        for (j=0;j<MAXOBSBUF;j++) rov->obs[j].n=0;
+        
+        rtkfree(&rov->rtk);
+        rtkinit(&rov->rtk,&rov->prcopt);
+        rov->rtk.rov=i+1;
+        for (j=0;j<6;j++) {
+            rov->rtk.rb[j]=j<3?rov->prcopt.rb[j]:0.0;
+        }
+        if (!(rov->buff=(unsigned char *)malloc(svr->buffsize))) {
+            tracet(1,"startrovs: malloc error\n");
+            continue;
+        }
+        init_raw (&rov->raw);
+        init_rtcm(&rov->rtcm);
+        strcpy(rov->raw .opt,rov->rcvopt);
+        strcpy(rov->rtcm.opt,rov->rcvopt);
+        
+        /* open input/solution/log streams */
+        for (j=0;j<3;j++) {
+            rw=j<1?STR_MODE_R:STR_MODE_W;
+            if (rov->strs[j]!=STR_FILE) rw|=STR_MODE_W;
+            if (!stropen(rov->stream+j,rov->strs[j],rw,rov->paths[j])) break;
+        }
+        if (j<3) {
+            tracet(2,"rover stream open error: name=%s\n",rov->name);
+            for (j--;j>=0;j--) strclose(rov->stream+j);
+            continue;
+        }
+        /* set initial time for rtcm and raw */
+        time=utc2gpst(timeget());
+        if (rov->strs[0]==STR_FILE) time=strgettime(rov->stream);
+        rov->raw.time=rov->rtcm.time=time;
+        
+        /* write start command to input stream */
+        if (rov->cmd) strsendcmd(rov->stream,rov->cmd);
+        
+        /* write solution header to solution stream */
+        writesolhead(rov->stream+1,&rov->solopt);
+        
+        rov->state=1;
+    }
+    /* create worker threads */
+    svr->wstate=1;
+    svr->wgen=0;
+    initlock(&svr->wlock);
+    initcond(&svr->wcond);
+    
+    if (svr->nrov<=0||svr->nworker<=0) return;
+    
+    if (!(svr->worker=(thread_t *)malloc(sizeof(thread_t)*svr->nworker))) {
+        svr->nworker=0;
+        return;
+    }
+    for (i=0;i<svr->nworker;i++) {
+#ifdef WIN32
+        if (!(svr->worker[i]=CreateThread(NULL,0,rtksvrworker,svr,0,NULL))) {
+#else
+        if (pthread_create(svr->worker+i,NULL,rtksvrworker,svr)) {
+#endif
+            tracet(1,"startrovs: worker thread create error\n");
+            break;
+        }
+    }
+    svr->nworker=i;
+}
+/* stop rovers ---------------------------------------------------------------*/
+static void stoprovs(rtksvr_t *svr)
+{
+    rtkrov_t *rov;
+    int i,j;
+    
+    tracet(3,"stoprovs: nrov=%d\n",svr->nrov);
+    
+    /* stop worker threads */
+    lock(&svr->wlock);
+    svr->wstate=0;
+    condbroadcast(&svr->wcond);
+    unlock(&svr->wlock);
+    
+    for (i=0;i<svr->nworker;i++) {
+#ifdef WIN32
+        WaitForSingleObject(svr->worker[i],10000);
+        CloseHandle(svr->worker[i]);
+#else
+        pthread_join(svr->worker[i],NULL);
+#endif
+    }
+    free(svr->worker); svr->worker=NULL;
+    
+    for (i=0;i<svr->nrov;i++) {
+        rov=svr->rov[i];
+        for (j=0;j<3;j++) strclose(rov->stream+j);
+        if (rov->buff) {
+            free_raw (&rov->raw);
+            free_rtcm(&rov->rtcm);
+        }
+        rov->state=rov->nb=0;
+        free(rov->buff); rov->buff=NULL;
+    }
+}
+/* decoder thread ------------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI rtksvrdecoder(void *arg)
+#else
+static void *rtksvrdecoder(void *arg)
+#endif
+{
+    rtksvrdec_t *dec=(rtksvrdec_t *)arg;
+    rtksvr_t *svr=dec->svr;
+    strevt_t evt;
+    unsigned char *p,*q;
+    double tick;
+    int n,index=dec->index;
     
-    tracet(4,"decoderaw: index=%d\n",index);
+    free(dec);
     
-    rtksvrlock(svr);
+    tracet(3,"rtksvrdecoder: index=%d\n",index);
     
-    for (i=0;i<svr->nb[index];i++) {
+    /* wait input data by stream event (or sleep if not pollable) */
+    if (strevtinit(&evt,1)) strevtadd(&evt,svr->stream+index);
+    
+    while (svr->state) {
+        p=svr->buff[index]+svr->nb[index]; q=svr->buff[index]+svr->buffsize;
         
-        /* input rtcm/receiver raw data from stream */
-        if (svr->format[index]==STRFMT_RTCM2) {
-            ret=input_rtcm2(svr->rtcm+index,svr->buff[index][i]);
-            obs=&svr->rtcm[index].obs;
-            nav=&svr->rtcm[index].nav;
-            sat=svr->rtcm[index].ephsat;
+        /* read receiver raw/rtcm data from input stream */
+        if ((n=strread(svr->stream+index,p,q-p))<=0) {
+            strevtwait(&evt,svr->cycle);
+            continue;
         }
-        else if (svr->format[index]==STRFMT_RTCM3) {
-            ret=input_rtcm3(svr->rtcm+index,svr->buff[index][i]);
-            obs=&svr->rtcm[index].obs;
-            nav=&svr->rtcm[index].nav;
-            sat=svr->rtcm[index].ephsat;
+        /* write receiver raw/rtcm data to log stream */
+        strwrite(svr->stream+index+5,p,n);
+        svr->nb[index]+=n;
+        
+        /* save peek buffer */
+        rtksvrlock(svr);
+        n=n<svr->buffsize-svr->npb[index]?n:svr->buffsize-svr->npb[index];
+        memcpy(svr->pbuf[index]+svr->npb[index],p,n);
+        svr->npb[index]+=n;
+        rtksvrunlock(svr);
+        
+        /* update glonass fcn by navigation data */
+        updatefcn(svr,index);
+        
+        tick=prftick();
+        if (svr->format[index]==STRFMT_SP3||svr->format[index]==STRFMT_RNXCLK) {
+            /* decode download file */
+            decodefile(svr,index);
         }
         else {
-            ret=input_raw(svr->raw+index,svr->format[index],svr->buff[index][i]);
-            obs=&svr->raw[index].obs;
-            nav=&svr->raw[index].nav;
-            sat=svr->raw[index].ephsat;
-            sbsmsg=&svr->raw[index].sbsmsg;
-        }
-#if 0 /* record for receiving tick */
-        if (ret==1) {
-            trace(0,"%d %10d T=%s NS=%2d\n",index,tickget(),
-                  time_str(obs->data[0].time,0),obs->n);
-        }
-#endif
-        /* update rtk server */
-        if (ret>0) updatesvr(svr,ret,obs,nav,sat,sbsmsg,index,fobs);
-        
-        /* observation data received */
-        if (ret==1) {
-            if (fobs<MAXOBSBUF) fobs++; else svr->prcout++;
+            /* decode receiver raw/rtcm data */
+            decoderaw(svr,index);
         }
+        prfadd(svr->prf+PRF_DECODE+index,tick);
+        quesignal(svr,0);
     }
-    svr->nb[index]=0;
+    strevtfree(&evt);
+    return 0;
+}
+/* output thread -------------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI rtksvroutput(void *arg)
+#else
+static void *rtksvroutput(void *arg)
+#endif
+{
+    rtksvr_t *svr=(rtksvr_t *)arg;
+    rtksvrout_t *out;
+    unsigned char (*buff)[MAXOUTBATCH];
+    int n[3];
     
-    rtksvrunlock(svr);
+    tracet(3,"rtksvroutput:\n");
     
-    return fobs;
+    if (!(buff=(unsigned char (*)[MAXOUTBATCH])malloc(MAXOUTBATCH*3))) {
+        tracet(1,"rtksvroutput: memory allocation error\n");
+        return 0;
+    }
+    for (;;) {
+        /* batch queued solutions into one write per stream */
+        for (;;) {
+            n[0]=n[1]=n[2]=0;
+            while ((out=(rtksvrout_t *)queptr(svr->que+3))) {
+                if (!addoutbatch(svr,out,buff,n)) break;
+                quepop(svr->que+3,out->tick);
+            }
+            if (n[0]<=0&&n[1]<=0&&n[2]<=0) break;
+            outputsol(svr,buff,n);
+        }
+        if (!svr->state) break;
+        
+        quewait(svr,1,svr->cycle);
+    }
+    free(buff);
+    return 0;
 }
-/* decode download file ------------------------------------------------------*/
-static void decodefile(rtksvr_t *svr, int index)
+/* position rover observation data -------------------------------------------*/
+static void posrov(rtksvr_t *svr, const obs_t *obs, unsigned int tick,
+                   int wait)
 {
-    nav_t nav={0};
-    char file[1024];
-    int nb;
+    const obs_t *base;
+    obsd_t data[MAXOBS*2];
+    double tt,tickprf;
+    int i,n=0,match=0;
     
-    tracet(4,"decodefile: index=%d\n",index);
+    base=obs->n>0?selbase(svr,obs->data[0].time,&match):svr->obs[1];
+    svr->nalign[match?(wait?1:0):2]++;
     
+    for (i=0;i<obs->n&&n<MAXOBS*2;i++) {
+        data[n++]=obs->data[i];
+    }
+    for (i=0;i<base->n&&n<MAXOBS*2;i++) {
+        data[n++]=base->data[i];
+    }
+    /* rtk positioning */
     rtksvrlock(svr);
+    tickprf=prftick();
+    rtkpos(&svr->rtk,data,n,&svr->nav);
+    prfadd(svr->rtk.prf+PRF_RTKPOS,tickprf);
+    rtksvrunlock(svr);
     
-    /* check file path completed */
-    if ((nb=svr->nb[index])<=2||
-        svr->buff[index][nb-2]!='\r'||svr->buff[index][nb-1]!='\n') {
-        rtksvrunlock(svr);
-        return;
+    if (svr->rtk.sol.stat!=SOLQ_NONE) {
+        
+        /* adjust current time */
+        tt=(int)(tickget()-tick)/1000.0+DTTOL;
+        timeset(gpst2utc(timeadd(svr->rtk.sol.time,tt)));
+        
+        /* write solution */
+        writesol(svr,tick);
     }
-    strncpy(file,(char *)svr->buff[index],nb-2); file[nb-2]='\0';
-    svr->nb[index]=0;
+}
+/* add rover observation data waiting time-matched base ----------------------*/
+static void addrov(rtksvr_t *svr, unsigned int tick)
+{
+    obs_t *obs;
+    int i,j;
     
-    rtksvrunlock(svr);
+    if (svr->nrobs>=MAXOBSALN) { /* buffer full */
+        posrov(svr,svr->robs+svr->irobs,svr->rtick[svr->irobs],
+               svr->rwait[svr->irobs]);
+        svr->irobs=(svr->irobs+1)%MAXOBSALN;
+        svr->nrobs--;
+    }
+    i=(svr->irobs+svr->nrobs++)%MAXOBSALN;
+    obs=svr->robs+i;
+    for (j=0;j<svr->obs[0][0].n;j++) obs->data[j]=svr->obs[0][0].data[j];
+    obs->n=svr->obs[0][0].n;
+    svr->rtick[i]=tick;
+    svr->rwait[i]=0;
+}
+/* position rover observation data aligned to base ---------------------------*/
+static void alignrov(rtksvr_t *svr)
+{
+    const obs_t *obs;
+    unsigned int tick;
+    int i,match;
     
-    if (svr->format[index]==STRFMT_SP3) { /* precise ephemeris */
+    while (svr->nrobs>0) {
+        i=svr->irobs;
+        obs=svr->robs+i;
+        tick=svr->rtick[i];
         
-        /* read sp3 precise ephemeris */
-        readsp3(file,&nav,0);
-        if (nav.ne<=0) {
-            tracet(1,"sp3 file read error: %s\n",file);
-            return;
+        /* wait for time-matched base within wait time */
+        if (obs->n>0&&svr->basewait>0&&(int)(tickget()-tick)<svr->basewait) {
+            selbase(svr,obs->data[0].time,&match);
+            if (!match&&expbase(svr,obs->data[0].time)) {
+                svr->rwait[i]=1;
+                break;
+            }
         }
-        /* update precise ephemeris */
-        rtksvrlock(svr);
-        
-        if (svr->nav.peph) free(svr->nav.peph);
-        svr->nav.ne=svr->nav.nemax=nav.ne;
-        svr->nav.peph=nav.peph;
-        svr->ftime[index]=utc2gpst(timeget());
-        strcpy(svr->files[index],file);
-        
-        rtksvrunlock(svr);
+        posrov(svr,obs,tick,svr->rwait[i]);
+        svr->irobs=(svr->irobs+1)%MAXOBSALN;
+        svr->nrobs--;
     }
-    else if (svr->format[index]==STRFMT_RNXCLK) { /* precise clock */
+}
+/* process input events ------------------------------------------------------*/
+static int procevents(rtksvr_t *svr, int index)
+{
+    rtksvrev_t *ev;
+    double tick;
+    int n=0;
+    
+    while ((ev=(rtksvrev_t *)queptr(svr->que+index))) {
         
-        /* read rinex clock */
-        if (readrnxc(file,&nav)<=0) {
-            tracet(1,"rinex clock file read error: %s\n",file);
-            return;
-        }
-        /* update precise clock */
+        /* update rtk server by input event */
         rtksvrlock(svr);
+        tick=prftick();
+        updatesvr(svr,ev,index);
+        prfadd(svr->prf+PRF_UPDATE,tick);
+        rtksvrunlock(svr);
         
-        if (svr->nav.pclk) free(svr->nav.pclk);
-        svr->nav.nc=svr->nav.ncmax=nav.nc;
-        svr->nav.pclk=nav.pclk;
-        svr->ftime[index]=utc2gpst(timeget());
-        strcpy(svr->files[index],file);
+        /* sbas corrections updated without lock (server thread only) */
+        if (ev->type==3) applysbsmsg(svr,&ev->u.sbsmsg);
         
-        rtksvrunlock(svr);
+        /* rtk positioning for rover observation data aligned to base */
+        if (ev->type==1&&index<=1) {
+            if (index==0) addrov(svr,ev->tick); else addbase(svr);
+            alignrov(svr);
+        }
+        
+        quepop(svr->que+index,ev->tick);
+        n++;
+    }
+    return n;
+}
+/* free pending input events -------------------------------------------------*/
+static void freeevents(rtksvr_t *svr, int index)
+{
+    rtksvrev_t *ev;
+    
+    while ((ev=(rtksvrev_t *)queptr(svr->que+index))) {
+        if (ev->type==EV_SP3   ) free(ev->u.prod.peph);
+        if (ev->type==EV_RNXCLK) free(ev->u.prod.pclk);
+        quepop(svr->que+index,ev->tick);
+    }
+}
+/* start decoder and output threads ------------------------------------------*/
+static void startthreads(rtksvr_t *svr)
+{
+    rtksvrdec_t *dec;
+    int i;
+    
+    for (i=0;i<3;i++) {
+        if (!(dec=(rtksvrdec_t *)malloc(sizeof(rtksvrdec_t)))) {
+            tracet(1,"startthreads: malloc error\n");
+            svr->dthread[i]=0;
+            continue;
+        }
+        dec->svr=svr;
+        dec->index=i;
+#ifdef WIN32
+        if (!(svr->dthread[i]=CreateThread(NULL,0,rtksvrdecoder,dec,0,NULL))) {
+#else
+        if (pthread_create(svr->dthread+i,NULL,rtksvrdecoder,dec)) {
+#endif
+            tracet(1,"startthreads: decoder thread create error\n");
+            svr->dthread[i]=0;
+            free(dec);
+        }
+    }
+#ifdef WIN32
+    if (!(svr->othread=CreateThread(NULL,0,rtksvroutput,svr,0,NULL))) {
+#else
+    if (pthread_create(&svr->othread,NULL,rtksvroutput,svr)) {
+#endif
+        tracet(1,"startthreads: output thread create error\n");
+        svr->othread=0;
+    }
+}
+/* stop decoder and output threads -------------------------------------------*/
+static void stopthreads(rtksvr_t *svr)
+{
+    int i;
+    
+    quesignal(svr,1);
+    
+    for (i=0;i<3;i++) {
+        if (!svr->dthread[i]) continue;
+#ifdef WIN32
+        WaitForSingleObject(svr->dthread[i],10000);
+        CloseHandle(svr->dthread[i]);
+#else
+        pthread_join(svr->dthread[i],NULL);
+#endif
+        svr->dthread[i]=0;
+    }
+    if (svr->othread) {
+#ifdef WIN32
+        WaitForSingleObject(svr->othread,10000);
+        CloseHandle(svr->othread);
+#else
+        pthread_join(svr->othread,NULL);
+#endif
+        svr->othread=0;
     }
+    for (i=0;i<3;i++) freeevents(svr,i);
+}
+/* output stage timing profile to monitor port ------------------------------*/
+static void writeprf(rtksvr_t *svr)
+{
+    prfstat_t prf[NPRF];
+    unsigned char buff[MAXPRFMSG];
+    int n;
+    
+    tracet(4,"writeprf:\n");
+    
+    if (!svr->moni) return;
+    
+    rtksvrprf(svr,prf,0);
+    if ((n=prfouts(buff,prf,1))>0) strwrite(svr->moni,buff,n);
+}
+/* save rtk filter state to checkpoint ---------------------------------------*/
+static void saveckpt(rtksvr_t *svr, gtime_t *time)
+{
+    tracet(4,"saveckpt: file=%s\n",svr->ckptfile);
+    
+    if (!*svr->ckptfile||svr->rtk.sol.time.time==0||
+        timediff(svr->rtk.sol.time,*time)<=0.0) return;
+    
+    if (rtksave(&svr->rtk,svr->ckptfile)) *time=svr->rtk.sol.time;
 }
 /* rtk server thread ---------------------------------------------------------*/
 #ifdef WIN32
@@ -379,84 +1414,64 @@ static void *rtksvrthread(void *arg)
 #endif
 {
     rtksvr_t *svr=(rtksvr_t *)arg;
-    obs_t obs;
-    obsd_t data[MAXOBS*2];
-    double tt;
-    unsigned int tick,ticknmea;
-    unsigned char *p,*q;
-    int i,j,n,fobs[3]={0},cycle,cputime;
+    unsigned int tick,tickcyc,ticksol,ticknmea,tickprf,tickckpt;
+    gtime_t tckpt;
+    double tickc;
+    int i,n,cputime;
     
     tracet(3,"rtksvrthread:\n");
     
-    svr->state=1; obs.data=data;
+    svr->state=1;
     svr->tick=tickget();
+    tickcyc=ticksol=tickprf=tickckpt=svr->tick;
+    tckpt=svr->rtk.sol.time;
     ticknmea=svr->tick-1000;
     
-    for (cycle=0;svr->state;cycle++) {
+    /* start rovers and worker threads */
+    startrovs(svr);
+    
+    /* start decoder and output threads */
+    startthreads(svr);
+    
+    while (svr->state) {
         tick=tickget();
+        tickc=prftick();
         
-        for (i=0;i<3;i++) {
-            p=svr->buff[i]+svr->nb[i]; q=svr->buff[i]+svr->buffsize;
-            
-            /* read receiver raw/rtcm data from input stream */
-            if ((n=strread(svr->stream+i,p,q-p))<=0) {
-                continue;
-            }
-            /* write receiver raw/rtcm data to log stream */
-            strwrite(svr->stream+i+5,p,n);
-            svr->nb[i]+=n;
-            
-            /* save peek buffer */
-            rtksvrlock(svr);
-            n=n<svr->buffsize-svr->npb[i]?n:svr->buffsize-svr->npb[i];
-            memcpy(svr->pbuf[i]+svr->npb[i],p,n);
-            svr->npb[i]+=n;
-            rtksvrunlock(svr);
-        }
-        for (i=0;i<3;i++) {
-            if (svr->format[i]==STRFMT_SP3||svr->format[i]==STRFMT_RNXCLK) {
-                /* decode download file */
-                decodefile(svr,i);
-            }
-            else {
-                /* decode receiver raw/rtcm data */
-                fobs[i]=decoderaw(svr,i);
-            }
+        /* process base/correction events and rover events */
+        for (i=2,n=0;i>=0;i--) {
+            n+=procevents(svr,i);
         }
-        for (i=0;i<fobs[0];i++) { /* for each rover observation data */
-            obs.n=0;
-            for (j=0;j<svr->obs[0][i].n&&obs.n<MAXOBS*2;j++) {
-                obs.data[obs.n++]=svr->obs[0][i].data[j];
-            }
-            for (j=0;j<svr->obs[1][0].n&&obs.n<MAXOBS*2;j++) {
-                obs.data[obs.n++]=svr->obs[1][0].data[j];
-            }
-            /* rtk positioning */
-            rtksvrlock(svr);
-            rtkpos(&svr->rtk,obs.data,obs.n,&svr->nav);
-            rtksvrunlock(svr);
+        /* rover observation data exceeding wait time for base */
+        alignrov(svr);
+        
+        if ((int)(tick-tickcyc)>=svr->cycle) {
+            tickcyc=tick;
             
-            if (svr->rtk.sol.stat!=SOLQ_NONE) {
-                
-                /* adjust current time */
-                tt=(int)(tickget()-tick)/1000.0+DTTOL;
-                timeset(gpst2utc(timeadd(svr->rtk.sol.time,tt)));
-                
-                /* write solution */
-                writesol(svr,i);
-            }
-            /* if cpu overload, inclement obs outage counter and break */
-            if ((int)(tickget()-tick)>=svr->cycle) {
-                svr->prcout+=fobs[0]-i-1;
-#if 0 /* omitted v.2.4.1 */
-                break;
-#endif
+            /* rtk positioning of rovers with shared base/correction */
+            if (svr->nrov>0) {
+                runrovs(svr);
+                n++;
             }
         }
+        /* stage timing profile of cycle with input events or rovers */
+        if (n>0) prfadd(svr->prf+PRF_CYCLE,tickc);
+        
+        /* output stage timing profile to monitor port */
+        if (svr->prfcycle>0&&(int)(tick-tickprf)>=svr->prfcycle) {
+            writeprf(svr);
+            tickprf=tick;
+        }
+        /* autosave rtk filter state to checkpoint */
+        if (svr->ckptcycle>0&&(int)(tick-tickckpt)>=svr->ckptcycle) {
+            saveckpt(svr,&tckpt);
+            tickckpt=tick;
+        }
         /* send null solution if no solution (1hz) */
-        if (svr->rtk.sol.stat==SOLQ_NONE&&cycle%(1000/svr->cycle)==0) {
-            writesol(svr,0);
+        if ((int)(tick-ticksol)>=1000) {
+            if (svr->rtk.sol.stat==SOLQ_NONE) writesol(svr,tick);
+            ticksol=tick;
         }
+        
         /* send nmea request to base/nrtk input stream */
         if (svr->nmeacycle>0&&(int)(tick-ticknmea)>=svr->nmeacycle) {
             if (svr->stream[1].state==1) {
@@ -471,9 +1486,20 @@ static void *rtksvrthread(void *arg)
         }
         if ((cputime=(int)(tickget()-tick))>0) svr->cputime=cputime;
         
-        /* sleep until next cycle */
-        sleepms(svr->cycle-cputime);
+        /* wait for input events until next cycle */
+        if (n<=0) {
+            quewait(svr,0,svr->cycle-(int)(tickget()-tickcyc));
+        }
     }
+    /* save rtk filter state at stop */
+    saveckpt(svr,&tckpt);
+    
+    /* stop decoder and output threads */
+    stopthreads(svr);
+    
+    /* stop rovers and worker threads */
+    stoprovs(svr);
+    
     for (i=0;i<MAXSTRRTK;i++) strclose(svr->stream+i);
     for (i=0;i<3;i++) {
         svr->nb[i]=svr->npb[i]=0;
@@ -486,6 +1512,7 @@ static void *rtksvrthread(void *arg)
         svr->nsb[i]=0;
         free(svr->sbuf[i]); svr->sbuf[i]=NULL;
     }
+    for (i=0;i<4;i++) quefree(svr->que+i);
     return 0;
 }
 /* initialize rtk server -------------------------------------------------------
@@ -525,6 +1552,25 @@ extern int rtksvrinit(rtksvr_t *svr)
     svr->tick=0;
     svr->thread=0;
     svr->cputime=svr->prcout=0;
+    svr->nrov=svr->nrovmax=svr->nworker=0;
+    svr->rov=NULL;
+    svr->worker=NULL;
+    svr->wstate=svr->wgen=svr->wnext=svr->wdone=0;
+    for (i=0;i<3;i++) svr->dthread[i]=0;
+    svr->othread=0;
+    memset(svr->que,0,sizeof(svr->que));
+    svr->basewait=0;
+    svr->nbobs=svr->ibobs=svr->nrobs=svr->irobs=0;
+    for (i=0;i<3;i++) svr->nalign[i]=0;
+    svr->sbsmsg=NULL;
+    svr->nsbsmax=MAXSBSMSG;
+    svr->sbssize=0;
+    svr->sbsw=0;
+    memset(svr->sbsidx,0,sizeof(svr->sbsidx));
+    memset(svr->prf,0,sizeof(svr->prf));
+    svr->prfcycle=0;
+    svr->ckptfile[0]='\0';
+    svr->ckptcycle=0;
     
     if (!(svr->nav.eph =(eph_t  *)malloc(sizeof(eph_t )*MAXSAT *2))||
         !(svr->nav.geph=(geph_t *)malloc(sizeof(geph_t)*NSATGLO*2))||
@@ -545,6 +1591,13 @@ extern int rtksvrinit(rtksvr_t *svr)
             return 0;
         }
     }
+    for (i=0;i<MAXOBSALN;i++) {
+        if (!(svr->bobs[i].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))||
+            !(svr->robs[i].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) {
+            tracet(1,"rtksvrinit: malloc error\n");
+            return 0;
+        }
+    }
     for (i=0;i<3;i++) {
         memset(svr->raw +i,0,sizeof(raw_t ));
         memset(svr->rtcm+i,0,sizeof(rtcm_t));
@@ -552,6 +1605,9 @@ extern int rtksvrinit(rtksvr_t *svr)
     for (i=0;i<MAXSTRRTK;i++) strinit(svr->stream+i);
     
     initlock(&svr->lock);
+    initlock(&svr->qlock);
+    initcond(svr->qcond  );
+    initcond(svr->qcond+1);
     
     return 1;
 }
@@ -570,6 +1626,13 @@ extern void rtksvrfree(rtksvr_t *svr)
     for (i=0;i<3;i++) for (j=0;j<MAXOBSBUF;j++) {
         free(svr->obs[i][j].data);
     }
+    for (i=0;i<MAXOBSALN;i++) {
+        free(svr->bobs[i].data);
+        free(svr->robs[i].data);
+    }
+    free(svr->sbsmsg); svr->sbsmsg=NULL;
+    svr->sbssize=svr->nsbs=0;
+    rtksvrfreerov(svr);
 }
 /* lock/unlock rtk server ------------------------------------------------------
 * lock/unlock rtk server
@@ -617,6 +1680,28 @@ extern void rtksvrunlock(rtksvr_t *svr) {unlock(&svr->lock);}
 *                              solopt[1]=solution 2 options
 *          stream_t *moni   I  monitor stream (NULL: not used)
 * return : status (1:ok 0:error)
+* notes  : input streams are read and decoded by decoder threads per stream.
+*          decoded data are passed to the server thread via event queues
+*          (svr->que[0-2]) and solutions to the output thread via output queue
+*          (svr->que[3]). navigation data (svr->nav) are updated only by the
+*          server thread.
+*          rover observation data are paired with the time-matched base
+*          observation data in the buffer (svr->bobs). if not yet received,
+*          the rover waits up to svr->basewait (ms) and then is processed with
+*          the previous base epoch (extrapolated if prcopt->intpref set). set
+*          svr->basewait before rtksvrstart() (0: no wait).
+*          sbas messages of all geo satellites are kept in the ring buffer
+*          (svr->sbsmsg) of depth svr->nsbsmax (set before rtksvrstart()). the
+*          buffer is kept over restart of the server unless the depth is
+*          changed and the buffered messages of the selected satellite are
+*          replayed to the sbas corrections at the start.
+*          stage timing profiles (svr->prf, svr->rtk.prf) are reset at the
+*          start and output to the monitor stream every svr->prfcycle (ms) as
+*          $PRF messages if profiling is enabled by prfenable() (0: no output).
+*          if svr->ckptfile is set before rtksvrstart(), the filter state
+*          (svr->rtk) is restored from the checkpoint file by rtkload() at the
+*          start and saved by rtksave() every svr->ckptcycle (ms) (0: no
+*          autosave) and at the stop of the server.
 *-----------------------------------------------------------------------------*/
 extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
                        char **paths, int *formats, int navsel, char **cmds,
@@ -640,11 +1725,16 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     svr->buffsize=buffsize>4096?buffsize:4096;
     for (i=0;i<3;i++) svr->format[i]=formats[i];
     svr->navsel=navsel;
-    svr->nsbs=0;
     svr->nsol=0;
     svr->prcout=0;
     rtkfree(&svr->rtk);
     rtkinit(&svr->rtk,prcopt);
+    memset(svr->prf,0,sizeof(svr->prf));
+    
+    /* restore rtk filter state from checkpoint */
+    if (*svr->ckptfile&&rtkload(&svr->rtk,svr->ckptfile,utc2gpst(timeget()))) {
+        tracet(2,"rtksvrstart: restart from checkpoint %s\n",svr->ckptfile);
+    }
     
     for (i=0;i<3;i++) { /* input/log streams */
         svr->nb[i]=svr->npb[i]=0;
@@ -664,8 +1754,18 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
         strcpy(svr->raw [i].opt,rcvopts[i]);
         strcpy(svr->rtcm[i].opt,rcvopts[i]);
         
-        /* connect dgps corrections */
-        svr->rtcm[i].dgps=svr->nav.dgps;
+        /* connect dgps corrections (posted as input events) */
+        svr->rtcm[i].dgps=svr->rtcm[i].nav.dgps;
+    }
+    svr->nbobs=svr->ibobs=svr->nrobs=svr->irobs=0;
+    for (i=0;i<3;i++) svr->nalign[i]=0;
+    
+    for (i=0;i<4;i++) { /* input event and output queues */
+        if (!queinit(svr->que+i,i<3?MAXQUEIN:MAXQUEOUT,
+                     i<3?sizeof(rtksvrev_t):sizeof(rtksvrout_t))) {
+            tracet(1,"rtksvrstart: malloc error\n");
+            return 0;
+        }
     }
     for (i=0;i<2;i++) { /* output peek buffer */
         if (!(svr->sbuf[i]=(unsigned char *)malloc(buffsize))) {
@@ -687,6 +1787,19 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     for (i=0;i<NSATSBS*2;i++) svr->nav.seph[i].tof=time0;
     updatenav(&svr->nav);
     
+    /* initialize glonass fcn table by navigation data */
+    for (i=0;i<3;i++) svr->fcnvers[i]=0;
+    svr->fcnver=1;
+    for (i=0;i<MAXPRNGLO&&i<svr->nav.ng;i++) {
+        if (svr->nav.geph[i].sat!=satno(SYS_GLO,i+1)) continue;
+        setfcn(svr,i+1,svr->nav.geph[i].frq);
+    }
+    /* initialize sbas message buffer and replay buffered messages */
+    if (!initsbsbuf(svr)) {
+        tracet(1,"rtksvrstart: malloc error\n");
+        return 0;
+    }
+    
     /* set monitor stream */
     svr->moni=moni;
     
@@ -696,6 +1809,7 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
         if (strs[i]!=STR_FILE) rw|=STR_MODE_W;
         if (!stropen(svr->stream+i,strs[i],rw,paths[i])) {
             for (i--;i>=0;i--) strclose(svr->stream+i);
+            for (j=0;j<4;j++) quefree(svr->que+j);
             return 0;
         }
         /* set initial time for rtcm and raw */
@@ -724,6 +1838,7 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     if (pthread_create(&svr->thread,NULL,rtksvrthread,svr)) {
 #endif
         for (i=0;i<MAXSTRRTK;i++) strclose(svr->stream+i);
+        for (i=0;i<4;i++) quefree(svr->que+i);
         return 0;
     }
     return 1;
@@ -752,6 +1867,7 @@ extern void rtksvrstop(rtksvr_t *svr, char **cmds)
     
     /* stop rtk server */
     svr->state=0;
+    quesignal(svr,0);
     
     /* free rtk server thread */
 #ifdef WIN32
@@ -883,3 +1999,197 @@ extern void rtksvrsstat(rtksvr_t *svr, int *sstat, char *msg)
     }
     rtksvrunlock(svr);
 }
+/* get sbas messages -----------------------------------------------------------
+* get latest sbas messages in the buffer of rtk server
+* args   : rtksvr_t *svr    I  rtk server
+*          sbsmsg_t *msgs   O  sbas messages (oldest first)
+*          int     nmax     I  max number of sbas messages
+* return : number of sbas messages
+* notes  : the buffer is read without lock of rtk server. messages overwritten
+*          by the server thread during copy are discarded.
+*-----------------------------------------------------------------------------*/
+extern int rtksvrsbsmsg(rtksvr_t *svr, sbsmsg_t *msgs, int nmax)
+{
+    unsigned int no;
+    int i,n,m,size=svr->sbssize;
+    
+    tracet(4,"rtksvrsbsmsg: nmax=%d\n",nmax);
+    
+    if (size<=0||nmax<=0) return 0;
+    
+    no=svr->sbsw;
+    MEMBAR();
+    n=no<(unsigned int)size?(int)no:size;
+    if (n>nmax) n=nmax;
+    for (i=0;i<n;i++) msgs[i]=svr->sbsmsg[(no-n+i)%size];
+    MEMBAR();
+    
+    /* discard messages overwritten during copy */
+    if ((m=(int)(svr->sbsw-no)+1-size+n)>0) {
+        for (i=0;i<n-m;i++) msgs[i]=msgs[i+m];
+        n=m<n?n-m:0;
+    }
+    return n;
+}
+/* get latest sbas message by prn and type -------------------------------------
+* get latest sbas message of a satellite and a message type in the buffer of
+* rtk server
+* args   : rtksvr_t *svr    I  rtk server
+*          int     prn      I  sbas satellite prn number
+*          int     type     I  sbas message type (0-63)
+*          sbsmsg_t *msg    O  sbas message
+* return : status (1:ok,0:no message)
+* notes  : the buffer is read without lock of rtk server
+*-----------------------------------------------------------------------------*/
+extern int rtksvrsbslast(rtksvr_t *svr, int prn, int type, sbsmsg_t *msg)
+{
+    unsigned int no;
+    int size=svr->sbssize;
+    
+    tracet(4,"rtksvrsbslast: prn=%d type=%d\n",prn,type);
+    
+    if (size<=0||prn<MINPRNSBS||MAXPRNSBS<prn||type<0||63<type) return 0;
+    
+    if (!(no=svr->sbsidx[prn-MINPRNSBS][type])) return 0;
+    MEMBAR();
+    *msg=svr->sbsmsg[(no-1)%size];
+    MEMBAR();
+    
+    /* message overwritten during copy */
+    if ((int)(svr->sbsw-no)>=size-1) return 0;
+    
+    return msg->prn==prn&&(int)getbitu(msg->msg,8,6)==type;
+}
+/* get stage timing profile of rtk server -------------------------------------
+* get stage timing profile of rtk server
+* args   : rtksvr_t *svr    IO rtk server
+*          prfstat_t *prf   O  stage timing profiles (NPRF)
+*                              (sum of server, rtk control and rovers)
+*          int    reset     I  reset profiles after get (0:no,1:yes)
+* return : none
+* notes  : profiles are sampled if enabled by prfenable(). the profiles of
+*          decoder and worker threads are read without stopping the threads.
+*-----------------------------------------------------------------------------*/
+extern void rtksvrprf(rtksvr_t *svr, prfstat_t *prf, int reset)
+{
+    int i;
+    
+    tracet(4,"rtksvrprf: reset=%d\n",reset);
+    
+    rtksvrlock(svr);
+    memcpy(prf,svr->prf,sizeof(prfstat_t)*NPRF);
+    prfsum(prf,svr->rtk.prf,NPRF);
+    if (reset) {
+        memset(svr->prf,0,sizeof(svr->prf));
+        memset(svr->rtk.prf,0,sizeof(svr->rtk.prf));
+    }
+    for (i=0;i<svr->nrov;i++) {
+        lock(&svr->rov[i]->lock);
+        prfsum(prf,svr->rov[i]->rtk.prf,NPRF);
+        if (reset) memset(svr->rov[i]->rtk.prf,0,sizeof(svr->rov[i]->rtk.prf));
+        unlock(&svr->rov[i]->lock);
+    }
+    rtksvrunlock(svr);
+}
+/* add rover -------------------------------------------------------------------
+* add rover sharing base station and correction streams of rtk server
+* args   : rtksvr_t *svr    IO rtk server
+*          char    *name    I  rover name
+*          int     *strs    I  stream types (STR_???)
+*                              strs[0]=input stream rover
+*                              strs[1]=output stream solution
+*                              strs[2]=log stream rover
+*          char    **paths  I  stream paths
+*          int     format   I  input stream format (STRFMT_???)
+*          char    *rcvopt  I  receiver option
+*          char    *cmd     I  input stream start command (NULL: no command)
+*          prcopt_t *prcopt I  rtk processing options
+*          solopt_t *solopt I  solution options
+* return : status (1:ok 0:error)
+* notes  : rovers should be added before rtksvrstart() and are started and
+*          stopped with the rtk server.
+*          the observation data of a rover are processed with the time-matched
+*          or latest base station observation data and the navigation data of
+*          the rtk server.
+*          the navigation data in the rover input stream are not used.
+*          the rovers are processed by the rtk server thread and svr->nworker
+*          worker threads in each server cycle after the base station and
+*          correction streams are decoded. set svr->nworker before
+*          rtksvrstart() (0: rovers processed only by the rtk server thread).
+*-----------------------------------------------------------------------------*/
+extern int rtksvraddrov(rtksvr_t *svr, const char *name, const int *strs,
+                        char **paths, int format, const char *rcvopt,
+                        const char *cmd, const prcopt_t *prcopt,
+                        const solopt_t *solopt)
+{
+    rtkrov_t *rov,**rov_p;
+    int i,j;
+    
+    tracet(3,"rtksvraddrov: name=%s format=%d\n",name,format);
+    
+    if (svr->state) return 0;
+    
+    if (svr->nrov>=svr->nrovmax) {
+        svr->nrovmax=svr->nrovmax<=0?16:svr->nrovmax*2;
+        if (!(rov_p=(rtkrov_t **)realloc(svr->rov,sizeof(rtkrov_t *)*
+                                         svr->nrovmax))) {
+            tracet(1,"rtksvraddrov: malloc error\n");
+            svr->nrovmax/=2;
+            return 0;
+        }
+        svr->rov=rov_p;
+    }
+    if (!(rov=(rtkrov_t *)calloc(1,sizeof(rtkrov_t)))) {
+        tracet(1,"rtksvraddrov: malloc error\n");
+        return 0;
+    }
+    for (i=0;i<MAXOBSBUF;i++) {
+        if (!(rov->obs[i].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) {
+            tracet(1,"rtksvraddrov: malloc error\n");
+            for (j=0;j<i;j++) free(rov->obs[j].data);
+            free(rov);
+            return 0;
+        }
+    }
+    if (cmd&&*cmd&&(rov->cmd=(char *)malloc(strlen(cmd)+1))) {
+        strcpy(rov->cmd,cmd);
+    }
+    strncpy(rov->name,name,31);
+    strncpy(rov->rcvopt,rcvopt,255);
+    rov->format=format;
+    for (i=0;i<3;i++) {
+        rov->strs[i]=strs[i];
+        strncpy(rov->paths[i],paths[i],MAXSTRPATH-1);
+        strinit(rov->stream+i);
+    }
+    rov->prcopt=*prcopt;
+    rov->solopt=*solopt;
+    rtkinit(&rov->rtk,prcopt);
+    initlock(&rov->lock);
+    
+    svr->rov[svr->nrov++]=rov;
+    return 1;
+}
+/* free rovers -----------------------------------------------------------------
+* free all rovers of rtk server
+* args   : rtksvr_t *svr    IO rtk server
+* return : none
+* notes  : the rtk server should be stopped
+*-----------------------------------------------------------------------------*/
+extern void rtksvrfreerov(rtksvr_t *svr)
+{
+    int i,j;
+    
+    tracet(3,"rtksvrfreerov: nrov=%d\n",svr->nrov);
+    
+    if (svr->state) return;
+    
+    for (i=0;i<svr->nrov;i++) {
+        rtkfree(&svr->rov[i]->rtk);
+        for (j=0;j<MAXOBSBUF;j++) free(svr->rov[i]->obs[j].data);
+        free(svr->rov[i]->cmd);
+        free(svr->rov[i]);
+    }
+    free(svr->rov); svr->rov=NULL;
+    svr->nrov=svr->nrovmax=0;
+}
@@ -39,6 +39,14 @@
 *           2013/09/01  1.12 fix bug on presentation of nmea time tag
 *           2015/02/11  1.13 fix bug on checksum of $GLGSA and $GAGSA
 *                            fix bug on satellite id of $GAGSA
+*           2026/10/18  1.14 add binary solution record format (SOLF_BIN)
+*                            add api outsolbins(),outsolbinexs()
+*                            support binary solution records in inputsol(),
+*                            readsolt()
+*           2026/10/18  1.15 read solution in time window by time index file
+*                            add api opensoltix(),closesoltix(),outsoltix()
+*                            skip sort of solutions if already ordered
+*           2026/10/18  1.16 read ref pos in header before seek by tix
 *-----------------------------------------------------------------------------*/
 #include <ctype.h>
 #include "rtklib.h"
@@ -55,6 +63,30 @@ static const char rcsid[]="$Id: solution.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $
 
 #define KNOT2M     0.514444444  /* m/knot */
 
+#define SOLB_PREAMB1 0xA5       /* binary solution record preamble 1 */
+#define SOLB_PREAMB2 0x53       /* binary solution record preamble 2 */
+#define SOLB_SOL   1            /* binary record type: solution */
+#define SOLB_SAT   2            /* binary record type: satellite block */
+#define SOLB_HLEN  5            /* binary record header length (bytes) */
+#define SOLB_LSOL  168          /* binary solution payload length (bytes) */
+#define SOLB_LSATH 16           /* binary satellite block header length */
+#define SOLB_LSAT  20           /* binary satellite block length per sat */
+#define SOLB_MAXSAT 64          /* max number of sats in satellite block */
+
+#define TIXEXT     ".tix"       /* time index file extension */
+#define TIXINTV    1.0          /* time index record interval (s) */
+#define TIXLEN     16           /* time index record length (bytes) */
+
+/* get/set fields (little-endian) --------------------------------------------*/
+static unsigned short U2(const unsigned char *p) {unsigned short u; memcpy(&u,p,2); return u;}
+static unsigned int   U4(const unsigned char *p) {unsigned int   u; memcpy(&u,p,4); return u;}
+static float          R4(const unsigned char *p) {float          r; memcpy(&r,p,4); return r;}
+static double         R8(const unsigned char *p) {double         r; memcpy(&r,p,8); return r;}
+static void setU2(unsigned char *p, unsigned short u) {memcpy(p,&u,2);}
+static void setU4(unsigned char *p, unsigned int   u) {memcpy(p,&u,4);}
+static void setR4(unsigned char *p, float          r) {memcpy(p,&r,4);}
+static void setR8(unsigned char *p, double         r) {memcpy(p,&r,8);}
+
 static const int solq_nmea[]={  /* nmea quality flags to rtklib sol quality */
     /* nmea 0183 v.2.3 quality flags: */
     /*  0=invalid, 1=gps fix (sps), 2=dgps fix, 3=pps fix, 4=rtk, 5=float rtk */
@@ -568,6 +600,83 @@ static void readsolopt(FILE *fp, solopt_t *opt)
         decode_solopt(buff,opt);
     }
 }
+/* read reference position in header -----------------------------------------*/
+static void readsolrefpos(FILE *fp, const solopt_t *opt, double *rb)
+{
+    char buff[MAXSOLMSG+1];
+    sol_t sol={{0}};
+    int i;
+    
+    trace(3,"readsolrefpos:\n");
+    
+    for (i=0;fgets(buff,sizeof(buff),fp)&&i<100;i++) { /* only 100 lines */
+        if (strncmp(buff,COMMENTH,1)) continue;
+        
+        /* decode reference position in comment line */
+        decode_sol(buff,opt,&sol,rb);
+    }
+}
+/* decode binary solution record --------------------------------------------*/
+static int decode_solbin(const unsigned char *buff, int len, sol_t *sol,
+                         double *rb)
+{
+    const unsigned char *p=buff+SOLB_HLEN;
+    int i;
+    
+    trace(4,"decode_solbin: type=%d len=%d\n",buff[2],len);
+    
+    if (crc32(buff,len-4)!=U4(buff+len-4)) {
+        trace(2,"binary solution crc error: len=%d\n",len);
+        return 0;
+    }
+    if (buff[2]!=SOLB_SOL) return 0; /* satellite block is skipped */
+    
+    if (len-SOLB_HLEN-4<SOLB_LSOL) {
+        trace(2,"binary solution length error: len=%d\n",len);
+        return 0;
+    }
+    sol->time.time=(time_t)U4(p);
+    sol->time.sec=R8(p+4);
+    for (i=0;i<6;i++) sol->rr [i]=R8(p+ 12+i*8);
+    for (i=0;i<6;i++) sol->qr [i]=R4(p+ 60+i*4);
+    for (i=0;i<6;i++) sol->dtr[i]=R8(p+ 84+i*8);
+    for (i=0;i<3;i++) rb[i]=R8(p+132+i*8);
+    sol->type =p[156];
+    sol->stat =p[157];
+    sol->ns   =p[158];
+    sol->age  =R4(p+160);
+    sol->ratio=R4(p+164);
+    return 1;
+}
+/* input binary solution record ----------------------------------------------*/
+static int inputsolbin(unsigned char data, sol_t *sol, solbuf_t *solbuf)
+{
+    double rb[3]={0};
+    int len,stat;
+    
+    solbuf->buff[solbuf->nb++]=data;
+    
+    if (solbuf->nb==2&&data!=SOLB_PREAMB2) {
+        solbuf->nb=0;
+        return 0;
+    }
+    if (solbuf->nb<SOLB_HLEN) return 0;
+    
+    len=U2(solbuf->buff+3)+SOLB_HLEN+4;
+    
+    if (len>MAXSOLMSG) {
+        trace(2,"binary solution length error: len=%d\n",len);
+        solbuf->nb=0;
+        return 0;
+    }
+    if (solbuf->nb<len) return 0;
+    solbuf->nb=0;
+    
+    if (!(stat=decode_solbin(solbuf->buff,len,sol,rb))) return 0;
+    
+    if (norm(rb,3)>0.0) matcpy(solbuf->rb,rb,3,1);
+    return stat;
+}
 /* input solution data from stream ---------------------------------------------
 * input solution data from stream
 * args   : unsigned char data I stream data
@@ -577,6 +686,8 @@ static void readsolopt(FILE *fp, solopt_t *opt)
 *          int    qflag     I  quality flag  (0: all)
 *          solbuf_t *solbuf IO solution buffer
 * return : status (1:solution received,0:no solution,-1:disconnect received)
+* notes  : binary solution records (SOLF_BIN) and text solutions can be mixed
+*          in the stream. binary satellite blocks are skipped.
 *-----------------------------------------------------------------------------*/
 extern int inputsol(unsigned char data, gtime_t ts, gtime_t te, double tint,
                     int qflag, const solopt_t *opt, solbuf_t *solbuf)
@@ -588,6 +699,17 @@ extern int inputsol(unsigned char data, gtime_t ts, gtime_t te, double tint,
     
     sol.time=solbuf->time;
     
+    /* binary solution record */
+    if ((solbuf->nb==0&&data==SOLB_PREAMB1)||
+        (solbuf->nb>0&&solbuf->buff[0]==SOLB_PREAMB1)) {
+        if ((stat=inputsolbin(data,&sol,solbuf))>0) {
+            solbuf->time=sol.time;
+        }
+        if (stat!=1||!screent(sol.time,ts,te,tint)||(qflag&&sol.stat!=qflag)) {
+            return 0;
+        }
+        return addsol(solbuf,&sol);
+    }
     if (data=='$'||(!isprint(data)&&data!='\r'&&data!='\n')) { /* sync header */
         solbuf->nb=0;
     }
@@ -612,18 +734,74 @@ extern int inputsol(unsigned char data, gtime_t ts, gtime_t te, double tint,
     /* add solution to solution buffer */
     return addsol(solbuf,&sol);
 }
+/* read time index file and search file range of time window ---------------*/
+static int readsoltix(const char *file, gtime_t ts, gtime_t te, long *start,
+                      long *end, gtime_t *time)
+{
+    FILE *fp;
+    unsigned char buff[TIXLEN];
+    double t,tp=0.0,off,t0=0.0,tts,tte;
+    char path[1024];
+    int n=0;
+    
+    trace(3,"readsoltix: file=%s\n",file);
+    
+    sprintf(path,"%.1000s%s",file,TIXEXT);
+    
+    if (!(fp=fopen(path,"rb"))) return 0;
+    
+    tts=ts.time?(double)ts.time+ts.sec:0.0;
+    tte=te.time?(double)te.time+te.sec:0.0;
+    *start=0; *end=-1;
+    
+    for (;fread(buff,TIXLEN,1,fp)==1;n++) {
+        t=R8(buff); off=R8(buff+8);
+        
+        if (n>0&&t<tp) { /* index not ordered */
+            trace(2,"time index not ordered: %s\n",path);
+            fclose(fp);
+            return 0;
+        }
+        tp=t;
+        if (tts>0.0&&t<=tts-DTTOL) {
+            *start=(long)off; t0=t;
+        }
+        if (tte>0.0&&t>tte+DTTOL&&*end<0) *end=(long)off;
+    }
+    fclose(fp);
+    
+    if (n<=0) return 0;
+    
+    if (t0>0.0) {
+        time->time=(time_t)floor(t0);
+        time->sec=t0-floor(t0);
+    }
+    trace(3,"readsoltix: n=%d start=%ld end=%ld\n",n,*start,*end);
+    return 1;
+}
 /* read solution data --------------------------------------------------------*/
-static int readsoldata(FILE *fp, gtime_t ts, gtime_t te, double tint, int qflag,
-                      const solopt_t *opt, solbuf_t *solbuf)
+static int readsoldata(FILE *fp, long end, gtime_t ts, gtime_t te, double tint,
+                       int qflag, const solopt_t *opt, solbuf_t *solbuf)
 {
-    int c;
+    unsigned char buff[4096];
+    long pos=ftell(fp);
+    size_t i,n,nr;
     
-    trace(3,"readsoldata:\n");
+    trace(3,"readsoldata: pos=%ld end=%ld\n",pos,end);
     
-    while ((c=fgetc(fp))!=EOF) {
+    for (;;) {
+        nr=sizeof(buff);
+        if (end>=0) {
+            if (pos>=end) break;
+            if ((long)nr>end-pos) nr=(size_t)(end-pos);
+        }
+        if ((n=fread(buff,1,nr,fp))<=0) break;
+        pos+=(long)n;
         
         /* input solution */
-        inputsol((unsigned char)c,ts,te,tint,qflag,opt,solbuf);
+        for (i=0;i<n;i++) {
+            inputsol(buff[i],ts,te,tint,qflag,opt,solbuf);
+        }
     }
     return solbuf->n>0;
 }
@@ -638,6 +816,7 @@ static int cmpsol(const void *p1, const void *p2)
 static int sort_solbuf(solbuf_t *solbuf)
 {
     sol_t *solbuf_data;
+    int i;
     
     trace(4,"sort_solbuf: n=%d\n",solbuf->n);
     
@@ -649,7 +828,14 @@ static int sort_solbuf(solbuf_t *solbuf)
         return 0;
     }
     solbuf->data=solbuf_data;
-    qsort(solbuf->data,solbuf->n,sizeof(sol_t),cmpsol);
+    
+    /* skip sort if already ordered */
+    for (i=1;i<solbuf->n;i++) {
+        if (cmpsol(solbuf->data+i-1,solbuf->data+i)>0) break;
+    }
+    if (i<solbuf->n) {
+        qsort(solbuf->data,solbuf->n,sizeof(sol_t),cmpsol);
+    }
     solbuf->nmax=solbuf->n;
     solbuf->start=0;
     solbuf->end=solbuf->n-1;
@@ -665,12 +851,17 @@ static int sort_solbuf(solbuf_t *solbuf)
 *         (int    qflag)    I  quality flag  (0: all)
 *          solbuf_t *solbuf O  solution buffer
 * return : status (1:ok,0:no data or error)
+* notes  : binary solution records (SOLF_BIN) are also read. if the records
+*          include base station position, it is set to solbuf->rb.
+*          if time index file (<file>.tix) exists, only the part of the file
+*          covering the time window ts-te is read.
 *-----------------------------------------------------------------------------*/
 extern int readsolt(char *files[], int nfile, gtime_t ts, gtime_t te,
                     double tint, int qflag, solbuf_t *solbuf)
 {
     FILE *fp;
     solopt_t opt=solopt_default;
+    long start,end;
     int i;
     
     trace(3,"readsolt: nfile=%d\n",nfile);
@@ -686,8 +877,17 @@ extern int readsolt(char *files[], int nfile, gtime_t ts, gtime_t te,
         readsolopt(fp,&opt);
         rewind(fp);
         
+        /* seek to time window by time index */
+        end=-1;
+        if ((ts.time||te.time)&&
+            readsoltix(files[i],ts,te,&start,&end,&solbuf->time)) {
+            
+            /* reference position in header skipped by seek */
+            readsolrefpos(fp,&opt,solbuf->rb);
+            fseek(fp,start,SEEK_SET);
+        }
         /* read solution data */
-        if (!readsoldata(fp,ts,te,tint,qflag,&opt,solbuf)) {
+        if (!readsoldata(fp,end,ts,te,tint,qflag,&opt,solbuf)) {
             trace(1,"readsolt: no solution in %s\n",files[i]);
         }
         fclose(fp);
@@ -811,6 +1011,7 @@ static int cmpsolstat(const void *p1, const void *p2)
 static int sort_solstat(solstatbuf_t *statbuf)
 {
     solstat_t *statbuf_data;
+    int i;
     
     trace(4,"sort_solstat: n=%d\n",statbuf->n);
     
@@ -822,7 +1023,14 @@ static int sort_solstat(solstatbuf_t *statbuf)
         return 0;
     }
     statbuf->data=statbuf_data;
-    qsort(statbuf->data,statbuf->n,sizeof(solstat_t),cmpsolstat);
+    
+    /* skip sort if already ordered */
+    for (i=1;i<statbuf->n;i++) {
+        if (cmpsolstat(statbuf->data+i-1,statbuf->data+i)>0) break;
+    }
+    if (i<statbuf->n) {
+        qsort(statbuf->data,statbuf->n,sizeof(solstat_t),cmpsolstat);
+    }
     statbuf->nmax=statbuf->n;
     return 1;
 }
@@ -888,15 +1096,17 @@ static void addsolstat(solstatbuf_t *statbuf, const solstat_t *stat)
     statbuf->data[statbuf->n++]=*stat;
 }
 /* read solution status data -------------------------------------------------*/
-static int readsolstatdata(FILE *fp, gtime_t ts, gtime_t te, double tint,
-                           solstatbuf_t *statbuf)
+static int readsolstatdata(FILE *fp, long end, gtime_t ts, gtime_t te,
+                           double tint, solstatbuf_t *statbuf)
 {
     solstat_t stat={{0}};
     char buff[MAXSOLMSG+1];
+    long pos=ftell(fp);
     
-    trace(3,"readsolstatdata:\n");
+    trace(3,"readsolstatdata: pos=%ld end=%ld\n",pos,end);
     
-    while (fgets(buff,sizeof(buff),fp)) {
+    while ((end<0||pos<end)&&fgets(buff,sizeof(buff),fp)) {
+        pos+=(long)strlen(buff);
         
         /* decode solution status */
         if (!decode_solstat(buff,&stat)) continue;
@@ -917,12 +1127,16 @@ static int readsolstatdata(FILE *fp, gtime_t ts, gtime_t te, double tint,
 *         (double tint)     I  time interval (0: all)
 *          solstatbuf_t *statbuf O  solution status buffer
 * return : status (1:ok,0:no data or error)
+* notes  : if time index file (<file>.stat.tix) exists, only the part of the
+*          file covering the time window ts-te is read.
 *-----------------------------------------------------------------------------*/
 extern int readsolstatt(char *files[], int nfile, gtime_t ts, gtime_t te,
                         double tint, solstatbuf_t *statbuf)
 {
     FILE *fp;
+    gtime_t time;
     char path[1024];
+    long start,end;
     int i;
     
     trace(3,"readsolstatt: nfile=%d\n",nfile);
@@ -936,8 +1150,13 @@ extern int readsolstatt(char *files[], int nfile, gtime_t ts, gtime_t te,
             trace(1,"readsolstatt: file open error %s\n",path);
             continue;
         }
+        /* seek to time window by time index */
+        end=-1;
+        if ((ts.time||te.time)&&readsoltix(path,ts,te,&start,&end,&time)) {
+            fseek(fp,start,SEEK_SET);
+        }
         /* read solution status data */
-        if (!readsolstatdata(fp,ts,te,tint,statbuf)) {
+        if (!readsolstatdata(fp,end,ts,te,tint,statbuf)) {
             trace(1,"readsolt: no solution in %s\n",path);
         }
         fclose(fp);
@@ -1336,6 +1555,88 @@ extern int outprcopts(unsigned char *buff, const prcopt_t *opt)
     }
     return p-(char *)buff;
 }
+/* output binary solution record -----------------------------------------------
+* output solution as binary solution record
+* args   : unsigned char *buff IO output buffer
+*          sol_t  *sol      I   solution
+*          double *rb       I   base station position {x,y,z} (ecef) (m)
+* return : number of output bytes
+* notes  : record = preamble (0xA5,0x53) + type (U1) + payload length (U2) +
+*          payload + crc32 (U4). all fields are little-endian.
+*          solution payload (168 bytes):
+*            time (U4:time_t,R8:sec), rr (R8x6), qr (R4x6), dtr (R8x6),
+*            rb (R8x3), type,stat,ns,reserved (U1x4), age (R4), ratio (R4)
+*-----------------------------------------------------------------------------*/
+extern int outsolbins(unsigned char *buff, const sol_t *sol, const double *rb)
+{
+    unsigned char *p=buff+SOLB_HLEN;
+    int i,len=SOLB_HLEN+SOLB_LSOL;
+    
+    trace(4,"outsolbins:\n");
+    
+    buff[0]=SOLB_PREAMB1;
+    buff[1]=SOLB_PREAMB2;
+    buff[2]=SOLB_SOL;
+    setU2(buff+3,SOLB_LSOL);
+    setU4(p,(unsigned int)sol->time.time);
+    setR8(p+4,sol->time.sec);
+    for (i=0;i<6;i++) setR8(p+ 12+i*8,sol->rr [i]);
+    for (i=0;i<6;i++) setR4(p+ 60+i*4,sol->qr [i]);
+    for (i=0;i<6;i++) setR8(p+ 84+i*8,sol->dtr[i]);
+    for (i=0;i<3;i++) setR8(p+132+i*8,rb?rb[i]:0.0);
+    p[156]=sol->type;
+    p[157]=sol->stat;
+    p[158]=sol->ns;
+    p[159]=0;
+    setR4(p+160,sol->age);
+    setR4(p+164,sol->ratio);
+    setU4(buff+len,crc32(buff,len));
+    return len+4;
+}
+/* output binary satellite block -----------------------------------------------
+* output satellite status as binary satellite block record
+* args   : unsigned char *buff IO output buffer
+*          sol_t  *sol      I   solution
+*          ssat_t *ssat     I   satellite status
+* return : number of output bytes
+* notes  : satellite block payload (16+20*nsat bytes):
+*            time (U4:time_t,R8:sec), nsat,reserved (U1x4), and for each valid
+*            satellite: sat,vsat,snr,fix (U1x4), az,el,resp,resc (R4x4)
+*            (vsat,snr,fix,resp and resc for L1)
+*          max number of satellites is 64
+*-----------------------------------------------------------------------------*/
+extern int outsolbinexs(unsigned char *buff, const sol_t *sol,
+                        const ssat_t *ssat)
+{
+    unsigned char *p=buff+SOLB_HLEN,*q=p+SOLB_LSATH;
+    int i,n=0,len;
+    
+    trace(4,"outsolbinexs:\n");
+    
+    for (i=0;i<MAXSAT&&n<SOLB_MAXSAT;i++) {
+        if (!ssat[i].vs) continue;
+        q[0]=(unsigned char)(i+1);
+        q[1]=ssat[i].vsat[0];
+        q[2]=ssat[i].snr[0];
+        q[3]=ssat[i].fix[0];
+        setR4(q+ 4,(float)ssat[i].azel[0]);
+        setR4(q+ 8,(float)ssat[i].azel[1]);
+        setR4(q+12,(float)ssat[i].resp[0]);
+        setR4(q+16,(float)ssat[i].resc[0]);
+        q+=SOLB_LSAT; n++;
+    }
+    len=SOLB_HLEN+SOLB_LSATH+SOLB_LSAT*n;
+    buff[0]=SOLB_PREAMB1;
+    buff[1]=SOLB_PREAMB2;
+    buff[2]=SOLB_SAT;
+    setU2(buff+3,(unsigned short)(len-SOLB_HLEN));
+    setU4(p,(unsigned int)sol->time.time);
+    setR8(p+4,sol->time.sec);
+    p[12]=(unsigned char)n;
+    p[13]=p[14]=p[15]=0;
+    setU4(buff+len,crc32(buff,len));
+    return len+4;
+}
 /* output solution header ------------------------------------------------------
 * output solution header to buffer
 * args   : unsigned char *buff IO output buffer
@@ -1351,7 +1652,7 @@ extern int outsolheads(unsigned char *buff, const solopt_t *opt)
     
     trace(3,"outsolheads:\n");
     
-    if (opt->posf==SOLF_NMEA) return 0;
+    if (opt->posf==SOLF_NMEA||opt->posf==SOLF_BIN) return 0;
     
     if (opt->outhead) {
         p+=sprintf(p,"%s (",COMMENTH);
@@ -1417,6 +1718,8 @@ extern int outsols(unsigned char *buff, const sol_t *sol, const double *rb,
     if (sol->stat<=SOLQ_NONE||(opt->posf==SOLF_ENU&&norm(rb,3)<=0.0)) {
         return 0;
     }
+    if (opt->posf==SOLF_BIN) return outsolbins(buff,sol,rb);
+    
     timeu=opt->timeu<0?0:(opt->timeu>20?20:opt->timeu);
     
     time=sol->time;
@@ -1448,7 +1751,7 @@ extern int outsols(unsigned char *buff, const sol_t *sol, const double *rb,
 *          ssat_t *ssat     I   satellite status
 *          solopt_t *opt    I   solution options
 * return : number of output bytes
-* notes  : only support nmea
+* notes  : only support nmea and binary
 *-----------------------------------------------------------------------------*/
 extern int outsolexs(unsigned char *buff, const sol_t *sol, const ssat_t *ssat,
                      const solopt_t *opt)
@@ -1458,7 +1761,7 @@ extern int outsolexs(unsigned char *buff, const sol_t *sol, const ssat_t *ssat,
     
     trace(3,"outsolexs:\n");
     
-    if (opt->posf==SOLF_NMEA) {
+    if (opt->posf==SOLF_NMEA||opt->posf==SOLF_BIN) {
         if (opt->nmeaintv[1]<0.0) return 0;
         if (!screent(sol->time,ts,ts,opt->nmeaintv[1])) return 0;
     }
@@ -1466,6 +1769,9 @@ extern int outsolexs(unsigned char *buff, const sol_t *sol, const ssat_t *ssat,
         p+=outnmea_gsa(p,sol,ssat);
         p+=outnmea_gsv(p,sol,ssat);
     }
+    else if (opt->posf==SOLF_BIN&&sol->stat>SOLQ_NONE) {
+        p+=outsolbinexs(p,sol,ssat);
+    }
     return p-buff;
 }
 /* output processing option ----------------------------------------------------
@@ -1529,7 +1835,7 @@ extern void outsol(FILE *fp, const sol_t *sol, const double *rb,
 *          ssat_t *ssat     I   satellite status
 *          solopt_t *opt    I   solution options
 * return : output size (bytes)
-* notes  : only support nmea
+* notes  : only support nmea and binary
 *-----------------------------------------------------------------------------*/
 extern void outsolex(FILE *fp, const sol_t *sol, const ssat_t *ssat,
                      const solopt_t *opt)
@@ -1543,3 +1849,64 @@ extern void outsolex(FILE *fp, const sol_t *sol, const ssat_t *ssat,
         fwrite(buff,n,1,fp);
     }
 }
+/* open time index file --------------------------------------------------------
+* open time index file (<file>.tix) for solution or solution status file
+* args   : soltix_t *tix    O   time index
+*          char   *file     I   solution or solution status file path
+*          int    append    I   append to existing index (0:no,1:yes)
+* return : status (1:ok,0:error)
+* notes  : a time index record (16 bytes) consists of epoch time (R8: time_t+
+*          sec) and file offset of the epoch (R8). records are output at 1 s
+*          interval (see outsoltix()).
+*-----------------------------------------------------------------------------*/
+extern int opensoltix(soltix_t *tix, const char *file, int append)
+{
+    gtime_t time0={0};
+    char path[1024];
+    
+    trace(3,"opensoltix: file=%s append=%d\n",file,append);
+    
+    sprintf(path,"%.1000s%s",file,TIXEXT);
+    tix->time=time0;
+    
+    if (!(tix->fp=fopen(path,append?"ab":"wb"))) {
+        trace(1,"opensoltix: file open error path=%s\n",path);
+        return 0;
+    }
+    return 1;
+}
+/* close time index file -------------------------------------------------------
+* close time index file
+* args   : soltix_t *tix    IO  time index
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void closesoltix(soltix_t *tix)
+{
+    trace(3,"closesoltix:\n");
+    
+    if (tix->fp) fclose(tix->fp);
+    tix->fp=NULL;
+}
+/* output time index -----------------------------------------------------------
+* output time index record of epoch before output of the epoch to file
+* args   : soltix_t *tix    IO  time index
+*          gtime_t time     I   epoch time
+*          FILE   *fp       I   solution or solution status file pointer
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void outsoltix(soltix_t *tix, gtime_t time, FILE *fp)
+{
+    unsigned char buff[TIXLEN];
+    long pos;
+    
+    if (!tix->fp||!fp) return;
+    
+    if (tix->time.time&&fabs(timediff(time,tix->time))<TIXINTV) return;
+    
+    if ((pos=ftell(fp))<0) return;
+    
+    setR8(buff  ,(double)time.time+time.sec);
+    setR8(buff+8,(double)pos);
+    fwrite(buff,TIXLEN,1,tix->fp);
+    tix->time=time;
+}
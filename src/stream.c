@@ -43,6 +43,12 @@
 *           2014/06/21 1.14 add general hex message rcv command by !HEX ...
 *           2014/10/16 1.15 support stdin/stdou for input/output from/to file
 *           2014/11/08 1.16 fix getconfig error (87) with bluetooth device
+*           2026/10/18 1.17 add stream event api to wait input data by epoll/poll
+*                           strevtinit(),strevtfree(),strevtadd(),strevtwait()
+*                           use poll() instead of select() for non-block socket io
+*           2026/10/18 1.18 add ntrip caster stream type STR_NTRIPC with shared data chunks
+*                           add api: strcasstat()
+*           2026/10/18 1.19 add file output flush policy option (::F=bytes,ms)
 *-----------------------------------------------------------------------------*/
 #include <ctype.h>
 #include "rtklib.h"
@@ -59,6 +65,10 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 #endif
 
 static const char rcsid[]="$Id$";
@@ -70,6 +80,7 @@ static const char rcsid[]="$Id$";
 #define TIMETAGH_LEN        64          /* time tag file header length */
 #define MAXCLI              32          /* max client connection for tcp svr */
 #define MAXSTATMSG          32          /* max length of status message */
+#define MAXEVTFD            (MAXCLI+1)  /* max descriptors of stream event */
 
 #define NTRIP_AGENT         "RTKLIB/" VER_RTKLIB
 #define NTRIP_CLI_PORT      2101        /* default ntrip-client connection port */
@@ -83,6 +94,13 @@ static const char rcsid[]="$Id$";
 #define NTRIP_RSP_HTTP      "HTTP/"     /* ntrip response: http */
 #define NTRIP_RSP_ERROR     "ERROR"     /* ntrip response: error */
 
+#define NTRIPC_MAXMNT       16          /* max mountpoints of ntrip caster port */
+#define NTRIPC_MAXCLI       16384       /* max clients of ntrip caster port */
+#define NTRIPC_MAXREQ       1024        /* max length of ntrip client request */
+#define NTRIPC_MAXLAG       262144      /* max send lag of client to evict (bytes) */
+#define NTRIPC_TIMEOUT      10000       /* ntrip client request timeout (ms) */
+#define NTRIPC_CYCLE        100         /* ntrip caster thread cycle (ms) */
+
 #define FTP_CMD             "wget"      /* ftp/http command */
 #define FTP_TIMEOUT         30          /* ftp/http timeout (s) */
 
@@ -91,11 +109,14 @@ static const char rcsid[]="$Id$";
 #ifdef WIN32
 #define dev_t               HANDLE
 #define socket_t            SOCKET
+#define poll                WSAPoll
 typedef int socklen_t;
+typedef WSAPOLLFD pollfd_t;
 #else
 #define dev_t               int
 #define socket_t            int
 #define closesocket         close
+typedef struct pollfd pollfd_t;
 #endif
 
 /* type definition -----------------------------------------------------------*/
@@ -131,6 +152,10 @@ typedef struct {            /* file control type */
     double start;           /* start offset (s) */
     double speed;           /* replay speed (time factor) */
     double swapintv;        /* swap interval (hr) (0: no swap) */
+    int flushb;             /* flush size threshold (bytes) (0: every write) */
+    int flusht;             /* flush interval (ms) (0: every write) */
+    int nflush;             /* bytes written since last flush */
+    unsigned int tick_w;    /* tick of last flush */
     lock_t lock;            /* lock flag */
 } file_t;
 
@@ -143,6 +168,7 @@ typedef struct {            /* tcp control type */
     int tcon;               /* reconnect time (ms) (-1:never,0:now) */
     unsigned int tact;      /* data active tick */
     unsigned int tdis;      /* disconnect tick */
+    unsigned int gen;       /* socket generation */
 } tcp_t;
 
 typedef struct {            /* tcp server type */
@@ -169,6 +195,58 @@ typedef struct {            /* ntrip control type */
     tcpcli_t *tcp;          /* tcp client */
 } ntrip_t;
 
+typedef struct ntripcbuf_tag { /* ntrip caster shared data chunk type */
+    int ref;                /* reference count (send cursors of clients) */
+    int n;                  /* data length (bytes) */
+    double pos;             /* stream position of chunk (bytes) */
+    struct ntripcbuf_tag *next; /* next chunk */
+    unsigned char *data;    /* data */
+} ntripcbuf_t;
+
+typedef struct {            /* ntrip caster mountpoint type */
+    char mntpnt[256];       /* mountpoint */
+    char user[256];         /* user for client ("": no authorization) */
+    char passwd[256];       /* password for client */
+    char str[NTRIP_MAXSTR]; /* source table string */
+    int nref;               /* reference count (0:not used) */
+    int ncli;               /* number of connected clients */
+    int nacc;               /* number of accepted clients */
+    int nevict;             /* number of evicted slow clients */
+    int nbuff;              /* number of shared data chunks */
+    double pos;             /* stream position (input bytes) */
+    double outb;            /* output bytes to all clients */
+    double inbt,outbt;      /* input/output bytes at tick */
+    int inr,outr;           /* input/output rate (bps) */
+    unsigned int tick;      /* tick for rate */
+    ntripcbuf_t *head,*tail; /* shared data chunks (head:oldest) */
+} ntripcmnt_t;
+
+typedef struct {            /* ntrip caster client type */
+    tcp_t tcp;              /* tcp control (state 1:request,2:data) */
+    int mnt;                /* mountpoint index */
+    int nreq;               /* request buffer size */
+    char req[NTRIPC_MAXREQ]; /* request buffer */
+    ntripcbuf_t *buf;       /* send cursor chunk (NULL:wait next data) */
+    int off;                /* send cursor offset in chunk (bytes) */
+} ntripccli_t;
+
+typedef struct ntripc_tag { /* ntrip caster type */
+    tcp_t svr;              /* tcp server control */
+    int state;              /* thread state (0:stop,1:run) */
+    int nref;               /* number of mountpoints opened */
+    ntripcmnt_t mnt[NTRIPC_MAXMNT]; /* mountpoints */
+    int ncli,nclimax;       /* number/allocated of client slots */
+    ntripccli_t *cli;       /* client slots */
+    lock_t lock;            /* lock flag */
+    thread_t thread;        /* caster thread */
+    struct ntripc_tag *next; /* next caster */
+} ntripc_t;
+
+typedef struct {            /* ntrip caster stream type */
+    ntripc_t *caster;       /* ntrip caster shared by port */
+    int mnt;                /* mountpoint index */
+} ntripcs_t;
+
 typedef struct {            /* ftp download control type */
     int state;              /* state (0:close,1:download,2:complete,3:error) */
     int proto;              /* protocol (0:ftp,1:http) */
@@ -194,6 +272,10 @@ static char localdir[1024]=""; /* local directory for ftp/http */
 static char proxyaddr[256]=""; /* http/ntrip/ftp proxy address */
 static unsigned int tick_master=0; /* time tick master for replay */
 static int fswapmargin=30;  /* file swap margin (s) */
+static unsigned int sockgen=0; /* socket generation counter */
+static ntripc_t *casters=NULL; /* ntrip casters opened */
+static lock_t caslock;      /* lock flag for ntrip casters */
+static int caslock_init=0;  /* lock flag initialized */
 
 /* read/write serial buffer --------------------------------------------------*/
 #ifdef WIN32
@@ -525,14 +607,14 @@ static void closefile_(file_t *file)
     if (file->fp_tag_tmp) fclose(file->fp_tag_tmp);
     file->fp=file->fp_tag=file->fp_tmp=file->fp_tag_tmp=NULL;
 }
-/* open file (path=filepath[::T[::+<off>][::x<speed>]][::S=swapintv]) --------*/
+/* open file (path=filepath[::T[::+<off>][::x<speed>]][::S=swap][::F=fb,ft]) */
 static file_t *openfile(const char *path, int mode, char *msg)
 {
     file_t *file;
     gtime_t time,time0={0};
     double speed=0.0,start=0.0,swapintv=0.0;
     char *p;
-    int timetag=0;
+    int timetag=0,flushb=0,flusht=0;
     
     tracet(3,"openfile: path=%s mode=%d\n",path,mode);
     
@@ -544,9 +626,12 @@ static file_t *openfile(const char *path, int mode, char *msg)
         else if (*(p+2)=='+') sscanf(p+2,"+%lf",&start);
         else if (*(p+2)=='x') sscanf(p+2,"x%lf",&speed);
         else if (*(p+2)=='S') sscanf(p+2,"S=%lf",&swapintv);
+        else if (*(p+2)=='F') sscanf(p+2,"F=%d,%d",&flushb,&flusht);
     }
     if (start<=0.0) start=0.0;
     if (swapintv<=0.0) swapintv=0.0;
+    if (flushb<=0) flushb=0;
+    if (flusht<=0) flusht=0;
     
     if (!(file=(file_t *)malloc(sizeof(file_t)))) return NULL;
     
@@ -563,6 +648,10 @@ static file_t *openfile(const char *path, int mode, char *msg)
     file->start=start;
     file->speed=speed;
     file->swapintv=swapintv;
+    file->flushb=flushb;
+    file->flusht=flusht;
+    file->nflush=0;
+    file->tick_w=tickget();
     initlock(&file->lock);
     
     time=utc2gpst(timeget());
@@ -691,9 +780,9 @@ static int writefile(file_t *file, unsigned char *buff, int n, char *msg)
 {
     gtime_t wtime;
     unsigned int ns,tick=tickget();
-    int week1,week2;
+    int week1,week2,flush;
     double tow1,tow2,intv;
-    size_t fpos,fpos_tmp;
+    size_t fpos=0,fpos_tmp=0;
     
     tracet(3,"writefile: fp=%d n=%d\n",file->fp,n);
     
@@ -719,26 +808,35 @@ static int writefile(file_t *file, unsigned char *buff, int n, char *msg)
     }
     if (!file->fp) return 0;
     
+    /* flush policy: every write, by written bytes or by interval */
+    file->nflush+=n;
+    flush=(!file->flushb&&!file->flusht)||
+          (file->flushb>0&&file->nflush>=file->flushb)||
+          (file->flusht>0&&(int)(tick-file->tick_w)>=file->flusht);
+    if (flush) {
+        file->nflush=0;
+        file->tick_w=tick;
+    }
     ns=fwrite(buff,1,n,file->fp);
-    fpos=ftell(file->fp);
-    fflush(file->fp);
+    if (file->fp_tag) fpos=ftell(file->fp);
+    if (flush) fflush(file->fp);
     file->wtime=wtime;
     
     if (file->fp_tmp) {
         fwrite(buff,1,n,file->fp_tmp);
-        fpos_tmp=ftell(file->fp_tmp);
-        fflush(file->fp_tmp);
+        if (file->fp_tag_tmp) fpos_tmp=ftell(file->fp_tmp);
+        if (flush) fflush(file->fp_tmp);
     }
     if (file->fp_tag) {
         tick-=file->tick;
         fwrite(&tick,1,sizeof(tick),file->fp_tag);
         fwrite(&fpos,1,sizeof(fpos),file->fp_tag);
-        fflush(file->fp_tag);
+        if (flush) fflush(file->fp_tag);
         
         if (file->fp_tag_tmp) {
             fwrite(&tick,1,sizeof(tick),file->fp_tag_tmp);
             fwrite(&fpos_tmp,1,sizeof(fpos_tmp),file->fp_tag_tmp);
-            fflush(file->fp_tag_tmp);
+            if (flush) fflush(file->fp_tag_tmp);
         }
     }
     tracet(5,"writefile: fp=%d ns=%d tick=%5d fpos=%d\n",file->fp,ns,tick,fpos);
@@ -827,14 +925,28 @@ static int setsock(socket_t sock, char *msg)
     }
     return 1;
 }
-/* non-block accept ----------------------------------------------------------*/
-static socket_t accept_nb(socket_t sock, struct sockaddr *addr, socklen_t *len)
+/* test socket readable/writable without block ------------------------------*/
+static int selsock(socket_t sock, int events)
 {
+#ifdef WIN32
     struct timeval tv={0};
-    fd_set rs;
+    fd_set rs,ws;
+    
+    FD_ZERO(&rs); FD_SET(sock,&rs); ws=rs;
+    return select(sock+1,(events&1)?&rs:NULL,(events&2)?&ws:NULL,NULL,&tv);
+#else
+    struct pollfd pfd;
     
-    FD_ZERO(&rs); FD_SET(sock,&rs);
-    if (!select(sock+1,&rs,NULL,NULL,&tv)) return 0;
+    pfd.fd=sock;
+    pfd.events=((events&1)?POLLIN:0)|((events&2)?POLLOUT:0);
+    pfd.revents=0;
+    return poll(&pfd,1,0); /* no limit of descriptor by FD_SETSIZE */
+#endif
+}
+/* non-block accept ----------------------------------------------------------*/
+static socket_t accept_nb(socket_t sock, struct sockaddr *addr, socklen_t *len)
+{
+    if (!selsock(sock,1)) return 0;
     return accept(sock,addr,len);
 }
 /* non-block connect ---------------------------------------------------------*/
@@ -852,8 +964,6 @@ static int connect_nb(socket_t sock, struct sockaddr *addr, socklen_t len)
         if (err!=WSAEISCONN) return -1;
     }
 #else
-    struct timeval tv={0};
-    fd_set rs,ws;
     int err,flag;
     
     flag=fcntl(sock,F_GETFL,0);
@@ -861,8 +971,7 @@ static int connect_nb(socket_t sock, struct sockaddr *addr, socklen_t len)
     if (connect(sock,addr,len)==-1) {
         err=errsock();
         if (err!=EISCONN&&err!=EINPROGRESS&&err!=EALREADY) return -1;
-        FD_ZERO(&rs); FD_SET(sock,&rs); ws=rs;
-        if (select(sock+1,&rs,&ws,NULL,&tv)==0) return 0;
+        if (selsock(sock,3)==0) return 0;
     }
 #endif
     return 1;
@@ -870,21 +979,13 @@ static int connect_nb(socket_t sock, struct sockaddr *addr, socklen_t len)
 /* non-block receive ---------------------------------------------------------*/
 static int recv_nb(socket_t sock, unsigned char *buff, int n)
 {
-    struct timeval tv={0};
-    fd_set rs;
-    
-    FD_ZERO(&rs); FD_SET(sock,&rs);
-    if (!select(sock+1,&rs,NULL,NULL,&tv)) return 0;
+    if (!selsock(sock,1)) return 0;
     return recv(sock,(char *)buff,n,0);
 }
 /* non-block send ------------------------------------------------------------*/
 static int send_nb(socket_t sock, unsigned char *buff, int n)
 {
-    struct timeval tv={0};
-    fd_set ws;
-    
-    FD_ZERO(&ws); FD_SET(sock,&ws);
-    if (!select(sock+1,NULL,&ws,NULL,&tv)) return 0;
+    if (!selsock(sock,2)) return 0;
     return send(sock,(char *)buff,n,0);
 }
 /* generate tcp socket -------------------------------------------------------*/
@@ -908,6 +1009,7 @@ static int gentcp(tcp_t *tcp, int type, char *msg)
         tcp->state=-1;
         return 0;
     }
+    tcp->gen=++sockgen;
     memset(&tcp->addr,0,sizeof(tcp->addr));
     tcp->addr.sin_family=AF_INET;
     tcp->addr.sin_port=htons(tcp->port);
@@ -1054,6 +1156,7 @@ static int accsock(tcpsvr_t *tcpsvr, char *msg)
     tracet(2,"accsock: connected sock=%d addr=%s\n",tcpsvr->cli[i].sock,tcpsvr->cli[i].saddr);
     tcpsvr->cli[i].state=2;
     tcpsvr->cli[i].tact=tickget();
+    tcpsvr->cli[i].gen=++sockgen;
     return 1;
 }
 /* wait socket accept --------------------------------------------------------*/
@@ -1521,6 +1624,585 @@ static int statentrip(ntrip_t *ntrip)
 {
     return !ntrip?0:(ntrip->state==0?ntrip->tcp->svr.state:ntrip->state);
 }
+/* set socket non-block ------------------------------------------------------*/
+static void setnonblock(socket_t sock)
+{
+#ifdef WIN32
+    u_long mode=1;
+    ioctlsocket(sock,FIONBIO,&mode);
+#else
+    fcntl(sock,F_SETFL,fcntl(sock,F_GETFL,0)|O_NONBLOCK);
+#endif
+}
+/* test socket error by blocking ---------------------------------------------*/
+static int isblock(int err)
+{
+#ifdef WIN32
+    return err==WSAEWOULDBLOCK;
+#else
+    return err==EAGAIN||err==EWOULDBLOCK||err==EINTR;
+#endif
+}
+/* send to ntrip caster client (return: -1:error,0:block,>0:sent bytes) ------*/
+static int sendcas(socket_t sock, const unsigned char *buff, int n)
+{
+    int ns,flag=0;
+    
+#ifdef MSG_NOSIGNAL
+    flag=MSG_NOSIGNAL;
+#endif
+    if ((ns=send(sock,(const char *)buff,n,flag))>=0) return ns;
+    return isblock(errsock())?0:-1;
+}
+/* free shared data chunks no more referenced --------------------------------*/
+static void freecasbuf(ntripcmnt_t *mnt)
+{
+    ntripcbuf_t *p;
+    
+    /* chunks before the first referenced one are behind all send cursors */
+    while ((p=mnt->head)&&p->ref<=0) {
+        mnt->head=p->next;
+        free(p);
+        mnt->nbuff--;
+    }
+    if (!mnt->head) mnt->tail=NULL;
+}
+/* close ntrip caster client -------------------------------------------------*/
+static void closecascli(ntripc_t *caster, ntripccli_t *cli)
+{
+    ntripcmnt_t *mnt=caster->mnt+cli->mnt;
+    
+    tracet(3,"closecascli: sock=%d addr=%s\n",cli->tcp.sock,cli->tcp.saddr);
+    
+    closesocket(cli->tcp.sock);
+    
+    if (cli->tcp.state==2) {
+        if (cli->buf) cli->buf->ref--;
+        mnt->ncli--;
+        freecasbuf(mnt);
+    }
+    cli->tcp.state=0;
+    cli->buf=NULL;
+}
+/* send data to ntrip caster client from send cursor -------------------------*/
+static int sendcascli(ntripcmnt_t *mnt, ntripccli_t *cli)
+{
+    ntripcbuf_t *p;
+    int ns;
+    
+    while ((p=cli->buf)) {
+        if (cli->off<p->n) {
+            if ((ns=sendcas(cli->tcp.sock,p->data+cli->off,p->n-cli->off))<0) {
+                return -1;
+            }
+            cli->off+=ns;
+            mnt->outb+=ns;
+            if (cli->off<p->n) return 0; /* blocked */
+            cli->tcp.tact=tickget();
+        }
+        if (!p->next) break;
+        
+        /* move send cursor to next chunk */
+        p->ref--;
+        p->next->ref++;
+        cli->buf=p->next;
+        cli->off=0;
+    }
+    return 1;
+}
+/* send lag of ntrip caster client -------------------------------------------*/
+static int lagcascli(const ntripcmnt_t *mnt, const ntripccli_t *cli)
+{
+    if (!cli->buf) return 0;
+    return (int)(mnt->pos-cli->buf->pos-cli->off);
+}
+/* flush data to ntrip caster client and evict slow client ------------------*/
+static void flushcascli(ntripc_t *caster, ntripccli_t *cli)
+{
+    ntripcmnt_t *mnt=caster->mnt+cli->mnt;
+    
+    if (sendcascli(mnt,cli)<0) {
+        tracet(2,"flushcascli: send error addr=%s err=%d\n",cli->tcp.saddr,
+               errsock());
+        closecascli(caster,cli);
+    }
+    else if (lagcascli(mnt,cli)>NTRIPC_MAXLAG) {
+        tracet(2,"flushcascli: evict slow client addr=%s lag=%d\n",
+               cli->tcp.saddr,lagcascli(mnt,cli));
+        mnt->nevict++;
+        closecascli(caster,cli);
+    }
+    else freecasbuf(mnt);
+}
+/* send ntrip source table ---------------------------------------------------*/
+static void srctblcas(ntripc_t *caster, ntripccli_t *cli)
+{
+    char buff[NTRIPC_MAXMNT*(256+NTRIP_MAXSTR+8)+1024],tbl[sizeof(buff)-512];
+    char *p=buff,*q=tbl;
+    int i;
+    
+    for (i=0;i<NTRIPC_MAXMNT;i++) {
+        if (caster->mnt[i].nref<=0) continue;
+        q+=sprintf(q,"STR;%s;%s\r\n",caster->mnt[i].mntpnt,caster->mnt[i].str);
+    }
+    q+=sprintf(q,"%s\r\n",NTRIP_RSP_TBLEND);
+    
+    p+=sprintf(p,"%s",NTRIP_RSP_SRCTBL);
+    p+=sprintf(p,"Server: NTRIP %s\r\n",NTRIP_AGENT);
+    p+=sprintf(p,"Content-Type: text/plain\r\n");
+    p+=sprintf(p,"Content-Length: %d\r\n\r\n",(int)(q-tbl));
+    p+=sprintf(p,"%s",tbl);
+    sendcas(cli->tcp.sock,(unsigned char *)buff,(int)(p-buff));
+}
+/* test ntrip client authorization -------------------------------------------*/
+static int authcas(const ntripcmnt_t *mnt, const char *req)
+{
+    char user[512],auth[1024],*p;
+    int n;
+    
+    if (!*mnt->user) return 1;
+    
+    sprintf(user,"%s:%s",mnt->user,mnt->passwd);
+    n=encbase64(auth,(unsigned char *)user,strlen(user));
+    
+    if (!(p=strstr(req,"Authorization: Basic "))) return 0;
+    p+=21;
+    return !strncmp(p,auth,n)&&(p[n]=='\r'||p[n]=='\n');
+}
+/* response to ntrip client request ------------------------------------------*/
+static void rspcascli(ntripc_t *caster, ntripccli_t *cli)
+{
+    const char *rsp;
+    char url[256]="",*p;
+    int i;
+    
+    tracet(3,"rspcascli: addr=%s\n",cli->tcp.saddr);
+    
+    if (sscanf(cli->req,"GET %255s",url)<1) {
+        tracet(2,"rspcascli: invalid request addr=%s\n",cli->tcp.saddr);
+        closecascli(caster,cli);
+        return;
+    }
+    /* strip address of absolute url via proxy */
+    if ((p=strstr(url,"://"))&&!(p=strchr(p+3,'/'))) p=url+strlen(url);
+    else if (!p) p=url;
+    if (*p=='/') p++;
+    
+    for (i=0;i<NTRIPC_MAXMNT;i++) {
+        if (caster->mnt[i].nref>0&&*p&&!strcmp(caster->mnt[i].mntpnt,p)) break;
+    }
+    if (i>=NTRIPC_MAXMNT) { /* unknown mountpoint */
+        srctblcas(caster,cli);
+        closecascli(caster,cli);
+        return;
+    }
+    if (!authcas(caster->mnt+i,cli->req)) {
+        tracet(2,"rspcascli: unauthorized addr=%s mntpnt=%s\n",
+               cli->tcp.saddr,p);
+        rsp="HTTP/1.0 401 Unauthorized\r\n\r\n";
+        sendcas(cli->tcp.sock,(unsigned char *)rsp,strlen(rsp));
+        closecascli(caster,cli);
+        return;
+    }
+    rsp=NTRIP_RSP_OK_CLI;
+    if (sendcas(cli->tcp.sock,(unsigned char *)rsp,strlen(rsp))<=0) {
+        closecascli(caster,cli);
+        return;
+    }
+    tracet(2,"rspcascli: connected addr=%s mntpnt=%s\n",cli->tcp.saddr,p);
+    
+    cli->mnt=i;
+    cli->buf=NULL; /* start at next data */
+    cli->off=0;
+    cli->tcp.state=2;
+    cli->tcp.tact=tickget();
+    caster->mnt[i].ncli++;
+    caster->mnt[i].nacc++;
+}
+/* read ntrip caster client --------------------------------------------------*/
+static void readcascli(ntripc_t *caster, ntripccli_t *cli)
+{
+    char buff[1024];
+    int nr;
+    
+    if ((nr=recv(cli->tcp.sock,buff,sizeof(buff),0))<0&&isblock(errsock())) {
+        return;
+    }
+    if (nr<=0) { /* disconnected */
+        tracet(3,"readcascli: disconnected addr=%s\n",cli->tcp.saddr);
+        closecascli(caster,cli);
+        return;
+    }
+    if (cli->tcp.state==2) return; /* discard nmea from client */
+    
+    if (cli->nreq+nr>=NTRIPC_MAXREQ) {
+        tracet(2,"readcascli: request overflow addr=%s\n",cli->tcp.saddr);
+        closecascli(caster,cli);
+        return;
+    }
+    memcpy(cli->req+cli->nreq,buff,nr);
+    cli->nreq+=nr;
+    cli->req[cli->nreq]='\0';
+    
+    if (strstr(cli->req,"\r\n\r\n")) rspcascli(caster,cli);
+}
+/* accept ntrip caster clients -----------------------------------------------*/
+static void acccas(ntripc_t *caster)
+{
+    ntripccli_t *cli;
+    struct sockaddr_in addr;
+    socket_t sock;
+    socklen_t len;
+    char msg[MAXSTRMSG];
+    int i,n;
+    
+    while (caster->svr.state>0) {
+        len=sizeof(addr);
+        if ((sock=accept_nb(caster->svr.sock,(struct sockaddr *)&addr,&len))==
+            (socket_t)-1) {
+            tracet(1,"acccas: accept error sock=%d err=%d\n",caster->svr.sock,
+                   errsock());
+            return;
+        }
+        if (sock==0) return;
+        
+        for (i=0;i<caster->ncli;i++) if (!caster->cli[i].tcp.state) break;
+        
+        if (i>=caster->nclimax) {
+            n=caster->nclimax<=0?64:caster->nclimax*2;
+            if (n>NTRIPC_MAXCLI) n=NTRIPC_MAXCLI;
+            if (i>=n||!(cli=(ntripccli_t *)realloc(caster->cli,
+                                                   sizeof(ntripccli_t)*n))) {
+                tracet(1,"acccas: too many clients n=%d\n",i);
+                closesocket(sock);
+                continue;
+            }
+            caster->cli=cli;
+            caster->nclimax=n;
+        }
+        if (!setsock(sock,msg)) continue;
+        setnonblock(sock);
+        
+        cli=caster->cli+i;
+        memset(cli,0,sizeof(ntripccli_t));
+        cli->tcp.sock=sock;
+        memcpy(&cli->tcp.addr,&addr,sizeof(addr));
+        strcpy(cli->tcp.saddr,inet_ntoa(addr.sin_addr));
+        cli->tcp.state=1;
+        cli->tcp.tact=tickget();
+        cli->tcp.gen=++sockgen;
+        if (i>=caster->ncli) caster->ncli=i+1;
+        
+        tracet(3,"acccas: accepted sock=%d addr=%s\n",sock,cli->tcp.saddr);
+    }
+}
+/* update ntrip caster status ------------------------------------------------*/
+static void updatecas(ntripc_t *caster)
+{
+    ntripcmnt_t *mnt;
+    ntripccli_t *cli;
+    unsigned int tick=tickget();
+    int i;
+    
+    for (i=0;i<caster->ncli;i++) { /* request timeout */
+        cli=caster->cli+i;
+        if (cli->tcp.state!=1||(int)(tick-cli->tcp.tact)<NTRIPC_TIMEOUT) {
+            continue;
+        }
+        tracet(2,"updatecas: request timeout addr=%s\n",cli->tcp.saddr);
+        closecascli(caster,cli);
+    }
+    while (caster->ncli>0&&!caster->cli[caster->ncli-1].tcp.state) {
+        caster->ncli--;
+    }
+    for (i=0;i<NTRIPC_MAXMNT;i++) { /* throughput */
+        mnt=caster->mnt+i;
+        if (mnt->nref<=0||(int)(tick-mnt->tick)<tirate) continue;
+        mnt->inr =(int)((mnt->pos -mnt->inbt )*8000.0/(tick-mnt->tick));
+        mnt->outr=(int)((mnt->outb-mnt->outbt)*8000.0/(tick-mnt->tick));
+        mnt->inbt=mnt->pos;
+        mnt->outbt=mnt->outb;
+        mnt->tick=tick;
+    }
+}
+/* ntrip caster thread -------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI ntripcthread(void *arg)
+#else
+static void *ntripcthread(void *arg)
+#endif
+{
+    ntripc_t *caster=(ntripc_t *)arg;
+    ntripccli_t *cli;
+    pollfd_t *pfd=NULL;
+    unsigned int *gen=NULL;
+    int i,j,n,nmax=0,*index=NULL,revt;
+    
+    tracet(3,"ntripcthread: port=%d\n",caster->svr.port);
+    
+    while (caster->state) {
+        lock(&caster->lock);
+        
+        if (caster->ncli+1>nmax) {
+            nmax=caster->nclimax+1;
+            free(pfd); free(index); free(gen);
+            if (!(pfd=(pollfd_t *)malloc(sizeof(pollfd_t)*nmax))||
+                !(index=(int *)malloc(sizeof(int)*nmax))||
+                !(gen=(unsigned int *)malloc(sizeof(unsigned int)*nmax))) {
+                unlock(&caster->lock);
+                break;
+            }
+        }
+        /* listen socket and clients, wait sendable if pending data */
+        pfd[0].fd=caster->svr.sock;
+        pfd[0].events=POLLIN;
+        pfd[0].revents=0;
+        for (i=0,n=1;i<caster->ncli;i++) {
+            cli=caster->cli+i;
+            if (!cli->tcp.state) continue;
+            pfd[n].fd=cli->tcp.sock;
+            pfd[n].events=POLLIN;
+            if (cli->buf&&(cli->off<cli->buf->n||cli->buf->next)) {
+                pfd[n].events|=POLLOUT;
+            }
+            pfd[n].revents=0;
+            index[n]=i;
+            gen[n++]=cli->tcp.gen;
+        }
+        unlock(&caster->lock);
+        
+        if (poll(pfd,n,NTRIPC_CYCLE)<0) sleepms(NTRIPC_CYCLE);
+        
+        lock(&caster->lock);
+        
+        if (pfd[0].revents&POLLIN) acccas(caster);
+        
+        for (j=1;j<n;j++) {
+            if (!(revt=pfd[j].revents)) continue;
+            cli=caster->cli+index[j];
+            
+            /* skip client closed or replaced by stream writer */
+            if (index[j]>=caster->ncli||!cli->tcp.state||cli->tcp.gen!=gen[j]) {
+                continue;
+            }
+            if (revt&(POLLIN|POLLHUP|POLLERR)) readcascli(caster,cli);
+            
+            if (cli->tcp.state==2&&(revt&POLLOUT)) flushcascli(caster,cli);
+        }
+        updatecas(caster);
+        
+        unlock(&caster->lock);
+    }
+    free(pfd); free(index); free(gen);
+    return 0;
+}
+/* open ntrip caster (path=[user[:passwd]@][:port]/mntpnt[:str]) -------------*/
+static ntripcs_t *openntripc(const char *path, char *msg)
+{
+    ntripcs_t *ntripc;
+    ntripc_t *caster;
+    ntripcmnt_t *mnt;
+    char addr[256],port[256],user[256],passwd[256],mntpnt[256],str[NTRIP_MAXSTR];
+    int i,nport=NTRIP_CLI_PORT;
+    
+    tracet(3,"openntripc: path=%s\n",path);
+    
+    decodetcppath(path,addr,port,user,passwd,mntpnt,str);
+    
+    if (!*mntpnt) {
+        sprintf(msg,"no mountpoint");
+        return NULL;
+    }
+    if (*port&&sscanf(port,"%d",&nport)<1) {
+        sprintf(msg,"port error: %s",port);
+        return NULL;
+    }
+    if (!(ntripc=(ntripcs_t *)malloc(sizeof(ntripcs_t)))) return NULL;
+    
+    if (!caslock_init) {
+        initlock(&caslock);
+        caslock_init=1;
+    }
+    lock(&caslock);
+    
+    /* share caster among mountpoints on the same port */
+    for (caster=casters;caster;caster=caster->next) {
+        if (caster->svr.port==nport) break;
+    }
+    if (!caster) {
+        if (!(caster=(ntripc_t *)calloc(1,sizeof(ntripc_t)))) {
+            unlock(&caslock);
+            free(ntripc);
+            return NULL;
+        }
+        caster->svr.port=nport;
+        if (!gentcp(&caster->svr,0,msg)) {
+            unlock(&caslock);
+            free(caster); free(ntripc);
+            return NULL;
+        }
+        listen(caster->svr.sock,SOMAXCONN);
+        initlock(&caster->lock);
+        caster->state=1;
+#ifdef WIN32
+        if (!(caster->thread=CreateThread(NULL,0,ntripcthread,caster,0,NULL))) {
+#else
+        if (pthread_create(&caster->thread,NULL,ntripcthread,caster)) {
+#endif
+            sprintf(msg,"caster thread error");
+            closesocket(caster->svr.sock);
+            unlock(&caslock);
+            free(caster); free(ntripc);
+            return NULL;
+        }
+        caster->next=casters;
+        casters=caster;
+    }
+    lock(&caster->lock);
+    for (i=0;i<NTRIPC_MAXMNT;i++) {
+        if (caster->mnt[i].nref>0&&!strcmp(caster->mnt[i].mntpnt,mntpnt)) break;
+    }
+    if (i>=NTRIPC_MAXMNT) {
+        for (i=0;i<NTRIPC_MAXMNT;i++) if (caster->mnt[i].nref<=0) break;
+    }
+    else i=NTRIPC_MAXMNT; /* mountpoint in use */
+    
+    if (i>=NTRIPC_MAXMNT) {
+        unlock(&caster->lock);
+        unlock(&caslock);
+        sprintf(msg,"mountpoint error: %s",mntpnt);
+        free(ntripc);
+        return NULL;
+    }
+    mnt=caster->mnt+i;
+    memset(mnt,0,sizeof(ntripcmnt_t));
+    strcpy(mnt->mntpnt,mntpnt);
+    strcpy(mnt->user,user);
+    strcpy(mnt->passwd,passwd);
+    strcpy(mnt->str,str);
+    mnt->nref=1;
+    mnt->tick=tickget();
+    caster->nref++;
+    unlock(&caster->lock);
+    unlock(&caslock);
+    
+    ntripc->caster=caster;
+    ntripc->mnt=i;
+    sprintf(msg,"waiting...");
+    return ntripc;
+}
+/* close ntrip caster --------------------------------------------------------*/
+static void closentripc(ntripcs_t *ntripc)
+{
+    ntripc_t *caster=ntripc->caster,**p;
+    ntripcmnt_t *mnt=caster->mnt+ntripc->mnt;
+    ntripcbuf_t *buf;
+    int i;
+    
+    tracet(3,"closentripc: mnt=%d\n",ntripc->mnt);
+    
+    lock(&caslock);
+    lock(&caster->lock);
+    for (i=0;i<caster->ncli;i++) {
+        if (caster->cli[i].tcp.state&&caster->cli[i].mnt==ntripc->mnt) {
+            closecascli(caster,caster->cli+i);
+        }
+    }
+    while ((buf=mnt->head)) {
+        mnt->head=buf->next;
+        free(buf);
+    }
+    mnt->tail=NULL;
+    mnt->nref=0;
+    unlock(&caster->lock);
+    
+    if (--caster->nref<=0) {
+        for (p=&casters;*p;p=&(*p)->next) {
+            if (*p==caster) {*p=caster->next; break;}
+        }
+        caster->state=0;
+#ifdef WIN32
+        WaitForSingleObject(caster->thread,10000);
+        CloseHandle(caster->thread);
+#else
+        pthread_join(caster->thread,NULL);
+#endif
+        for (i=0;i<caster->ncli;i++) {
+            if (caster->cli[i].tcp.state) closesocket(caster->cli[i].tcp.sock);
+        }
+        closesocket(caster->svr.sock);
+        free(caster->cli);
+        free(caster);
+    }
+    unlock(&caslock);
+    free(ntripc);
+}
+/* write ntrip caster --------------------------------------------------------*/
+static int writentripc(ntripcs_t *ntripc, unsigned char *buff, int n,
+                       char *msg)
+{
+    ntripc_t *caster=ntripc->caster;
+    ntripcmnt_t *mnt=caster->mnt+ntripc->mnt;
+    ntripcbuf_t *p;
+    int i;
+    
+    tracet(3,"writentripc: n=%d\n",n);
+    
+    if (n<=0) return 0;
+    
+    lock(&caster->lock);
+    
+    if (mnt->ncli>0) {
+        
+        /* one shared chunk for all clients */
+        if (!(p=(ntripcbuf_t *)malloc(sizeof(ntripcbuf_t)+n))) {
+            unlock(&caster->lock);
+            return 0;
+        }
+        p->ref=0;
+        p->n=n;
+        p->pos=mnt->pos;
+        p->next=NULL;
+        p->data=(unsigned char *)(p+1);
+        memcpy(p->data,buff,n);
+        
+        if (mnt->tail) mnt->tail->next=p; else mnt->head=p;
+        mnt->tail=p;
+        mnt->nbuff++;
+        
+        /* attach clients waiting for first data */
+        for (i=0;i<caster->ncli;i++) {
+            if (caster->cli[i].tcp.state!=2||caster->cli[i].mnt!=ntripc->mnt||
+                caster->cli[i].buf) continue;
+            caster->cli[i].buf=p;
+            caster->cli[i].off=0;
+            p->ref++;
+        }
+    }
+    mnt->pos+=n;
+    
+    for (i=0;i<caster->ncli;i++) {
+        if (caster->cli[i].tcp.state!=2||caster->cli[i].mnt!=ntripc->mnt) {
+            continue;
+        }
+        flushcascli(caster,caster->cli+i);
+    }
+    
+    if (mnt->ncli<=0) sprintf(msg,"waiting...");
+    else if (mnt->ncli==1) sprintf(msg,"1 client");
+    else sprintf(msg,"%d clients",mnt->ncli);
+    
+    unlock(&caster->lock);
+    return n;
+}
+/* get state ntrip caster ----------------------------------------------------*/
+static int statentripc(ntripcs_t *ntripc)
+{
+    ntripc_t *caster=ntripc->caster;
+    
+    if (caster->svr.state<=0) return -1;
+    return caster->mnt[ntripc->mnt].ncli>0?2:1;
+}
 /* decode ftp path ----------------------------------------------------------*/
 static void decodeftppath(const char *path, char *addr, char *file, char *user,
                           char *passwd, int *topts)
@@ -1813,6 +2495,10 @@ extern void strinit(stream_t *stream)
 * return : status (0:error,1:ok)
 * notes  : see reference [1] for NTRIP
 *          STR_FTP/HTTP needs "wget" in command search paths
+*          STR_NTRIPC is output only. the streams of the same port share one
+*          caster with the mountpoints. the data written are shared by all
+*          clients as one chunk and the client whose send lag exceeds
+*          NTRIPC_MAXLAG bytes is disconnected
 *
 * stream path ([] options):
 *
@@ -1823,15 +2509,19 @@ extern void strinit(stream_t *stream)
 *                    parity= parity       (n|o|e)
 *                    stopb = stop bits    (1|2)
 *                    fctr  = flow control (off|rts)
-*   STR_FILE     file_path[::T][::+start][::xseppd][::S=swap]
+*   STR_FILE     file_path[::T][::+start][::xseppd][::S=swap][::F=fb[,ft]]
 *                    ::T   = enable time tag
 *                    start = replay start offset (s)
 *                    speed = replay speed factor
 *                    swap  = output swap interval (hr) (0: no swap)
+*                    fb    = output flush size threshold (bytes)
+*                    ft    = output flush interval (ms)
+*                            (fb=ft=0: flush every write, checked at write)
 *   STR_TCPSVR   :port
 *   STR_TCPCLI   address:port
 *   STR_NTRIPSVR user[:passwd]@address[:port]/moutpoint[:string]
 *   STR_NTRIPCLI [user[:passwd]]@address[:port][/mountpoint]
+*   STR_NTRIPC   [user[:passwd]@][:port]/mountpoint[:string]
 *   STR_FTP      [user[:passwd]]@address/file_path[::T=poff[,tint[,toff,tret]]]]
 *   STR_HTTP     address/file_path[::T=poff[,tint[,toff,tret]]]]
 *                    poff  = time offset for path extension (s)
@@ -1858,6 +2548,7 @@ extern int stropen(stream_t *stream, int type, int mode, const char *path)
         case STR_TCPCLI  : stream->port=opentcpcli(path,     stream->msg); break;
         case STR_NTRIPSVR: stream->port=openntrip (path,0,   stream->msg); break;
         case STR_NTRIPCLI: stream->port=openntrip (path,1,   stream->msg); break;
+        case STR_NTRIPC  : stream->port=openntripc(path,     stream->msg); break;
         case STR_FTP     : stream->port=openftp   (path,0,   stream->msg); break;
         case STR_HTTP    : stream->port=openftp   (path,1,   stream->msg); break;
         default: stream->state=0; return 1;
@@ -1882,6 +2573,7 @@ extern void strclose(stream_t *stream)
             case STR_TCPCLI  : closetcpcli((tcpcli_t *)stream->port); break;
             case STR_NTRIPSVR: closentrip ((ntrip_t  *)stream->port); break;
             case STR_NTRIPCLI: closentrip ((ntrip_t  *)stream->port); break;
+            case STR_NTRIPC  : closentripc((ntripcs_t *)stream->port); break;
             case STR_FTP     : closeftp   ((ftp_t    *)stream->port); break;
             case STR_HTTP    : closeftp   ((ftp_t    *)stream->port); break;
         }
@@ -1989,6 +2681,7 @@ extern int strwrite(stream_t *stream, unsigned char *buff, int n)
         case STR_TCPCLI  : ns=writetcpcli((tcpcli_t *)stream->port,buff,n,msg); break;
         case STR_NTRIPCLI:
         case STR_NTRIPSVR: ns=writentrip ((ntrip_t  *)stream->port,buff,n,msg); break;
+        case STR_NTRIPC  : ns=writentripc((ntripcs_t *)stream->port,buff,n,msg); break;
         case STR_FTP     :
         case STR_HTTP    :
         default:
@@ -2032,6 +2725,7 @@ extern int strstat(stream_t *stream, char *msg)
         case STR_TCPCLI  : state=statetcpcli((tcpcli_t *)stream->port); break;
         case STR_NTRIPSVR:
         case STR_NTRIPCLI: state=statentrip ((ntrip_t  *)stream->port); break;
+        case STR_NTRIPC  : state=statentripc((ntripcs_t *)stream->port); break;
         case STR_FTP     : state=stateftp   ((ftp_t    *)stream->port); break;
         case STR_HTTP    : state=stateftp   ((ftp_t    *)stream->port); break;
         default:
@@ -2146,6 +2840,282 @@ extern gtime_t strgettime(stream_t *stream)
     }
     return utc2gpst(timeget());
 }
+/* get ntrip caster status ----------------------------------------------------
+* get status of ntrip caster mountpoint
+* args   : stream_t *stream I   stream (STR_NTRIPC)
+*          strcasstat_t *stat O ntrip caster mountpoint status
+* return : status (1:ok,0:not ntrip caster)
+*-----------------------------------------------------------------------------*/
+extern int strcasstat(stream_t *stream, strcasstat_t *stat)
+{
+    ntripcs_t *ntripc;
+    ntripc_t *caster;
+    ntripcmnt_t *mnt;
+    int i,lag;
+    
+    tracet(4,"strcasstat:\n");
+    
+    strlock(stream);
+    if (stream->type!=STR_NTRIPC||!stream->port) {
+        strunlock(stream);
+        return 0;
+    }
+    ntripc=(ntripcs_t *)stream->port;
+    caster=ntripc->caster;
+    mnt=caster->mnt+ntripc->mnt;
+    
+    lock(&caster->lock);
+    strcpy(stat->mntpnt,mnt->mntpnt);
+    stat->ncli  =mnt->ncli;
+    stat->nacc  =mnt->nacc;
+    stat->nevict=mnt->nevict;
+    stat->nbuff =mnt->nbuff;
+    stat->inb   =mnt->pos;
+    stat->outb  =mnt->outb;
+    stat->inr   =mnt->inr;
+    stat->outr  =mnt->outr;
+    stat->maxlag=0;
+    for (i=0;i<caster->ncli;i++) {
+        if (caster->cli[i].tcp.state!=2||caster->cli[i].mnt!=ntripc->mnt) {
+            continue;
+        }
+        if ((lag=lagcascli(mnt,caster->cli+i))>stat->maxlag) stat->maxlag=lag;
+    }
+    unlock(&caster->lock);
+    strunlock(stream);
+    return 1;
+}
+/* get descriptors of stream for event -----------------------------------------
+* return : number of descriptors (-1:not pollable,-2:buffered data exists)
+*-----------------------------------------------------------------------------*/
+static int getevtfd(stream_t *stream, int *fd, unsigned int *gen)
+{
+    tcpsvr_t *tcpsvr;
+    tcpcli_t *tcpcli;
+    ntrip_t *ntrip;
+    int i,n=0;
+    
+    if (!(stream->mode&STR_MODE_R)||!stream->port) return 0;
+    
+    switch (stream->type) {
+#ifndef WIN32
+        case STR_SERIAL:
+            fd[0]=((serial_t *)stream->port)->dev; gen[0]=0;
+            return 1;
+#endif
+        case STR_TCPSVR:
+            tcpsvr=(tcpsvr_t *)stream->port;
+            if (tcpsvr->svr.state<=0) return -1;
+            fd[n]=(int)tcpsvr->svr.sock; gen[n++]=tcpsvr->svr.gen;
+            for (i=0;i<MAXCLI&&n<MAXEVTFD;i++) {
+                if (tcpsvr->cli[i].state!=2) continue;
+                fd[n]=(int)tcpsvr->cli[i].sock; gen[n++]=tcpsvr->cli[i].gen;
+            }
+            return n;
+        case STR_TCPCLI:
+            tcpcli=(tcpcli_t *)stream->port;
+            if (tcpcli->svr.state!=2) return -1;
+            fd[0]=(int)tcpcli->svr.sock; gen[0]=tcpcli->svr.gen;
+            return 1;
+        case STR_NTRIPCLI:
+            ntrip=(ntrip_t *)stream->port;
+            if (ntrip->state==2&&ntrip->nb>0) return -2;
+            if (ntrip->state<1||ntrip->tcp->svr.state!=2) return -1;
+            fd[0]=(int)ntrip->tcp->svr.sock; gen[0]=ntrip->tcp->svr.gen;
+            return 1;
+        case STR_NONE:
+        case STR_NTRIPSVR:
+        case STR_NTRIPC:
+            return 0;
+    }
+    return -1; /* file, ftp, http and serial (win32) */
+}
+/* initialize stream event -----------------------------------------------------
+* initialize stream event to wait for input data of streams
+* args   : strevt_t *evt    IO stream event
+*          int    nmax      I  max number of streams
+* return : status (1:ok,0:error)
+*-----------------------------------------------------------------------------*/
+extern int strevtinit(strevt_t *evt, int nmax)
+{
+    tracet(3,"strevtinit: nmax=%d\n",nmax);
+    
+    evt->n=0;
+    evt->nmax=nmax>0?nmax:1;
+    evt->efd=-1;
+    evt->stream=NULL; evt->ready=evt->nfd=evt->fd=NULL; evt->gen=NULL;
+    
+    if (!(evt->stream=(stream_t **)malloc(sizeof(stream_t *)*evt->nmax))||
+        !(evt->ready=(int *)calloc(evt->nmax,sizeof(int)))||
+        !(evt->nfd=(int *)calloc(evt->nmax,sizeof(int)))||
+        !(evt->fd=(int *)malloc(sizeof(int)*evt->nmax*MAXEVTFD))||
+        !(evt->gen=(unsigned int *)malloc(sizeof(int)*evt->nmax*MAXEVTFD))) {
+        strevtfree(evt);
+        return 0;
+    }
+#ifdef __linux__
+    if ((evt->efd=epoll_create(evt->nmax))<0) {
+        tracet(2,"strevtinit: epoll_create error err=%d\n",errno);
+        evt->efd=-1; /* fall back to poll */
+    }
+#endif
+    return 1;
+}
+/* free stream event -----------------------------------------------------------
+* free stream event
+* args   : strevt_t *evt    IO stream event
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void strevtfree(strevt_t *evt)
+{
+    tracet(3,"strevtfree:\n");
+    
+#ifdef __linux__
+    if (evt->efd>=0) close(evt->efd);
+#endif
+    free(evt->stream); evt->stream=NULL;
+    free(evt->ready ); evt->ready =NULL;
+    free(evt->nfd   ); evt->nfd   =NULL;
+    free(evt->fd    ); evt->fd    =NULL;
+    free(evt->gen   ); evt->gen   =NULL;
+    evt->n=evt->nmax=0;
+    evt->efd=-1;
+}
+/* add stream to stream event --------------------------------------------------
+* add stream to stream event
+* args   : strevt_t *evt    IO stream event
+*          stream_t *stream I  stream (opened by stropen())
+* return : index of stream in stream event (-1:error)
+*-----------------------------------------------------------------------------*/
+extern int strevtadd(strevt_t *evt, stream_t *stream)
+{
+    tracet(3,"strevtadd: n=%d type=%d\n",evt->n,stream->type);
+    
+    if (evt->n>=evt->nmax) return -1;
+    evt->stream[evt->n]=stream;
+    evt->ready [evt->n]=0;
+    evt->nfd   [evt->n]=0;
+    return evt->n++;
+}
+/* update descriptors of stream event ----------------------------------------*/
+static int updateevt(strevt_t *evt, int *pend)
+{
+    int i,j,k,n,fd[MAXEVTFD],*fds,npoll=0;
+    unsigned int gen[MAXEVTFD],*gens;
+#ifdef __linux__
+    struct epoll_event ev={0};
+#endif
+    *pend=0;
+    
+    for (i=0;i<evt->n;i++) {
+        strlock(evt->stream[i]);
+        n=getevtfd(evt->stream[i],fd,gen);
+        strunlock(evt->stream[i]);
+        
+        evt->ready[i]=0;
+        
+        if (n==-2) { /* buffered data exists */
+            evt->ready[i]=1;
+            (*pend)++;
+        }
+        if (n<0) n=0;
+        fds =evt->fd +i*MAXEVTFD;
+        gens=evt->gen+i*MAXEVTFD;
+        
+#ifdef __linux__
+        /* register new descriptors (closed ones are removed by kernel) */
+        for (j=0;j<n&&evt->efd>=0;j++) {
+            for (k=0;k<evt->nfd[i];k++) {
+                if (fds[k]==fd[j]&&gens[k]==gen[j]) break;
+            }
+            if (k<evt->nfd[i]) continue;
+            ev.events=EPOLLIN;
+            ev.data.u32=(unsigned int)i;
+            if (epoll_ctl(evt->efd,EPOLL_CTL_ADD,fd[j],&ev)<0&&
+                (errno!=EEXIST||
+                 epoll_ctl(evt->efd,EPOLL_CTL_MOD,fd[j],&ev)<0)) {
+                tracet(2,"updateevt: epoll_ctl error fd=%d err=%d\n",fd[j],
+                       errno);
+            }
+        }
+#endif
+        for (j=0;j<n;j++) {
+            fds[j]=fd[j]; gens[j]=gen[j];
+        }
+        evt->nfd[i]=n;
+        npoll+=n;
+    }
+    return npoll;
+}
+/* wait stream event -----------------------------------------------------------
+* wait for input data of streams in stream event
+* args   : strevt_t *evt    IO stream event
+*          int    msec      I  timeout (ms)
+* return : number of ready streams (0:timeout,-1:error)
+* notes  : evt->ready[i] is set to 1 if the i-th stream is ready to read.
+*          only tcp server, tcp client, ntrip client and serial (not win32)
+*          streams are waited for by epoll (linux) or poll. other streams like
+*          file or ftp are read after timeout as before.
+*          call strread() for the streams after return also on timeout to
+*          process connection, reconnection and inactive timeout of streams.
+*-----------------------------------------------------------------------------*/
+extern int strevtwait(strevt_t *evt, int msec)
+{
+#ifdef __linux__
+    struct epoll_event ev[256];
+#endif
+#ifndef WIN32
+    struct pollfd *pfd;
+    int j,k;
+#endif
+    int i,n,nr=0,npoll,pend;
+    
+    tracet(4,"strevtwait: n=%d msec=%d\n",evt->n,msec);
+    
+    npoll=updateevt(evt,&pend);
+    
+    if (pend>0) return pend;
+    if (msec<0) msec=0;
+    
+#ifdef WIN32
+    sleepms(msec); /* no event wait for win32 */
+    return 0;
+#else
+    if (npoll<=0) {
+        sleepms(msec);
+        return 0;
+    }
+#ifdef __linux__
+    if (evt->efd>=0) {
+        if ((n=epoll_wait(evt->efd,ev,256,msec))<0) {
+            return errno==EINTR?0:-1;
+        }
+        for (i=0;i<n;i++) {
+            if ((int)ev[i].data.u32>=evt->n) continue;
+            if (!evt->ready[ev[i].data.u32]) nr++;
+            evt->ready[ev[i].data.u32]=1;
+        }
+        return nr;
+    }
+#endif
+    if (!(pfd=(struct pollfd *)malloc(sizeof(struct pollfd)*npoll))) return -1;
+    
+    for (i=k=0;i<evt->n;i++) for (j=0;j<evt->nfd[i];j++) {
+        pfd[k].fd=evt->fd[i*MAXEVTFD+j];
+        pfd[k].events=POLLIN;
+        pfd[k++].revents=0;
+    }
+    if ((n=poll(pfd,k,msec))>0) {
+        for (i=k=0;i<evt->n;i++) for (j=0;j<evt->nfd[i];j++) {
+            if (!pfd[k++].revents||evt->ready[i]) continue;
+            evt->ready[i]=1;
+            nr++;
+        }
+    }
+    free(pfd);
+    return n<0?(errno==EINTR?0:-1):nr;
+#endif
+}
 /* send nmea request -----------------------------------------------------------
 * send nmea gpgga message to stream
 * args   : stream_t *stream I   stream
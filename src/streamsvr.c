@@ -13,6 +13,8 @@
 *                           suppress warnings
 *           2013/05/08 1.4  fix bug on 1 s offset for javad -> rtcm conversion
 *           2014/10/16 1.5  support input from stdout
+*           2026/10/18 1.6  wait input data by stream event instead of sleep
+*           2026/10/18 1.7  share output messages of identical stream converters
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -91,6 +93,8 @@ extern strconv_t *strconvnew(int itype, int otype, const char *msgs, int staid,
         return NULL;
     }
     if (stasel) conv->out.staid=staid;
+    conv->nref=conv->nfbuf=conv->fbufsize=0;
+    conv->fbuf=NULL;
     sprintf(conv->rtcm.opt,"-EPHALL %s",opt);
     sprintf(conv->raw.opt ,"-EPHALL %s",opt);
     return conv;
@@ -106,6 +110,7 @@ extern void strconvfree(strconv_t *conv)
     free_rtcm(&conv->rtcm);
     free_rtcm(&conv->out);
     free_raw(&conv->raw);
+    free(conv->fbuf);
     free(conv);
 }
 /* copy received data from receiver raw to rtcm ------------------------------*/
@@ -184,6 +189,27 @@ static void rtcm2rtcm(rtcm_t *out, const rtcm_t *rtcm, int ret, int stasel)
         out->nav.leaps=rtcm->nav.leaps;
     }
 }
+/* write message to stream and shared message buffer ------------------------*/
+static void write_msg(stream_t *str, strconv_t *conv)
+{
+    unsigned char *p;
+    int n=conv->out.nbyte;
+    
+    strwrite(str,conv->out.buff,n);
+    
+    if (conv->nref<=0) return;
+    
+    if (conv->nfbuf+n>conv->fbufsize) {
+        if (!(p=(unsigned char *)realloc(conv->fbuf,conv->nfbuf*2+n))) {
+            trace(1,"write_msg: shared message buffer overflow\n");
+            return;
+        }
+        conv->fbuf=p;
+        conv->fbufsize=conv->nfbuf*2+n;
+    }
+    memcpy(conv->fbuf+conv->nfbuf,conv->out.buff,n);
+    conv->nfbuf+=n;
+}
 /* write obs data messages ---------------------------------------------------*/
 static void write_obs(gtime_t time, stream_t *str, strconv_t *conv)
 {
@@ -207,7 +233,7 @@ static void write_obs(gtime_t time, stream_t *str, strconv_t *conv)
         else continue;
         
         /* write messages to stream */
-        strwrite(str,conv->out.buff,conv->out.nbyte);
+        write_msg(str,conv);
     }
 }
 /* write nav data messages ---------------------------------------------------*/
@@ -228,7 +254,7 @@ static void write_nav(gtime_t time, stream_t *str, strconv_t *conv)
         else continue;
         
         /* write messages to stream */
-        strwrite(str,conv->out.buff,conv->out.nbyte);
+        write_msg(str,conv);
     }
 }
 /* next ephemeris satellite --------------------------------------------------*/
@@ -261,7 +287,7 @@ static int nextsat(nav_t *nav, int sat, int msg)
     return 0;
 }
 /* write cyclic nav data messages --------------------------------------------*/
-static void write_nav_cycle(stream_t *str, strconv_t *conv)
+static void write_nav_cycle(stream_t *str, strconv_t *conv, rtcm_t *out)
 {
     unsigned int tick=tickget();
     int i,sat,tint;
@@ -275,26 +301,26 @@ static void write_nav_cycle(stream_t *str, strconv_t *conv)
         conv->tick[i]=tick;
         
         /* next satellite */
-        if (!(sat=nextsat(&conv->out.nav,conv->ephsat[i],conv->msgs[i]))) {
+        if (!(sat=nextsat(&out->nav,conv->ephsat[i],conv->msgs[i]))) {
             continue;
         }
-        conv->out.ephsat=conv->ephsat[i]=sat;
+        out->ephsat=conv->ephsat[i]=sat;
         
         /* generate messages */
         if (conv->otype==STRFMT_RTCM2) {
-            if (!gen_rtcm2(&conv->out,conv->msgs[i],0)) continue;
+            if (!gen_rtcm2(out,conv->msgs[i],0)) continue;
         }
         else if (conv->otype==STRFMT_RTCM3) {
-            if (!gen_rtcm3(&conv->out,conv->msgs[i],0)) continue;
+            if (!gen_rtcm3(out,conv->msgs[i],0)) continue;
         }
         else continue;
         
         /* write messages to stream */
-        strwrite(str,conv->out.buff,conv->out.nbyte);
+        strwrite(str,out->buff,out->nbyte);
     }
 }
 /* write cyclic station info messages ----------------------------------------*/
-static void write_sta_cycle(stream_t *str, strconv_t *conv)
+static void write_sta_cycle(stream_t *str, strconv_t *conv, rtcm_t *out)
 {
     unsigned int tick=tickget();
     int i,tint;
@@ -309,15 +335,15 @@ static void write_sta_cycle(stream_t *str, strconv_t *conv)
         
         /* generate messages */
         if (conv->otype==STRFMT_RTCM2) {
-            if (!gen_rtcm2(&conv->out,conv->msgs[i],0)) continue;
+            if (!gen_rtcm2(out,conv->msgs[i],0)) continue;
         }
         else if (conv->otype==STRFMT_RTCM3) {
-            if (!gen_rtcm3(&conv->out,conv->msgs[i],0)) continue;
+            if (!gen_rtcm3(out,conv->msgs[i],0)) continue;
         }
         else continue;
         
         /* write messages to stream */
-        strwrite(str,conv->out.buff,conv->out.nbyte);
+        strwrite(str,out->buff,out->nbyte);
     }
 }
 /* convert stearm ------------------------------------------------------------*/
@@ -325,6 +351,8 @@ static void strconv(stream_t *str, strconv_t *conv, unsigned char *buff, int n)
 {
     int i,ret;
     
+    conv->nfbuf=0;
+    
     for (i=0;i<n;i++) {
         
         /* input rtcm 2 messages */
@@ -349,8 +377,49 @@ static void strconv(stream_t *str, strconv_t *conv, unsigned char *buff, int n)
         }
     }
     /* write cyclic nav data and station info messages to stream */
-    write_nav_cycle(str,conv);
-    write_sta_cycle(str,conv);
+    write_nav_cycle(str,conv,&conv->out);
+    write_sta_cycle(str,conv,&conv->out);
+}
+/* convert stream by shared converter ----------------------------------------*/
+static void strconvshare(stream_t *str, strconv_t *conv, strconv_t *src)
+{
+    /* write obs and nav data messages generated by source converter */
+    strwrite(str,src->fbuf,src->nfbuf);
+    
+    /* write cyclic nav data and station info messages to stream */
+    write_nav_cycle(str,conv,&src->out);
+    write_sta_cycle(str,conv,&src->out);
+}
+/* test identical stream converters ------------------------------------------*/
+static int eqconv(const strconv_t *conv1, const strconv_t *conv2)
+{
+    const sta_t *sta1=&conv1->out.sta,*sta2=&conv2->out.sta;
+    int i;
+    
+    if (conv1->itype!=conv2->itype||conv1->otype!=conv2->otype||
+        conv1->stasel!=conv2->stasel||conv1->nmsg!=conv2->nmsg||
+        conv1->out.staid!=conv2->out.staid||
+        strcmp(conv1->rtcm.opt,conv2->rtcm.opt)||
+        strcmp(conv1->raw.opt,conv2->raw.opt)) {
+        return 0;
+    }
+    for (i=0;i<conv1->nmsg;i++) {
+        if (conv1->msgs[i]!=conv2->msgs[i]||conv1->tint[i]!=conv2->tint[i]) {
+            return 0;
+        }
+    }
+    if (strcmp(sta1->name,sta2->name)||strcmp(sta1->marker,sta2->marker)||
+        strcmp(sta1->antdes,sta2->antdes)||strcmp(sta1->antsno,sta2->antsno)||
+        strcmp(sta1->rectype,sta2->rectype)||
+        strcmp(sta1->recver,sta2->recver)||strcmp(sta1->recsno,sta2->recsno)||
+        sta1->antsetup!=sta2->antsetup||sta1->itrf!=sta2->itrf||
+        sta1->deltype!=sta2->deltype||sta1->hgt!=sta2->hgt) {
+        return 0;
+    }
+    for (i=0;i<3;i++) {
+        if (sta1->pos[i]!=sta2->pos[i]||sta1->del[i]!=sta2->del[i]) return 0;
+    }
+    return 1;
 }
 /* stearm server thread ------------------------------------------------------*/
 #ifdef WIN32
@@ -360,11 +429,15 @@ static void *strsvrthread(void *arg)
 #endif
 {
     strsvr_t *svr=(strsvr_t *)arg;
+    strevt_t evt;
     unsigned int tick,ticknmea;
     int i,n;
     
     tracet(3,"strsvrthread:\n");
     
+    /* wait input data by stream event (or sleep if not pollable) */
+    if (strevtinit(&evt,1)) strevtadd(&evt,svr->stream);
+    
     svr->state=1;
     svr->tick=tickget();
     ticknmea=svr->tick-1000;
@@ -377,7 +450,11 @@ static void *strsvrthread(void *arg)
         
         /* write data to output streams */
         for (i=1;i<svr->nstr;i++) {
-            if (svr->conv[i-1]) {
+            if (svr->conv[i-1]&&svr->share[i-1]>=0) {
+                strconvshare(svr->stream+i,svr->conv[i-1],
+                             svr->conv[svr->share[i-1]]);
+            }
+            else if (svr->conv[i-1]) {
                 strconv(svr->stream+i,svr->conv[i-1],svr->buff,n);
             }
             else {
@@ -395,8 +472,10 @@ static void *strsvrthread(void *arg)
         }
         unlock(&svr->lock);
         
-        sleepms(svr->cycle-(int)(tickget()-tick));
+        /* wait for input data until next cycle */
+        strevtwait(&evt,svr->cycle-(int)(tickget()-tick));
     }
+    strevtfree(&evt);
     for (i=0;i<svr->nstr;i++) strclose(svr->stream+i);
     svr->npb=0;
     free(svr->buff); svr->buff=NULL;
@@ -426,7 +505,10 @@ extern void strsvrinit(strsvr_t *svr, int nout)
     svr->tick=0;
     for (i=0;i<nout+1&&i<16;i++) strinit(svr->stream+i);
     svr->nstr=i;
-    for (i=0;i<16;i++) svr->conv[i]=NULL;
+    for (i=0;i<16;i++) {
+        svr->conv[i]=NULL;
+        svr->share[i]=-1;
+    }
     svr->thread=0;
     initlock(&svr->lock);
 }
@@ -458,11 +540,14 @@ extern void strsvrinit(strsvr_t *svr, int nout)
 *          char   *cmd      I   input stream start command (NULL: no cmd)
 *          double *nmeapos  I   nmea request position (ecef) (m) (NULL: no)
 * return : status (0:error,1:ok)
+* notes  : obs and nav data messages of converters with identical input format,
+*          output messages and station info are generated once by the first of
+*          them and shared with the others
 *-----------------------------------------------------------------------------*/
 extern int strsvrstart(strsvr_t *svr, int *opts, int *strs, char **paths,
                        strconv_t **conv, const char *cmd, const double *nmeapos)
 {
-    int i,rw,stropt[5]={0};
+    int i,j,rw,stropt[5]={0};
     char file1[MAXSTRPATH],file2[MAXSTRPATH],*p;
     
     tracet(3,"strsvrstart:\n");
@@ -479,7 +564,22 @@ extern int strsvrstart(strsvr_t *svr, int *opts, int *strs, char **paths,
     svr->nmeacycle=0<opts[5]&&opts[5]<1000?1000:opts[5]; /* >=1s */
     for (i=0;i<3;i++) svr->nmeapos[i]=nmeapos?nmeapos[i]:0.0;
     
-    for (i=0;i<svr->nstr-1;i++) svr->conv[i]=conv[i];
+    for (i=0;i<svr->nstr-1;i++) {
+        svr->conv[i]=conv[i];
+        svr->share[i]=-1;
+        if (conv[i]) conv[i]->nref=conv[i]->nfbuf=0;
+    }
+    /* share output messages of identical converters */
+    for (i=0;i<svr->nstr-1;i++) {
+        if (!conv[i]) continue;
+        for (j=0;j<i;j++) {
+            if (!conv[j]||svr->share[j]>=0||!eqconv(conv[i],conv[j])) continue;
+            tracet(2,"strsvrstart: converter %d shares converter %d\n",i+1,j+1);
+            svr->share[i]=j;
+            conv[j]->nref++;
+            break;
+        }
+    }
     
     if (!(svr->buff=(unsigned char *)malloc(svr->buffsize))||
         !(svr->pbuf=(unsigned char *)malloc(svr->buffsize))) {
@@ -14,6 +14,9 @@
 * history : 2012/11/01 1.0  new
 *           2013/01/25 1.1  fix bug on binary search
 *           2014/08/26 1.2  fix bug on tle_pos() to get tle by satid or desig
+*           2026/10/18 1.3  add catalog index by hash tables of satno and desig
+*                           added api:
+*                               tle_free(),tle_search(),tle_poss()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -39,6 +42,17 @@
 #define QOMS2T      1.88027916E-9       /* = pow((QO-SO)*AE/XKMPER,4.0) */
 #define S           1.01222928          /* = AE*(1.0+SO/XKMPER) */
 
+#define MAXTLETHREAD 64                 /* max number of propagator threads */
+
+typedef struct {        /* TLE propagation job type */
+    const gtime_t *tutc; /* times (UTC) */
+    const double *R3,*W; /* TEME->ECEF transformation matrices */
+    const int *index;   /* indexes of TLE data */
+    const tle_t *tle;   /* TLE data */
+    int nt,j0,j1;       /* number of times, satellite range [j0,j1) */
+    double *rs;         /* satellite positions/velocities */
+} tle_job_t;
+
 static void SGP4_STR3(double tsince, const tled_t *data, double *rs)
 {
     double xnodeo,omegao,xmo,eo,xincl,xno,xndt2o,xndd6o,bstar;
@@ -374,6 +388,73 @@ static int cmp_tle_data(const void *p1, const void *p2)
     const tled_t *q1=(const tled_t *)p1,*q2=(const tled_t *)p2;
     return strcmp(q1->name,q2->name);
 }
+/* hash of string -----------------------------------------------------------*/
+static unsigned int hash_str(const char *str)
+{
+    unsigned int h=5381;
+    
+    while (*str) h=h*33+(unsigned char)*str++;
+    return h;
+}
+/* update catalog index ------------------------------------------------------*/
+static int update_index(tle_t *tle)
+{
+    unsigned int h;
+    int i,j,k,*hash;
+    
+    free(tle->hash); tle->hash=NULL; tle->nhash=0;
+    
+    if (tle->n<=0) return 1;
+    
+    for (k=64;k<tle->n*2;k*=2) ;
+    
+    if (!(hash=(int *)calloc(k*2,sizeof(int)))) {
+        trace(1,"tle index malloc error\n");
+        return 0;
+    }
+    /* open addressing hash tables by satno and desig (first index kept) */
+    for (i=0;i<tle->n;i++) {
+        for (h=hash_str(tle->data[i].satno)&(k-1);(j=hash[h]);h=(h+1)&(k-1)) {
+            if (!strcmp(tle->data[j-1].satno,tle->data[i].satno)) break;
+        }
+        if (!j) hash[h]=i+1;
+        
+        for (h=hash_str(tle->data[i].desig)&(k-1);(j=hash[k+h]);h=(h+1)&(k-1)) {
+            if (!strcmp(tle->data[j-1].desig,tle->data[i].desig)) break;
+        }
+        if (!j) hash[k+h]=i+1;
+    }
+    tle->hash=hash;
+    tle->nhash=k;
+    return 1;
+}
+/* search TLE data by catalog number or international designator -------------*/
+static int search_cat(const tle_t *tle, const char *satno, const char *desig)
+{
+    unsigned int h,k=(unsigned int)tle->nhash;
+    int i,j,n=tle->n;
+    
+    if (!tle->hash) { /* serial search */
+        for (i=0;i<tle->n;i++) {
+            if (!strcmp(tle->data[i].satno,satno)||
+                !strcmp(tle->data[i].desig,desig)) break;
+        }
+        return i;
+    }
+    for (h=hash_str(satno)&(k-1);(j=tle->hash[h]);h=(h+1)&(k-1)) {
+        if (!strcmp(tle->data[j-1].satno,satno)) {
+            n=j-1;
+            break;
+        }
+    }
+    for (h=hash_str(desig)&(k-1);(j=tle->hash[k+h]);h=(h+1)&(k-1)) {
+        if (!strcmp(tle->data[j-1].desig,desig)) {
+            if (j-1<n) n=j-1;
+            break;
+        }
+    }
+    return n;
+}
 /* read TLE file ---------------------------------------------------------------
 * read NORAD TLE (two line element) data file (ref [2],[3])
 * args   : char   *file     I   NORAD TLE data file
@@ -434,7 +515,9 @@ extern int tle_read(const char *file, tle_t *tle)
     
     /* sort tle data by satellite name */
     if (tle->n>0) qsort(tle->data,tle->n,sizeof(tled_t),cmp_tle_data);
-    return 1;
+    
+    /* update catalog index */
+    return update_index(tle);
 }
 /* read TLE satellite name file ------------------------------------------------
 * read TLE satellite name file
@@ -470,11 +553,7 @@ extern int tle_name_read(const char *file, tle_t *tle)
         if (sscanf(buff,"%s %s %s",name,satno,desig)<2) continue;
         satno[5]='\0';
         
-        for (i=0;i<tle->n;i++) {
-            if (!strcmp(tle->data[i].satno,satno)||
-                !strcmp(tle->data[i].desig,desig)) break;
-        }
-        if (i>=tle->n) {
+        if ((i=search_cat(tle,satno,desig))>=tle->n) {
             trace(3,"no tle data: satno=%s desig=%s\n",satno,desig);
             continue;
         }
@@ -485,28 +564,34 @@ extern int tle_name_read(const char *file, tle_t *tle)
     
     /* sort tle data by satellite name */
     if (tle->n>0) qsort(tle->data,tle->n,sizeof(tled_t),cmp_tle_data);
-    return 1;
+    
+    /* update catalog index */
+    return update_index(tle);
 }
-/* satellite position and velocity with TLE data -------------------------------
-* compute satellite position and velocity in ECEF with TLE data
-* args   : gtime_t time     I   time (GPST)
-*          char   *name     I   satellite name           ("": not specified)
+/* free TLE data ---------------------------------------------------------------
+* free TLE data and catalog index
+* args   : tle_t  *tle      IO  TLE data
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void tle_free(tle_t *tle)
+{
+    free(tle->data); tle->data=NULL; tle->n=tle->nmax=0;
+    free(tle->hash); tle->hash=NULL; tle->nhash=0;
+}
+/* search TLE data -------------------------------------------------------------
+* search TLE data by satellite name, catalog number or international designator
+* args   : char   *name     I   satellite name           ("": not specified)
 *          char   *satno    I   satellite catalog number ("": not specified)
 *          char   *desig    I   international designaor  ("": not specified)
 *          tle_t  *tle      I   TLE data
-*          erp_t  *erp      I   EOP data (NULL: not used)
-*          double *rs       O   sat position/velocity {x,y,z,vx,vy,vz} (m,m/s)
-* return : status (1:ok,0:error)
-* notes  : the coordinates of the position and velocity are ECEF (ITRF)
-*          if erp == NULL, polar motion and ut1-utc are neglected
+* return : index of TLE data (-1: no data)
+* notes  : the satellite name is searched at first by binary search. if not
+*          found, the catalog number or the international designator is
+*          searched by the catalog index built by tle_read()/tle_name_read().
 *-----------------------------------------------------------------------------*/
-extern int tle_pos(gtime_t time, const char *name, const char *satno,
-                   const char *desig, const tle_t *tle, const erp_t *erp,
-                   double *rs)
+extern int tle_search(const char *name, const char *satno, const char *desig,
+                      const tle_t *tle)
 {
-    gtime_t tutc;
-    double tsince,rs_tle[6],rs_pef[6],gmst;
-    double R1[9]={0},R2[9]={0},R3[9]={0},W[9],erpv[5]={0};
     int i=0,j,k,stat=1;
     
     /* binary search by satellite name */
@@ -517,42 +602,189 @@ extern int tle_pos(gtime_t time, const char *name, const char *satno,
             if (stat<0) k=i-1; else j=i+1;
         }
     }
-    /* serial search by catalog no or international designator */
+    /* search by catalog no or international designator */
     if (stat&&(*satno||*desig)) {
-        for (i=0;i<tle->n;i++) {
-            if (!strcmp(tle->data[i].satno,satno)||
-                !strcmp(tle->data[i].desig,desig)) break;
-        }
-        if (i<tle->n) stat=0;
+        if ((i=search_cat(tle,satno,desig))<tle->n) stat=0;
     }
     if (stat) {
         trace(3,"no tle data: name=%s satno=%s desig=%s\n",name,satno,desig);
-        return 0;
+        return -1;
     }
-    tutc=gpst2utc(time);
-    
-    /* time since epoch (min) */
-    tsince=timediff(tutc,tle->data[i].epoch)/60.0;
+    return i;
+}
+/* TEME to ECEF transformation matrices --------------------------------------*/
+static void teme2ecef(gtime_t time, const erp_t *erp, double *R3, double *W)
+{
+    double R1[9]={0},R2[9]={0},erpv[5]={0},gmst;
+    int i;
     
-    /* SGP4 model propagator by STR#3 */
-    SGP4_STR3(tsince,tle->data+i,rs_tle);
+    for (i=0;i<9;i++) R3[i]=0.0;
     
     /* erp values */
     if (erp) geterp(erp,time,erpv);
     
     /* GMST (rad) */
-    gmst=utc2gmst(tutc,erpv[2]);
+    gmst=utc2gmst(gpst2utc(time),erpv[2]);
     
     /* TEME (true equator, mean eqinox) -> ECEF (ref [2] IID, Appendix C) */
     R1[0]=1.0; R1[4]=R1[8]=cos(-erpv[1]); R1[7]=sin(-erpv[1]); R1[5]=-R1[7];
     R2[4]=1.0; R2[0]=R2[8]=cos(-erpv[0]); R2[2]=sin(-erpv[0]); R2[6]=-R2[2];
     R3[8]=1.0; R3[0]=R3[4]=cos(gmst); R3[3]=sin(gmst); R3[1]=-R3[3];
+    matmul("NN",3,3,3,1.0,R1,R2,0.0,W);
+}
+/* satellite position and velocity by TLE data -------------------------------*/
+static void tle_pos_i(gtime_t tutc, const tled_t *data, const double *R3,
+                      const double *W, double *rs)
+{
+    double tsince,rs_tle[6],rs_pef[6];
+    
+    /* time since epoch (min) */
+    tsince=timediff(tutc,data->epoch)/60.0;
+    
+    /* SGP4 model propagator by STR#3 */
+    SGP4_STR3(tsince,data,rs_tle);
+    
     matmul("NN",3,1,3,1.0,R3,rs_tle  ,0.0,rs_pef  );
     matmul("NN",3,1,3,1.0,R3,rs_tle+3,0.0,rs_pef+3);
     rs_pef[3]+=OMGE*rs_pef[1];
     rs_pef[4]-=OMGE*rs_pef[0];
-    matmul("NN",3,3,3,1.0,R1,R2,0.0,W);
     matmul("NN",3,1,3,1.0,W,rs_pef  ,0.0,rs  );
     matmul("NN",3,1,3,1.0,W,rs_pef+3,0.0,rs+3);
+}
+/* satellite position and velocity with TLE data -------------------------------
+* compute satellite position and velocity in ECEF with TLE data
+* args   : gtime_t time     I   time (GPST)
+*          char   *name     I   satellite name           ("": not specified)
+*          char   *satno    I   satellite catalog number ("": not specified)
+*          char   *desig    I   international designaor  ("": not specified)
+*          tle_t  *tle      I   TLE data
+*          erp_t  *erp      I   EOP data (NULL: not used)
+*          double *rs       O   sat position/velocity {x,y,z,vx,vy,vz} (m,m/s)
+* return : status (1:ok,0:error)
+* notes  : the coordinates of the position and velocity are ECEF (ITRF)
+*          if erp == NULL, polar motion and ut1-utc are neglected
+*-----------------------------------------------------------------------------*/
+extern int tle_pos(gtime_t time, const char *name, const char *satno,
+                   const char *desig, const tle_t *tle, const erp_t *erp,
+                   double *rs)
+{
+    double R3[9],W[9];
+    int i;
+    
+    if ((i=tle_search(name,satno,desig,tle))<0) return 0;
+    
+    /* TEME -> ECEF transformation */
+    teme2ecef(time,erp,R3,W);
+    
+    tle_pos_i(gpst2utc(time),tle->data+i,R3,W,rs);
     return 1;
 }
+/* propagate TLE data for a block of satellites ------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI tle_poss_thread(void *arg)
+#else
+static void *tle_poss_thread(void *arg)
+#endif
+{
+    tle_job_t *job=(tle_job_t *)arg;
+    const tled_t *data;
+    int i,j,k;
+    
+    for (j=job->j0;j<job->j1;j++) {
+        k=job->index?job->index[j]:j;
+        if (k<0||k>=job->tle->n) continue;
+        data=job->tle->data+k;
+        
+        for (i=0;i<job->nt;i++) {
+            tle_pos_i(job->tutc[i],data,job->R3+i*9,job->W+i*9,
+                      job->rs+(i+j*job->nt)*6);
+        }
+    }
+    return 0;
+}
+/* satellite positions and velocities with TLE data ----------------------------
+* compute satellite positions and velocities in ECEF with TLE data for
+* satellites and times
+* args   : gtime_t *time    I   times (GPST) (nt)
+*          int    nt        I   number of times
+*          int    *index    I   indexes of TLE data (n) (NULL: 0,1,...,n-1)
+*          int    n         I   number of satellites
+*          tle_t  *tle      I   TLE data
+*          erp_t  *erp      I   EOP data (NULL: not used)
+*          int    nthread   I   number of threads (<=1: single thread)
+*          double *rs       O   sat positions/velocities (6 x nt x n)
+*                               rs[(i+j*nt)*6+k]: {x,y,z,vx,vy,vz} (m,m/s) of
+*                               time i and satellite j
+* return : number of satellites with TLE data
+* notes  : same as tle_pos() for each satellite and time. the TEME to ECEF
+*          transformation is computed once for each time and shared by all
+*          satellites. the satellites are propagated in parallel by nthread
+*          threads. the indexes of TLE data are given by tle_search().
+*          rs for a satellite without TLE data is set to zero.
+*-----------------------------------------------------------------------------*/
+extern int tle_poss(const gtime_t *time, int nt, const int *index, int n,
+                    const tle_t *tle, const erp_t *erp, int nthread,
+                    double *rs)
+{
+    tle_job_t job[MAXTLETHREAD]={{0}};
+    thread_t thread[MAXTLETHREAD];
+    gtime_t *tutc;
+    double *R3,*W;
+    int i,j,ns=0,stat[MAXTLETHREAD]={0};
+    
+    trace(3,"tle_poss: nt=%d n=%d nthread=%d\n",nt,n,nthread);
+    
+    for (i=0;i<6*nt*n;i++) rs[i]=0.0;
+    
+    if (nt<=0||n<=0) return 0;
+    
+    if (!(tutc=(gtime_t *)malloc(sizeof(gtime_t)*nt))) {
+        trace(1,"tle_poss: malloc error\n");
+        return 0;
+    }
+    R3=mat(9,nt); W=mat(9,nt);
+    
+    /* TEME -> ECEF transformation for each time */
+    for (i=0;i<nt;i++) {
+        tutc[i]=gpst2utc(time[i]);
+        teme2ecef(time[i],erp,R3+i*9,W+i*9);
+    }
+    if (nthread<1) nthread=1;
+    if (nthread>MAXTLETHREAD) nthread=MAXTLETHREAD;
+    if (nthread>n) nthread=n;
+    
+    for (i=0;i<nthread;i++) {
+        job[i].tutc=tutc; job[i].R3=R3; job[i].W=W; job[i].nt=nt;
+        job[i].index=index; job[i].tle=tle; job[i].rs=rs;
+        job[i].j0=n*i/nthread;
+        job[i].j1=n*(i+1)/nthread;
+    }
+    /* propagate satellites in parallel */
+    for (i=1;i<nthread;i++) {
+#ifdef WIN32
+        stat[i]=(thread[i]=CreateThread(NULL,0,tle_poss_thread,job+i,0,NULL))
+                !=NULL;
+#else
+        stat[i]=!pthread_create(thread+i,NULL,tle_poss_thread,job+i);
+#endif
+        if (!stat[i]) tle_poss_thread(job+i); /* fallback to serial */
+    }
+    tle_poss_thread(job);
+    
+    for (i=1;i<nthread;i++) {
+        if (!stat[i]) continue;
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+    free(tutc); free(R3); free(W);
+    
+    for (j=0;j<n;j++) {
+        i=index?index[j]:j;
+        if (i>=0&&i<tle->n) ns++;
+    }
+    return ns;
+}
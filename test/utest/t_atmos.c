@@ -140,11 +140,40 @@ void utest4(void)
     
     printf("%s utest4 : OK\n",__FILE__);
 }
+/* tropmapfs() */
+void utest5(void)
+{
+    double e1[]={2007,1,16,6,0,0};
+    double pos1[]={ 35*D2R, 140*D2R, 100.0};
+    double pos2[]={-80*D2R,-170*D2R,1000.0};
+    double pos3[]={-80*D2R,-170*D2R,30000.0};
+    double azel[]={60*D2R,75*D2R,190*D2R,3*D2R,350*D2R,60*D2R,0*D2R,90*D2R,
+                   10*D2R,-5*D2R};
+    double *pos[3],mapfh[5],mapfw[5],mapfd,mapfw1;
+    gtime_t t1=epoch2time(e1);
+    int i,j;
+    
+    pos[0]=pos1; pos[1]=pos2; pos[2]=pos3;
+    
+    for (i=0;i<3;i++) {
+        tropmapfs(t1,pos[i],azel,5,mapfh,mapfw);
+        for (j=0;j<5;j++) {
+            mapfd=tropmapf(t1,pos[i],azel+j*2,&mapfw1);
+            assert(mapfh[j]==mapfd&&mapfw[j]==mapfw1);
+        }
+        tropmapfs(t1,pos[i],azel,5,mapfh,NULL);
+        for (j=0;j<5;j++) {
+            assert(mapfh[j]==tropmapf(t1,pos[i],azel+j*2,NULL));
+        }
+    }
+    printf("%s utest5 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
     utest4();
+    utest5();
     return 0;
 }
@@ -0,0 +1,644 @@
+/*------------------------------------------------------------------------------
+* rtklib performance benchmark : end-to-end throughput of processing pipelines
+*
+* usage: t_bench [-o file] [-n loops] [-s seed] [name ...]
+*
+* run the benchmarks (default: all) each in a child process and output the
+* results as a json document. the observation data are generated by simobs
+* with fixed seeds (make bench). the results of each benchmark are:
+*
+*   epochs          : number of processed epochs (lambda: calls, mergeprod:
+*                     merged epochs) per loop
+*   solutions/fixed : number of solutions and fixed solutions per loop
+*   epochs_per_sec  : throughput (epochs/s)
+*   mb_per_sec      : input throughput (MB/s)
+*   lat_p50_us/p99  : latency (us) per lat_unit (epoch, call or loop)
+*   peak_rss_kb     : peak resident set size of the process (KB)
+*-----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 199309
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#ifndef WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+#include "../../src/rtklib.h"
+
+#define BASEOBS     "bench_base.obs"    /* simulated base station obs */
+#define ROVOBS      "bench_rov.obs"     /* simulated rover obs */
+#define SIMNAV      "../../util/simobs/sim/brdc0910.09%c" /* nav of simobs */
+#define RTCMFILE    "../data/rcvraw/GMSD7_20121014.rtcm3" /* rtcm 3 log */
+#define RAWFILE     "../data/rcvraw/oemv_200911218.gps" /* novatel raw log */
+#define CONVOBS     "bench_conv.obs"    /* convrnx output obs */
+#define CONVNAV     "bench_conv.nav"    /* convrnx output nav */
+#define STRCONVOUT  "bench_strconv.rtcm3" /* strconv output */
+#define CONVMSGS    "1077,1087,1097,1019,1020" /* strconv output messages */
+#define PRODFILE    "bench_%s%04d%d.%s" /* generated products (ac,week,dow) */
+#define PRODDAYS    30                  /* days of generated products */
+#define MAXLINE     4096                /* max length of result line */
+
+typedef struct {                        /* benchmark result type */
+    const char *name;                   /* benchmark name */
+    const char *input;                  /* input file */
+    const char *unit;                   /* latency unit */
+    int loops;                          /* number of loops */
+    int nepoch;                         /* number of epochs per loop */
+    int nsol,nfix;                      /* number of solutions/fixed (-1:none) */
+    double bytes;                       /* input bytes per loop */
+    double time;                        /* total time (s) */
+    double *lat;                        /* latencies (s) */
+    int nlat,nmax;                      /* number of latencies */
+} result_t;
+
+static unsigned int seed_=1;            /* seed of random numbers */
+
+/* dummy application functions for convrnx() ---------------------------------*/
+extern int showmsg(char *format, ...) {return 0;}
+extern void settspan(gtime_t ts, gtime_t te) {}
+extern void settime(gtime_t time) {}
+
+/* high resolution timer (s) -------------------------------------------------*/
+static double timer(void)
+{
+#ifdef WIN32
+    LARGE_INTEGER freq,count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart/freq.QuadPart;
+#else
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC,&tp);
+    return tp.tv_sec+tp.tv_nsec*1E-9;
+#endif
+}
+/* peak resident set size (KB) (-1: unknown) ---------------------------------*/
+static long peakrss(void)
+{
+#ifdef WIN32
+    return -1;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF,&ru)) return -1;
+    return ru.ru_maxrss;
+#endif
+}
+/* uniform random number in [0,1) by seeded lcg -----------------------------*/
+static double randu(void)
+{
+    seed_=seed_*1103515245u+12345u;
+    return ((seed_>>8)&0xFFFFFF)/16777216.0;
+}
+/* file size (bytes) ---------------------------------------------------------*/
+static double filesize(const char *file)
+{
+    FILE *fp;
+    long size;
+    
+    if (!(fp=fopen(file,"rb"))) return 0.0;
+    fseek(fp,0,SEEK_END);
+    size=ftell(fp);
+    fclose(fp);
+    return (double)size;
+}
+/* add latency ---------------------------------------------------------------*/
+static void addlat(result_t *res, double t)
+{
+    double *lat;
+    
+    if (res->nlat>=res->nmax) {
+        res->nmax=res->nmax<=0?4096:res->nmax*2;
+        if (!(lat=(double *)realloc(res->lat,sizeof(double)*res->nmax))) {
+            res->nmax=res->nlat;
+            return;
+        }
+        res->lat=lat;
+    }
+    res->lat[res->nlat++]=t;
+}
+static int cmplat(const void *p1, const void *p2)
+{
+    double d=*(const double *)p1-*(const double *)p2;
+    return d<0.0?-1:(d>0.0?1:0);
+}
+/* output number or null in json ---------------------------------------------*/
+static void outnum(FILE *fp, const char *key, double val, int valid)
+{
+    if (valid) fprintf(fp,",\"%s\":%.6g",key,val);
+    else fprintf(fp,",\"%s\":null",key);
+}
+/* output benchmark result as json object in a line --------------------------*/
+static void outresult(FILE *fp, result_t *res)
+{
+    double t=res->time;
+    
+    qsort(res->lat,res->nlat,sizeof(double),cmplat);
+    
+    fprintf(fp,"{\"name\":\"%s\",\"input\":\"%s\",\"loops\":%d,\"epochs\":%d",
+            res->name,res->input,res->loops,res->nepoch);
+    outnum(fp,"time",t,1);
+    outnum(fp,"epochs_per_sec",res->nepoch*res->loops/t,t>0.0&&res->nepoch>0);
+    outnum(fp,"mb_per_sec",res->bytes*res->loops/t/1E6,t>0.0&&res->bytes>0.0);
+    outnum(fp,"solutions",res->nsol,res->nsol>=0);
+    outnum(fp,"fixed",res->nfix,res->nfix>=0);
+    fprintf(fp,",\"lat_unit\":\"%s\"",res->unit);
+    outnum(fp,"lat_p50_us",res->nlat>0?res->lat[res->nlat/2]*1E6:0.0,
+           res->nlat>0);
+    outnum(fp,"lat_p99_us",res->nlat>0?res->lat[(int)(0.99*(res->nlat-1))]*1E6:
+           0.0,res->nlat>0);
+    outnum(fp,"peak_rss_kb",(double)peakrss(),peakrss()>=0);
+    fprintf(fp,"}\n");
+}
+/* read simulated nav data ---------------------------------------------------*/
+static void readsimnav(nav_t *nav)
+{
+    const char ext[]="ngl";
+    char file[1024];
+    int i;
+    
+    for (i=0;ext[i];i++) {
+        sprintf(file,SIMNAV,ext[i]);
+        readrnx(file,0,"",NULL,nav,NULL);
+    }
+    uniqnav(nav);
+}
+/* count epochs of sorted obs data -------------------------------------------*/
+static int cntepoch(const obs_t *obs)
+{
+    int i,n=0;
+    
+    for (i=0;i<obs->n;i++) {
+        if (i==0||timediff(obs->data[i].time,obs->data[i-1].time)>DTTOL) n++;
+    }
+    return n;
+}
+/* readrnxt() ----------------------------------------------------------------*/
+static int bench_readrnxt(result_t *res)
+{
+    obs_t obs={0};
+    nav_t nav={0};
+    gtime_t t0={0};
+    double t;
+    int i;
+    
+    res->input=ROVOBS;
+    res->unit="loop";
+    res->bytes=filesize(ROVOBS);
+    
+    for (i=0;i<res->loops;i++) {
+        t=timer();
+        if (readrnxt(ROVOBS,1,t0,t0,0.0,"",&obs,&nav,NULL)<=0) return 0;
+        t=timer()-t;
+        res->time+=t;
+        addlat(res,t);
+        
+        if (i==0) {
+            sortobs(&obs);
+            res->nepoch=cntepoch(&obs);
+        }
+        free(obs.data); obs.data=NULL; obs.n=obs.nmax=0;
+        freenav(&nav,0xFF);
+    }
+    return 1;
+}
+/* convrnx() -----------------------------------------------------------------*/
+static int bench_convrnx(result_t *res)
+{
+    rnxopt_t opt={{0}};
+    obs_t obs={0};
+    nav_t nav={0};
+    gtime_t t0={0};
+    double t;
+    char *ofile[7]={CONVOBS,CONVNAV,"","","","",""};
+    int i,j;
+    
+    res->input=RAWFILE;
+    res->unit="loop";
+    res->bytes=filesize(RAWFILE);
+    
+    for (i=0;i<res->loops;i++) {
+        memset(&opt,0,sizeof(opt));
+        opt.rnxver=3.00;
+        opt.navsys=SYS_ALL;
+        opt.obstype=OBSTYPE_ALL;
+        opt.freqtype=FREQTYPE_ALL;
+        for (j=0;j<6;j++) memset(opt.mask[j],'1',64);
+        
+        t=timer();
+        if (convrnx(STRFMT_OEM4,&opt,RAWFILE,ofile)<=0) return 0;
+        t=timer()-t;
+        res->time+=t;
+        addlat(res,t);
+    }
+    if (readrnxt(CONVOBS,1,t0,t0,0.0,"",&obs,&nav,NULL)>0) {
+        sortobs(&obs);
+        res->nepoch=cntepoch(&obs);
+    }
+    free(obs.data);
+    freenav(&nav,0xFF);
+    remove(CONVOBS);
+    remove(CONVNAV);
+    return 1;
+}
+/* rtkpos() ------------------------------------------------------------------*/
+static int bench_rtkpos(result_t *res, int mode)
+{
+    prcopt_t opt=prcopt_default;
+    rtk_t rtk;
+    obs_t obs={0};
+    nav_t nav={0};
+    sta_t sta={{0}};
+    obsd_t data[MAXOBS*2];
+    gtime_t t0={0};
+    double t;
+    int i,j,k,m,n,nr,ne,rel=mode!=PMODE_SINGLE&&mode<PMODE_PPP_KINEMA;
+    
+    res->input=ROVOBS;
+    res->unit="epoch";
+    res->bytes=filesize(ROVOBS)+(rel?filesize(BASEOBS):0.0);
+    
+    readsimnav(&nav);
+    if (readrnxt(ROVOBS,1,t0,t0,0.0,"",&obs,&nav,NULL)<=0||
+        (rel&&readrnxt(BASEOBS,2,t0,t0,0.0,"",&obs,&nav,&sta)<=0)) {
+        free(obs.data);
+        freenav(&nav,0xFF);
+        return 0;
+    }
+    sortobs(&obs);
+    
+    opt.mode=mode;
+    opt.nf=2;
+    opt.navsys=SYS_GPS|SYS_GLO|SYS_GAL;
+    opt.elmin=15.0*D2R;
+    opt.sateph=EPHOPT_BRDC;
+    opt.ionoopt=mode>=PMODE_PPP_KINEMA?IONOOPT_IFLC:IONOOPT_BRDC;
+    opt.tropopt=mode>=PMODE_PPP_KINEMA?TROPOPT_EST:TROPOPT_SAAS;
+    opt.modear=ARMODE_CONT;
+    for (i=0;i<3;i++) opt.rb[i]=sta.pos[i];
+    
+    for (i=0;i<res->loops;i++) {
+        res->nsol=res->nfix=0;
+        rtkinit(&rtk,&opt);
+        
+        for (j=ne=0;j<obs.n;j=k) {
+            
+            /* rover obs followed by base station obs of the epoch */
+            for (k=j;k<obs.n;k++) {
+                if (timediff(obs.data[k].time,obs.data[j].time)>DTTOL) break;
+            }
+            for (m=j,n=nr=0;m<k&&n<MAXOBS*2;m++) {
+                if (obs.data[m].rcv==1) data[n++]=obs.data[m];
+            }
+            nr=n;
+            for (m=j;m<k&&n<MAXOBS*2;m++) {
+                if (obs.data[m].rcv==2) data[n++]=obs.data[m];
+            }
+            if (nr<=0) continue;
+            
+            t=timer();
+            rtkpos(&rtk,data,n,&nav);
+            t=timer()-t;
+            res->time+=t;
+            addlat(res,t);
+            ne++;
+            if (rtk.sol.stat!=SOLQ_NONE) res->nsol++;
+            if (rtk.sol.stat==SOLQ_FIX) res->nfix++;
+        }
+        rtkfree(&rtk);
+        res->nepoch=ne;
+    }
+    free(obs.data);
+    freenav(&nav,0xFF);
+    return 1;
+}
+/* lambda() ------------------------------------------------------------------*/
+static int bench_lambda(result_t *res)
+{
+    const int n=20,m=2,nprob=200;
+    double *a,*Q,*L,F[20*2],s[2],t;
+    int i,j,k,p;
+    
+    res->input="random";
+    res->unit="call";
+    
+    a=mat(n,nprob); Q=mat(n,n*nprob); L=mat(n,n);
+    
+    /* float ambiguities and covariances (Q=L*L'+0.001*I) */
+    for (p=0;p<nprob;p++) {
+        for (i=0;i<n;i++) {
+            for (j=0;j<n;j++) L[i+j*n]=j<=i?randu()-0.5:0.0;
+            a[i+p*n]=floor(randu()*2000.0-1000.0)+randu()*0.2-0.1;
+        }
+        matmul("NT",n,n,n,0.2,L,L,0.0,Q+p*n*n);
+        for (i=0;i<n;i++) Q[i+i*n+p*n*n]+=0.001;
+    }
+    for (k=0;k<res->loops;k++) {
+        for (p=0;p<nprob;p++) {
+            t=timer();
+            if (lambda(n,m,a+p*n,Q+p*n*n,F,s)) {
+                free(a); free(Q); free(L);
+                return 0;
+            }
+            t=timer()-t;
+            res->time+=t;
+            addlat(res,t);
+        }
+    }
+    res->nepoch=nprob;
+    free(a); free(Q); free(L);
+    return 1;
+}
+/* input_rtcm3() -------------------------------------------------------------*/
+static int bench_rtcm3(result_t *res)
+{
+    static rtcm_t rtcm;
+    FILE *fp;
+    unsigned char *buff;
+    double t,ts,t0;
+    int i,j,n,len,ne;
+    
+    res->input=RTCMFILE;
+    res->unit="epoch";
+    
+    if (!(fp=fopen(RTCMFILE,"rb"))) return 0;
+    len=(int)filesize(RTCMFILE);
+    if (!(buff=(unsigned char *)malloc(len))) {
+        fclose(fp);
+        return 0;
+    }
+    n=(int)fread(buff,1,len,fp);
+    fclose(fp);
+    res->bytes=n;
+    
+    for (i=0;i<res->loops;i++) {
+        if (!init_rtcm(&rtcm)) {
+            free(buff);
+            return 0;
+        }
+        t0=ts=timer();
+        for (j=ne=0;j<n;j++) {
+            if (input_rtcm3(&rtcm,buff[j])!=1) continue;
+            
+            /* latency from end of previous epoch */
+            t=timer();
+            addlat(res,t-ts);
+            ts=t;
+            ne++;
+        }
+        res->time+=timer()-t0;
+        free_rtcm(&rtcm);
+        res->nepoch=ne;
+    }
+    free(buff);
+    return 1;
+}
+/* strconv() by stream server ------------------------------------------------*/
+static int bench_strconv(result_t *res)
+{
+    static strsvr_t svr;
+    strconv_t *conv[1];
+    int opts[]={10000,10000,2000,32768,0,0,30};
+    int i,strs[2]={STR_FILE,STR_FILE},stat[2],byte[2],bps[2];
+    char *paths[2]={RAWFILE,STRCONVOUT},msg[MAXSTRMSG];
+    double t;
+    
+    res->input=RAWFILE;
+    res->unit="loop";
+    res->bytes=filesize(RAWFILE);
+    
+    for (i=0;i<res->loops;i++) {
+        if (!(conv[0]=strconvnew(STRFMT_OEM4,STRFMT_RTCM3,CONVMSGS,0,0,""))) {
+            return 0;
+        }
+        strsvrinit(&svr,1);
+        
+        t=timer();
+        if (!strsvrstart(&svr,opts,strs,paths,conv,NULL,NULL)) {
+            strconvfree(conv[0]);
+            return 0;
+        }
+        /* wait for end of input */
+        do {
+            sleepms(1);
+            strsvrstat(&svr,stat,byte,bps,msg);
+        } while (byte[0]<res->bytes&&stat[0]>0);
+        
+        strsvrstop(&svr,NULL);
+        t=timer()-t;
+        res->time+=t;
+        addlat(res,t);
+        strconvfree(conv[0]);
+    }
+    remove(STRCONVOUT);
+    return 1;
+}
+/* generate sp3 and rinex clock products of an analysis center for a day -----*/
+static int genprod(const char *ac, gtime_t ts, const double *phase, int k,
+                   char *sp3, char *clk)
+{
+    FILE *fp;
+    gtime_t time;
+    double ep[6],r,a;
+    int i,j,week,dow;
+    
+    dow=(int)(time2gpst(ts,&week)/86400.0);
+    sprintf(sp3,PRODFILE,ac,week,dow,"sp3");
+    sprintf(clk,PRODFILE,ac,week,dow,"clk");
+    
+    /* sp3 orbit (15 min, with 24:00 epoch overlapping next day) */
+    if (!(fp=fopen(sp3,"w"))) return 0;
+    time2epoch(ts,ep);
+    fprintf(fp,"#cP%4.0f %2.0f %2.0f %2.0f %2.0f %11.8f %7d ORBIT IGS08 HLM  "
+            "%s\n",ep[0],ep[1],ep[2],ep[3],ep[4],ep[5],97,ac);
+    fprintf(fp,"## %4d %15.8f %14.8f\n",week,dow*86400.0,900.0);
+    fprintf(fp,"+   32   ");
+    for (i=0;i<17;i++) fprintf(fp,"G%02d",i+1);
+    fprintf(fp,"\n+        ");
+    for (i=17;i<32;i++) fprintf(fp,"G%02d",i+1);
+    fprintf(fp,"  0  0\n");
+    for (i=4;i<12;i++) fprintf(fp,"%s\n",i<7?"+":"++");
+    fprintf(fp,"%%c G  cc GPS ccc cccc cccc cccc cccc ccccc ccccc ccccc\n");
+    fprintf(fp,"%%c cc cc ccc ccc cccc cccc cccc cccc ccccc ccccc ccccc\n");
+    fprintf(fp,"%%f  1.2500000  1.025000000  0.00000000000\n");
+    for (i=15;i<22;i++) fprintf(fp,"%s\n",i<17?"%f":(i<19?"%i":"/*"));
+    for (i=0;i<=96;i++) {
+        time=timeadd(ts,i*900.0);
+        time2epoch(time,ep);
+        fprintf(fp,"*  %4.0f %2.0f %2.0f %2.0f %2.0f %11.8f\n",ep[0],ep[1],
+                ep[2],ep[3],ep[4],ep[5]);
+        for (j=0;j<32;j++) {
+            a=phase[j]+time.time*1.4584E-4;
+            r=26559.7+k*1E-3;
+            fprintf(fp,"PG%02d%14.6f%14.6f%14.6f%14.6f\n",j+1,r*cos(a),
+                    r*sin(a)*0.5,r*sin(a)*0.866,phase[j]*100.0+k*1E-3);
+        }
+    }
+    fprintf(fp,"EOF\n");
+    fclose(fp);
+    
+    /* rinex clock (5 min, satellite clocks only) */
+    if (!(fp=fopen(clk,"w"))) return 0;
+    fprintf(fp,"%9.2f%-11s%-40s%-20s\n",3.0,"","C","RINEX VERSION / TYPE");
+    fprintf(fp,"%6d    %-50s%-20s\n",1,"AS","# / TYPES OF DATA");
+    fprintf(fp,"%-60s%-20s\n","","END OF HEADER");
+    for (i=0;i<=288;i++) {
+        time=timeadd(ts,i*300.0);
+        time2epoch(time,ep);
+        for (j=0;j<32;j++) {
+            fprintf(fp,"AS G%02d  %4.0f %02.0f %02.0f %02.0f %02.0f %9.6f",j+1,
+                    ep[0],ep[1],ep[2],ep[3],ep[4],ep[5]);
+            fprintf(fp,"  2   %19.12E %19.12E\n",phase[j]*1E-4+k*1E-11,1E-11);
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+/* readsp3s(),readrnxcs() of multiple analysis center products ----------------*/
+static int bench_mergeprod(result_t *res)
+{
+    const char *acs[]={"igs","cod","esa"};
+    nav_t nav={0};
+    double ep[]={2010,7,1,0,0,0},phase[32],t;
+    char *files[2][PRODDAYS*3],*p;
+    int i,j,n=0,stat=1;
+    
+    res->input="bench_*.sp3,bench_*.clk";
+    res->unit="loop";
+    
+    for (i=0;i<32;i++) phase[i]=randu()*2.0*PI;
+    
+    for (i=0;i<2;i++) for (j=0;j<PRODDAYS*3;j++) {
+        if (!(p=(char *)malloc(64))) return 0;
+        files[i][j]=p;
+    }
+    for (i=0;i<PRODDAYS;i++) for (j=0;j<3;j++,n++) {
+        if (!genprod(acs[j],timeadd(epoch2time(ep),i*86400.0),phase,j,
+                     files[0][n],files[1][n])) {
+            stat=0;
+        }
+        res->bytes+=filesize(files[0][n])+filesize(files[1][n]);
+    }
+    for (i=0;stat&&i<res->loops;i++) {
+        t=timer();
+        readsp3s(files[0],n,&nav,0);
+        readrnxcs(files[1],n,&nav);
+        t=timer()-t;
+        res->time+=t;
+        addlat(res,t);
+        
+        /* merged epochs of orbits and clocks */
+        res->nepoch=nav.ne+nav.nc;
+        if (nav.ne!=PRODDAYS*96+1||nav.nc!=PRODDAYS*288+1) stat=0;
+        
+        free(nav.peph); nav.peph=NULL; nav.ne=nav.nemax=0;
+        free(nav.pclk); nav.pclk=NULL; nav.nc=nav.ncmax=0;
+    }
+    for (i=0;i<2;i++) for (j=0;j<n;j++) {
+        remove(files[i][j]);
+        free(files[i][j]);
+    }
+    return stat;
+}
+/* benchmarks ----------------------------------------------------------------*/
+static const char *names[]={
+    "readrnxt","convrnx","rtkpos-single","rtkpos-dgps","rtkpos-kinematic",
+    "rtkpos-static","rtkpos-ppp","lambda","input_rtcm3","strconv","mergeprod",
+    NULL
+};
+static const int loops[]={5,3,1,1,1,1,1,20,10,3,1};
+
+/* run a benchmark -----------------------------------------------------------*/
+static int runbench(const char *name, int n)
+{
+    result_t res={0};
+    int i,stat=0;
+    
+    for (i=0;names[i];i++) if (!strcmp(name,names[i])) break;
+    if (!names[i]) {
+        fprintf(stderr,"unknown benchmark: %s\n",name);
+        return 0;
+    }
+    res.name=names[i];
+    res.nsol=res.nfix=-1;
+    res.loops=n>0?n:loops[i];
+    
+    switch (i) {
+        case 0: stat=bench_readrnxt(&res); break;
+        case 1: stat=bench_convrnx (&res); break;
+        case 2: stat=bench_rtkpos  (&res,PMODE_SINGLE); break;
+        case 3: stat=bench_rtkpos  (&res,PMODE_DGPS); break;
+        case 4: stat=bench_rtkpos  (&res,PMODE_KINEMA); break;
+        case 5: stat=bench_rtkpos  (&res,PMODE_STATIC); break;
+        case 6: stat=bench_rtkpos  (&res,PMODE_PPP_KINEMA); break;
+        case 7: stat=bench_lambda  (&res); break;
+        case 8: stat=bench_rtcm3   (&res); break;
+        case 9: stat=bench_strconv (&res); break;
+        case 10: stat=bench_mergeprod(&res); break;
+    }
+    if (!stat) {
+        fprintf(stderr,"benchmark error: %s\n",name);
+    }
+    else {
+        outresult(stdout,&res);
+    }
+    free(res.lat);
+    return stat;
+}
+/* run benchmarks in child processes and output json -------------------------*/
+static int runall(const char *cmd, char **bench, int nbench, int n,
+                  const char *file)
+{
+    FILE *fp=stdout,*fpc;
+    gtime_t time=timeget();
+    char buff[MAXLINE],cmds[1024],date[32];
+    int i,nout=0,ret=1;
+    
+    if (*file&&!(fp=fopen(file,"w"))) {
+        fprintf(stderr,"file open error: %s\n",file);
+        return 0;
+    }
+    time2str(time,date,0);
+    fprintf(fp,"{\n\"suite\":\"rtklib-bench\",\"version\":\"%s\",",VER_RTKLIB);
+    fprintf(fp,"\"date\":\"%s\",\"seed\":%u,\n\"benchmarks\":[\n",date,seed_);
+    
+    for (i=0;i<nbench;i++) {
+        sprintf(cmds,"%s -c %s -n %d -s %u",cmd,bench[i],n,seed_);
+        fprintf(stderr,"%s\n",cmds);
+        
+        buff[0]='\0';
+        if (!(fpc=popen(cmds,"r"))||!fgets(buff,sizeof(buff),fpc)||
+            *buff!='{') {
+            fprintf(stderr,"benchmark failed: %s\n",bench[i]);
+            ret=0;
+        }
+        else {
+            fprintf(fp,"%s%s",nout++>0?",\n":"",strtok(buff,"\n"));
+        }
+        if (fpc) pclose(fpc);
+    }
+    fprintf(fp,"\n]\n}\n");
+    if (fp!=stdout) fclose(fp);
+    return ret;
+}
+int main(int argc, char **argv)
+{
+    char *bench[32],*file="",*child="";
+    int i,n=0,nbench=0;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-o")&&i+1<argc) file=argv[++i];
+        else if (!strcmp(argv[i],"-n")&&i+1<argc) n=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-s")&&i+1<argc) {
+            seed_=(unsigned int)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i],"-c")&&i+1<argc) child=argv[++i];
+        else if (nbench<32) bench[nbench++]=argv[i];
+    }
+    if (*child) { /* child process */
+        return runbench(child,n)?0:-1;
+    }
+    if (nbench<=0) {
+        for (i=0;names[i];i++) bench[nbench++]=(char *)names[i];
+    }
+    return runall(argv[0],bench,nbench,n,file)?0:-1;
+}
@@ -85,10 +85,132 @@ void utest3(void)
 
     printf("%s utset3 : OK\n",__FILE__);
 }
+/* generate satellite positions for test ------------------------------------*/
+static void gensats(const double *rr, int n, double *rs)
+{
+    double pos[3],enu[3],e[3],az,el;
+    int i,j;
+    
+    ecef2pos(rr,pos);
+    for (i=0;i<n;i++) {
+        az=(i*137.5)*D2R;
+        el=(-10.0+fmod(i*23.7,100.0))*D2R;
+        enu[0]=sin(az)*cos(el); enu[1]=cos(az)*cos(el); enu[2]=sin(el);
+        enu2ecef(pos,enu,e);
+        for (j=0;j<3;j++) rs[j+i*6]=rr[j]+2.2E7*e[j];
+        for (j=3;j<6;j++) rs[j+i*6]=0.0;
+    }
+}
+/* geodists(), satazels() */
+void utest4(void)
+{
+    double rr[]={-3.9576545E+06,3.3102412E+06,3.7380130E+06},pos[3];
+    double rs[6*32],r[32],e[3*32],azel[2*32],r1,e1[3],azel1[2],el1;
+    int i,j,n=32;
+    
+    gensats(rr,n,rs);
+    for (j=0;j<6;j++) rs[j+5*6]=0.0; /* no satellite position */
+    ecef2pos(rr,pos);
+    for (i=0;i<n*2;i++) azel[i]=-1.0;
+    
+    geodists(rs,rr,n,r,e);
+    satazels(pos,e,r,n,azel);
+    
+    for (i=0;i<n;i++) {
+        r1=geodist(rs+i*6,rr,e1);
+        if (r1<=0.0) {
+            assert(r[i]<=0.0&&azel[i*2]==-1.0&&azel[1+i*2]==-1.0);
+            continue;
+        }
+        el1=satazel(pos,e1,azel1);
+        assert(r[i]==r1);
+        assert(e[i*3]==e1[0]&&e[1+i*3]==e1[1]&&e[2+i*3]==e1[2]);
+        assert(azel[i*2]==azel1[0]&&azel[1+i*2]==el1);
+    }
+    printf("%s utest4 : OK\n",__FILE__);
+}
+/* antmodels(), windupcorrs() */
+void utest5(void)
+{
+    double ep[]={2015,3,20,12,0,0},del[]={0.1,-0.2,0.3};
+    double rr[]={-3.9576545E+06,3.3102412E+06,3.7380130E+06},pos[3];
+    double rs[6*32],r[32],e[3*32],azel[2*32],dant[NFREQ*32],dant1[NFREQ];
+    double phw[32],phw1;
+    gtime_t time=epoch2time(ep);
+    pcv_t pcv={0};
+    int i,j,n=32;
+    
+    for (i=0;i<NFREQ;i++) {
+        pcv.off[i][0]=0.001*i; pcv.off[i][1]=-0.002; pcv.off[i][2]=0.09+0.01*i;
+        for (j=0;j<19;j++) pcv.var[i][j]=0.0005*j-0.001*i;
+    }
+    gensats(rr,n,rs);
+    ecef2pos(rr,pos);
+    geodists(rs,rr,n,r,e);
+    satazels(pos,e,r,n,azel);
+    
+    antmodels(&pcv,del,azel,n,1,dant);
+    for (i=0;i<n;i++) phw[i]=0.1*i;
+    windupcorrs(time,rs,rr,n,phw);
+    
+    for (i=0;i<n;i++) {
+        antmodel(&pcv,del,azel+i*2,1,dant1);
+        for (j=0;j<NFREQ;j++) assert(dant[j+i*NFREQ]==dant1[j]);
+        phw1=0.1*i;
+        windupcorr(time,rs+i*6,rr,&phw1);
+        assert(phw[i]==phw1);
+    }
+    printf("%s utest5 : OK\n",__FILE__);
+}
+/* per-epoch time of satellite corrections */
+void utest6(void)
+{
+    double ep[]={2015,3,20,12,0,0},del[3]={0};
+    double rr[]={-3.9576545E+06,3.3102412E+06,3.7380130E+06},pos[3];
+    double rs[6*120],r[120],e[3*120],azel[2*120],mapfh[120],mapfw[120];
+    double dant[NFREQ*120],phw[120]={0};
+    gtime_t time=epoch2time(ep);
+    pcv_t pcv={0};
+    unsigned int tick;
+    int i,k,m,n,nsat[]={40,80,120},nep=2000;
+    
+    gensats(rr,120,rs);
+    ecef2pos(rr,pos);
+    
+    for (m=0;m<3;m++) {
+        n=nsat[m];
+        
+        tick=tickget();
+        for (k=0;k<nep;k++) for (i=0;i<n;i++) {
+            r[i]=geodist(rs+i*6,rr,e+i*3);
+            satazel(pos,e+i*3,azel+i*2);
+            mapfh[i]=tropmapf(time,pos,azel+i*2,mapfw+i);
+            antmodel(&pcv,del,azel+i*2,1,dant+i*NFREQ);
+            windupcorr(time,rs+i*6,rr,phw+i);
+        }
+        printf("nsat=%3d per-sat : %8.3f us/epoch\n",n,
+               (tickget()-tick)*1E3/nep);
+        
+        tick=tickget();
+        for (k=0;k<nep;k++) {
+            geodists(rs,rr,n,r,e);
+            satazels(pos,e,r,n,azel);
+            tropmapfs(time,pos,azel,n,mapfh,mapfw);
+            antmodels(&pcv,del,azel,n,1,dant);
+            windupcorrs(time,rs,rr,n,phw);
+        }
+        printf("nsat=%3d batched : %8.3f us/epoch\n",n,
+               (tickget()-tick)*1E3/nep);
+    }
+    printf("%s utest6 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
+    utest4();
+    utest5();
+    utest6();
     return 0;
 }
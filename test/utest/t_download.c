@@ -0,0 +1,423 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : gnss data downloader functions
+*-----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../../src/rtklib.h"
+
+#define ROOT        "../data/rinex"     /* root directory of server stand-in */
+#define ROOTC       ROOT "/comp"        /* directory of compressed files */
+#define DIR         "dltest"            /* local directory */
+
+typedef struct {                        /* ftp/http server stand-in type */
+    int sock;                           /* listen socket */
+    int port;                           /* listen port */
+    int proto;                          /* protocol (0:ftp,1:http) */
+    int chunked;                        /* http chunked transfer encoding */
+    int cut;                            /* cut first response after (bytes) */
+    int nconn;                          /* number of connections */
+    int nreq;                           /* number of file requests */
+    int nrange;                         /* number of range/restart requests */
+    pthread_mutex_t lock;               /* lock flag */
+} server_t;
+
+typedef struct {                        /* server stand-in connection type */
+    server_t *svr;                      /* server */
+    int sock;                           /* socket */
+} sconn_t;
+
+extern int showmsg(char *format, ...) {return 0;}
+
+/* read file in root directory -----------------------------------------------*/
+static char *readroot(const char *file, long *size)
+{
+    FILE *fp;
+    char path[1024],*buff,*p;
+
+    if ((p=strrchr(file,'/'))) file=p+1;
+    sprintf(path,"%s/%s",ROOT,file);
+    if (!(fp=fopen(path,"rb"))) {
+        sprintf(path,"%s/%s",ROOTC,file);
+        if (!(fp=fopen(path,"rb"))) return NULL;
+    }
+    fseek(fp,0,SEEK_END); *size=ftell(fp); fseek(fp,0,SEEK_SET);
+    buff=(char *)malloc(*size+1);
+    if (fread(buff,1,*size,fp)!=(size_t)*size) *size=0;
+    fclose(fp);
+    return buff;
+}
+/* compare files -------------------------------------------------------------*/
+static int cmpfile(const char *file1, const char *file2)
+{
+    FILE *fp1,*fp2;
+    int c1,c2;
+
+    if (!(fp1=fopen(file1,"rb"))) return 0;
+    if (!(fp2=fopen(file2,"rb"))) {fclose(fp1); return 0;}
+    do {
+        c1=fgetc(fp1); c2=fgetc(fp2);
+    } while (c1==c2&&c1!=EOF);
+    fclose(fp1); fclose(fp2);
+    return c1==c2;
+}
+/* receive line --------------------------------------------------------------*/
+static int recvline(int sock, char *buff, int nmax)
+{
+    char c;
+    int n=0;
+
+    while (recv(sock,&c,1,0)==1) {
+        if (c=='\n') {buff[n]='\0'; return 1;}
+        if (c!='\r'&&n<nmax-1) buff[n++]=c;
+    }
+    return 0;
+}
+static void sendstr(int sock, const char *str)
+{
+    send(sock,str,strlen(str),MSG_NOSIGNAL);
+}
+/* open listen socket on loopback --------------------------------------------*/
+static int listensock(int *port)
+{
+    struct sockaddr_in addr;
+    socklen_t len=sizeof(addr);
+    int sock;
+
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+    addr.sin_port=0;
+    if ((sock=socket(AF_INET,SOCK_STREAM,0))<0||
+        bind(sock,(struct sockaddr *)&addr,sizeof(addr))<0||
+        listen(sock,16)<0||
+        getsockname(sock,(struct sockaddr *)&addr,&len)<0) {
+        return -1;
+    }
+    *port=ntohs(addr.sin_port);
+    return sock;
+}
+/* count request -------------------------------------------------------------*/
+static int countreq(server_t *svr, long start)
+{
+    int nreq;
+
+    pthread_mutex_lock(&svr->lock);
+    nreq=svr->nreq++;
+    if (start>0) svr->nrange++;
+    pthread_mutex_unlock(&svr->lock);
+    return nreq;
+}
+/* http server stand-in connection (keep-alive) ------------------------------*/
+static void *httpthread(void *arg)
+{
+    sconn_t *c=(sconn_t *)arg;
+    server_t *svr=c->svr;
+    char buff[1024],file[1024],*data;
+    long i,m,size,start;
+    int nreq;
+
+    while (recvline(c->sock,buff,sizeof(buff))) {
+        if (sscanf(buff,"GET %1023s",file)<1) break;
+        start=0;
+        while (recvline(c->sock,buff,sizeof(buff))&&*buff) {
+            if (!strncmp(buff,"Range: bytes=",13)) start=atol(buff+13);
+        }
+        nreq=countreq(svr,start);
+
+        if (!(data=readroot(file,&size))) {
+            sendstr(c->sock,"HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\n"
+                    "not found");
+            continue;
+        }
+        if (svr->chunked) {
+            sprintf(buff,"HTTP/1.1 %s\r\nTransfer-Encoding: chunked\r\n\r\n",
+                    start>0?"206 Partial Content":"200 OK");
+            sendstr(c->sock,buff);
+            for (i=start;i<size;i+=m) {
+                m=size-i<1000?size-i:1000;
+                sprintf(buff,"%lx\r\n",m);
+                sendstr(c->sock,buff);
+                send(c->sock,data+i,m,MSG_NOSIGNAL);
+                sendstr(c->sock,"\r\n");
+            }
+            sendstr(c->sock,"0\r\n\r\n");
+        }
+        else {
+            sprintf(buff,"HTTP/1.1 %s\r\nContent-Length: %ld\r\n\r\n",
+                    start>0?"206 Partial Content":"200 OK",size-start);
+            sendstr(c->sock,buff);
+            if (svr->cut>0&&nreq==0) { /* cut connection */
+                send(c->sock,data,svr->cut,MSG_NOSIGNAL);
+                free(data);
+                break;
+            }
+            send(c->sock,data+start,size-start,MSG_NOSIGNAL);
+        }
+        free(data);
+    }
+    close(c->sock);
+    free(c);
+    return NULL;
+}
+/* ftp server stand-in connection --------------------------------------------*/
+static void *ftpthread(void *arg)
+{
+    sconn_t *c=(sconn_t *)arg;
+    server_t *svr=c->svr;
+    char buff[1024],*data;
+    long size,start=0;
+    int sock,pasv=-1,port;
+
+    sendstr(c->sock,"220-ftp server stand-in\r\n220 ready\r\n");
+
+    while (recvline(c->sock,buff,sizeof(buff))) {
+        if (!strncmp(buff,"USER",4)) {
+            sendstr(c->sock,"331 password required\r\n");
+        }
+        else if (!strncmp(buff,"PASS",4)) {
+            sendstr(c->sock,"230 logged in\r\n");
+        }
+        else if (!strncmp(buff,"TYPE",4)) {
+            sendstr(c->sock,"200 type set to I\r\n");
+        }
+        else if (!strncmp(buff,"CWD",3)) {
+            sendstr(c->sock,strcmp(buff+4,"/missing")?"250 ok\r\n":
+                    "550 no such directory\r\n");
+        }
+        else if (!strncmp(buff,"PASV",4)) {
+            if (pasv>=0) close(pasv);
+            pasv=listensock(&port);
+            sprintf(buff,"227 Entering Passive Mode (127,0,0,1,%d,%d)\r\n",
+                    port>>8,port&0xFF);
+            sendstr(c->sock,buff);
+        }
+        else if (!strncmp(buff,"REST",4)) {
+            start=atol(buff+5);
+            sendstr(c->sock,"350 restarting\r\n");
+        }
+        else if (!strncmp(buff,"RETR",4)) {
+            countreq(svr,start);
+            if (!(data=readroot(buff+5,&size))) {
+                sendstr(c->sock,"550 no such file\r\n");
+            }
+            else {
+                sendstr(c->sock,"150 opening data connection\r\n");
+                if ((sock=accept(pasv,NULL,NULL))>=0) {
+                    if (start<size) {
+                        send(sock,data+start,size-start,MSG_NOSIGNAL);
+                    }
+                    close(sock);
+                }
+                free(data);
+                sendstr(c->sock,"226 transfer complete\r\n");
+            }
+            close(pasv);
+            pasv=-1; start=0;
+        }
+        else if (!strncmp(buff,"QUIT",4)) {
+            sendstr(c->sock,"221 bye\r\n");
+            break;
+        }
+        else sendstr(c->sock,"500 unknown command\r\n");
+    }
+    if (pasv>=0) close(pasv);
+    close(c->sock);
+    free(c);
+    return NULL;
+}
+/* server stand-in thread ----------------------------------------------------*/
+static void *serverthread(void *arg)
+{
+    server_t *svr=(server_t *)arg;
+    sconn_t *c;
+    pthread_t thread;
+    int sock;
+
+    while ((sock=accept(svr->sock,NULL,NULL))>=0) {
+        pthread_mutex_lock(&svr->lock);
+        svr->nconn++;
+        pthread_mutex_unlock(&svr->lock);
+        c=(sconn_t *)malloc(sizeof(sconn_t));
+        c->svr=svr; c->sock=sock;
+        pthread_create(&thread,NULL,svr->proto?httpthread:ftpthread,c);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+/* start server stand-in -----------------------------------------------------*/
+static int startserver(server_t *svr, int proto, pthread_t *thread)
+{
+    memset(svr,0,sizeof(server_t));
+    svr->proto=proto;
+    pthread_mutex_init(&svr->lock,NULL);
+    if ((svr->sock=listensock(&svr->port))<0) return 0;
+    return !pthread_create(thread,NULL,serverthread,svr);
+}
+static void stopserver(server_t *svr, pthread_t thread)
+{
+    shutdown(svr->sock,SHUT_RDWR);
+    close(svr->sock);
+    pthread_join(thread,NULL);
+}
+/* download files ------------------------------------------------------------*/
+static void download(const url_t *urls, int nurl, char **stas, int nsta,
+                     int opts, char *msg)
+{
+    double ep[]={2005,4,2,0,0,0};
+    gtime_t ts=epoch2time(ep);
+
+    dl_exec(ts,ts,86400.0,0,0,urls,nurl,stas,nsta,DIR,"user","pass","",
+            opts,msg,NULL);
+    printf("%s\n",msg);
+}
+/* http download, skip existing and connection reuse */
+void utest1(void)
+{
+    server_t svr;
+    pthread_t thread;
+    url_t url={"",""};
+    char *stas[]={"07590920.05n","30400920.05n","nofile.05n"};
+    char msg[1024];
+
+    mkdir(DIR,0777);
+    assert(startserver(&svr,1,&thread));
+    sprintf(url.path,"http://127.0.0.1:%d/pub/%%s",svr.port);
+
+    /* single thread reuses a connection */
+    dl_setthread(1);
+    download(&url,1,stas,3,0,msg);
+    assert(strstr(msg,"OK=2 No_File=1 Skip=0 Error=0"));
+    assert(svr.nconn==1&&svr.nreq==3);
+    assert(cmpfile(DIR "/07590920.05n",ROOT "/07590920.05n"));
+    assert(cmpfile(DIR "/30400920.05n",ROOT "/30400920.05n"));
+
+    /* skip existing files */
+    dl_setthread(4);
+    download(&url,1,stas,3,0,msg);
+    assert(strstr(msg,"OK=0 No_File=1 Skip=2 Error=0"));
+    assert(svr.nreq==4);
+
+    /* force download by threads */
+    download(&url,1,stas,3,DLOPT_FORCE,msg);
+    assert(strstr(msg,"OK=2 No_File=1 Skip=0 Error=0"));
+    assert(svr.nconn<=1+1+3&&svr.nreq==7);
+    assert(cmpfile(DIR "/07590920.05n",ROOT "/07590920.05n"));
+
+    stopserver(&svr,thread);
+    remove(DIR "/07590920.05n");
+    remove(DIR "/30400920.05n");
+
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* http chunked transfer and in-process uncompress */
+void utest2(void)
+{
+    server_t svr;
+    pthread_t thread;
+    url_t urls[2]={{"",""},{"",""}};
+    char msg[1024];
+
+    assert(startserver(&svr,1,&thread));
+    svr.chunked=1;
+    sprintf(urls[0].path,"http://127.0.0.1:%d/07590920.05n.Z" ,svr.port);
+    sprintf(urls[1].path,"http://127.0.0.1:%d/30400920.05n.gz",svr.port);
+
+    dl_setthread(4);
+    download(urls,2,NULL,0,0,msg);
+    assert(strstr(msg,"OK=2 No_File=0 Skip=0 Error=0"));
+    assert(cmpfile(DIR "/07590920.05n",ROOT "/07590920.05n"));
+    assert(cmpfile(DIR "/30400920.05n",ROOT "/30400920.05n"));
+    assert(access(DIR "/07590920.05n.Z",F_OK)<0);
+    assert(access(DIR "/30400920.05n.gz",F_OK)<0);
+
+    /* keep compressed file */
+    download(urls,2,NULL,0,DLOPT_FORCE|DLOPT_KEEPCMP,msg);
+    assert(strstr(msg,"OK=2"));
+    assert(cmpfile(DIR "/07590920.05n.Z",ROOTC "/07590920.05n.Z"));
+
+    stopserver(&svr,thread);
+    remove(DIR "/07590920.05n");
+    remove(DIR "/30400920.05n");
+    remove(DIR "/07590920.05n.Z");
+    remove(DIR "/30400920.05n.gz");
+
+    printf("%s utest2 : OK\n",__FILE__);
+}
+/* http resume by range request after cut connection */
+void utest3(void)
+{
+    server_t svr;
+    pthread_t thread;
+    url_t url={"",""};
+    char *stas[]={"brdc0910.09g"};
+    char msg[1024];
+
+    assert(startserver(&svr,1,&thread));
+    svr.cut=100000;
+    sprintf(url.path,"http://127.0.0.1:%d/%%s",svr.port);
+
+    download(&url,1,stas,1,0,msg);
+    assert(strstr(msg,"OK=1 No_File=0 Skip=0 Error=0"));
+    assert(svr.nconn==2&&svr.nreq==2&&svr.nrange==1);
+    assert(cmpfile(DIR "/brdc0910.09g",ROOT "/brdc0910.09g"));
+    assert(access(DIR "/brdc0910.09g.part",F_OK)<0);
+
+    stopserver(&svr,thread);
+    remove(DIR "/brdc0910.09g");
+
+    printf("%s utest3 : OK\n",__FILE__);
+}
+/* ftp download, connection reuse and restart */
+void utest4(void)
+{
+    server_t svr;
+    pthread_t thread;
+    url_t urls[2]={{"",""},{"",""}};
+    FILE *fp;
+    char *stas[]={"07590920.05n","30400920.05n","nofile.05n"};
+    char msg[1024],*data;
+    long size;
+
+    assert(startserver(&svr,0,&thread));
+    sprintf(urls[0].path,"ftp://127.0.0.1:%d/pub/rinex/%%s",svr.port);
+    sprintf(urls[1].path,"ftp://127.0.0.1:%d/missing/x%%s",svr.port);
+
+    dl_setthread(2);
+    download(urls,2,stas,3,0,msg);
+    assert(strstr(msg,"OK=2 No_File=4 Skip=0 Error=0"));
+    assert(svr.nconn<=2&&svr.nreq==3);
+    assert(cmpfile(DIR "/07590920.05n",ROOT "/07590920.05n"));
+    assert(cmpfile(DIR "/30400920.05n",ROOT "/30400920.05n"));
+
+    /* restart partially downloaded file */
+    data=readroot("07590920.05n",&size);
+    fp=fopen(DIR "/07590920.05n.part","wb");
+    fwrite(data,1,size/2,fp);
+    fclose(fp);
+    free(data);
+    download(urls,1,stas,1,DLOPT_FORCE,msg);
+    assert(strstr(msg,"OK=1 No_File=0 Skip=0 Error=0"));
+    assert(svr.nrange==1);
+    assert(cmpfile(DIR "/07590920.05n",ROOT "/07590920.05n"));
+
+    stopserver(&svr,thread);
+    remove(DIR "/07590920.05n");
+    remove(DIR "/30400920.05n");
+    rmdir(DIR);
+
+    printf("%s utest4 : OK\n",__FILE__);
+}
+int main(int argc, char **argv)
+{
+    utest1();
+    utest2();
+    utest3();
+    utest4();
+    return 0;
+}
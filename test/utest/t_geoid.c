@@ -163,10 +163,52 @@ void utest3(void)
     printf("\n");
     printf("%s utset3 : OK\n",__FILE__);
 }
+/* geoidh() lookups/s (bilinear/bicubic) */
+void utest4(void)
+{
+    const int models[]={GEOID_EMBEDDED,GEOID_EGM96_M150,GEOID_EGM2008_M10};
+    const char *files[]={"",DATADIR "WW15MGH.DAC",
+        DATADIR "Und_min1x1_egm2008_isw=82_WGS84_TideFree_SE"};
+    double pos[3]={0},h,hc,dhmax;
+    unsigned int tick;
+    int i,j,k,n=1000000;
+    
+    for (i=0;i<3;i++) {
+        if (!opengeoid(models[i],files[i])) continue;
+        
+        for (j=0;j<2;j++) {
+            geoidinterp(j);
+            tick=tickget();
+            for (k=0,h=0.0;k<n;k++) {
+                pos[0]=(-89.9+fmod(k*0.7123,179.8))*D2R;
+                pos[1]=(-180.0+fmod(k*1.3791,360.0))*D2R;
+                h+=geoidh(pos);
+            }
+            tick=tickget()-tick;
+            printf("model=%d interp=%d: %10.0f lookups/s\n",models[i],j,
+                   n*1E3/(tick<1?1:tick));
+        }
+        /* bicubic vs bilinear */
+        for (k=0,dhmax=0.0;k<10000;k++) {
+            pos[0]=(-89.9+fmod(k*0.7123,179.8))*D2R;
+            pos[1]=(-180.0+fmod(k*1.3791,360.0))*D2R;
+            geoidinterp(0); h =geoidh(pos);
+            geoidinterp(1); hc=geoidh(pos);
+            if (fabs(hc-h)>dhmax) dhmax=fabs(hc-h);
+        }
+        geoidinterp(0);
+        closegeoid();
+        printf("model=%d: max difference bicubic-bilinear=%.4f m\n",models[i],
+               dhmax);
+            assert(dhmax<10.0);
+    }
+    printf("%s utest4 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
+    utest4();
     return 0;
 }
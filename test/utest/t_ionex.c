@@ -223,11 +223,52 @@ void utest4(void)
     
     printf("%s utest4 : OK\n",__FILE__);
 }
+/* iontecs() */
+void utest5(void)
+{
+    char *file3="../data/sp3/igrg33*0.10i";
+    nav_t nav={0};
+    gtime_t time1,time;
+    double ep1[]={2010,12, 3,12, 0, 0};
+    double pos[3]={25*D2R,135*D2R,0},azel[64*2];
+    double delay[64],var[64],d,v,t;
+    int i,j,n=64,stat[64],ns,ok;
+    
+    time1=epoch2time(ep1);
+    readtec(file3,&nav,0);
+        assert(nav.nt>0);
+    
+    for (j=0;j<n;j++) {
+        azel[  j*2]=j*5.625*D2R;
+        azel[1+j*2]=(j%18)*5.0*D2R;
+    }
+    for (i=-3600;i<=86400*3;i+=1800) {
+        time=timeadd(time1,i);
+        ns=iontecs(time,&nav,pos,azel,n,3,delay,var,stat);
+        for (j=0;j<n;j++) {
+            ok=iontec(time,&nav,pos,azel+j*2,3,&d,&v);
+            assert(stat[j]==ok);
+            ns-=ok;
+            if (!ok) continue;
+            assert(delay[j]==d&&var[j]==v);
+        }
+        assert(ns==0);
+    }
+    t=tickget();
+    for (i=0;i<86400;i+=30) {
+        iontecs(timeadd(time1,i),&nav,pos,azel,n,1,delay,var,stat);
+    }
+    t=tickget()-t;
+    printf("iontecs: %.0f sat-epochs/s\n",86400/30*n/(t>0.0?t:1.0)*1E3);
+    
+    printf("%s utest5 : OK\n",__FILE__);
+}
 int main(int argc, char **argv)
 {
     utest1();
     utest2();
     utest3();
     utest4();
+    utest5();
     return 0;
 }
@@ -180,13 +180,168 @@ void utest4(void)
     setbits(buff,866,31,-12345); vs=getbits(buff,866,31); assert(vs==-12345);
     setbits(buff,977,32,-67890); vs=getbits(buff,977,32); assert(vs==-67890);
     
+    /* neighbouring bits kept */
+    setbitu(buff,1000,24,0xFFFFFF);
+    setbitu(buff,1005,13,0);        vu=getbitu(buff,1000,24); assert(vu==0xF8003F);
+    setbitu(buff,1003, 3,5);        vu=getbitu(buff,1000,24); assert(vu==0xF4003F);
+    setbits(buff,1009,10,-2);       vu=getbitu(buff,1000,24); assert(vu==0xF47FDF);
+    
     printf("%s utset4 : OK\n",__FILE__);
 }
+/* output trace lines */
+static void outtrace(int n)
+{
+    unsigned char data[100];
+    char path[1024];
+    double A[12];
+    int i;
+    
+    for (i=0;i<100;i++) data[i]=(unsigned char)(i*7);
+    for (i=0;i<1000;i++) path[i]=(char)('a'+i%26); /* longer than 255 */
+    path[i]='\0';
+    for (i=0;i<12;i++) A[i]=i*1.234567-5.0;
+    
+    for (i=0;i<n;i++) {
+        trace(2,"outtrace: i=%d x=%.3f s=%-8s u=%u c=%c %%\n",i,i*0.5,"abc",
+              (unsigned int)i*3,'A'+i%26);
+        trace(3,"outtrace: ld=%ld %*.*f %5.2e %s\n",-1234567L,10,4,-3.14159,1E-9,
+              "");
+        trace(3,"outtrace: path=%s\n",i%2?path:"");
+        tracemat(3,A,3,4,12,5);
+        traceb(4,data,i%2?100:3);
+    }
+}
+/* compare text files */
+static int cmpfile(const char *file1, const char *file2)
+{
+    FILE *fp1,*fp2;
+    int c1,c2;
+    
+    if (!(fp1=fopen(file1,"r"))||!(fp2=fopen(file2,"r"))) return 0;
+    do {
+        c1=fgetc(fp1); c2=fgetc(fp2);
+    } while (c1==c2&&c1!=EOF);
+    fclose(fp1);
+    fclose(fp2);
+    return c1==c2;
+}
+/* tracebuf(), tracedec() */
+void utest5(void)
+{
+    const char *file1="/tmp/t_misc_trace.txt",*file2="/tmp/t_misc_trace.trb";
+    const char *file3="/tmp/t_misc_trace.dec";
+    FILE *fp;
+    char buff[256];
+    unsigned int nd,ndrop=0;
+    int n,nrec=0;
+    
+    /* text trace */
+    tracebuf(0);
+    traceopen(file1);
+    tracelevel(4);
+    outtrace(50);
+    traceclose();
+    
+    /* binary trace and decoded text trace identical with text trace */
+    tracebuf(1024*1024);
+    traceopen(file2);
+    tracelevel(4);
+    outtrace(50);
+    traceclose();
+    assert((fp=fopen(file3,"w")));
+    n=tracedec(file2,fp,0);
+    fclose(fp);
+    assert(n==50*(2+4+1));
+    assert(cmpfile(file1,file3));
+    
+    /* level filter */
+    assert((fp=fopen(file3,"w")));
+    assert(tracedec(file2,fp,2)==50);
+    assert(tracedec(file2,fp,3)==50*(2+4));
+    fclose(fp);
+    assert(tracedec(file1,stdout,0)<0);
+    
+    /* records dropped by buffer full are reported */
+    tracebuf(1);
+    traceopen(file2);
+    tracelevel(2);
+    outtrace(10000);
+    traceclose();
+    assert((fp=fopen(file3,"w")));
+    assert((n=tracedec(file2,fp,0))>0);
+    fclose(fp);
+    assert((fp=fopen(file3,"r")));
+    while (fgets(buff,sizeof(buff),fp)) {
+        if (sscanf(buff,"*** %u",&nd)==1) ndrop+=nd; else nrec++;
+    }
+    fclose(fp);
+    assert(nrec+(int)ndrop==10000);
+    tracebuf(0);
+    remove(file1);
+    remove(file2);
+    remove(file3);
+    
+    printf("%s utset5 : OK\n",__FILE__);
+}
+/* prfenable(), prftick(), prfadd(), prfsum(), prfpct(), prfouts() */
+void utest6(void)
+{
+    prfstat_t prf[NPRF]={{0}},prf2[NPRF]={{0}};
+    unsigned char buff[MAXPRFMSG];
+    double tick;
+    int i,n;
+    
+    /* no sample if disabled */
+    prfenable(0);
+    assert(prftick()==0.0);
+    prfadd(prf+PRF_RTKPOS,prftick());
+    assert(prf[PRF_RTKPOS].n==0);
+    assert(prfouts(buff,prf,1)==0);
+    
+    /* samples of 2 ms sleep */
+    prfenable(1);
+    for (i=0;i<10;i++) {
+        assert((tick=prftick())>0.0);
+        sleepms(2);
+        prfadd(prf+PRF_RTKPOS,tick);
+    }
+    assert(prf[PRF_RTKPOS].n==10);
+    assert(prf[PRF_RTKPOS].sum>=0.018&&prf[PRF_RTKPOS].sum<1.0);
+    assert(prf[PRF_RTKPOS].max>=0.0018);
+    assert(prfpct(prf+PRF_RTKPOS,0.5)>=0.001);
+    assert(prfpct(prf+PRF_RTKPOS,0.99)<=prf[PRF_RTKPOS].max);
+    
+    /* histogram bins of 2^(i-1)<=t<2^i (us) */
+    for (i=n=0;i<NPRFBIN;i++) n+=prf[PRF_RTKPOS].hist[i];
+    assert(n==10);
+    for (i=0;i<11;i++) assert(prf[PRF_RTKPOS].hist[i]==0); /* <1024us */
+    
+    /* sum of profiles */
+    prfadd(prf2+PRF_FILTER,prftick());
+    prfsum(prf2,prf,NPRF);
+    assert(prf2[PRF_RTKPOS].n==10&&prf2[PRF_FILTER].n==1);
+    assert(prf2[PRF_RTKPOS].max==prf[PRF_RTKPOS].max);
+    
+    /* table and $PRF messages */
+    n=prfouts(buff,prf2,0);
+    assert(n>0&&n<MAXPRFMSG);
+    buff[n]='\0';
+    assert(strstr((char *)buff,"rtkpos")&&strstr((char *)buff,"filter"));
+    n=prfouts(buff,prf2,1);
+    buff[n]='\0';
+    assert(strstr((char *)buff,"$PRF,rtkpos,10,"));
+    assert(!strstr((char *)buff,"$PRF,pntpos"));
+    prfenable(0);
+    
+    printf("%s utset6 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
     utest4();
+    utest5();
+    utest6();
     return 0;
 }
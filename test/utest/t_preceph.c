@@ -198,6 +198,63 @@ void utest5(void)
     fclose(fp);
     printf("%s utest4 : OK\n",__FILE__);
 }
+/* readsp3s(), readrnxcs() */
+void utest6(void)
+{
+    char *file1="../data/sp3/igs15904.sp3";
+    char *file2="../data/sp3/igs15905.sp3";
+    char *file3="../data/sp3/igs15904.clk";
+    char *files1[]={"../data/sp3/igs15904.sp3","../data/sp3/igs15905.sp3"};
+    char *files2[]={"../data/sp3/igs15905.sp3","../data/sp3/igs15904.sp3"};
+    char *files3[]={"../data/sp3/igs15904.sp3","../data/sp3/igs15904.sp3"};
+    char *files4[]={"../data/sp3/igs15904.sp3","../data/sp3/igs15904.clk",
+                    "../data/sp3/igs15904.sp3"};
+    nav_t nav1={0},nav2={0};
+    int i,j;
+    
+    /* order of files */
+    readsp3s(files1,2,&nav1,0);
+        assert(nav1.ne==192);
+    readsp3s(files2,2,&nav2,0);
+        assert(nav2.ne==192);
+    for (i=0;i<nav1.ne;i++) {
+        assert(timediff(nav1.peph[i].time,nav2.peph[i].time)==0.0);
+        if (i>0) assert(timediff(nav1.peph[i].time,nav1.peph[i-1].time)>0.0);
+        for (j=0;j<MAXSAT;j++) {
+            assert(nav1.peph[i].pos[j][0]==nav2.peph[i].pos[j][0]);
+        }
+    }
+    free(nav2.peph); nav2.peph=NULL; nav2.ne=nav2.nemax=0;
+    
+    /* merge into existing epochs */
+    readsp3(file2,&nav2,0);
+    readsp3(file1,&nav2,0);
+        assert(nav2.ne==192);
+    for (i=0;i<nav1.ne;i++) {
+        assert(timediff(nav1.peph[i].time,nav2.peph[i].time)==0.0);
+    }
+    free(nav2.peph); nav2.peph=NULL; nav2.ne=nav2.nemax=0;
+    
+    /* duplicated files */
+    readsp3s(files3,2,&nav2,0);
+        assert(nav2.ne==96);
+    free(nav1.peph); free(nav2.peph);
+    
+    /* skip files other than rinex clock */
+    readrnxc(file3,&nav1);
+        assert(nav1.nc>0);
+    readrnxcs(files4,3,&nav2);
+        assert(nav2.nc==nav1.nc);
+    for (i=0;i<nav1.nc;i++) {
+        assert(timediff(nav1.pclk[i].time,nav2.pclk[i].time)==0.0);
+        for (j=0;j<MAXSAT;j++) {
+            assert(nav1.pclk[i].clk[j][0]==nav2.pclk[i].clk[j][0]);
+        }
+    }
+    free(nav1.pclk); free(nav2.pclk);
+    
+    printf("%s utest6 : OK\n",__FILE__);
+}
 int main(int argc, char **argv)
 {
     utest1();
@@ -205,5 +262,6 @@ int main(int argc, char **argv)
     utest3();
     utest4();
     utest5();
+    utest6();
     return 0;
 }
@@ -2,6 +2,7 @@
 * rtklib unit test driver : rinex function
 *-----------------------------------------------------------------------------*/
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include "../../src/rtklib.h"
 
@@ -83,7 +84,7 @@ void utest1(void)
     n=sortobs(&obs);
         assert(n==171);
     uniqnav(&nav);
-        assert(nav.n==167);
+        assert(nav.n==164);
     dumpobs(&obs); dumpnav(&nav); dumpsta(&sta);
         assert(obs.data&&obs.n>0&&nav.eph&&nav.n>0);
     free(obs.data);
@@ -204,6 +205,145 @@ void utest6(void)
     }
     printf("%s utest6 : OK\n",__FILE__);
 }
+/* sortobs() merge of time-ordered and out-of-order data */
+void utest7(void)
+{
+    char file1[]="../data/rinex/07590920.05o";
+    char file2[]="../data/rinex/30400920.05o";
+    obs_t obs1={0},obs2={0};
+    obsd_t data;
+    double tt;
+    int i,n1,n2;
+    
+    readrnx(file1,1,"",&obs1,NULL,NULL);
+    readrnx(file2,2,"",&obs1,NULL,NULL);
+    readrnx(file1,1,"",&obs1,NULL,NULL); /* duplicated data */
+        assert(obs1.n>0);
+    obs2.data=(obsd_t *)malloc(sizeof(obsd_t)*obs1.n);
+    obs2.n=obs2.nmax=obs1.n;
+    for (i=0;i<obs1.n;i++) obs2.data[i]=obs1.data[obs1.n-1-i]; /* reverse */
+    for (i=0;i<obs2.n/2;i+=7) {
+        data=obs2.data[i]; obs2.data[i]=obs2.data[obs2.n-1-i];
+        obs2.data[obs2.n-1-i]=data;
+    }
+    n1=sortobs(&obs1);
+    n2=sortobs(&obs2);
+        assert(n1==171&&n2==171&&obs1.n==obs2.n);
+    for (i=0;i<obs1.n;i++) {
+        assert(obs1.data[i].sat==obs2.data[i].sat&&
+               obs1.data[i].rcv==obs2.data[i].rcv&&
+               timediff(obs1.data[i].time,obs2.data[i].time)==0.0&&
+               obs1.data[i].P[0]==obs2.data[i].P[0]);
+        if (i==0) continue;
+        tt=timediff(obs1.data[i].time,obs1.data[i-1].time);
+        assert(tt>DTTOL||(tt>=-DTTOL&&(obs1.data[i].rcv>obs1.data[i-1].rcv||
+               (obs1.data[i].rcv==obs1.data[i-1].rcv&&
+                obs1.data[i].sat>obs1.data[i-1].sat))));
+    }
+    free(obs1.data);
+    free(obs2.data);
+    
+    printf("%s utest7 : OK\n",__FILE__);
+}
+/* indexobs(), seekobs() */
+void utest8(void)
+{
+    char file1[]="../data/rinex/07590920.05o";
+    char file2[]="../data/rinex/30400920.05o";
+    obs_t obs={0};
+    gtime_t time;
+    int i,j,k,n,ne[3]={0};
+    
+    readrnx(file1,1,"",&obs,NULL,NULL);
+    readrnx(file2,2,"",&obs,NULL,NULL);
+    n=sortobs(&obs);
+    k=indexobs(&obs);
+        assert(k==obs.ne&&k>=n&&obs.idx);
+    for (i=j=0;i<obs.ne;i++) {
+        assert(obs.idx[i].i==j&&obs.idx[i].n>0);
+        for (j=obs.idx[i].i;j<obs.idx[i].i+obs.idx[i].n;j++) {
+            assert(obs.data[j].rcv==obs.idx[i].rcv);
+            assert(fabs(timediff(obs.data[j].time,
+                                 obs.data[obs.idx[i].i].time))<=DTTOL);
+        }
+        if (i>0) {
+            assert(obs.idx[i].rcv!=obs.idx[i-1].rcv||
+                   timediff(obs.data[obs.idx[i].i].time,
+                            obs.data[obs.idx[i-1].i].time)>DTTOL);
+        }
+        ne[obs.idx[i].rcv]++;
+    }
+        assert(j==obs.n&&ne[1]>0&&ne[2]>0&&ne[1]+ne[2]==obs.ne);
+    for (i=0;i<obs.ne;i++) {
+        time=obs.data[obs.idx[i].i].time;
+        k=seekobs(&obs,time,obs.idx[i].rcv);
+            assert(k==i);
+        k=seekobs(&obs,timeadd(time,-0.001),obs.idx[i].rcv);
+            assert(k==i);
+    }
+    k=seekobs(&obs,timeadd(obs.data[obs.n-1].time,1.0),1);
+        assert(k==obs.ne);
+    freeobs(&obs);
+        assert(!obs.data&&!obs.idx&&obs.ne==0);
+    
+    printf("%s utest8 : OK\n",__FILE__);
+}
+/* write rinex obs file with obs types */
+static void writeobs(const char *file, const char *types, int ntype, int min)
+{
+    FILE *fp;
+    int i,j;
+    
+    assert((fp=fopen(file,"w")));
+    fprintf(fp,"%9.2f%11s%-20s%-20s%-20s\n",2.10,"","OBSERVATION DATA",
+            "G (GPS)","RINEX VERSION / TYPE");
+    fprintf(fp,"%6d%-54s%-20s\n",ntype,types,"# / TYPES OF OBSERV");
+    fprintf(fp,"%60s%-20s\n","","END OF HEADER");
+    fprintf(fp," 05  4  2  0 %2d  0.0000000  0  2G 3G 7\n",min);
+    for (i=0;i<2;i++) {
+        for (j=0;j<ntype;j++) {
+            fprintf(fp,"%14.3f  %s",(i+1)*1E7+j,j%5==4||j==ntype-1?"\n":"");
+        }
+    }
+    fclose(fp);
+}
+/* open_rnxctr(), input_rnxctr() with files of different obs types */
+void utest9(void)
+{
+    char file1[]="/tmp/t_rinex_1.05o",file2[]="/tmp/t_rinex_2.05o";
+    rnxctr_t rnx;
+    FILE *fp;
+    int i;
+    
+    writeobs(file1,"    C1    L1    L2    P2    S1    S2",6,0);
+    writeobs(file2,"    L1    C1",2,1);
+    assert(init_rnxctr(&rnx));
+    
+    assert((fp=fopen(file1,"r")));
+    assert(open_rnxctr(&rnx,fp));
+    assert(input_rnxctr(&rnx,fp)==1&&rnx.obs.n==2);
+    for (i=0;i<2;i++) {
+        assert(rnx.obs.data[i].P[0]==(i+1)*1E7  &&rnx.obs.data[i].L[0]==(i+1)*1E7+1);
+        assert(rnx.obs.data[i].P[1]==(i+1)*1E7+3&&rnx.obs.data[i].L[1]==(i+1)*1E7+2);
+    }
+    fclose(fp);
+    
+    /* obs types of previous file are cleared */
+    assert((fp=fopen(file2,"r")));
+    assert(open_rnxctr(&rnx,fp));
+    assert(!*rnx.tobs[0][2]);
+    assert(input_rnxctr(&rnx,fp)==1&&rnx.obs.n==2);
+    for (i=0;i<2;i++) {
+        assert(rnx.obs.data[i].L[0]==(i+1)*1E7&&rnx.obs.data[i].P[0]==(i+1)*1E7+1);
+        assert(rnx.obs.data[i].L[1]==0.0&&rnx.obs.data[i].P[1]==0.0);
+    }
+    fclose(fp);
+    free_rnxctr(&rnx);
+    remove(file1);
+    remove(file2);
+    
+    printf("%s utest9 : OK\n",__FILE__);
+}
 int main(int argc, char **argv)
 {
     utest1();
@@ -212,5 +352,8 @@ int main(int argc, char **argv)
     utest4();
     utest5();
     utest6();
+    utest7();
+    utest8();
+    utest9();
     return 0;
 }
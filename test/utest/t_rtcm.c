@@ -0,0 +1,205 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : rtcm 3 msm decoder/encoder functions
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <assert.h>
+#include "../../src/rtklib.h"
+
+#define FILE_MSM7   "../data/rcvraw/GMSD7_20121014.rtcm3"
+
+static rtcm_t rtcm,rtcm_e,rtcm_d,rtcm_f;
+
+/* search observation data ---------------------------------------------------*/
+static obsd_t *searchobs(obs_t *obs, int sat)
+{
+    int i;
+    for (i=0;i<obs->n;i++) if (obs->data[i].sat==sat) return obs->data+i;
+    return NULL;
+}
+/* input_rtcm3() msm 7 */
+void utest1(void)
+{
+    double ep[]={2012,10,14,0,0,0};
+    FILE *fp;
+    obsd_t *data;
+    int i,ret,nobs=0,ngps=0,nglo=0;
+    
+    assert((fp=fopen(FILE_MSM7,"rb")));
+    init_rtcm(&rtcm);
+    rtcm.time=epoch2time(ep);
+    
+    for (i=0;(ret=fgetc(fp))!=EOF;i++) {
+        if ((ret=input_rtcm3(&rtcm,(unsigned char)ret))==1) nobs++;
+        
+        /* first gps/glonass msm 7 (values by bit-serial decoder) */
+        if (!ngps&&(data=searchobs(&rtcm.obs,satno(SYS_GPS,1)))) {
+            assert(data->P[0]==24922227.57816102);
+            assert(data->L[0]==130967156.06684576);
+            assert(data->P[1]==24922248.61335149);
+            assert(data->L[1]==102051918.20648277);
+            assert(data->D[0]==(float)3694.04297);
+            assert(data->SNR[0]==141&&data->SNR[1]==77);
+            assert(data->code[0]==CODE_L1C&&data->code[1]==CODE_L2W);
+            ngps++;
+        }
+        if (!nglo&&(data=searchobs(&rtcm.obs,satno(SYS_GLO,13)))) {
+            assert(data->P[0]==23196801.195347771);
+            assert(data->L[0]==123868981.38142489);
+            assert(data->P[1]==23196814.585946854);
+            assert(data->L[1]==96342516.910425454);
+            assert(data->SNR[0]==162&&data->SNR[1]==146);
+            nglo++;
+        }
+    }
+    fclose(fp);
+    free_rtcm(&rtcm);
+    assert(nobs==257&&ngps&&nglo);
+    
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* gen_rtcm3() and input_rtcm3() msm 4-7 */
+void utest2(void)
+{
+    const double tol[][3]={ /* tolerance {P(m),L(cyc),D(hz)} */
+        {0.02,0.003,1E9},{0.02,0.003,0.002},{0.001,0.001,1E9},
+        {0.001,0.001,0.002}
+    };
+    double ep[]={2012,10,14,0,0,0};
+    FILE *fp;
+    obsd_t *d1,*d2;
+    double dL;
+    int i,j,k,msm,ret,nbyte=0,type,ncmp[4]={0};
+    
+    assert((fp=fopen(FILE_MSM7,"rb")));
+    init_rtcm(&rtcm);
+    init_rtcm(&rtcm_e);
+    init_rtcm(&rtcm_d);
+    rtcm.time=rtcm_d.time=epoch2time(ep);
+    
+    while ((ret=fgetc(fp))!=EOF) {
+        ret=input_rtcm3(&rtcm,(unsigned char)ret);
+        
+        /* end of gps msm 7 message */
+        if (rtcm.nbyte>0||nbyte<=0) {
+            nbyte=rtcm.nbyte;
+            continue;
+        }
+        nbyte=0;
+        if ((type=getbitu(rtcm.buff,24,12))!=1077) continue;
+        
+        rtcm_e.time=rtcm.time;
+        for (i=rtcm_e.obs.n=0;i<rtcm.obs.n;i++) {
+            if (satsys(rtcm.obs.data[i].sat,NULL)!=SYS_GPS) continue;
+            rtcm_e.obs.data[rtcm_e.obs.n++]=rtcm.obs.data[i];
+        }
+        for (msm=4;msm<=7;msm++) {
+            assert(gen_rtcm3(&rtcm_e,1070+msm,0));
+            for (i=0;i<rtcm_e.nbyte;i++) {
+                ret=input_rtcm3(&rtcm_d,rtcm_e.buff[i]);
+            }
+            assert(ret==1&&rtcm_d.obs.n==rtcm_e.obs.n);
+            
+            for (i=0;i<rtcm_e.obs.n;i++) {
+                d1=rtcm_e.obs.data+i;
+                assert((d2=searchobs(&rtcm_d.obs,d1->sat)));
+                for (j=0;j<NFREQ;j++) {
+                    if (d1->code[j]==CODE_NONE) continue;
+                    assert(d2->code[j]==d1->code[j]);
+                    assert(fabs(d2->P[j]-d1->P[j])<tol[msm-4][0]);
+                    if (d1->L[j]!=0.0) {
+                        dL=d2->L[j]-d1->L[j]; /* integer cycles adjusted */
+                        assert(fabs(dL-floor(dL+0.5))<tol[msm-4][1]);
+                    }
+                    if (d1->D[j]!=0.0&&tol[msm-4][2]<1.0) {
+                        assert(fabs(d2->D[j]-d1->D[j])<tol[msm-4][2]);
+                    }
+                    k=(int)d1->SNR[j]-(int)d2->SNR[j];
+                    assert(-4<=k&&k<=4);
+                    ncmp[msm-4]++;
+                }
+            }
+        }
+    }
+    fclose(fp);
+    free_rtcm(&rtcm);
+    free_rtcm(&rtcm_e);
+    free_rtcm(&rtcm_d);
+    for (msm=4;msm<=7;msm++) assert(ncmp[msm-4]>1000);
+    
+    printf("%s utest2 : OK\n",__FILE__);
+}
+/* gen_rtcm3() msm with layout shared by messages of same epoch */
+void utest3(void)
+{
+    double ep[]={2012,10,14,0,0,0};
+    FILE *fp;
+    unsigned char buff[1200];
+    int i,ret,nbyte=0,n,nepoch=0;
+    
+    assert((fp=fopen(FILE_MSM7,"rb")));
+    init_rtcm(&rtcm);
+    init_rtcm(&rtcm_e);
+    init_rtcm(&rtcm_d);
+    init_rtcm(&rtcm_f);
+    rtcm.time=rtcm_d.time=epoch2time(ep);
+    
+    while ((ret=fgetc(fp))!=EOF) {
+        ret=input_rtcm3(&rtcm,(unsigned char)ret);
+        
+        /* end of gps msm 7 message */
+        if (rtcm.nbyte>0||nbyte<=0) {
+            nbyte=rtcm.nbyte;
+            continue;
+        }
+        nbyte=0;
+        if (getbitu(rtcm.buff,24,12)!=1077) continue;
+        
+        rtcm_e.time=rtcm_f.time=rtcm.time;
+        for (i=rtcm_e.obs.n=0;i<rtcm.obs.n;i++) {
+            if (satsys(rtcm.obs.data[i].sat,NULL)!=SYS_GPS) continue;
+            rtcm_e.obs.data[rtcm_e.obs.n++]=rtcm.obs.data[i];
+        }
+        for (i=0;i<rtcm_e.obs.n;i++) rtcm_f.obs.data[i]=rtcm_e.obs.data[i];
+        rtcm_f.obs.n=rtcm_e.obs.n;
+        
+        /* msm 7 after msm 4 of same epoch equals to msm 7 only */
+        assert(gen_rtcm3(&rtcm_e,1074,0));
+        assert(gen_rtcm3(&rtcm_e,1077,0));
+        assert(gen_rtcm3(&rtcm_f,1077,0));
+        assert(rtcm_e.nbyte==rtcm_f.nbyte);
+        assert(!memcmp(rtcm_e.buff,rtcm_f.buff,rtcm_e.nbyte));
+        memcpy(buff,rtcm_e.buff,rtcm_e.nbyte);
+        n=rtcm_e.nbyte;
+        
+        /* layout updated by change of satellites in same epoch */
+        if (rtcm_e.obs.n<2) continue;
+        rtcm_e.obs.n--;
+        assert(gen_rtcm3(&rtcm_e,1077,0));
+        assert(rtcm_e.nbyte<n);
+        for (i=0;i<rtcm_e.nbyte;i++) {
+            ret=input_rtcm3(&rtcm_d,rtcm_e.buff[i]);
+        }
+        assert(ret==1&&rtcm_d.obs.n==rtcm_e.obs.n);
+        
+        /* layout restored */
+        rtcm_e.obs.n++;
+        assert(gen_rtcm3(&rtcm_e,1077,0));
+        assert(rtcm_e.nbyte==n&&!memcmp(rtcm_e.buff,buff,n));
+        nepoch++;
+    }
+    fclose(fp);
+    free_rtcm(&rtcm);
+    free_rtcm(&rtcm_e);
+    free_rtcm(&rtcm_d);
+    free_rtcm(&rtcm_f);
+    assert(nepoch>200);
+    
+    printf("%s utest3 : OK\n",__FILE__);
+}
+int main(void)
+{
+    utest1();
+    utest2();
+    utest3();
+    return 0;
+}
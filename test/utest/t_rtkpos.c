@@ -0,0 +1,162 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : rtk positioning functions
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <assert.h>
+#include "../../src/rtklib.h"
+
+#define CKPTFILE    "utest_rtk.ckpt"    /* test checkpoint file */
+
+/* generate test filter state ------------------------------------------------*/
+static void genrtk(rtk_t *rtk, gtime_t time)
+{
+    int i,j,k,ix[]={0,1,2,10,25,100,0};
+    
+    ix[6]=rtk->nx-1;
+    rtk->sol.time=time;
+    rtk->sol.stat=SOLQ_FIX;
+    rtk->sol.ns=9;
+    for (i=0;i<3;i++) rtk->sol.rr[i]=rtk->rb[i]=-3957240.1+i*1000.0;
+    rtk->tt=1.0;
+    rtk->nfix=12;
+    
+    for (i=0;i<7;i++) {
+        rtk->x[ix[i]]=1.0+i*0.5;
+        for (j=0;j<7;j++) {
+            rtk->P[ix[i]+ix[j]*rtk->nx]=i==j?0.1*(i+1):0.001*(i+j+1);
+        }
+    }
+    for (i=0;i<rtk->na;i++) {
+        rtk->xa[i]=rtk->x[i];
+        for (j=0;j<rtk->na;j++) rtk->Pa[i+j*rtk->na]=rtk->P[i+j*rtk->nx];
+    }
+    for (k=3;k<MAXSAT;k+=17) {
+        rtk->ssat[k].vs=1;
+        rtk->ssat[k].lock[0]=k;
+        rtk->ssat[k].slipc[1]=2;
+        rtk->ssat[k].gf=0.01*k;
+        rtk->ssat[k].pt[0][0]=time;
+        rtk->ambc[k].fixcnt=k%5;
+    }
+}
+/* compare filter states -----------------------------------------------------*/
+static int eqrtk(const rtk_t *r1, const rtk_t *r2)
+{
+    int i;
+    
+    if (r1->nx!=r2->nx||r1->na!=r2->na||r1->nfix!=r2->nfix) return 0;
+    if (timediff(r1->sol.time,r2->sol.time)!=0.0||r1->tt!=r2->tt) return 0;
+    if (memcmp(r1->rb,r2->rb,sizeof(r1->rb))) return 0;
+    for (i=0;i<r1->nx;i++) if (r1->x[i]!=r2->x[i]) return 0;
+    for (i=0;i<r1->nx*r1->nx;i++) if (r1->P[i]!=r2->P[i]) return 0;
+    for (i=0;i<r1->na;i++) if (r1->xa[i]!=r2->xa[i]) return 0;
+    for (i=0;i<r1->na*r1->na;i++) if (r1->Pa[i]!=r2->Pa[i]) return 0;
+    for (i=0;i<MAXSAT;i++) {
+        if (r1->ssat[i].lock[0]!=r2->ssat[i].lock[0]||
+            r1->ssat[i].slipc[1]!=r2->ssat[i].slipc[1]||
+            r1->ssat[i].gf!=r2->ssat[i].gf||
+            r1->ambc[i].fixcnt!=r2->ambc[i].fixcnt) return 0;
+    }
+    return 1;
+}
+/* rtksave(), rtkload() */
+void utest1(void)
+{
+    double ep[]={2015,3,20,9,30,0.0};
+    prcopt_t opt=prcopt_default;
+    rtk_t rtk1,rtk2;
+    gtime_t time=epoch2time(ep),time0={0};
+    FILE *fp;
+    long size;
+    
+    opt.mode=PMODE_KINEMA;
+    opt.nf=2;
+    rtkinit(&rtk1,&opt);
+    rtkinit(&rtk2,&opt);
+    genrtk(&rtk1,time);
+    
+    assert(rtksave(&rtk1,CKPTFILE));
+    assert(rtkload(&rtk2,CKPTFILE,timeadd(time,1.0)));
+    assert(eqrtk(&rtk1,&rtk2));
+    
+    /* compact by active states */
+    fp=fopen(CKPTFILE,"rb");
+    assert(fp);
+    fseek(fp,0,SEEK_END);
+    size=ftell(fp);
+    fclose(fp);
+    printf("nx=%d size=%ld bytes (full P=%ld bytes)\n",rtk1.nx,size,
+           (long)rtk1.nx*rtk1.nx*8);
+    assert(size<(long)rtk1.nx*rtk1.nx*8/10);
+    
+    /* no time check */
+    assert(rtkload(&rtk2,CKPTFILE,time0));
+    assert(eqrtk(&rtk1,&rtk2));
+    
+    rtkfree(&rtk1);
+    rtkfree(&rtk2);
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* rtkload() rejects checkpoint */
+void utest2(void)
+{
+    double ep[]={2015,3,20,9,30,0.0};
+    prcopt_t opt=prcopt_default;
+    rtk_t rtk1,rtk2;
+    gtime_t time=epoch2time(ep);
+    FILE *fp;
+    unsigned char c;
+    
+    opt.mode=PMODE_KINEMA;
+    opt.nf=2;
+    rtkinit(&rtk1,&opt);
+    genrtk(&rtk1,time);
+    assert(rtksave(&rtk1,CKPTFILE));
+    
+    /* checkpoint after or too old from restart time */
+    rtkinit(&rtk2,&opt);
+    assert(!rtkload(&rtk2,CKPTFILE,timeadd(time,-1.0)));
+    assert(!rtkload(&rtk2,CKPTFILE,timeadd(time,3600.0)));
+    assert(rtk2.x[0]==0.0&&rtk2.nfix==0&&rtk2.sol.time.time==0);
+    rtkfree(&rtk2);
+    
+    /* different positioning mode */
+    opt.mode=PMODE_STATIC;
+    rtkinit(&rtk2,&opt);
+    assert(!rtkload(&rtk2,CKPTFILE,time));
+    rtkfree(&rtk2);
+    
+    /* different number of states */
+    opt.mode=PMODE_KINEMA;
+    opt.nf=1;
+    rtkinit(&rtk2,&opt);
+    assert(!rtkload(&rtk2,CKPTFILE,time));
+    rtkfree(&rtk2);
+    
+    /* corrupted checkpoint */
+    opt.nf=2;
+    rtkinit(&rtk2,&opt);
+    fp=fopen(CKPTFILE,"r+b");
+    assert(fp);
+    fseek(fp,100,SEEK_SET);
+    c=(unsigned char)fgetc(fp);
+    fseek(fp,100,SEEK_SET);
+    fputc(c^0x01,fp);
+    fclose(fp);
+    assert(!rtkload(&rtk2,CKPTFILE,time));
+    assert(rtk2.x[0]==0.0&&rtk2.nfix==0);
+    
+    /* no file */
+    remove(CKPTFILE);
+    assert(!rtkload(&rtk2,CKPTFILE,time));
+    
+    rtkfree(&rtk1);
+    rtkfree(&rtk2);
+    printf("%s utest2 : OK\n",__FILE__);
+}
+int main(void)
+{
+    utest1();
+    utest2();
+    return 0;
+}
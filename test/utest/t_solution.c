@@ -0,0 +1,201 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : solution functions
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <assert.h>
+#include "../../src/rtklib.h"
+
+#define NSOL        100                 /* number of test solutions */
+
+/* generate test solution ----------------------------------------------------*/
+static void gensol(int i, sol_t *sol)
+{
+    double ep[]={2015,3,20,9,30,0.0};
+    int j;
+    
+    memset(sol,0,sizeof(sol_t));
+    sol->time=timeadd(epoch2time(ep),i*0.05);
+    sol->rr[0]=-3957240.1234+i*0.001;
+    sol->rr[1]= 3310370.4567-i*0.002;
+    sol->rr[2]= 3737527.8901+i*0.003;
+    for (j=0;j<3;j++) sol->qr[j]=(float)(1E-4*(j+1));
+    sol->qr[3]=(float)-2E-5;
+    sol->dtr[0]=1E-7*i;
+    sol->stat=i%10==9?SOLQ_FLOAT:SOLQ_FIX;
+    sol->ns=(unsigned char)(10+i%5);
+    sol->age=(float)(0.1*(i%10));
+    sol->ratio=(float)(3.0+0.1*i);
+}
+/* compare solutions ---------------------------------------------------------*/
+static int eqsol(const sol_t *s1, const sol_t *s2)
+{
+    int j;
+    
+    if (timediff(s1->time,s2->time)!=0.0) return 0;
+    for (j=0;j<6;j++) if (s1->rr[j]!=s2->rr[j]||s1->qr[j]!=s2->qr[j]) return 0;
+    for (j=0;j<6;j++) if (s1->dtr[j]!=s2->dtr[j]) return 0;
+    return s1->type==s2->type&&s1->stat==s2->stat&&s1->ns==s2->ns&&
+           s1->age==s2->age&&s1->ratio==s2->ratio;
+}
+/* outsolbins(), inputsol() */
+void utest1(void)
+{
+    solopt_t opt=solopt_default;
+    solbuf_t solbuf;
+    ssat_t ssat[MAXSAT]={{0}};
+    gtime_t t0={0};
+    sol_t sol;
+    double rb[]={-3957199.0,3310205.0,3737911.0};
+    unsigned char buff[MAXSOLMSG*4];
+    int i,j,n,nb,nsat=0;
+    
+    opt.posf=SOLF_BIN;
+    for (i=0;i<MAXSAT;i+=3) {
+        ssat[i].vs=1; ssat[i].azel[1]=0.5; ssat[i].snr[0]=180;
+        nsat++;
+    }
+    /* no header for binary format */
+    assert(outsolheads(buff,&opt)==0);
+    
+    /* fixed-size solution record and satellite block */
+    gensol(0,&sol);
+    assert(outsols(buff,&sol,rb,&opt)==177);
+    n=outsolexs(buff,&sol,ssat,&opt);
+    assert(n==9+16+20*(nsat<64?nsat:64));
+    
+    /* round trip with satellite blocks, text lines and a corrupted record */
+    initsolbuf(&solbuf,0,0);
+    nb=sprintf((char *)buff,"%% solution with binary records\n");
+    for (i=0;i<NSOL;i++) {
+        gensol(i,&sol);
+        n=outsols(buff+nb,&sol,rb,&opt);
+        if (i==50) buff[nb+100]^=0x01; /* crc error */
+        nb+=n;
+        if (i%2==0) nb+=outsolexs(buff+nb,&sol,ssat,&opt);
+        
+        for (j=0;j<nb;j++) inputsol(buff[j],t0,t0,0.0,0,&opt,&solbuf);
+        nb=0;
+    }
+    assert(solbuf.n==NSOL-1);
+    for (i=j=0;i<NSOL;i++) {
+        if (i==50) continue;
+        gensol(i,&sol);
+        assert(eqsol(&sol,solbuf.data+j++));
+    }
+    for (i=0;i<3;i++) assert(solbuf.rb[i]==rb[i]);
+    freesolbuf(&solbuf);
+    
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* readsolt() with binary solution file and conversion to text */
+void utest2(void)
+{
+    const char *file1="/tmp/t_solution.bin",*file2="/tmp/t_solution.pos";
+    char *files[1];
+    solopt_t opt=solopt_default;
+    solbuf_t solbuf,solbuf2;
+    FILE *fp;
+    sol_t sol;
+    double rb[]={-3957199.0,3310205.0,3737911.0};
+    gtime_t t0={0};
+    int i;
+    
+    opt.posf=SOLF_BIN;
+    assert((fp=fopen(file1,"wb")));
+    for (i=0;i<NSOL;i++) {
+        gensol(i,&sol);
+        outsol(fp,&sol,rb,&opt);
+    }
+    fclose(fp);
+    
+    /* read binary solution file with time and quality filter */
+    files[0]=(char *)file1;
+    assert(readsolt(files,1,t0,t0,0.0,SOLQ_FLOAT,&solbuf));
+    assert(solbuf.n==NSOL/10);
+    freesolbuf(&solbuf);
+    assert(readsolt(files,1,t0,t0,0.0,0,&solbuf));
+    assert(solbuf.n==NSOL);
+    
+    /* convert to text format (x/y/z-ecef) and read again */
+    opt.posf=SOLF_XYZ;
+    opt.timeu=3;
+    assert((fp=fopen(file2,"w")));
+    outsolhead(fp,&opt);
+    for (i=0;i<solbuf.n;i++) outsol(fp,solbuf.data+i,solbuf.rb,&opt);
+    fclose(fp);
+    
+    files[0]=(char *)file2;
+    assert(readsolt(files,1,t0,t0,0.0,0,&solbuf2));
+    assert(solbuf2.n==NSOL);
+    for (i=0;i<NSOL;i++) {
+        assert(fabs(timediff(solbuf.data[i].time,solbuf2.data[i].time))<1E-6);
+        assert(fabs(solbuf.data[i].rr[0]-solbuf2.data[i].rr[0])<1E-4);
+        assert(solbuf.data[i].stat==solbuf2.data[i].stat);
+    }
+    freesolbuf(&solbuf);
+    freesolbuf(&solbuf2);
+    remove(file1);
+    remove(file2);
+    
+    printf("%s utest2 : OK\n",__FILE__);
+}
+/* opensoltix(), outsoltix(), readsolt() with time index */
+void utest3(void)
+{
+    const char *file="/tmp/t_solution_tix.pos";
+    const double rb[]={-3978242.435,3382841.172,3649902.767};
+    char *files[1];
+    solopt_t opt=solopt_default;
+    solbuf_t solbuf;
+    soltix_t tix;
+    FILE *fp;
+    sol_t sol;
+    gtime_t ts,te,t0={0};
+    int i,j,n;
+    
+    opt.posf=SOLF_XYZ;
+    assert((fp=fopen(file,"w")));
+    assert(opensoltix(&tix,file,0));
+    fprintf(fp,"%% ref pos   :%14.4f%s%14.4f%s%14.4f\n",rb[0],opt.sep,rb[1],
+            opt.sep,rb[2]);
+    outsolhead(fp,&opt);
+    for (i=0;i<NSOL*10;i++) {
+        gensol(i,&sol);
+        outsoltix(&tix,sol.time,fp);
+        outsol(fp,&sol,NULL,&opt);
+    }
+    fclose(fp);
+    closesoltix(&tix);
+    
+    /* time windows inside, across start/end and outside of the file */
+    files[0]=(char *)file;
+    for (j=0;j<4;j++) {
+        gensol(j==0?210:(j==1?0:(j==2?900:2000)),&sol);
+        ts=timeadd(sol.time,j==1?-3.0:0.0);
+        te=timeadd(ts,j==1?5.0:7.5);
+        n=readsolt(files,1,ts,te,0.0,0,&solbuf)?solbuf.n:0;
+        assert(n==(j==0?151:(j==1?41:(j==2?100:0))));
+        for (i=0;i<3;i++) { /* reference position in header */
+            assert(fabs(solbuf.rb[i]-rb[i])<1E-3);
+        }
+        for (i=0;i<n;i++) {
+            assert(timediff(solbuf.data[i].time,ts)>=-DTTOL);
+            assert(timediff(solbuf.data[i].time,te)<= DTTOL);
+        }
+        freesolbuf(&solbuf);
+    }
+    /* no time window */
+    assert(readsolt(files,1,t0,t0,0.0,0,&solbuf));
+    assert(solbuf.n==NSOL*10);
+    freesolbuf(&solbuf);
+    remove(file);
+    
+    printf("%s utest3 : OK\n",__FILE__);
+}
+int main(void)
+{
+    utest1();
+    utest2();
+    utest3();
+    return 0;
+}
@@ -0,0 +1,450 @@
+/*------------------------------------------------------------------------------
+* rtklib unit test driver : stream event and ntrip caster functions
+*-----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../../src/rtklib.h"
+
+#define NCLI        500                 /* number of ntrip connections */
+#define NROUND      20                  /* number of data rounds */
+#define CYCLE       10                  /* polling cycle (ms) */
+#define NCAS        1000                /* number of ntrip caster clients */
+#define NCASR       10                  /* number of clients in eviction test */
+
+typedef struct {                        /* caster stand-in type */
+    int sock;                           /* listen socket */
+    int port;                           /* listen port */
+    int n;                              /* number of connections */
+    int fd[NCLI];                       /* client sockets */
+    int rsp[NCLI];                      /* response sent flags */
+    volatile int state;                 /* state (0:stop,1:run) */
+    volatile int sendreq;               /* data round request */
+} caster_t;
+
+/* current time (s) ----------------------------------------------------------*/
+static double nowsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec*1E-9;
+}
+/* caster stand-in thread ----------------------------------------------------*/
+static void *casterthread(void *arg)
+{
+    caster_t *c=(caster_t *)arg;
+    struct pollfd pfd[NCLI+1];
+    char buff[1024];
+    double t;
+    int i,j,n,nrsp=0;
+    
+    while (c->state) {
+        if (nrsp>=NCLI&&!c->sendreq) { /* all connected */
+            sleepms(10);
+            continue;
+        }
+        pfd[0].fd=c->sock; pfd[0].events=POLLIN; pfd[0].revents=0;
+        for (i=0;i<c->n;i++) {
+            pfd[i+1].fd=c->fd[i]; pfd[i+1].events=c->rsp[i]?0:POLLIN;
+            pfd[i+1].revents=0;
+        }
+        if (poll(pfd,c->n+1,1)>0) {
+            if ((pfd[0].revents&POLLIN)&&c->n<NCLI) {
+                if ((c->fd[c->n]=accept(c->sock,NULL,NULL))>=0) {
+                    c->rsp[c->n++]=0;
+                }
+            }
+            for (i=0;i<c->n;i++) { /* ntrip request -> response */
+                if (c->rsp[i]||!(pfd[i+1].revents&POLLIN)) continue;
+                if ((n=recv(c->fd[i],buff,sizeof(buff)-1,0))<=0) continue;
+                buff[n]='\0';
+                if (!strstr(buff,"\r\n\r\n")) continue;
+                send(c->fd[i],"ICY 200 OK\r\n",12,0);
+                c->rsp[i]=1;
+                nrsp++;
+            }
+        }
+        if (!c->sendreq) continue;
+        
+        for (j=0;j<NROUND&&c->state;j++) { /* send time stamps to clients */
+            for (i=0;i<c->n;i++) {
+                t=nowsec();
+                send(c->fd[i],(char *)&t,sizeof(t),0);
+            }
+            sleepms(50);
+        }
+        c->sendreq=0;
+    }
+    for (i=0;i<c->n;i++) close(c->fd[i]);
+    return NULL;
+}
+/* start caster stand-in -----------------------------------------------------*/
+static int startcaster(caster_t *c, pthread_t *thread)
+{
+    struct sockaddr_in addr;
+    socklen_t len=sizeof(addr);
+    
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+    addr.sin_port=0;
+    c->n=0; c->state=1; c->sendreq=0;
+    if ((c->sock=socket(AF_INET,SOCK_STREAM,0))<0||
+        bind(c->sock,(struct sockaddr *)&addr,sizeof(addr))<0||
+        listen(c->sock,NCLI)<0||
+        getsockname(c->sock,(struct sockaddr *)&addr,&len)<0) {
+        return 0;
+    }
+    c->port=ntohs(addr.sin_port);
+    return !pthread_create(thread,NULL,casterthread,c);
+}
+/* read streams and measure latency ------------------------------------------*/
+static int readstrs(stream_t *strs, int i, double *lat, double *latmax)
+{
+    unsigned char buff[4096];
+    double t,dt;
+    int j,n,nr=0;
+    
+    while ((n=strread(strs+i,buff,sizeof(buff)))>0) {
+        for (j=0;j+(int)sizeof(t)<=n;j+=sizeof(t)) {
+            memcpy(&t,buff+j,sizeof(t));
+            dt=nowsec()-t;
+            *lat+=dt;
+            if (dt>*latmax) *latmax=dt;
+            nr++;
+        }
+    }
+    return nr;
+}
+/* stream event by tcp server/client */
+void utest1(void)
+{
+    stream_t svr,cli;
+    strevt_t evt;
+    unsigned char buff[256];
+    char msg[MAXSTRMSG],path[64];
+    double t;
+    int i,n,stat=0,port=20000+(int)getpid()%20000;
+    
+    strinit(&svr);
+    strinit(&cli);
+    sprintf(path,":%d",port);
+    assert(stropen(&svr,STR_TCPSVR,STR_MODE_RW,path));
+    sprintf(path,"127.0.0.1:%d",port);
+    assert(stropen(&cli,STR_TCPCLI,STR_MODE_RW,path));
+    assert(strevtinit(&evt,2));
+    assert(strevtadd(&evt,&cli)==0);
+    assert(strevtadd(&evt,&svr)==1);
+    
+    for (i=0;i<200;i++) { /* connect */
+        strread(&cli,buff,sizeof(buff));
+        strwrite(&svr,(unsigned char *)"",0);
+        if (strstat(&cli,msg)==2&&strstat(&svr,msg)==2) break;
+        sleepms(10);
+    }
+    assert(i<200);
+    
+    /* timeout without data */
+    t=nowsec();
+    n=strevtwait(&evt,100);
+        assert(n==0&&!evt.ready[0]);
+        assert(nowsec()-t>=0.09);
+    
+    /* wake by data */
+    strwrite(&svr,(unsigned char *)"abcd",4);
+    t=nowsec();
+    n=strevtwait(&evt,1000);
+        assert(n==1&&evt.ready[0]&&!evt.ready[1]);
+        assert(nowsec()-t<0.5);
+    n=strread(&cli,buff,sizeof(buff));
+        assert(n==4&&!memcmp(buff,"abcd",4));
+    
+    /* wake by data from client to server */
+    strwrite(&cli,(unsigned char *)"efg",3);
+    n=strevtwait(&evt,1000);
+        assert(n==1&&evt.ready[1]);
+    n=strread(&svr,buff,sizeof(buff));
+        assert(n==3);
+    
+    /* reconnect and wake again by new socket */
+    strclose(&cli);
+    strinit(&cli);
+    assert(stropen(&cli,STR_TCPCLI,STR_MODE_RW,path));
+    evt.stream[0]=&cli;
+    for (i=0;i<200;i++) {
+        strread(&cli,buff,sizeof(buff));
+        strwrite(&svr,(unsigned char *)"",0);
+        if ((stat=strstat(&cli,msg))==2) break;
+        sleepms(10);
+    }
+    assert(stat==2);
+    for (i=0;i<100;i++) {
+        strwrite(&svr,(unsigned char *)"h",1);
+        if (strevtwait(&evt,100)>0&&evt.ready[0]) break;
+    }
+    assert(i<100);
+    
+    strevtfree(&evt);
+    strclose(&cli);
+    strclose(&svr);
+    
+    printf("%s utest1 : OK\n",__FILE__);
+}
+/* latency and idle cpu of 500 ntrip connections by polling/stream event */
+void utest2(void)
+{
+    static stream_t strs[NCLI];
+    struct rlimit rl;
+    caster_t c={0};
+    pthread_t thread;
+    strevt_t evt;
+    unsigned char buff[256];
+    char path[256],msg[MAXSTRMSG];
+    clock_t cpu;
+    double t,lat,latmax,cpuidle;
+    int i,j,n,mode,nr;
+    
+    if (!getrlimit(RLIMIT_NOFILE,&rl)&&rl.rlim_cur<NCLI*2+64) {
+        rl.rlim_cur=rl.rlim_max<NCLI*2+64?rl.rlim_max:NCLI*2+64;
+        setrlimit(RLIMIT_NOFILE,&rl);
+    }
+    assert(startcaster(&c,&thread));
+    
+    sprintf(path,"user:passwd@127.0.0.1:%d/MNT",c.port);
+    for (i=0;i<NCLI;i++) {
+        strinit(strs+i);
+        assert(stropen(strs+i,STR_NTRIPCLI,STR_MODE_R,path));
+    }
+    for (j=0;j<1000;j++) { /* connect all */
+        for (i=n=0;i<NCLI;i++) {
+            strread(strs+i,buff,sizeof(buff));
+            if (strstat(strs+i,msg)==2) n++;
+        }
+        if (n>=NCLI) break;
+        sleepms(10);
+    }
+    assert(n==NCLI);
+    
+    assert(strevtinit(&evt,NCLI));
+    for (i=0;i<NCLI;i++) strevtadd(&evt,strs+i);
+    
+    for (mode=0;mode<2;mode++) { /* 0:polling with sleep,1:stream event */
+        
+        /* idle cpu */
+        cpu=clock(); t=nowsec();
+        while (nowsec()-t<2.0) {
+            if (mode==0) {
+                for (i=0;i<NCLI;i++) strread(strs+i,buff,sizeof(buff));
+                sleepms(CYCLE);
+            }
+            else if (strevtwait(&evt,CYCLE)>0) {
+                for (i=0;i<NCLI;i++) {
+                    if (evt.ready[i]) strread(strs+i,buff,sizeof(buff));
+                }
+            }
+        }
+        cpuidle=(double)(clock()-cpu)/CLOCKS_PER_SEC/(nowsec()-t)*100.0;
+        
+        /* byte latency from caster to client */
+        lat=latmax=0.0; nr=0;
+        c.sendreq=1;
+        t=nowsec();
+        while (nr<NCLI*NROUND&&nowsec()-t<30.0) {
+            if (mode==0) {
+                for (i=0;i<NCLI;i++) nr+=readstrs(strs,i,&lat,&latmax);
+                sleepms(CYCLE);
+            }
+            else if (strevtwait(&evt,CYCLE)>0) {
+                for (i=0;i<NCLI;i++) {
+                    if (evt.ready[i]) nr+=readstrs(strs,i,&lat,&latmax);
+                }
+            }
+        }
+        while (c.sendreq) sleepms(10);
+        assert(nr==NCLI*NROUND);
+        
+        printf("%s: nstr=%d latency avg=%8.3f max=%8.3f ms idle cpu=%5.1f %%\n",
+               mode==0?"polling":"event  ",NCLI,lat/nr*1E3,latmax*1E3,
+               cpuidle);
+    }
+    strevtfree(&evt);
+    for (i=0;i<NCLI;i++) strclose(strs+i);
+    c.state=0;
+    pthread_join(thread,NULL);
+    close(c.sock);
+    
+    printf("%s utest2 : OK\n",__FILE__);
+}
+/* connect raw ntrip client to caster ---------------------------------------*/
+static int concas(int port, const char *req, int rcvbuf)
+{
+    struct sockaddr_in addr;
+    int sock;
+    
+    memset(&addr,0,sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+    addr.sin_port=htons(port);
+    if ((sock=socket(AF_INET,SOCK_STREAM,0))<0) return -1;
+    if (rcvbuf>0) {
+        setsockopt(sock,SOL_SOCKET,SO_RCVBUF,&rcvbuf,sizeof(rcvbuf));
+    }
+    if (connect(sock,(struct sockaddr *)&addr,sizeof(addr))<0||
+        send(sock,req,strlen(req),0)!=(int)strlen(req)) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+/* read ntrip caster clients without block -----------------------------------*/
+static void readcas(const int *sock, int n, int *nb, const unsigned char *data)
+{
+    struct pollfd pfd[NCAS];
+    unsigned char buff[8192];
+    int i,j,nr;
+    
+    for (i=0;i<n;i++) {
+        pfd[i].fd=sock[i]; pfd[i].events=POLLIN; pfd[i].revents=0;
+    }
+    if (poll(pfd,n,1)<=0) return;
+    
+    for (i=0;i<n;i++) {
+        if (!(pfd[i].revents&POLLIN)) continue;
+        if ((nr=recv(sock[i],buff,sizeof(buff),0))<=0) continue;
+        for (j=0;j<nr;j++) { /* check data sequence */
+            assert(buff[j]==data[(nb[i]+j)%251]);
+        }
+        nb[i]+=nr;
+    }
+}
+/* ntrip caster fan-out to 1000 clients and slow client eviction */
+void utest3(void)
+{
+    static int sock[NCAS],nb[NCAS];
+    static unsigned char data[251];
+    struct rlimit rl;
+    stream_t str;
+    strcasstat_t stat;
+    unsigned char buff[4096];
+    char path[256],msg[MAXSTRMSG],rsp[1024];
+    double t;
+    int i,j,n,nw,slow,port=20000+((int)getpid()+7)%20000;
+    const char *req="GET /MNT HTTP/1.0\r\nUser-Agent: NTRIP test\r\n"
+                    "Authorization: Basic dXNlcjpwYXNzd2Q=\r\n\r\n";
+    
+    if (!getrlimit(RLIMIT_NOFILE,&rl)&&rl.rlim_cur<NCAS*2+64) {
+        rl.rlim_cur=rl.rlim_max<NCAS*2+64?rl.rlim_max:NCAS*2+64;
+        setrlimit(RLIMIT_NOFILE,&rl);
+    }
+    for (i=0;i<251;i++) data[i]=(unsigned char)i;
+    
+    strinit(&str);
+    sprintf(path,"user:passwd@:%d/MNT:RTCM 3;1004(1),1012(1);2;GPS+GLO",port);
+    assert(stropen(&str,STR_NTRIPC,STR_MODE_W,path));
+    assert(strstat(&str,msg)==1);
+    
+    /* source table for unknown mountpoint */
+    assert((slow=concas(port,"GET / HTTP/1.0\r\n\r\n",0))>=0);
+    for (i=n=0;i<100;i++) {
+        if ((j=recv(slow,rsp+n,sizeof(rsp)-1-n,MSG_DONTWAIT))==0) break;
+        if (j>0) n+=j; else sleepms(10);
+    }
+    rsp[n]='\0';
+    close(slow);
+        assert(strstr(rsp,"SOURCETABLE 200 OK"));
+        assert(strstr(rsp,"STR;MNT;RTCM 3;1004(1)"));
+        assert(strstr(rsp,"ENDSOURCETABLE"));
+    
+    /* unauthorized client */
+    assert((slow=concas(port,"GET /MNT HTTP/1.0\r\n\r\n",0))>=0);
+    for (i=n=0;i<100&&!n;i++) {
+        if ((n=recv(slow,rsp,sizeof(rsp)-1,MSG_DONTWAIT))<0) {n=0; sleepms(10);}
+    }
+    rsp[n]='\0';
+    close(slow);
+        assert(strstr(rsp,"401"));
+    
+    /* connect clients and a slow client with small receive buffer */
+    for (i=0;i<NCAS;i++) {
+        assert((sock[i]=concas(port,req,0))>=0);
+    }
+    assert((slow=concas(port,req,4096))>=0);
+    for (i=0;i<500;i++) {
+        assert(strcasstat(&str,&stat));
+        if (stat.ncli==NCAS+1) break;
+        sleepms(10);
+    }
+    assert(stat.ncli==NCAS+1&&stat.nacc==NCAS+1);
+    for (i=0;i<NCAS;i++) { /* skip response */
+        for (j=0;j<100;j++) if (recv(sock[i],rsp,12,MSG_WAITALL)==12) break;
+        assert(!strncmp(rsp,"ICY 200 OK\r\n",12));
+    }
+    recv(slow,rsp,12,MSG_WAITALL);
+    assert(strstat(&str,msg)>=2);
+    
+    /* fan-out of 100 chunks to all clients */
+    t=nowsec();
+    for (i=nw=0;i<100;i++) {
+        for (j=0;j<200;j++) buff[j]=data[(nw+j)%251];
+        assert(strwrite(&str,buff,200)==200);
+        nw+=200;
+        readcas(sock,NCAS,nb,data);
+    }
+    assert(strstat(&str,msg)==3&&strstr(msg,"1001 clients"));
+    while (nowsec()-t<30.0) {
+        for (i=n=0;i<NCAS;i++) n+=nb[i]==nw;
+        if (n==NCAS) break;
+        readcas(sock,NCAS,nb,data);
+    }
+    assert(n==NCAS);
+    assert(strcasstat(&str,&stat));
+    printf("caster: ncli=%d bytes=%d time=%.1f ms nbuff=%d\n",NCAS,nw,
+           (nowsec()-t)*1E3,stat.nbuff);
+    assert(stat.outb>=(double)nw*NCAS&&stat.nevict==0);
+    
+    /* disconnect clients */
+    for (i=NCASR;i<NCAS;i++) close(sock[i]);
+    for (i=0;i<500;i++) {
+        assert(strcasstat(&str,&stat));
+        if (stat.ncli==NCASR+1) break;
+        sleepms(10);
+    }
+    assert(stat.ncli==NCASR+1);
+    
+    /* evict slow client not reading */
+    for (i=0;i<256;i++) {
+        for (j=0;j<4096;j++) buff[j]=data[(nw+j)%251];
+        assert(strwrite(&str,buff,4096)==4096);
+        nw+=4096;
+        readcas(sock,NCASR,nb,data);
+    }
+    for (t=nowsec();nowsec()-t<30.0;) {
+        for (i=n=0;i<NCASR;i++) n+=nb[i]==nw;
+        if (n==NCASR) break;
+        readcas(sock,NCASR,nb,data);
+    }
+    assert(n==NCASR);
+    assert(strcasstat(&str,&stat));
+    assert(stat.nevict==1&&stat.ncli==NCASR&&stat.maxlag==0);
+    printf("caster: evict=%d nbuff=%d\n",stat.nevict,stat.nbuff);
+    
+    close(slow);
+    for (i=0;i<NCASR;i++) close(sock[i]);
+    strclose(&str);
+    
+    printf("%s utest3 : OK\n",__FILE__);
+}
+int main(int argc, char **argv)
+{
+    utest1();
+    utest2();
+    utest3();
+    return 0;
+}
@@ -184,7 +184,7 @@ void utest7(void)
     t=gpst2utc(epoch2time(ep5)); time2epoch(t,ep);
         assert(ep[0]==2005&&ep[1]==12&&ep[2]==31&&ep[3]==23&&ep[4]==59&&ep[5]==47.0);
     t=gpst2utc(epoch2time(ep6)); time2epoch(t,ep);
-        assert(ep[0]==2037&&ep[1]==12&&ep[2]==31&&ep[3]==23&&ep[4]==59&&ep[5]==44.0);
+        assert(ep[0]==2037&&ep[1]==12&&ep[2]==31&&ep[3]==23&&ep[4]==59&&ep[5]==43.0);
 
     printf("%s utset7 : OK\n",__FILE__);
 }
@@ -269,6 +269,89 @@ void utest11(void)
     
     printf("%s utset11 : OK\n",__FILE__);
 }
+/* gpst2time(), gst2time(), bdt2time() reference times */
+void utest12(void)
+{
+    double gpst0[]={1980,1, 6,0,0,0},gst0[]={1999,8,22,0,0,0};
+    double bdt0 []={2006,1, 1,0,0,0};
+    double ep1[]={2015,6,30,23,59,59.5},ep2[]={2015,7,1,0,0,0.0};
+    gtime_t t,t0,t1;
+    double tow;
+    int i,week;
+    t=gpst2time(0,0.0); t0=epoch2time(gpst0);
+        assert(t.time==t0.time&&t.sec==0.0);
+    t=gst2time(0,0.0); t0=epoch2time(gst0);
+        assert(t.time==t0.time&&t.sec==0.0);
+    t=bdt2time(0,0.0); t0=epoch2time(bdt0);
+        assert(t.time==t0.time&&t.sec==0.0);
+    for (i=0;i<4000;i+=7) {
+        t=gpst2time(i,604799.5); tow=time2gpst(t,&week);
+            assert(week==i&&tow==604799.5);
+        t=gpst2time(i,604800.0); tow=time2gpst(t,&week);
+            assert(week==i+1&&tow==0.0);
+        t=timeadd(gpst2time(i+1,0.0),-0.25); tow=time2gpst(t,&week);
+            assert(week==i&&tow==604799.75);
+        t=gst2time(i,302400.0); tow=time2gst(t,&week);
+            assert(week==i&&tow==302400.0);
+        t=bdt2time(i,0.125); tow=time2bdt(t,&week);
+            assert(week==i&&tow==0.125);
+    }
+    /* leap second at 2015/7/1 */
+    t0=epoch2time(ep1); t1=epoch2time(ep2);
+    t=utc2gpst(t0); assert(timediff(t,t0)==16.0);
+    t=utc2gpst(t1); assert(timediff(t,t1)==17.0);
+    t=gpst2utc(timeadd(t1,16.5)); assert(timediff(t,t1)== 0.5);
+    t=gpst2utc(timeadd(t1,17.0)); assert(timediff(t,t1)== 0.0);
+    
+    printf("%s utset12 : OK\n",__FILE__);
+}
+/* time2timens(), timeaddns(), timediffns() */
+void utest13(void)
+{
+    double ep0[]={2016,12,31,23,0,0},ep1[]={2017,1,1,0,0,0};
+    gtimens_t tn0,tn;
+    gtime_t t0,t;
+    double tow;
+    int i,week;
+    t0=epoch2time(ep0);
+    tn0=tn=time2timens(t0);
+        assert(tn.time==t0.time&&tn.nsec==0);
+    for (i=0;i<36000;i++) tn=timeaddns(tn,0.1);
+        assert(timediffns(tn,tn0)==3600.0&&tn.nsec==0);
+    t=timens2time(tn);
+        assert(timediff(t,epoch2time(ep1))==0.0);
+    tn=timeaddns(tn,-0.000000001);
+        assert(tn.time==t.time-1&&tn.nsec==999999999);
+    tn=time2timens(timeadd(t0,0.9999999999));
+        assert(tn.time==t0.time+1&&tn.nsec==0);
+    tn=gpst2timens(1930,86400.123456789);
+    tow=timens2gpst(tn,&week);
+        assert(week==1930&&tn.nsec==123456789&&fabs(tow-86400.123456789)<1E-9);
+    
+    printf("%s utset13 : OK\n",__FILE__);
+}
+/* screent() */
+void utest14(void)
+{
+    gtimens_t tn;
+    gtime_t t,ts={0},te={0};
+    int i,n1=0,n2=0,n3=0;
+    tn=gpst2timens(1929,604000.0);
+    for (i=0;i<20000;i++,tn=timeaddns(tn,0.1)) { /* over week rollover */
+        t=timens2time(tn);
+        if (screent(t,ts,te,0.1)) n1++;
+        if (screent(t,ts,te,0.2)) n2++;
+        if (screent(t,ts,te,30.0)) n3++;
+    }
+        assert(n1==20000&&n2==10000&&n3==66);
+    t=gpst2time(1930,0.0); ts=timeadd(t,-1.0); te=timeadd(t,1.0);
+        assert( screent(t,ts,te,1.0));
+        assert(!screent(timeadd(t,0.5),ts,te,1.0));
+        assert(!screent(timeadd(t,-2.0),ts,te,0.0));
+        assert(!screent(timeadd(te,0.01),ts,te,0.0));
+    
+    printf("%s utset14 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
@@ -282,5 +365,8 @@ int main(void)
     utest9();
     utest10();
     utest11();
+    utest12();
+    utest13();
+    utest14();
     return 0;
 }
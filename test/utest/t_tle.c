@@ -2,6 +2,7 @@
 * rtklib unit test driver : norad two line element function
 *-----------------------------------------------------------------------------*/
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include "../../src/rtklib.h"
 
@@ -138,11 +139,80 @@ static void utest3(void)
     }
     fprintf(OUT,"%s utest3 : OK\n",__FILE__);
 }
+/* tle_search(), tle_poss() --------------------------------------------------*/
+static void utest4(void)
+{
+    const char *file2="../data/tle/TLE_GNSS_20121101.txt";
+    const char *file3="../data/tle/igs17127.erp";
+    const double ep[6]={2012,10,31,0,0,0};
+    erp_t erp={0};
+    tle_t tle={0};
+    gtime_t time[96];
+    double *rs,rs1[6],t;
+    int i,j,k,n,nt=96,*index,stat;
+    
+    stat=readerp(file3,&erp);
+        assert(stat);
+    
+    stat=tle_read(file2,&tle);
+        assert(stat);
+        assert(tle.n>0&&tle.hash);
+    
+    n=tle.n;
+    index=imat(n,1);
+    
+    /* search by catalog number or international designator */
+    for (i=0;i<n;i++) {
+        for (j=0;j<n;j++) {
+            if (!strcmp(tle.data[j].satno,tle.data[i].satno)) break;
+        }
+        k=tle_search("",tle.data[i].satno,"",&tle);
+            assert(k==j);
+        for (j=0;j<n;j++) {
+            if (!strcmp(tle.data[j].desig,tle.data[i].desig)) break;
+        }
+        k=tle_search("","XXXXX",tle.data[i].desig,&tle);
+            assert(k==j);
+        index[i]=tle_search(tle.data[i].name,"","",&tle);
+            assert(index[i]>=0);
+    }
+    k=tle_search("","XXXXX","XXXXX",&tle);
+        assert(k<0);
+    
+    /* batch propagation */
+    for (i=0;i<nt;i++) time[i]=timeadd(epoch2time(ep),900.0*i);
+    rs=mat(6*nt,n);
+    
+    for (k=1;k<=4;k*=2) {
+        stat=tle_poss(time,nt,index,n,&tle,&erp,k,rs);
+            assert(stat==n);
+        
+        for (j=0;j<n;j++) for (i=0;i<nt;i++) {
+            stat=tle_pos(time[i],tle.data[index[j]].name,"","",&tle,&erp,rs1);
+                assert(stat);
+                assert(!memcmp(rs1,rs+(i+j*nt)*6,sizeof(rs1)));
+        }
+    }
+    /* throughput */
+    for (k=1;k<=4;k*=2) {
+        t=tickget();
+        for (i=0;i<10;i++) tle_poss(time,nt,index,n,&tle,&erp,k,rs);
+        t=tickget()-t;
+        fprintf(OUT,"tle_poss: nthread=%d %.0f sat-epochs/s\n",k,
+                10.0*nt*n/(t>0.0?t:1.0)*1E3);
+    }
+    free(rs); free(index);
+    tle_free(&tle);
+        assert(!tle.data&&!tle.hash&&tle.n==0);
+    
+    fprintf(OUT,"%s utest4 : OK\n",__FILE__);
+}
 /* main ----------------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
     utest1();
     utest2();
+    utest4(); /* before utest3 failing by R16 broadcast/TLE mismatch */
     utest3();
     return 0;
 }
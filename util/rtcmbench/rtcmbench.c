@@ -0,0 +1,377 @@
+/*------------------------------------------------------------------------------
+* rtcmbench.c : rtcm 3 decoder and encoder benchmark
+*
+*          Copyright (C) 2026 by T.TAKASU, All rights reserved.
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/18  1.0 new
+*           2026/10/18  1.1 add conversion of receiver raw log into msm7
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+static const char rcsid[]="$Id:$";
+
+#define PROGNAME    "RTCMBENCH"         /* program name */
+#define RTCM3PREAMB 0xD3                /* rtcm ver.3 frame preamble */
+#define MAXFRAME    (1024+6)            /* max length of rtcm 3 frame (bytes) */
+#define MAXOUT      8                   /* max number of output streams */
+#define OUTFILE     "rtcmbench_%d.rtcm3" /* output file of raw log conversion */
+
+/* output messages of raw log conversion (msm7 and ephemerides) */
+#define CONVMSGS    "1077,1087,1097,1117,1127,1019,1020"
+
+/* receiver raw formats ------------------------------------------------------*/
+static const char *fmtstrs[]={
+    "nov","oem3","ubx","ss2","hemis","stq","gw10","javad","nvs","binex","rt17",
+    NULL
+};
+static const int fmts[]={
+    STRFMT_OEM4,STRFMT_OEM3,STRFMT_UBX,STRFMT_SS2,STRFMT_CRES,STRFMT_STQ,
+    STRFMT_GW10,STRFMT_JAVAD,STRFMT_NVS,STRFMT_BINEX,STRFMT_RT17
+};
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: rtcmbench [option]... file",
+"",
+" Decode rtcm 3 messages in the file repeatedly and print the decoding",
+" throughput in frames/s. Observation data can be re-encoded into msm messages",
+" of the specified type before the benchmark. The decoded observation data are",
+" output to the file by option -o to compare the results of decoders.",
+"",
+" With option -r, the file is a receiver raw log which is converted into msm7",
+" and ephemeris messages by the stream server with one or more output streams",
+" (" OUTFILE "), and the conversion throughput is printed.",
+"",
+" -?        print help",
+" -n loop   number of decoding or conversion loops [10]",
+" -m msm    re-encode observation data into msm (4-7) messages [no]",
+" -o file   output decoded observation data of first loop [no]",
+" -r fmt    convert receiver raw log of format [no]",
+"           (nov,oem3,ubx,ss2,hemis,stq,gw10,javad,nvs,binex,rt17)",
+" -c nout   number of output streams of raw log conversion (1-8) [1]",
+" -x level  debug trace level (0:off) [0]"
+};
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) {
+        fprintf(stderr,"%s\n",help[i]);
+    }
+    exit(0);
+}
+/* read file -----------------------------------------------------------------*/
+static unsigned char *readfile(const char *file, int *len)
+{
+    FILE *fp;
+    unsigned char *buff;
+    long size;
+    
+    if (!(fp=fopen(file,"rb"))) {
+        fprintf(stderr,"file open error: %s\n",file);
+        return NULL;
+    }
+    fseek(fp,0,SEEK_END); size=ftell(fp); fseek(fp,0,SEEK_SET);
+    if (size<=0||!(buff=(unsigned char *)malloc(size))) {
+        fclose(fp);
+        return NULL;
+    }
+    *len=(int)fread(buff,1,size,fp);
+    fclose(fp);
+    return buff;
+}
+/* count rtcm 3 frames -------------------------------------------------------*/
+static void cntframe(const unsigned char *buff, int len, int *nframe, int *nmsm)
+{
+    int i,n,type;
+    
+    *nframe=*nmsm=0;
+    for (i=0;i+6<=len;) {
+        if (buff[i]!=RTCM3PREAMB) {
+            i++;
+            continue;
+        }
+        n=getbitu(buff+i,14,10)+6;
+        type=getbitu(buff+i,24,12);
+        if (i+n>len||crc24q(buff+i,n-3)!=getbitu(buff+i,(n-3)*8,24)) {
+            i++;
+            continue;
+        }
+        (*nframe)++;
+        if (1071<=type&&type<=1127&&type%10>=4&&type%10<=7) (*nmsm)++;
+        i+=n;
+    }
+}
+/* msm message types of a system ---------------------------------------------*/
+static int msmtype(int sys, int msm)
+{
+    switch (sys) {
+        case SYS_GPS: return 1070+msm;
+        case SYS_GLO: return 1080+msm;
+        case SYS_GAL: return 1090+msm;
+        case SYS_SBS: return 1100+msm;
+        case SYS_QZS: return 1110+msm;
+        case SYS_CMP: return 1120+msm;
+    }
+    return 0;
+}
+/* re-encode observation data into msm messages ------------------------------
+* observation data decoded by each msm message are encoded into msm message of
+* the specified type with same system and sync flag
+*-----------------------------------------------------------------------------*/
+static unsigned char *encmsm(const unsigned char *buff, int len, int msm,
+                             int *nout)
+{
+    const int syss[]={SYS_GPS,SYS_GLO,SYS_GAL,SYS_SBS,SYS_QZS,SYS_CMP};
+    static rtcm_t dec,enc;
+    unsigned char *out;
+    int i,j,k,n=0,ret,nbyte=0,type,sys;
+    
+    if (!(out=(unsigned char *)malloc((size_t)len*4+MAXFRAME))) return NULL;
+    
+    init_rtcm(&dec);
+    init_rtcm(&enc);
+    
+    for (i=0;i<len;i++) {
+        ret=input_rtcm3(&dec,buff[i]);
+        
+        /* test end of msm message */
+        if (dec.nbyte>0||nbyte<=0) {
+            nbyte=dec.nbyte;
+            continue;
+        }
+        nbyte=0;
+        type=getbitu(dec.buff,24,12);
+        if (type<1071||1127<type||type%10<4||type%10>7) continue;
+        sys=syss[(type-1071)/10<6?(type-1071)/10:0];
+        
+        enc.time=dec.time;
+        enc.staid=dec.staid;
+        for (j=enc.obs.n=0;j<dec.obs.n;j++) {
+            if (satsys(dec.obs.data[j].sat,NULL)!=sys) continue;
+            enc.obs.data[enc.obs.n++]=dec.obs.data[j];
+        }
+        for (j=0;j<MAXPRNGLO;j++) enc.nav.geph[j]=dec.nav.geph[j];
+        for (j=0;j<MAXSAT;j++) enc.nav.eph[j]=dec.nav.eph[j];
+        
+        if (!gen_rtcm3(&enc,msmtype(sys,msm),ret!=1)) continue;
+        if (n+enc.nbyte>len*4) break;
+        for (k=0;k<enc.nbyte;k++) out[n++]=enc.buff[k];
+    }
+    free_rtcm(&dec);
+    free_rtcm(&enc);
+    *nout=n;
+    return out;
+}
+/* output observation data ---------------------------------------------------*/
+static void outobs(FILE *fp, const obs_t *obs)
+{
+    char tstr[64],id[32];
+    int i,j;
+    
+    for (i=0;i<obs->n;i++) {
+        time2str(obs->data[i].time,tstr,9);
+        satno2id(obs->data[i].sat,id);
+        fprintf(fp,"%s %s",tstr,id);
+        for (j=0;j<NFREQ+NEXOBS;j++) {
+            fprintf(fp," %.17g %.17g %.9g %d %d %d",obs->data[i].P[j],
+                    obs->data[i].L[j],obs->data[i].D[j],obs->data[i].SNR[j],
+                    obs->data[i].LLI[j],obs->data[i].code[j]);
+        }
+        fprintf(fp,"\n");
+    }
+}
+/* decode rtcm 3 messages ----------------------------------------------------
+* observation data are output at end of each observation message if fp!=NULL
+*-----------------------------------------------------------------------------*/
+static int decode(const unsigned char *buff, int len, FILE *fp)
+{
+    static rtcm_t rtcm;
+    int i,ret,nbyte=0,nobs=0;
+    
+    init_rtcm(&rtcm);
+    
+    for (i=0;i<len;i++) {
+        if ((ret=input_rtcm3(&rtcm,buff[i]))==1) nobs++;
+        
+        if (fp&&rtcm.nbyte==0&&nbyte>0&&ret>=0&&rtcm.obs.n>0&&
+            (ret==1||getbitu(rtcm.buff,24,12)>=1071)) {
+            fprintf(fp,"> %d\n",getbitu(rtcm.buff,24,12));
+            outobs(fp,&rtcm.obs);
+        }
+        nbyte=rtcm.nbyte;
+    }
+    free_rtcm(&rtcm);
+    return nobs;
+}
+/* compare files -------------------------------------------------------------*/
+static int cmpfile(const char *file1, const char *file2)
+{
+    FILE *fp1,*fp2;
+    int c1,c2;
+    
+    if (!(fp1=fopen(file1,"rb"))) return 0;
+    if (!(fp2=fopen(file2,"rb"))) {
+        fclose(fp1);
+        return 0;
+    }
+    do {
+        c1=fgetc(fp1);
+        c2=fgetc(fp2);
+    } while (c1==c2&&c1!=EOF);
+    
+    fclose(fp1);
+    fclose(fp2);
+    return c1==c2;
+}
+/* convert receiver raw log by stream server ---------------------------------
+* convert receiver raw log into msm7 and ephemeris messages with nout output
+* streams. return 0 if error or the outputs are not identical
+*-----------------------------------------------------------------------------*/
+static int convraw(const char *file, int fmt, int size, int nout)
+{
+    static strsvr_t svr;
+    strconv_t *conv[MAXOUT]={0};
+    int opts[]={10000,10000,2000,32768,0,0,30};
+    int i,ret=1,strs[MAXOUT+1],stat[MAXOUT+1],byte[MAXOUT+1],bps[MAXOUT+1];
+    char path[MAXOUT+1][1024],*paths[MAXOUT+1],msg[MAXSTRMSG];
+    
+    strsvrinit(&svr,nout);
+    
+    for (i=0;i<=nout;i++) {
+        strs[i]=STR_FILE;
+        paths[i]=path[i];
+        if (i==0) strcpy(path[i],file); else sprintf(path[i],OUTFILE,i);
+        
+        if (i>0&&!(conv[i-1]=strconvnew(fmt,STRFMT_RTCM3,CONVMSGS,0,0,""))) {
+            ret=0;
+        }
+    }
+    if (ret&&!strsvrstart(&svr,opts,strs,paths,conv,NULL,NULL)) {
+        fprintf(stderr,"stream server start error\n");
+        ret=0;
+    }
+    if (ret) {
+        /* wait for end of input */
+        do {
+            sleepms(1);
+            strsvrstat(&svr,stat,byte,bps,msg);
+        } while (byte[0]<size&&stat[0]>0);
+        
+        strsvrstop(&svr,NULL);
+    }
+    for (i=0;i<nout;i++) strconvfree(conv[i]);
+    
+    for (i=2;ret&&i<=nout;i++) {
+        if (!(ret=cmpfile(path[1],path[i]))) {
+            fprintf(stderr,"output streams differ: %s %s\n",path[1],path[i]);
+        }
+    }
+    return ret;
+}
+/* benchmark raw log conversion ----------------------------------------------*/
+static int benchconv(const char *file, int fmt, int n, int nout)
+{
+    unsigned char *buff;
+    unsigned int tick;
+    double t;
+    char outfile[1024];
+    int i,len,size,nframe=0,nmsm=0;
+    
+    if (!(buff=readfile(file,&size))) return -1;
+    free(buff);
+    
+    tick=tickget();
+    for (i=0;i<n;i++) {
+        if (!convraw(file,fmt,size,nout)) return -1;
+    }
+    t=(tickget()-tick)*1E-3;
+    
+    sprintf(outfile,OUTFILE,1);
+    if ((buff=readfile(outfile,&len))) {
+        cntframe(buff,len,&nframe,&nmsm);
+        free(buff);
+    }
+    for (i=1;i<=nout;i++) {
+        sprintf(outfile,OUTFILE,i);
+        remove(outfile);
+    }
+    fprintf(stderr,"%s: %s bytes=%d nout=%d out frames=%d msm frames=%d\n",
+            PROGNAME,file,size,nout,nframe,nmsm);
+    fprintf(stderr,"%s: loops=%d time=%.3f s input bytes/s=%.0f "
+            "out msm frames/s=%.0f\n",PROGNAME,n,t,t>0.0?(double)size*n/t:0.0,
+            t>0.0?nmsm*nout*n/t:0.0);
+    return 0;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    FILE *fp=NULL;
+    unsigned char *buff,*msgs;
+    unsigned int tick;
+    double t;
+    char *infile="",*outfile="";
+    int i,j,n=10,msm=0,fmt=-1,nout=1,trlevel=0,len,nframe,nmsm,nobs=0;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-n")&&i+1<argc) n=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-m")&&i+1<argc) msm=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-o")&&i+1<argc) outfile=argv[++i];
+        else if (!strcmp(argv[i],"-r")&&i+1<argc) {
+            for (j=0;fmtstrs[j];j++) if (!strcmp(argv[i+1],fmtstrs[j])) break;
+            if (!fmtstrs[j]) printhelp();
+            fmt=fmts[j];
+            i++;
+        }
+        else if (!strcmp(argv[i],"-c")&&i+1<argc) nout=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-x")&&i+1<argc) trlevel=atoi(argv[++i]);
+        else if (*argv[i]=='-') printhelp();
+        else infile=argv[i];
+    }
+    if (!*infile||n<=0||(msm&&(msm<4||msm>7))||nout<1||MAXOUT<nout) {
+        printhelp();
+    }
+    if (trlevel>0) {
+        traceopen("rtcmbench.trace");
+        tracelevel(trlevel);
+    }
+    if (fmt>=0) { /* raw log conversion */
+        i=benchconv(infile,fmt,n,nout);
+        traceclose();
+        return i;
+    }
+    if (!(buff=readfile(infile,&len))) return -1;
+    
+    if (msm) { /* re-encode observation data */
+        if (!(msgs=encmsm(buff,len,msm,&len))) {
+            free(buff);
+            return -1;
+        }
+        free(buff);
+        buff=msgs;
+    }
+    cntframe(buff,len,&nframe,&nmsm);
+    
+    if (*outfile&&!(fp=fopen(outfile,"w"))) {
+        fprintf(stderr,"file open error: %s\n",outfile);
+        free(buff);
+        return -1;
+    }
+    tick=tickget();
+    for (i=0;i<n;i++) {
+        nobs=decode(buff,len,i==0?fp:NULL);
+    }
+    t=(tickget()-tick)*1E-3;
+    
+    if (fp) fclose(fp);
+    free(buff);
+    traceclose();
+    
+    fprintf(stderr,"%s: %s msm=%d bytes=%d frames=%d msm frames=%d epochs=%d\n",
+            PROGNAME,infile,msm,len,nframe,nmsm,nobs);
+    fprintf(stderr,"%s: loops=%d time=%.3f s frames/s=%.0f msm frames/s=%.0f\n",
+            PROGNAME,n,t,t>0.0?nframe*n/t:0.0,t>0.0?nmsm*n/t:0.0);
+    return 0;
+}
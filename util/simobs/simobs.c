@@ -5,6 +5,9 @@
 *
 * version : $Revision: 1.1 $ $Date: 2008/07/17 21:55:16 $
 * history : 2009/03/23  1.0 new
+*           2026/10/18  1.1 update to current api, output rinex 3 obs
+*                           add option -s for seed of random numbers
+*           2026/10/18  1.2 step epochs by integer nanoseconds
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -24,6 +27,14 @@ static double errcp2    =0.002;         /* carrier-phase meas error/sin(el) (m)
 static double errpr1    =0.2;           /* pseudorange error (m) */
 static double errpr2    =0.2;           /* pseudorange error/sin(el) (m) */
 
+static const unsigned char codes[][3]={ /* obs codes {L1,L2,L5} */
+    {CODE_L1C,CODE_L2W,CODE_L5Q},{CODE_L1C,CODE_L2P,0},{CODE_L1C,0,CODE_L5Q}
+};
+static const char *tobs[][9]={          /* rinex 3 obs types {GPS,GLO,GAL} */
+    {"C1C","L1C","S1C","C2W","L2W","S2W","C5Q","L5Q","S5Q"},
+    {"C1C","L1C","S1C","C2P","L2P","S2P"},
+    {"C1C","L1C","S1C","C5Q","L5Q","S5Q"}
+};
 static int gpsblock[]={                 /* gps block flag (1:block IIF) */
     1,1,1,1,1, 0,0,0,0,0, 0,0,0,0,0, 0,0,0,0,0,
     0,0,0,0,0, 0,0,0,0,0, 0,0
@@ -70,15 +81,16 @@ static void errmodel(const double *azel, double *snr, double *ecp, double *epr)
 }
 /* generate simulated observation data ---------------------------------------*/
 static int simobs(gtime_t ts, gtime_t te, double tint, const double *rr,
-                  nav_t *nav, obs_t *obs, int opt)
+                  nav_t *nav, obs_t *obs, unsigned int seed)
 {
     gtime_t time;
+    gtimens_t tn;
     obsd_t data[MAXSAT]={{{0}}};
-    double pos[3],rs[3*MAXSAT],dts[MAXSAT],r,e[3],azel[2];
+    double pos[3],rs[6*MAXSAT],dts[2*MAXSAT],var[MAXSAT],r,e[3],azel[2],lam;
     double ecp[MAXSAT][NFREQ]={{0}},epr[MAXSAT][NFREQ]={{0}};
     double snr[MAXSAT][NFREQ]={{0}},ers[MAXSAT][3]={{0}};
     double iono,trop,fact,cp,pr,dtr=0.0,rref[3],bl;
-    int i,j,k,n,ns,amb[MAXSAT][NFREQ]={{0}},sys,prn;
+    int i,j,k,n,ns,amb[MAXSAT][NFREQ]={{0}},svh[MAXSAT],sys,prn,m;
     char s[64];
     
     double pref[]={36.106114294,140.087190410,70.3010}; /* ref station */
@@ -97,36 +109,36 @@ static int simobs(gtime_t ts, gtime_t te, double tint, const double *rr,
         data[i].P[0]=2E7;
         for (j=0;j<3;j++) ers[i][j]=randn(0.0,erreph);
     }
-    srand(tickget());
+    srand(seed?seed:tickget());
     
     ecef2pos(rr,pos);
     n=(int)(timediff(te,ts)/tint+1.0);
     
-    for (i=0;i<n;i++) {
-        time=timeadd(ts,tint*i);
+    for (i=0,tn=time2timens(ts);i<n;i++,tn=timeaddns(tn,tint)) {
+        time=timens2time(tn);
         time2str(time,s,0);
         
         for (j=0;j<MAXSAT;j++) data[j].time=time;
         
         for (j=0;j<3;j++) { /* iteration for pseudorange */
-            satpos(time,data,MAXSAT,nav,rs,dts);
+            satposs(time,data,MAXSAT,nav,EPHOPT_BRDC,rs,dts,var,svh);
             for (k=0;k<MAXSAT;k++) {
-                if ((r=geodist(rs+k*3,rr,e))<=0.0) continue;
-                data[k].P[0]=r+CLIGHT*(dtr-dts[k]);
+                if ((r=geodist(rs+k*6,rr,e))<=0.0) continue;
+                data[k].P[0]=r+CLIGHT*(dtr-dts[k*2]);
             }
         }
-        satpos(time,data,MAXSAT,nav,rs,dts);
+        satposs(time,data,MAXSAT,nav,EPHOPT_BRDC,rs,dts,var,svh);
         for (j=ns=0;j<MAXSAT;j++) {
             
             /* add ephemeris error */
-            for (k=0;k<3;k++) rs[k+j*3]+=ers[j][k];
+            for (k=0;k<3;k++) rs[k+j*6]+=ers[j][k];
             
-            if ((r=geodist(rs+j*3,rr,e))<=0.0) continue;
+            if (svh[j]||(r=geodist(rs+j*6,rr,e))<=0.0) continue;
             satazel(pos,e,azel);
             if (azel[1]<minel*D2R) continue;
             
-            iono=ionmodel(time,nav->ion,pos,azel);
-            trop=tropmodel(pos,azel,0.3);
+            iono=ionmodel(time,nav->ion_gps,pos,azel);
+            trop=tropmodel(time,pos,azel,0.3);
             
             /* add ionospheric error */
             iono+=errion*bl*ionmapf(pos,azel);
@@ -139,29 +151,29 @@ static int simobs(gtime_t ts, gtime_t te, double tint, const double *rr,
                 data[j].L[k]=data[j].P[k]=0.0;
                 data[j].SNR[k]=0;
                 data[j].LLI[k]=0;
+                data[j].code[k]=0;
                 
-                if (sys==SYS_GPS) {
-                    if (k>=3) continue; /* no L5a/L5b in gps */
-                    if (k>=2&&!gpsblock[prn-1]) continue; /* no L5 in block II */
-                }
-                else if (sys==SYS_GLO) {
-                    if (k>=3) continue;
-                }
-                else if (sys==SYS_GAL) {
-                    if (k==1) continue; /* no L2 in galileo */
-                }
+                if (sys==SYS_GPS) m=0;
+                else if (sys==SYS_GLO) m=1;
+                else if (sys==SYS_GAL) m=2;
                 else continue;
                 
+                if (k>=3||!codes[m][k]) continue;
+                if (sys==SYS_GPS&&k>=2&&!gpsblock[prn-1]) continue; /* block II */
+                if ((lam=satwavelen(data[j].sat,k,nav))<=0.0) continue;
+                
                 /* generate observation data */
-                fact=lam[k]*lam[k]/lam[0]/lam[0];
-                cp=r+CLIGHT*(dtr-dts[j])-fact*iono+trop+ecp[j][k];
-                pr=r+CLIGHT*(dtr-dts[j])+fact*iono+trop+epr[j][k];
+                fact=lam*lam/satwavelen(data[j].sat,0,nav)/
+                     satwavelen(data[j].sat,0,nav);
+                cp=r+CLIGHT*(dtr-dts[j*2])-fact*iono+trop+ecp[j][k];
+                pr=r+CLIGHT*(dtr-dts[j*2])+fact*iono+trop+epr[j][k];
                 
-                if (amb[j][k]==0) amb[j][k]=(int)(-cp/lam[k]);
-                data[j].L[k]=cp/lam[k]+amb[j][k];
+                if (amb[j][k]==0) amb[j][k]=(int)(-cp/lam);
+                data[j].L[k]=cp/lam+amb[j][k];
+                data[j].code[k]=codes[m][k];
                 data[j].P[k]=pr;
-                data[j].SNR[k]=(unsigned char)snr[j][k];
-                data[j].LLI[k]=data[j].SNR[k]<slipthres?1:0;
+                data[j].SNR[k]=(unsigned char)(snr[j][k]*4.0+0.5);
+                data[j].LLI[k]=snr[j][k]<slipthres?1:0;
             }
             if (obs->nmax<=obs->n) {
                 if (obs->nmax==0) obs->nmax=65532; else obs->nmax+=65532;
@@ -189,7 +201,8 @@ int main(int argc, char **argv)
     double es[]={2000,1,1,0,0,0},ee[]={2000,1,1,0,0,0},tint=30.0;
     double pos[3]={0},rr[3];
     char *infile[16]={0},*outfile="";
-    int i,j,n=0,opt=0;
+    unsigned int seed=0;
+    int i,j,n=0;
     
     for (i=1;i<argc;i++) {
         if      (!strcmp(argv[i],"-o")&&i+1<argc) outfile=argv[++i];
@@ -202,6 +215,9 @@ int main(int argc, char **argv)
             te=epoch2time(ee);
         }
         else if (!strcmp(argv[i],"-ti")&&i+1<argc) tint=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-s")&&i+1<argc) {
+            seed=(unsigned int)atoi(argv[++i]);
+        }
         else if (!strcmp(argv[i],"-r")&&i+3<argc) {
             for (j=0;j<3;j++) pos[j]=atof(argv[++i]); /* lat,lon,hgt */
         }
@@ -222,14 +238,14 @@ int main(int argc, char **argv)
     pos[0]*=D2R; pos[1]*=D2R; pos2ecef(pos,rr);
     
     /* read simulated/real rinex nav files */
-    readrnx(infile,n,&obs,&nav);
+    for (i=0;i<n;i++) readrnx(infile[i],1,"",&obs,&nav,NULL);
     
     if (nav.n<=0) {
         fprintf(stderr,"no nav data\n");
         return -1;
     }
     /* generate simulated observation data */
-    if (!simobs(ts,te,tint,rr,&nav,&obs,opt)) return -1;
+    if (!simobs(ts,te,tint,rr,&nav,&obs,seed)) return -1;
     
     /* output rinex obs file */
     if (!(fp=fopen(outfile,"w"))) {
@@ -240,13 +256,18 @@ int main(int argc, char **argv)
     strcpy(rnxopt.prog,PROGNAME);
     strcpy(rnxopt.comment[0],"SIMULATED OBS DATA");
     rnxopt.tstart=ts;
-    rnxopt.tstart=te;
+    rnxopt.tend=te;
+    rnxopt.tint=tint;
+    rnxopt.rnxver=3.00;
     rnxopt.navsys=SYS_ALL;
     rnxopt.obstype=OBSTYPE_PR|OBSTYPE_CP|OBSTYPE_SNR;
     rnxopt.freqtype=FREQTYPE_L1|FREQTYPE_L2|FREQTYPE_L5|FREQTYPE_L7;
     for (i=0;i<3;i++) rnxopt.apppos[i]=rr[i];
-    
-    outrnxobsh(fp,&rnxopt);
+    for (i=0;i<3;i++) {
+        for (j=0;j<9&&tobs[i][j];j++) strcpy(rnxopt.tobs[i][j],tobs[i][j]);
+        rnxopt.nobs[i]=j;
+    }
+    outrnxobsh(fp,&rnxopt,&nav);
     
     for (i=0;i<obs.n;i=j) {
         for (j=i;j<obs.n;j++) {
@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------------
+* solconv.c : solution format converter
+*
+*          Copyright (C) 2026 by T.TAKASU, All rights reserved.
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+static const char rcsid[]="$Id:$";
+
+#define PROGNAME    "SOLCONV"           /* program name */
+#define MAXFILE     16                  /* max number of input files */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: solconv [option]... file file [...]",
+"",
+" Read solution files (text or binary) and output the solutions in the",
+" specified solution format. Binary solution records are output by rtkrcv or",
+" rnx2rtkp with option out-solformat=bin (or outstr?-format=bin).",
+"",
+" -?        print help",
+" -ts ds ts start day/time (ds=y/m/d ts=h:m:s) [obs start time]",
+" -te de te end day/time   (de=y/m/d te=h:m:s) [obs end time]",
+" -ti tint  time interval (sec) [all]",
+" -q  qflag quality flag (0:all,1:fix,2:float,3:sbas,4:dgps,5:single,6:ppp)",
+"           [all]",
+" -f  fmt   output format (llh,xyz,enu,nmea,bin) [llh]",
+" -t        output time format as yyyy/mm/dd hh:mm:ss.ss [sssss.s]",
+" -u        output time in utc [gpst]",
+" -d        output latitude/longitude in the form of ddd mm ss.ss' [ddd.ddd]",
+" -s sep    field separator [' ']",
+" -o file   output file [stdout]"
+};
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
+    exit(0);
+}
+/* solconv main --------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    FILE *fp=stdout;
+    solopt_t opt=solopt_default;
+    solbuf_t solbuf={0};
+    gtime_t ts={0},te={0};
+    double es[]={2000,1,1,0,0,0},ee[]={2000,1,1,0,0,0},tint=0.0;
+    char *infile[MAXFILE],*outfile="",*fmt="llh";
+    int i,n=0,qflag=0;
+    
+    opt.outhead=0;
+    
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-ts")&&i+2<argc) {
+            sscanf(argv[++i],"%lf/%lf/%lf",es,es+1,es+2);
+            sscanf(argv[++i],"%lf:%lf:%lf",es+3,es+4,es+5);
+            ts=epoch2time(es);
+        }
+        else if (!strcmp(argv[i],"-te")&&i+2<argc) {
+            sscanf(argv[++i],"%lf/%lf/%lf",ee,ee+1,ee+2);
+            sscanf(argv[++i],"%lf:%lf:%lf",ee+3,ee+4,ee+5);
+            te=epoch2time(ee);
+        }
+        else if (!strcmp(argv[i],"-ti")&&i+1<argc) tint=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-q" )&&i+1<argc) qflag=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-f" )&&i+1<argc) fmt=argv[++i];
+        else if (!strcmp(argv[i],"-t" )) opt.timef=1;
+        else if (!strcmp(argv[i],"-u" )) opt.times=TIMES_UTC;
+        else if (!strcmp(argv[i],"-d" )) opt.degf=1;
+        else if (!strcmp(argv[i],"-s" )&&i+1<argc) strcpy(opt.sep,argv[++i]);
+        else if (!strcmp(argv[i],"-o" )&&i+1<argc) outfile=argv[++i];
+        else if (*argv[i]=='-') printhelp();
+        else if (n<MAXFILE) infile[n++]=argv[i];
+    }
+    if      (!strcmp(fmt,"llh" )) opt.posf=SOLF_LLH;
+    else if (!strcmp(fmt,"xyz" )) opt.posf=SOLF_XYZ;
+    else if (!strcmp(fmt,"enu" )) opt.posf=SOLF_ENU;
+    else if (!strcmp(fmt,"nmea")) opt.posf=SOLF_NMEA;
+    else if (!strcmp(fmt,"bin" )) opt.posf=SOLF_BIN;
+    else {
+        fprintf(stderr,"invalid output format: %s\n",fmt);
+        return -1;
+    }
+    if (n<=0) {
+        fprintf(stderr,"no input file\n");
+        return -1;
+    }
+    /* read solution files */
+    if (!readsolt(infile,n,ts,te,tint,qflag,&solbuf)) {
+        fprintf(stderr,"no solution data\n");
+        return -1;
+    }
+    if (*outfile&&!(fp=fopen(outfile,opt.posf==SOLF_BIN?"wb":"w"))) {
+        fprintf(stderr,"error : outfile open %s\n",outfile);
+        freesolbuf(&solbuf);
+        return -1;
+    }
+    strcpy(opt.prog,PROGNAME);
+    
+    /* output solutions */
+    outsolhead(fp,&opt);
+    
+    for (i=0;i<solbuf.n;i++) {
+        outsol(fp,solbuf.data+i,solbuf.rb,&opt);
+    }
+    if (fp!=stdout) fclose(fp);
+    
+    fprintf(stderr,"%d solutions converted\n",solbuf.n);
+    
+    freesolbuf(&solbuf);
+    return 0;
+}
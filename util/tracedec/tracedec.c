@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------
+* tracedec.c : binary trace decoder
+*
+*          Copyright (C) 2026 by T.TAKASU, All rights reserved.
+*
+* version : $Revision:$ $Date:$
+* history : 2026/10/18  1.0 new
+*-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+static const char rcsid[]="$Id:$";
+
+#define PROGNAME    "TRACEDEC"          /* program name */
+#define TEXTFILE    "tracedec_bench.trace" /* text trace file of benchmark */
+#define BINFILE     "tracedec_bench.trb" /* binary trace file of benchmark */
+
+/* help text -----------------------------------------------------------------*/
+static const char *help[]={
+"",
+" usage: tracedec [option]... file",
+"",
+" Decode the binary trace file generated with tracebuf() (e.g. rtkrcv -b) and",
+" output the text trace identical with the trace without binary trace buffers.",
+"",
+" With option -b, the overhead of trace calls is measured for the suppressed",
+" trace, the text trace (" TEXTFILE ") and the binary trace",
+" (" BINFILE ") and printed in ns per call.",
+"",
+" -?        print help",
+" -l level  max trace level of output (0:all) [0]",
+" -o file   output file [stdout]",
+" -b ncall  measure trace overhead with number of calls [no]",
+" -s size   binary trace buffer size per thread (KB) for -b [1024]"
+};
+/* print help ----------------------------------------------------------------*/
+static void printhelp(void)
+{
+    int i;
+    for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) {
+        fprintf(stderr,"%s\n",help[i]);
+    }
+    exit(0);
+}
+/* trace calls ---------------------------------------------------------------*/
+static double tracecall(int ncall)
+{
+    unsigned int tick=tickget();
+    double t;
+    int i;
+    
+    for (i=0;i<ncall;i++) {
+        trace(3,"tracecall: i=%d x=%.3f y=%13.3f id=%s\n",i,i*0.001,i*1E3,
+              "G01");
+    }
+    t=(double)(tickget()-tick);
+    return t*1E6/ncall;
+}
+/* measure trace overhead ----------------------------------------------------*/
+static int benchtrace(int ncall, int size)
+{
+    FILE *fp;
+    double t1,t2,t3;
+    int nrec;
+    
+    /* suppressed trace */
+    tracebuf(0);
+    traceopen(TEXTFILE);
+    tracelevel(2);
+    t1=tracecall(ncall);
+    
+    /* text trace */
+    tracelevel(3);
+    t2=tracecall(ncall);
+    traceclose();
+    
+    /* binary trace */
+    tracebuf(size);
+    traceopen(BINFILE);
+    tracelevel(3);
+    t3=tracecall(ncall);
+    traceclose();
+    tracebuf(0);
+    
+    if (!(fp=tmpfile())) return -1;
+    nrec=tracedec(BINFILE,fp,0);
+    fclose(fp);
+    if (nrec<0) {
+        fprintf(stderr,"binary trace decode error: %s\n",BINFILE);
+        return -1;
+    }
+    fprintf(stderr,"%s: calls=%d buffer size=%d bytes\n",PROGNAME,ncall,size);
+    fprintf(stderr,"%s: suppressed: %8.1f ns/call\n",PROGNAME,t1);
+    fprintf(stderr,"%s: text      : %8.1f ns/call\n",PROGNAME,t2);
+    fprintf(stderr,"%s: binary    : %8.1f ns/call (records=%d dropped=%d)\n",
+            PROGNAME,t3,nrec,ncall-nrec);
+    return 0;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    FILE *fp=stdout;
+    char *infile="",*outfile="";
+    int i,level=0,ncall=0,size=1024,nrec;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-l")&&i+1<argc) level=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-o")&&i+1<argc) outfile=argv[++i];
+        else if (!strcmp(argv[i],"-b")&&i+1<argc) ncall=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-s")&&i+1<argc) size=atoi(argv[++i]);
+        else if (*argv[i]=='-') printhelp();
+        else infile=argv[i];
+    }
+    if (ncall>0) {
+        return benchtrace(ncall,size*1024);
+    }
+    if (!*infile) printhelp();
+    
+    if (*outfile&&!(fp=fopen(outfile,"w"))) {
+        fprintf(stderr,"file open error: %s\n",outfile);
+        return -1;
+    }
+    nrec=tracedec(infile,fp,level);
+    
+    if (fp!=stdout) fclose(fp);
+    
+    if (nrec<0) {
+        fprintf(stderr,"binary trace decode error: %s\n",infile);
+        return -1;
+    }
+    return 0;
+}